@@ -6,7 +6,24 @@
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 
 #if WITH_GAMEPLAY_DEBUGGER
+#include "Camera/PlayerCameraManager.h"
 #include "GameFramework/PlayerController.h"
+#include "Misc/StringBuilder.h"
+
+namespace RogueAIDebugCategory
+{
+	// Display names never change at runtime, resolve each once instead of per tile
+	template<typename TEnum>
+	const FString& GetCachedEnumDisplayName(const TEnum Value)
+	{
+		static TMap<int64, FString> Names;
+		const int64 Key = static_cast<int64>(Value);
+		if (const FString* Found = Names.Find(Key)) return *Found;
+		return Names.Add(Key, UEnum::GetDisplayValueAsText(Value).ToString());
+	}
+}
+
+using namespace RogueAIDebugCategory;
 
 FRogueAIDebugCategory::FRogueAIDebugCategory():
 Collector(FGameplayDebuggerEntityOverheadTilesCollector(this))
@@ -24,6 +41,9 @@ Collector(FGameplayDebuggerEntityOverheadTilesCollector(this))
 	/**2**/ BindKeyPress(EKeys::C.GetFName(), FGameplayDebuggerInputModifier::None, this, &FRogueAIDebugCategory::OnToggleCarriageOverheads, EGameplayDebuggerInputMode::Replicated);
 	/**3**/ BindKeyPress(EKeys::V.GetFName(), FGameplayDebuggerInputModifier::None, this, &FRogueAIDebugCategory::OnToggleStationOverheads, EGameplayDebuggerInputMode::Replicated);
 	/**4**/ BindKeyPress(EKeys::B.GetFName(), FGameplayDebuggerInputModifier::None, this, &FRogueAIDebugCategory::OnToggleTrackOverheads, EGameplayDebuggerInputMode::Replicated);
+	/**5**/ BindKeyPress(EKeys::N.GetFName(), FGameplayDebuggerInputModifier::None, this, &FRogueAIDebugCategory::OnPickEntity, EGameplayDebuggerInputMode::Replicated);
+
+	SetDataPackReplication<FRepData>(&DataPack);
 }
 
 TSharedRef<FGameplayDebuggerCategory> FRogueAIDebugCategory::MakeInstance()
@@ -38,74 +58,152 @@ void FRogueAIDebugCategory::CollectData(APlayerController* OwnerPC, AActor* Debu
 	const UWorld* World = GetWorldFromReplicator();
 	if (!World) return;
 
-	Collector = FGameplayDebuggerEntityOverheadTilesCollector(this);
 	RogueTrainSubsystem = World->GetSubsystem<URogueTrainWorldSubsystem>();	
 	if (!RogueTrainSubsystem) return;
 
+	// Keep the snapshots we display alive, the debug processor skips any nobody asked for
+	ERogueDebugSnapshot Requested = ERogueDebugSnapshot::None;
+	if (bDrawPassengerOverheads) Requested |= ERogueDebugSnapshot::Passengers;
+	if (bDrawTrainOverheads) Requested |= ERogueDebugSnapshot::Trains;
+	if (bDrawCarriageOverheads) Requested |= ERogueDebugSnapshot::Carriages;
+	if (bDrawStationOverheads) Requested |= ERogueDebugSnapshot::Stations;
+
+	// Picking searches every kind, keep them all collected while a pick is pending or shown
+	if (bPickRequested || PickedEntity.IsSet())
+	{
+		Requested |= ERogueDebugSnapshot::Passengers | ERogueDebugSnapshot::Trains | ERogueDebugSnapshot::Carriages | ERogueDebugSnapshot::Stations;
+	}
+
+	// Cull at the source with a cone around the view, padded so tiles do not pop at the screen edge
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+	GetViewPoint(OwnerPC, ViewLocation, ViewDirection);
+	
+	const float FOV = OwnerPC->PlayerCameraManager ? OwnerPC->PlayerCameraManager->GetFOVAngle() : 90.f;
+	FRogueDebugView View;
+	View.Origin = ViewLocation;
+	View.Forward = ViewDirection;
+	View.CosHalfFOV = FMath::Cos(FMath::DegreesToRadians(FMath::Min(0.5f * FOV + 10.f, 180.f)));
+	View.MaxDistance = URogueAIDebuggerSettings::Get()->GameplayDebuggerConfig.OverheadMaxDistance;
+	RogueTrainSubsystem->RequestDebugSnapshots(Requested, View);
+
+	CollectPickedEntity(ViewLocation, ViewDirection);
+
+	// A gap in collection means the category was hidden or the viewer reconnected, start them over from a keyframe
+	const double Now = World->GetTimeSeconds();
+	if (LastCollectTime < 0.0 || Now - LastCollectTime > 2.0 * FMath::Max(CollectDataInterval, 0.1f))
+	{
+		PackEncoder.ForceKeyframe();
+	}
+	LastCollectTime = Now;
+
+	// Only the encoded rows leave the server, tiles are formatted from the decoded pack on the viewing side.
+	// Tiles are rebuilt every collect, the pick highlight and settings can change without the pack changing
+	const bool bPackChanged = EncodeDataPack();
+	if (IsCategoryLocal())
+	{
+		if (bPackChanged)
+		{
+			PackDecoder.Apply(DataPack.Payload);
+		}
+		RebuildOverheads();
+	}
+}
+
+void FRogueAIDebugCategory::OnGameplayDebuggerActivated()
+{
+	PackEncoder.ForceKeyframe();
+	PackDecoder.Reset();
+	LastCollectTime = -1.0;
+}
+
+bool FRogueAIDebugCategory::EncodeDataPack()
+{
+	// Rows of the kinds being drawn, plus the picked entity so its tile shows even when its kind is toggled off
+	auto EncodeSnapshot = [this](const auto& Snapshot, const bool bDraw)
+	{
+		if (!bDraw && !PickedEntity.IsSet()) return;
+		
+		const auto& Rows = Snapshot.GetFront();
+		for (const int32 Row : Snapshot.GetFrontRows())
+		{
+			if (bDraw || Rows[Row].Entity == PickedEntity)
+			{
+				PackEncoder.Add(Rows[Row]);
+			}
+		}
+	};
+
+	PackEncoder.BeginPack();
+	EncodeSnapshot(RogueTrainSubsystem->GetPassengerDebugSnapshot(), bDrawPassengerOverheads);
+	EncodeSnapshot(RogueTrainSubsystem->GetTrainDebugSnapshot(), bDrawTrainOverheads);
+	EncodeSnapshot(RogueTrainSubsystem->GetCarriageDebugSnapshot(), bDrawCarriageOverheads);
+	EncodeSnapshot(RogueTrainSubsystem->GetStationDebugSnapshot(), bDrawStationOverheads);
+	return PackEncoder.EndPack(DataPack.Payload);
+}
+
+void FRogueAIDebugCategory::OnDataPackReplicated(int32 DataPackId)
+{
+	PackDecoder.Apply(DataPack.Payload);
+	RebuildOverheads();
+}
+
+void FRogueAIDebugCategory::RebuildOverheads()
+{
+	Collector.Reset();
 	CollectPassengerEntityData();
 	CollectTrainEntityData();
 	CollectCarriageEntityData();
 	CollectStationEntityData();
 	CollectTrackData();
-	
-	DataPack.Collector = Collector;
 }
 
-void FRogueAIDebugCategory::CollectPassengerEntityData()
+void FRogueAIDebugCategory::FRepData::Serialize(FArchive& Ar)
 {
-	if (!bDrawPassengerOverheads) return;
+	Ar << Payload;
+}
 
-	const TArray<FRogueDebugPassenger>& PassengerDebugSnapshot = RogueTrainSubsystem->GetPassengerDebugSnapshot();
-	for (const FRogueDebugPassenger& DebugPassenger : PassengerDebugSnapshot)
+void FRogueAIDebugCategory::CollectPassengerEntityData()
+{
+	// Decoded pack rows, the server already culled them to the view and to the enabled kinds
+	for (const TPair<uint64, FRogueDebugPassenger>& Pair : PackDecoder.GetPassengers())
 	{
-		const FVector EntityPosition = DebugPassenger.WorldPos;
-		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(EntityPosition);
-		GetPassengerEntityOverheadInfo(DebugPassenger, Info);
+		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(Pair.Value.WorldPos, Pair.Key);
+		GetPassengerEntityOverheadInfo(Pair.Value, Info);
 	}	
 }
 
 void FRogueAIDebugCategory::CollectTrainEntityData()
 {
-	if (!bDrawTrainOverheads) return;
-	
-	const TArray<FRogueDebugTrain>& TrainDebugSnapshot = RogueTrainSubsystem->GetTrainDebugSnapshot();
-	for (const FRogueDebugTrain& DebugTrain : TrainDebugSnapshot)
+	for (const TPair<uint64, FRogueDebugTrain>& Pair : PackDecoder.GetTrains())
 	{
-		const FVector EntityPosition = DebugTrain.WorldPos;
-		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(EntityPosition);
-		GetTrainEntityOverheadInfo(DebugTrain, Info);
+		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(Pair.Value.WorldPos, Pair.Key);
+		GetTrainEntityOverheadInfo(Pair.Value, Info);
 	}	
 }
 
 void FRogueAIDebugCategory::CollectCarriageEntityData()
 {
-	if (!bDrawCarriageOverheads) return;
-	
-	const TArray<FRogueDebugCarriage>& CarriageDebugSnapshot = RogueTrainSubsystem->GetCarriageDebugSnapshot();
-	for (const FRogueDebugCarriage& DebugCarriage : CarriageDebugSnapshot)
+	for (const TPair<uint64, FRogueDebugCarriage>& Pair : PackDecoder.GetCarriages())
 	{
-		const FVector EntityPosition = DebugCarriage.WorldPos;
-		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(EntityPosition);
-		GetCarriageEntityOverheadInfo(DebugCarriage, Info);
+		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(Pair.Value.WorldPos, Pair.Key);
+		GetCarriageEntityOverheadInfo(Pair.Value, Info);
 	}	
 }
 
 void FRogueAIDebugCategory::CollectStationEntityData()
 {
-	if (!bDrawStationOverheads) return;
-	
-	const TArray<FRogueDebugStation>& StationDebugSnapshot = RogueTrainSubsystem->GetStationDebugSnapshot();
-	for (const FRogueDebugStation& DebugStation : StationDebugSnapshot)
+	for (const TPair<uint64, FRogueDebugStation>& Pair : PackDecoder.GetStations())
 	{
-		const FVector EntityPosition = DebugStation.WorldPos;
-		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(EntityPosition);
-		GetStationEntityOverheadInfo(DebugStation, Info);
+		FGameplayDebuggerEntityOverheadTiles& Info = Collector.Add(Pair.Value.WorldPos, Pair.Key);
+		GetStationEntityOverheadInfo(Pair.Value, Info);
 	}	
 }
 
 void FRogueAIDebugCategory::CollectTrackData()
 {
-	if (!bDrawTrackOverheads) return;
+	// Track rows are not part of the pack, only drawn where the subsystem is local
+	if (!bDrawTrackOverheads || !RogueTrainSubsystem) return;
 	
 	const TArray<FRogueDebugTrack>& TrackDebugSnapshot = RogueTrainSubsystem->GetTrackDebugSnapshot();
 	for (const FRogueDebugTrack& DebugTrack : TrackDebugSnapshot)
@@ -116,72 +214,131 @@ void FRogueAIDebugCategory::CollectTrackData()
 	}	
 }
 
+void FRogueAIDebugCategory::CollectPickedEntity(const FVector& ViewLocation, const FVector& ViewDirection)
+{
+	const auto& Conf = URogueAIDebuggerSettings::Get()->GameplayDebuggerConfig;
+	const float MaxDistance = Conf.OverheadMaxDistance > 0.f ? Conf.OverheadMaxDistance : UE_FLOAT_HUGE_DISTANCE;
+	
+	// Pick the entity nearest the view ray from the published spatial indices, only what is collected can be picked
+	if (bPickRequested)
+	{
+		// Kinds that were not being collected publish on the next frame end, resolve on the collect after that
+		if (!bPickArmed)
+		{
+			bPickArmed = true;
+			return;
+		}
+		
+		bPickRequested = false;
+		bPickArmed = false;
+		PickedEntity = FMassEntityHandle();
+		
+		double BestMissSq = FMath::Square(Conf.PickRadius);
+		auto PickFrom = [&](const auto& Snapshot)
+		{
+			const int32 Row = Snapshot.GetFrontIndex().PickAlongRay(ViewLocation, ViewDirection, MaxDistance, BestMissSq);
+			if (Row != INDEX_NONE)
+			{
+				PickedEntity = Snapshot.GetFront()[Row].Entity;
+			}
+		};
+		
+		PickFrom(RogueTrainSubsystem->GetStationDebugSnapshot());
+		PickFrom(RogueTrainSubsystem->GetTrainDebugSnapshot());
+		PickFrom(RogueTrainSubsystem->GetCarriageDebugSnapshot());
+		PickFrom(RogueTrainSubsystem->GetPassengerDebugSnapshot());
+	}
+
+	if (!PickedEntity.IsSet()) return;
+
+	// The picked row is encoded into the pack with the drawn kinds, here only its summary line is added
+	auto AddPicked = [&](const auto& Snapshot, const TCHAR* Label)
+	{
+		const auto& Rows = Snapshot.GetFront();
+		for (const int32 Row : Snapshot.GetFrontRows())
+		{
+			if (Rows[Row].Entity != PickedEntity) continue;
+			
+			AddTextLine(FString::Printf(TEXT("{yellow}Picked {white}%s %d at %s"), Label, PickedEntity.Index, *Rows[Row].WorldPos.ToCompactString()));
+			return true;
+		}
+		return false;
+	};
+
+	const bool bFound = AddPicked(RogueTrainSubsystem->GetPassengerDebugSnapshot(), TEXT("Passenger"))
+		|| AddPicked(RogueTrainSubsystem->GetTrainDebugSnapshot(), TEXT("Train"))
+		|| AddPicked(RogueTrainSubsystem->GetCarriageDebugSnapshot(), TEXT("Carriage"))
+		|| AddPicked(RogueTrainSubsystem->GetStationDebugSnapshot(), TEXT("Station"));
+	
+	if (!bFound)
+	{
+		AddTextLine(FString::Printf(TEXT("{yellow}Picked {white}%d {gray}(out of view)"), PickedEntity.Index));
+	}
+}
+
 void FRogueAIDebugCategory::GetPassengerEntityOverheadInfo(const FRogueDebugPassenger& DebugPassenger, FGameplayDebuggerEntityOverheadTiles& Info)
 {
-	FGameplayDebuggerEntityOverheadCategory& TravelCategory = Info.Category("Travel Info");
-	TravelCategory.Add("Origin", FString::FromInt(DebugPassenger.OriginStation.Index));
-	TravelCategory.Add("Dest", FString::FromInt(DebugPassenger.DestStation.Index));
-	TravelCategory.Add("Phase", UEnum::GetDisplayValueAsText(DebugPassenger.Phase).ToString());
-
-	FGameplayDebuggerEntityOverheadCategory& WaitingCategory = Info.Category("Wait Info");
-	WaitingCategory.Add("IsWaiting", FString::Printf(TEXT("%s"), DebugPassenger.bWaiting ? TEXT("true") : TEXT("false")));
-	WaitingCategory.Add("Wait", FString::FromInt(DebugPassenger.WaitingPointIdx));
-	WaitingCategory.Add("WaitSlot", FString::FromInt(DebugPassenger.WaitingSlotIdx));
+	FGameplayDebuggerEntityOverheadCategory& TravelCategory = Info.Category(TEXT("Travel Info"));
+	TravelCategory.AddF(TEXT("Origin"), TEXT("%d"), DebugPassenger.OriginStationIdx);
+	TravelCategory.AddF(TEXT("Dest"), TEXT("%d"), DebugPassenger.DestStationIdx);
+	TravelCategory.Add(TEXT("Phase"), GetCachedEnumDisplayName(DebugPassenger.Phase));
+
+	FGameplayDebuggerEntityOverheadCategory& WaitingCategory = Info.Category(TEXT("Wait Info"));
+	WaitingCategory.Add(TEXT("IsWaiting"), DebugPassenger.bWaiting ? TEXT("true") : TEXT("false"));
+	WaitingCategory.AddF(TEXT("Wait"), TEXT("%d"), DebugPassenger.WaitingPointIdx);
+	WaitingCategory.AddF(TEXT("WaitSlot"), TEXT("%d"), DebugPassenger.WaitingSlotIdx);
 	
-	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category("Movement Info");
-	MovementCategory.Add("DistToGoal", FString::Printf(TEXT("%.0f"), DebugPassenger.Move.DistToGoal)); 
-	MovementCategory.Add("Speed", FString::Printf(TEXT("%.0f"), DebugPassenger.Move.DesiredSpeed.Get())); 
-	MovementCategory.Add("AcceptRad", FString::Printf(TEXT("%.0f"), DebugPassenger.Move.AcceptanceRadius)); 
+	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category(TEXT("Movement Info"));
+	MovementCategory.AddF(TEXT("DistToGoal"), TEXT("%.0f"), DebugPassenger.Move.DistToGoal); 
+	MovementCategory.AddF(TEXT("Speed"), TEXT("%.0f"), DebugPassenger.Move.DesiredSpeed.Get()); 
+	MovementCategory.AddF(TEXT("AcceptRad"), TEXT("%.0f"), DebugPassenger.Move.AcceptanceRadius); 
 }
 
 void FRogueAIDebugCategory::GetTrainEntityOverheadInfo(const FRogueDebugTrain& DebugTrain, FGameplayDebuggerEntityOverheadTiles& Info)
 {
-	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category("Movement Info");
-	MovementCategory.Add("Alpha", FString::Printf(TEXT("%.2f"), DebugTrain.Alpha)); 
-	MovementCategory.Add("Speed", FString::Printf(TEXT("%.0f"), DebugTrain.Speed));
-	MovementCategory.Add("TargetStation", FString::FromInt(DebugTrain.TargetStationIdx)); 
+	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category(TEXT("Movement Info"));
+	MovementCategory.AddF(TEXT("Distance"), TEXT("%.0f"), DebugTrain.Distance); 
+	MovementCategory.AddF(TEXT("Speed"), TEXT("%.0f"), DebugTrain.Speed);
+	MovementCategory.AddF(TEXT("TargetStation"), TEXT("%d"), DebugTrain.TargetStationIdx); 
 	
-	FGameplayDebuggerEntityOverheadCategory& StationCategory = Info.Category("Station Info");
-	StationCategory.Add("IsStopping", FString::Printf(TEXT("%s"), DebugTrain.bIsStopping ? TEXT("true") : TEXT("false")));
-	StationCategory.Add("IsAtStation", FString::Printf(TEXT("%s"), DebugTrain.bAtStation ? TEXT("true") : TEXT("false")));
-	StationCategory.Add("RemTime", FString::Printf(TEXT("%.0f"), DebugTrain.StationTimeRemaining));
-	StationCategory.Add("StopPhase", UEnum::GetDisplayValueAsText(DebugTrain.TrainPhase).ToString());
+	FGameplayDebuggerEntityOverheadCategory& StationCategory = Info.Category(TEXT("Station Info"));
+	StationCategory.Add(TEXT("IsStopping"), DebugTrain.bIsStopping ? TEXT("true") : TEXT("false"));
+	StationCategory.Add(TEXT("IsAtStation"), DebugTrain.bAtStation ? TEXT("true") : TEXT("false"));
+	StationCategory.AddF(TEXT("RemTime"), TEXT("%.0f"), DebugTrain.StationTimeRemaining);
+	StationCategory.Add(TEXT("StopPhase"), GetCachedEnumDisplayName(DebugTrain.TrainPhase));
 }
 
 void FRogueAIDebugCategory::GetCarriageEntityOverheadInfo(const FRogueDebugCarriage& DebugCarriage, FGameplayDebuggerEntityOverheadTiles& Info)
 {
-	FGameplayDebuggerEntityOverheadCategory& CarriageCategory = Info.Category("Carriage Info");	
-	CarriageCategory.Add("Index", FString::FromInt(DebugCarriage.IndexInTrain));
-	CarriageCategory.Add("Capacity", FString::FromInt(DebugCarriage.Capacity));
-	CarriageCategory.Add("Occupants", FString::FromInt(DebugCarriage.Occupants));
-	CarriageCategory.Add("Spacing", FString::Printf(TEXT("%.0f"), DebugCarriage.Spacing));
-
-	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category("Movement Info");
-	MovementCategory.Add("Alpha", FString::Printf(TEXT("%.2f"), DebugCarriage.Alpha)); 
-	MovementCategory.Add("Speed", FString::Printf(TEXT("%.0f"), DebugCarriage.Speed));
+	FGameplayDebuggerEntityOverheadCategory& CarriageCategory = Info.Category(TEXT("Carriage Info"));	
+	CarriageCategory.AddF(TEXT("Index"), TEXT("%d"), DebugCarriage.IndexInTrain);
+	CarriageCategory.AddF(TEXT("Capacity"), TEXT("%d"), DebugCarriage.Capacity);
+	CarriageCategory.AddF(TEXT("Occupants"), TEXT("%d"), DebugCarriage.Occupants);
+	CarriageCategory.AddF(TEXT("Spacing"), TEXT("%.0f"), DebugCarriage.Spacing);
+
+	FGameplayDebuggerEntityOverheadCategory& MovementCategory = Info.Category(TEXT("Movement Info"));
+	MovementCategory.AddF(TEXT("Distance"), TEXT("%.0f"), DebugCarriage.Distance); 
+	MovementCategory.AddF(TEXT("Speed"), TEXT("%.0f"), DebugCarriage.Speed);
 }
 
 void FRogueAIDebugCategory::GetStationEntityOverheadInfo(const FRogueDebugStation& DebugStation, FGameplayDebuggerEntityOverheadTiles& Info)
 {
-	FGameplayDebuggerEntityOverheadCategory& StationCategory = Info.Category("Station Info");	
-	StationCategory.Add("Index", FString::FromInt(DebugStation.StationIdx)); 	
-	//StationCategory.Add("Alpha", FString::Printf(TEXT("%.2f"), DebugStation.TrackAlpha)); 
-	StationCategory.Add("PSpawns", FString::FromInt(DebugStation.TotalSpawnPoints)); 	
+	FGameplayDebuggerEntityOverheadCategory& StationCategory = Info.Category(TEXT("Station Info"));	
+	StationCategory.AddF(TEXT("Index"), TEXT("%d"), DebugStation.StationIdx); 	
+	//StationCategory.AddF(TEXT("Alpha"), TEXT("%.2f"), DebugStation.TrackAlpha); 
+	StationCategory.AddF(TEXT("PSpawns"), TEXT("%d"), DebugStation.TotalSpawnPoints); 	
 
-	FGameplayDebuggerEntityOverheadCategory& WaitingCategory = Info.Category("Wait Info");
-	WaitingCategory.Add("WaitingCount", FString::FromInt(DebugStation.TotalWaiting)); 	
-	WaitingCategory.Add("WaitPoints", FString::FromInt(DebugStation.TotalWaitingPoints));
+	FGameplayDebuggerEntityOverheadCategory& WaitingCategory = Info.Category(TEXT("Wait Info"));
+	WaitingCategory.AddF(TEXT("WaitingCount"), TEXT("%d"), DebugStation.TotalWaiting); 	
+	WaitingCategory.AddF(TEXT("WaitPoints"), TEXT("%d"), DebugStation.TotalWaitingPoints);
 
 	for (int i = 0; i < DebugStation.Grids.Num(); ++i)
 	{
 		const FRogueDebugWaitingGrid& WaitGrid = DebugStation.Grids[i];
-		WaitingCategory.Add(FString::Printf(TEXT("Grid%d"), i),FString::Printf(TEXT("WP %d | Slots %d | Occ %d | Free %d"),
-				  WaitGrid.WaitingPointIdx, WaitGrid.Slots, WaitGrid.Occupied, WaitGrid.Free));
-		/*WaitingCategory.Add("WpIndex", FString::FromInt(WaitGrid.WaitingPointIdx));
-		WaitingCategory.Add("Slots", FString::FromInt(WaitGrid.Slots));
-		WaitingCategory.Add("Occupied", FString::FromInt(WaitGrid.Occupied));
-		WaitingCategory.Add("Free", FString::FromInt(WaitGrid.Free));
-		WaitingCategory.Add("--", FString::Printf(TEXT("%s"), TEXT("----")));*/
+		TStringBuilder<16> GridLabel;
+		GridLabel << TEXT("Grid") << i;
+		WaitingCategory.AddF(GridLabel.ToView(), TEXT("WP %d | Slots %d | Occ %d | Free %d"),
+				  WaitGrid.WaitingPointIdx, WaitGrid.Slots, WaitGrid.Occupied, WaitGrid.Free);
 	}
 }
 
@@ -194,9 +351,10 @@ void FRogueAIDebugCategory::DrawData(APlayerController* OwnerPC, FGameplayDebugg
 {
 	Context.Printf(TEXT("[{yellow}%s{white}] Passenger Overheads: %s"), *GetInputHandlerDescription(0), GPD_COND_STRING(bDrawPassengerOverheads, "On", "Off"));
 	Context.Printf(TEXT("[{yellow}%s{white}] Train Overheads: %s"), *GetInputHandlerDescription(1), GPD_COND_STRING(bDrawTrainOverheads, "On", "Off"));
-	Context.Printf(TEXT("[{yellow}%s{white}] Carriage Overheads: %s"), *GetInputHandlerDescription(3), GPD_COND_STRING(bDrawCarriageOverheads, "On", "Off"));
-	Context.Printf(TEXT("[{yellow}%s{white}] Station Overheads: %s"), *GetInputHandlerDescription(4), GPD_COND_STRING(bDrawStationOverheads, "On", "Off"));
-	Context.Printf(TEXT("[{yellow}%s{white}] Track Overheads: %s"), *GetInputHandlerDescription(5), GPD_COND_STRING(bDrawTrackOverheads, "On", "Off"));
+	Context.Printf(TEXT("[{yellow}%s{white}] Carriage Overheads: %s"), *GetInputHandlerDescription(2), GPD_COND_STRING(bDrawCarriageOverheads, "On", "Off"));
+	Context.Printf(TEXT("[{yellow}%s{white}] Station Overheads: %s"), *GetInputHandlerDescription(3), GPD_COND_STRING(bDrawStationOverheads, "On", "Off"));
+	Context.Printf(TEXT("[{yellow}%s{white}] Track Overheads: %s"), *GetInputHandlerDescription(4), GPD_COND_STRING(bDrawTrackOverheads, "On", "Off"));
+	Context.Printf(TEXT("[{yellow}%s{white}] Pick entity under view centre"), *GetInputHandlerDescription(5));
 
 	Context.MoveToNewLine();
 
@@ -204,12 +362,11 @@ void FRogueAIDebugCategory::DrawData(APlayerController* OwnerPC, FGameplayDebugg
 	FVector ViewDirection = FVector::ZeroVector;
 	GetViewPoint(OwnerPC, ViewLocation, ViewDirection);
 
+	// Lines accumulate in the category's arena and reach the line batcher in one call when Drawer goes out of scope
 	FLineBatchProxy Drawer(GetWorldFromReplicator());
-	Drawer.Thickness(4.0f);
+	Drawer.WithArena(LineArena).Thickness(4.0f);
 
-	Collector = FGameplayDebuggerEntityOverheadTilesCollector(this, &Context);
-	Collector.From(DataPack.Collector);
-	Collector.Draw();
+	Collector.Draw(Context, TileCache);
 	
 	/*if (!Cached.Owner.IsValid())
 	{
@@ -287,6 +444,12 @@ void FRogueAIDebugCategory::OnToggleTrackOverheads()
 	SaveAllSettings();
 }
 
+void FRogueAIDebugCategory::OnPickEntity()
+{
+	// Resolved on the next collect, which has the owner's view
+	bPickRequested = true;
+}
+
 void FRogueAIDebugCategory::SaveAllSettings()
 {
 	auto Settings = URogueAIDebuggerSettings::Get();
@@ -0,0 +1,470 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RogueAIDebugDataPack.h"
+
+using namespace RogueDebugPack;
+
+namespace RogueDebugPack
+{
+	int32 QuantizeCm(const double Value) { return FMath::RoundToInt32(FMath::Clamp(Value, static_cast<double>(MIN_int32), static_cast<double>(MAX_int32))); }
+
+	void WriteVarUInt(TArray<uint8>& Out, uint64 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Out.Add(static_cast<uint8>(Value) | 0x80);
+			Value >>= 7;
+		}
+		Out.Add(static_cast<uint8>(Value));
+	}
+
+	void WriteVarInt(TArray<uint8>& Out, const int64 Value)
+	{
+		WriteVarUInt(Out, (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63));
+	}
+
+	struct FReader
+	{
+		TConstArrayView<uint8> Data;
+		int32 Pos = 0;
+		bool bError = false;
+
+		explicit FReader(TConstArrayView<uint8> InData) : Data(InData) {}
+
+		uint8 ReadByte()
+		{
+			if (Pos >= Data.Num())
+			{
+				bError = true;
+				return 0;
+			}
+			return Data[Pos++];
+		}
+
+		uint64 ReadVarUInt()
+		{
+			uint64 Value = 0;
+			for (int32 Shift = 0; Shift < 64 && !bError; Shift += 7)
+			{
+				const uint8 Byte = ReadByte();
+				Value |= static_cast<uint64>(Byte & 0x7f) << Shift;
+				if (!(Byte & 0x80)) return Value;
+			}
+			bError = true;
+			return 0;
+		}
+
+		int64 ReadVarInt()
+		{
+			const uint64 Value = ReadVarUInt();
+			return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1);
+		}
+	};
+
+	void AddPosition(TArray<int32>& Out, const FVector& WorldPos)
+	{
+		Out.Add(QuantizeCm(WorldPos.X));
+		Out.Add(QuantizeCm(WorldPos.Y));
+		Out.Add(QuantizeCm(WorldPos.Z));
+	}
+
+	FVector GetPosition(TConstArrayView<int32> In, const int32 First)
+	{
+		return FVector(In[First], In[First + 1], In[First + 2]);
+	}
+
+	// Field layouts, keep Dequantize in step with Add
+	namespace PassengerField { enum { PosX, PosY, PosZ, Origin, Dest, Phase, bWaiting, WaitingPoint, WaitingSlot, DistToGoal, Speed, AcceptRadius, Num }; }
+	namespace TrainField { enum { PosX, PosY, PosZ, Distance, Speed, TargetStation, Flags, StationTimeDeci, Phase, Num }; }
+	namespace CarriageField { enum { PosX, PosY, PosZ, IndexInTrain, Capacity, Occupants, Spacing, Distance, Speed, Num }; }
+	namespace StationField { enum { PosX, PosY, PosZ, StationIdx, TotalWaiting, TotalSpawnPoints, TotalWaitingPoints, NumGrids, FirstGrid }; }
+	constexpr int32 FieldsPerGrid = 4;
+
+	void Dequantize(TConstArrayView<int32> In, FRogueDebugPassenger& Out)
+	{
+		if (In.Num() < PassengerField::Num) return;
+		Out.WorldPos = GetPosition(In, PassengerField::PosX);
+		Out.OriginStationIdx = In[PassengerField::Origin];
+		Out.DestStationIdx = In[PassengerField::Dest];
+		Out.Phase = static_cast<ERoguePassengerPhase>(In[PassengerField::Phase]);
+		Out.bWaiting = In[PassengerField::bWaiting] != 0;
+		Out.WaitingPointIdx = In[PassengerField::WaitingPoint];
+		Out.WaitingSlotIdx = In[PassengerField::WaitingSlot];
+		Out.Move.DistToGoal = In[PassengerField::DistToGoal];
+		Out.Move.DesiredSpeed = FMassInt16Real(static_cast<float>(In[PassengerField::Speed]));
+		Out.Move.AcceptanceRadius = In[PassengerField::AcceptRadius];
+	}
+
+	void Dequantize(TConstArrayView<int32> In, FRogueDebugTrain& Out)
+	{
+		if (In.Num() < TrainField::Num) return;
+		Out.WorldPos = GetPosition(In, TrainField::PosX);
+		Out.Distance = In[TrainField::Distance];
+		Out.Speed = In[TrainField::Speed];
+		Out.TargetStationIdx = In[TrainField::TargetStation];
+		Out.bIsStopping = (In[TrainField::Flags] & 1) != 0;
+		Out.bAtStation = (In[TrainField::Flags] & 2) != 0;
+		Out.StationTimeRemaining = In[TrainField::StationTimeDeci] * 0.1f;
+		Out.TrainPhase = static_cast<ERogueStationTrainPhase>(In[TrainField::Phase]);
+	}
+
+	void Dequantize(TConstArrayView<int32> In, FRogueDebugCarriage& Out)
+	{
+		if (In.Num() < CarriageField::Num) return;
+		Out.WorldPos = GetPosition(In, CarriageField::PosX);
+		Out.IndexInTrain = In[CarriageField::IndexInTrain];
+		Out.Capacity = In[CarriageField::Capacity];
+		Out.Occupants = In[CarriageField::Occupants];
+		Out.Spacing = In[CarriageField::Spacing];
+		Out.Distance = In[CarriageField::Distance];
+		Out.Speed = In[CarriageField::Speed];
+	}
+
+	void Dequantize(TConstArrayView<int32> In, FRogueDebugStation& Out)
+	{
+		if (In.Num() < StationField::FirstGrid) return;
+		Out.WorldPos = GetPosition(In, StationField::PosX);
+		Out.StationIdx = In[StationField::StationIdx];
+		Out.TotalWaiting = In[StationField::TotalWaiting];
+		Out.TotalSpawnPoints = In[StationField::TotalSpawnPoints];
+		Out.TotalWaitingPoints = In[StationField::TotalWaitingPoints];
+
+		const int32 NumGrids = FMath::Clamp(In[StationField::NumGrids], 0, (In.Num() - StationField::FirstGrid) / FieldsPerGrid);
+		Out.Grids.SetNum(NumGrids);
+		for (int32 i = 0; i < NumGrids; ++i)
+		{
+			const int32 First = StationField::FirstGrid + i * FieldsPerGrid;
+			Out.Grids[i].WaitingPointIdx = In[First];
+			Out.Grids[i].Slots = In[First + 1];
+			Out.Grids[i].Occupied = In[First + 2];
+			Out.Grids[i].Free = In[First + 3];
+		}
+	}
+}
+
+void FRogueDebugPackEncoder::BeginPack()
+{
+	for (FKindState& State : Kinds)
+	{
+		State.Keys.Reset();
+		State.Fields.Reset();
+		State.Offsets.Reset();
+		State.Offsets.Add(0);
+	}
+}
+
+FRogueDebugPackEncoder::FKindState& FRogueDebugPackEncoder::BeginRow(const EKind Kind, const FMassEntityHandle Entity)
+{
+	FKindState& State = Kinds[static_cast<int32>(Kind)];
+	State.Keys.Add(Entity.AsNumber());
+	return State;
+}
+
+void FRogueDebugPackEncoder::EndRow(FKindState& State)
+{
+	State.Offsets.Add(State.Fields.Num());
+}
+
+void FRogueDebugPackEncoder::Add(const FRogueDebugPassenger& Row)
+{
+	FKindState& State = BeginRow(EKind::Passenger, Row.Entity);
+	AddPosition(State.Fields, Row.WorldPos);
+	State.Fields.Add(Row.OriginStationIdx);
+	State.Fields.Add(Row.DestStationIdx);
+	State.Fields.Add(static_cast<int32>(Row.Phase));
+	State.Fields.Add(Row.bWaiting ? 1 : 0);
+	State.Fields.Add(Row.WaitingPointIdx);
+	State.Fields.Add(Row.WaitingSlotIdx);
+	State.Fields.Add(QuantizeCm(Row.Move.DistToGoal));
+	State.Fields.Add(QuantizeCm(Row.Move.DesiredSpeed.Get()));
+	State.Fields.Add(QuantizeCm(Row.Move.AcceptanceRadius));
+	EndRow(State);
+}
+
+void FRogueDebugPackEncoder::Add(const FRogueDebugTrain& Row)
+{
+	FKindState& State = BeginRow(EKind::Train, Row.Entity);
+	AddPosition(State.Fields, Row.WorldPos);
+	State.Fields.Add(QuantizeCm(Row.Distance));
+	State.Fields.Add(QuantizeCm(Row.Speed));
+	State.Fields.Add(Row.TargetStationIdx);
+	State.Fields.Add((Row.bIsStopping ? 1 : 0) | (Row.bAtStation ? 2 : 0));
+	State.Fields.Add(FMath::RoundToInt32(Row.StationTimeRemaining * 10.f));
+	State.Fields.Add(static_cast<int32>(Row.TrainPhase));
+	EndRow(State);
+}
+
+void FRogueDebugPackEncoder::Add(const FRogueDebugCarriage& Row)
+{
+	FKindState& State = BeginRow(EKind::Carriage, Row.Entity);
+	AddPosition(State.Fields, Row.WorldPos);
+	State.Fields.Add(Row.IndexInTrain);
+	State.Fields.Add(Row.Capacity);
+	State.Fields.Add(Row.Occupants);
+	State.Fields.Add(QuantizeCm(Row.Spacing));
+	State.Fields.Add(QuantizeCm(Row.Distance));
+	State.Fields.Add(QuantizeCm(Row.Speed));
+	EndRow(State);
+}
+
+void FRogueDebugPackEncoder::Add(const FRogueDebugStation& Row)
+{
+	FKindState& State = BeginRow(EKind::Station, Row.Entity);
+	AddPosition(State.Fields, Row.WorldPos);
+	State.Fields.Add(Row.StationIdx);
+	State.Fields.Add(Row.TotalWaiting);
+	State.Fields.Add(Row.TotalSpawnPoints);
+	State.Fields.Add(Row.TotalWaitingPoints);
+	State.Fields.Add(Row.Grids.Num());
+	for (const FRogueDebugWaitingGrid& Grid : Row.Grids)
+	{
+		State.Fields.Add(Grid.WaitingPointIdx);
+		State.Fields.Add(Grid.Slots);
+		State.Fields.Add(Grid.Occupied);
+		State.Fields.Add(Grid.Free);
+	}
+	EndRow(State);
+}
+
+bool FRogueDebugPackEncoder::EndPack(TArray<uint8>& OutPayload)
+{
+	const bool bKeyframe = PacksSinceKeyframe >= KeyframeInterval;
+	if (bKeyframe)
+	{
+		for (FKindState& State : Kinds)
+		{
+			State.Baselines.Reset();
+		}
+	}
+
+	uint32 PackId = LastPackId + 1;
+	if (PackId == 0) PackId = 1;
+
+	Body.Reset();
+	for (FKindState& State : Kinds)
+	{
+		WriteKind(State, PackId, bKeyframe);
+	}
+
+	// Deltas are against the keyframe, the same body decodes to the same rows as the last pack
+	if (!bKeyframe && Body == LastBody) return false;
+	LastBody = Body;
+
+	Scratch.Reset();
+	Scratch.Add(Version);
+	WriteVarUInt(Scratch, PackId);
+	WriteVarUInt(Scratch, bKeyframe ? 0 : KeyframePackId);
+	Scratch.Append(Body);
+
+	LastPackId = PackId;
+	if (bKeyframe)
+	{
+		KeyframePackId = PackId;
+	}
+	PacksSinceKeyframe = bKeyframe ? 1 : PacksSinceKeyframe + 1;
+	Swap(OutPayload, Scratch);
+	return true;
+}
+
+void FRogueDebugPackEncoder::WriteKind(FKindState& State, const uint32 PackId, const bool bKeyframe)
+{
+	// Rows whose quantized fields differ from the keyframe. A keyframe makes every row its baseline,
+	// rows first seen after it have no baseline and are written from zero until the next keyframe
+	if (bKeyframe)
+	{
+		State.Baselines.Reset();
+	}
+	
+	State.ChangedRows.Reset();
+	for (int32 i = 0; i < State.Keys.Num(); ++i)
+	{
+		const TConstArrayView<int32> Fields(State.Fields.GetData() + State.Offsets[i], State.Offsets[i + 1] - State.Offsets[i]);
+		FBaseline* Baseline = bKeyframe ? &State.Baselines.Add(State.Keys[i]) : State.Baselines.Find(State.Keys[i]);
+		if (Baseline)
+		{
+			Baseline->LastPackId = PackId;
+		}
+		
+		if (!Baseline || Baseline->Fields.Num() != Fields.Num() || FMemory::Memcmp(Baseline->Fields.GetData(), Fields.GetData(), Fields.Num() * sizeof(int32)) != 0)
+		{
+			State.ChangedRows.Add(i);
+		}
+	}
+
+	// Keyframe rows not collected this pack, they stay in the baselines for the next deltas
+	State.RemovedKeys.Reset();
+	for (const TPair<uint64, FBaseline>& Pair : State.Baselines)
+	{
+		if (Pair.Value.LastPackId != PackId)
+		{
+			State.RemovedKeys.Add(Pair.Key);
+		}
+	}
+
+	WriteVarUInt(Body, State.RemovedKeys.Num());
+	for (const uint64 Key : State.RemovedKeys)
+	{
+		WriteVarUInt(Body, Key);
+	}
+
+	WriteVarUInt(Body, State.ChangedRows.Num());
+	for (const int32 i : State.ChangedRows)
+	{
+		const TConstArrayView<int32> Fields(State.Fields.GetData() + State.Offsets[i], State.Offsets[i + 1] - State.Offsets[i]);
+		FBaseline* Baseline = State.Baselines.Find(State.Keys[i]);
+		const TConstArrayView<int32> BaseFields = Baseline ? TConstArrayView<int32>(Baseline->Fields) : TConstArrayView<int32>();
+
+		WriteVarUInt(Body, State.Keys[i]);
+		WriteVarUInt(Body, Fields.Num());
+
+		// One changed-field mask per 32 fields, then a delta for every set bit
+		for (int32 First = 0; First < Fields.Num(); First += 32)
+		{
+			const int32 Last = FMath::Min(First + 32, Fields.Num());
+			uint32 Mask = 0;
+			for (int32 f = First; f < Last; ++f)
+			{
+				const int32 Base = BaseFields.IsValidIndex(f) ? BaseFields[f] : 0;
+				if (Fields[f] != Base) Mask |= 1u << (f - First);
+			}
+
+			WriteVarUInt(Body, Mask);
+			for (int32 f = First; f < Last; ++f)
+			{
+				if (!(Mask & (1u << (f - First)))) continue;
+				const int32 Base = BaseFields.IsValidIndex(f) ? BaseFields[f] : 0;
+				WriteVarInt(Body, static_cast<int64>(Fields[f]) - Base);
+			}
+		}
+
+		if (bKeyframe)
+		{
+			Baseline->Fields.Reset();
+			Baseline->Fields.Append(Fields.GetData(), Fields.Num());
+		}
+	}
+}
+
+bool FRogueDebugPackDecoder::Apply(TConstArrayView<uint8> Payload)
+{
+	FReader Reader(Payload);
+	if (Reader.ReadByte() != Version) return false;
+
+	const uint32 PackId = static_cast<uint32>(Reader.ReadVarUInt());
+	const uint32 BaselineId = static_cast<uint32>(Reader.ReadVarUInt());
+	if (Reader.bError) return false;
+
+	// A delta is only meaningful on top of the keyframe it was made against, wait for the next keyframe otherwise
+	const bool bKeyframe = BaselineId == 0;
+	if (bKeyframe)
+	{
+		Reset();
+	}
+	else if (BaselineId != KeyframePackId)
+	{
+		return false;
+	}
+
+	for (int32 KindIdx = 0; KindIdx < NumKinds && !Reader.bError; ++KindIdx)
+	{
+		// Every delta starts from the keyframe rows, whatever packs were skipped in between
+		TMap<uint64, TArray<int32>>& KindFields = Fields[KindIdx];
+		KindFields = KeyframeFields[KindIdx];
+
+		const uint64 NumRemoved = Reader.ReadVarUInt();
+		for (uint64 i = 0; i < NumRemoved && !Reader.bError; ++i)
+		{
+			KindFields.Remove(Reader.ReadVarUInt());
+		}
+
+		const uint64 NumChanged = Reader.ReadVarUInt();
+		for (uint64 i = 0; i < NumChanged && !Reader.bError; ++i)
+		{
+			const uint64 Key = Reader.ReadVarUInt();
+			const int32 NumFields = static_cast<int32>(FMath::Min<uint64>(Reader.ReadVarUInt(), Payload.Num()));
+
+			TArray<int32>& RowFields = KindFields.FindOrAdd(Key);
+			RowFields.SetNumZeroed(NumFields, EAllowShrinking::No);
+			for (int32 First = 0; First < NumFields && !Reader.bError; First += 32)
+			{
+				const int32 Last = FMath::Min(First + 32, NumFields);
+				const uint32 Mask = static_cast<uint32>(Reader.ReadVarUInt());
+				for (int32 f = First; f < Last; ++f)
+				{
+					if (Mask & (1u << (f - First)))
+					{
+						RowFields[f] = static_cast<int32>(RowFields[f] + Reader.ReadVarInt());
+					}
+				}
+			}
+		}
+	}
+
+	if (Reader.bError)
+	{
+		Reset();
+		return false;
+	}
+
+	if (bKeyframe)
+	{
+		for (int32 KindIdx = 0; KindIdx < NumKinds; ++KindIdx)
+		{
+			KeyframeFields[KindIdx] = Fields[KindIdx];
+		}
+		KeyframePackId = PackId;
+	}
+
+	RebuildRows();
+	return true;
+}
+
+void FRogueDebugPackDecoder::Reset()
+{
+	for (int32 KindIdx = 0; KindIdx < NumKinds; ++KindIdx)
+	{
+		Fields[KindIdx].Reset();
+		KeyframeFields[KindIdx].Reset();
+	}
+	Passengers.Reset();
+	Trains.Reset();
+	Carriages.Reset();
+	Stations.Reset();
+	KeyframePackId = 0;
+}
+
+void FRogueDebugPackDecoder::RebuildRows()
+{
+	Passengers.Reset();
+	Trains.Reset();
+	Carriages.Reset();
+	Stations.Reset();
+	
+	for (int32 KindIdx = 0; KindIdx < NumKinds; ++KindIdx)
+	{
+		for (const TPair<uint64, TArray<int32>>& Pair : Fields[KindIdx])
+		{
+			StoreRow(static_cast<EKind>(KindIdx), Pair.Key, Pair.Value);
+		}
+	}
+}
+
+void FRogueDebugPackDecoder::StoreRow(const EKind Kind, const uint64 Key, TConstArrayView<int32> InFields)
+{
+	auto Store = [Key, InFields](auto& Rows)
+	{
+		auto& Row = Rows.FindOrAdd(Key);
+		Row.Entity = FMassEntityHandle::FromNumber(Key);
+		Dequantize(InFields, Row);
+	};
+
+	switch (Kind)
+	{
+	case EKind::Passenger:	Store(Passengers); break;
+	case EKind::Train:		Store(Trains); break;
+	case EKind::Carriage:	Store(Carriages); break;
+	case EKind::Station:	Store(Stations); break;
+	default: break;
+	}
+}
@@ -2,6 +2,7 @@
 
 #include "RogueAIDebuggerEntityOverheadTiles.h"
 #include "CanvasItem.h"
+#include "Misc/StringBuilder.h"
 
 
 // copied from Core/Private/Misc/VarargsHeler.h 
@@ -33,59 +34,127 @@
 	FMemory::SystemFree(AllocatedBuffer);
 
 
-void FGameplayDebuggerEntityOverheadCategory::AddImpl(const FString& InLabel, const TCHAR* Fmt, ...) {
-	GROWABLE_PRINTF(Add(InLabel, Buffer));
+void FGameplayDebuggerEntityOverheadCategory::AddImpl(const FStringView InLabel, const TCHAR* Fmt, ...) {
+	GROWABLE_PRINTF(Add(InLabel, FStringView(Buffer, Result)));
 }
 
-FGameplayDebuggerEntityOverheadTiles::FGameplayDebuggerEntityOverheadTiles(class FGameplayDebuggerCategory* CategoryInst, const FVector& InWorldPos, FGameplayDebuggerCanvasContext* InCanvasContext):
-	CategoryInst(CategoryInst),
-	WorldPos(InWorldPos),
-	CanvasContext(InCanvasContext) {
+FGameplayDebuggerEntityOverheadCategory& FGameplayDebuggerEntityOverheadCategory::Add(const FStringView InLabel, const FStringView Value) {
+	AddPair(Collector->AppendText(InLabel), Collector->AppendText(Value), EGameplayDebuggerEntityOverheadPairType::RegularKeyValue);
+	return *this;
+}
 
-	ScreenPos = CanvasContext->ProjectLocation(WorldPos);
+FGameplayDebuggerEntityOverheadCategory& FGameplayDebuggerEntityOverheadCategory::Separator() {
+	AddPair(FGameplayDebuggerEntityOverheadText(), FGameplayDebuggerEntityOverheadText(), EGameplayDebuggerEntityOverheadPairType::Separator);
+	return *this;
+}
 
+void FGameplayDebuggerEntityOverheadCategory::AddPair(const FGameplayDebuggerEntityOverheadText& InLabel, const FGameplayDebuggerEntityOverheadText& InValue, const EGameplayDebuggerEntityOverheadPairType Type) {
+	const int32 PairIdx = Collector->Pairs.Add({InLabel, InValue, Type, ActiveIndentLevel, INDEX_NONE});
+	if (LastPair != INDEX_NONE) {
+		Collector->Pairs[LastPair].NextPair = PairIdx;
+	} else {
+		FirstPair = PairIdx;
+	}
+	LastPair = PairIdx;
 }
 
-FGameplayDebuggerEntityOverheadTiles::FGameplayDebuggerEntityOverheadTiles(FGameplayDebuggerEntityOverheadTilesCollector* Collector, const FVector& InWorldPos):
-	Collector(Collector),
-	CategoryInst(Collector->Category),
-	WorldPos(InWorldPos),
-	CanvasContext(&Collector->WorldContext) {
+FGameplayDebuggerEntityOverheadCategory& FGameplayDebuggerEntityOverheadTiles::Category(const FStringView Label) {
+	const int32 CategoryIdx = Collector->Categories.AddDefaulted();
+	FGameplayDebuggerEntityOverheadCategory& NewCategory = Collector->Categories[CategoryIdx];
+	NewCategory.Collector = Collector;
+	NewCategory.Label     = Collector->AppendText(Label);
+
+	if (LastCategory != INDEX_NONE) {
+		Collector->Categories[LastCategory].NextCategory = CategoryIdx;
+	} else {
+		FirstCategory = CategoryIdx;
+	}
+	LastCategory = CategoryIdx;
+
+	return NewCategory;
+}
 
-	ScreenPos = CanvasContext->ProjectLocation(WorldPos);
+FGameplayDebuggerEntityOverheadText FGameplayDebuggerEntityOverheadTilesCollector::AppendText(const FStringView InText) {
+	FGameplayDebuggerEntityOverheadText Range;
+	Range.Offset = Text.Num();
+	Range.Len    = InText.Len();
+	Text.Append(InText.GetData(), InText.Len());
+	return Range;
+}
+
+FGameplayDebuggerEntityOverheadTiles& FGameplayDebuggerEntityOverheadTilesCollector::Add(const FVector& WorldPos, const uint64 Key) {
+	if (const int32* Existing = TileLookup.Find(Key)) {
+		return WorldTiles[*Existing];
+	}
+
+	const int32 TileIdx = WorldTiles.AddDefaulted();
+	TileLookup.Add(Key, TileIdx);
+
+	FGameplayDebuggerEntityOverheadTiles& Tile = WorldTiles[TileIdx];
+	Tile.Collector = this;
+	Tile.WorldPos  = WorldPos;
+	Tile.Key       = Key;
+	return Tile;
+}
+
+FGameplayDebuggerEntityOverheadTiles& FGameplayDebuggerEntityOverheadTilesCollector::Add(const FVector& WorldPos) {
+	// Top bit keeps position keys apart from entity keys
+	return Add(WorldPos, (1ull << 63) | GetTypeHash(WorldPos));
 }
 
-FGameplayDebuggerEntityOverheadCategory& FGameplayDebuggerEntityOverheadTiles::Category(const FString& Label) {
-	return Categories.Emplace_GetRef(this, Label);
+void FGameplayDebuggerEntityOverheadTilesCollector::Reset() {
+	Text.Reset();
+	WorldTiles.Reset();
+	Categories.Reset();
+	Pairs.Reset();
+	TileLookup.Reset();
 }
 
-void FGameplayDebuggerEntityOverheadTiles::Print() {
-	Print(ScreenPos.X, ScreenPos.Y);
+uint32 FGameplayDebuggerEntityOverheadTilesCollector::HashTile(const FGameplayDebuggerEntityOverheadTiles& Tile) const {
+	uint32 Hash = 0;
+	for (int32 CategoryIdx = Tile.FirstCategory; CategoryIdx != INDEX_NONE; CategoryIdx = Categories[CategoryIdx].NextCategory) {
+		const FGameplayDebuggerEntityOverheadCategory& Category = Categories[CategoryIdx];
+		const FStringView Label = GetText(Category.Label);
+		Hash = FCrc::MemCrc32(Label.GetData(), Label.Len() * sizeof(TCHAR), Hash);
+
+		for (int32 PairIdx = Category.FirstPair; PairIdx != INDEX_NONE; PairIdx = Pairs[PairIdx].NextPair) {
+			const FGameplayDebuggerEntityOverheadPair& Pair = Pairs[PairIdx];
+			const FStringView PairLabel = GetText(Pair.Label);
+			const FStringView PairValue = GetText(Pair.Value);
+			Hash = HashCombineFast(Hash, (static_cast<uint32>(Pair.Type) << 16) | static_cast<uint32>(Pair.IndentLevel));
+			Hash = FCrc::MemCrc32(PairLabel.GetData(), PairLabel.Len() * sizeof(TCHAR), Hash);
+			Hash = FCrc::MemCrc32(PairValue.GetData(), PairValue.Len() * sizeof(TCHAR), Hash);
+		}
+	}
+	return Hash;
 }
 
-void FGameplayDebuggerEntityOverheadTiles::Print(const float ScreenX, const float ScreenY) {
-	FString FullOutputString = "";
+bool FGameplayDebuggerEntityOverheadTilesCollector::BuildTileText(const FGameplayDebuggerEntityOverheadTiles& Tile, FString& Out) const {
+	// Format on the stack, only the cached string is written and it keeps its capacity
+	TStringBuilder<2048> Builder;
 
 	bool bHasData = false;
 
 	int Idx = 0;
-	for (FGameplayDebuggerEntityOverheadCategory& Category : Categories) {
+	for (int32 CategoryIdx = Tile.FirstCategory; CategoryIdx != INDEX_NONE; CategoryIdx = Categories[CategoryIdx].NextCategory) {
+		const FGameplayDebuggerEntityOverheadCategory& Category = Categories[CategoryIdx];
 		if (Idx > 0) {
-			FullOutputString += "{(R=0,G=0,B=0,A=0)} - \n";
+			Builder << TEXT("{(R=0,G=0,B=0,A=0)} - \n");
 		}
 
-		FullOutputString += FString::Printf(TEXT("{yellow}%s\n"), *Category.Label);
+		Builder << TEXT("{yellow}") << GetText(Category.Label) << TEXT("\n");
 
 		bool bCategoryHasData = false;
 
-		for (FGameplayDebuggerEntityOverheadPair& Pair : Category.Pairs) {
+		for (int32 PairIdx = Category.FirstPair; PairIdx != INDEX_NONE; PairIdx = Pairs[PairIdx].NextPair) {
+			const FGameplayDebuggerEntityOverheadPair& Pair = Pairs[PairIdx];
 			switch (Pair.Type) {
 
 				case EGameplayDebuggerEntityOverheadPairType::RegularKeyValue: {
 					for (int i = 0; i < Pair.IndentLevel; ++i) {
-						FullOutputString += "    ";
-					}					
-					FullOutputString += FString::Printf(TEXT("{white}%s: {silver}%s\n"), *Pair.Label, *Pair.Value);
+						Builder << TEXT("    ");
+					}
+					Builder << TEXT("{white}") << GetText(Pair.Label) << TEXT(": {silver}") << GetText(Pair.Value) << TEXT("\n");
 					bHasData         = true;
 					bCategoryHasData = true;
 					break;
@@ -93,105 +162,96 @@ void FGameplayDebuggerEntityOverheadTiles::Print(const float ScreenX, const floa
 
 				case EGameplayDebuggerEntityOverheadPairType::Separator: {
 					if (bCategoryHasData)
-						FullOutputString += TEXT("{DimGrey}---------------------\n");
+						Builder << TEXT("{DimGrey}---------------------\n");
 					break;
 				}
 			}
-			
 		}
 
 		Idx++;
 	}
 
-	if (!bHasData) {
-		return;
+	Out.Reset();
+	if (bHasData) {
+		Out.Append(Builder.GetData(), Builder.Len());
 	}
+	return bHasData;
+}
 
-	float SizeX(0.f), SizeY(0.f);
-	CanvasContext->MeasureString(FullOutputString, SizeX, SizeY);
-	float PrintX = ScreenX - (SizeX * 0.5f);
-	float PrintY = ScreenY - (SizeY * 1.2f);
+void FGameplayDebuggerEntityOverheadTilesCollector::Draw(FGameplayDebuggerCanvasContext& CanvasContext, FGameplayDebuggerEntityOverheadTileCache& Cache) const {
+	FGameplayDebuggerCanvasContext WorldContext(CanvasContext);
+	WorldContext.Font = GEngine->GetSmallFont();
+	WorldContext.FontRenderInfo.bEnableShadow = true;
 
-	const FVector2D BackgroundPos  = FVector2D(PrintX - 5, PrintY - 5);
-	const FVector2D BackgroundSize = FVector2D(SizeX + 10, SizeY + 10);
+	const uint64 Frame = GFrameCounter;
 
-	FCanvasTileItem Background(FVector2D(0.0f), BackgroundSize, FLinearColor(0.1, 0.1, 0.1, 0.8));
-	Background.BlendMode = SE_BLEND_Translucent;
+	for (const FGameplayDebuggerEntityOverheadTiles& Tile : WorldTiles) {
+		if (!WorldContext.IsLocationVisible(Tile.WorldPos))
+			continue;
 
-	CanvasContext->DrawItem(Background, BackgroundPos.X, BackgroundPos.Y);
-	CanvasContext->PrintAt(PrintX, PrintY, FullOutputString);
-}
+		// Rebuild text and measure only when the tile content changed since it was cached
+		FGameplayDebuggerEntityOverheadTileCache::FEntry& Entry = Cache.Entries.FindOrAdd(Tile.Key);
+		const uint32 Hash = HashTile(Tile);
+		if (Entry.LastUsedFrame == 0 || Entry.Hash != Hash) {
+			Entry.Hash = Hash;
+			Entry.SizeX = Entry.SizeY = 0.f;
+			if (BuildTileText(Tile, Entry.Text)) {
+				WorldContext.MeasureString(Entry.Text, Entry.SizeX, Entry.SizeY);
+			}
+		}
+		Entry.LastUsedFrame = Frame;
 
-FGameplayDebuggerEntityOverheadTiles& FGameplayDebuggerEntityOverheadTilesCollector::Add(const FVector& WorldPos) {
-	auto Tile = WorldTiles.FindByPredicate([&WorldPos](const FGameplayDebuggerEntityOverheadTiles& Tile) {
-		return Tile.WorldPos == WorldPos;
-	});
-	if (!Tile) {
-		return WorldTiles.Add_GetRef(FGameplayDebuggerEntityOverheadTiles(this, WorldPos));
-	}
+		if (Entry.Text.IsEmpty()) {
+			continue;
+		}
 
-	return *Tile;
-}
+		const FVector2D ScreenPos = WorldContext.ProjectLocation(Tile.WorldPos);
+		const float PrintX = ScreenPos.X - (Entry.SizeX * 0.5f);
+		const float PrintY = ScreenPos.Y - (Entry.SizeY * 1.2f);
 
-void FGameplayDebuggerEntityOverheadTilesCollector::Draw() {
-	for (FGameplayDebuggerEntityOverheadTiles& Tile : WorldTiles) {
-		if (!CanvasContext->IsLocationVisible(Tile.WorldPos))
-			continue;
+		const FVector2D BackgroundPos  = FVector2D(PrintX - 5, PrintY - 5);
+		const FVector2D BackgroundSize = FVector2D(Entry.SizeX + 10, Entry.SizeY + 10);
+
+		FCanvasTileItem Background(FVector2D(0.0f), BackgroundSize, FLinearColor(0.1, 0.1, 0.1, 0.8));
+		Background.BlendMode = SE_BLEND_Translucent;
 
-		Tile.Print(Tile.ScreenPos.X, Tile.ScreenPos.Y);
+		WorldContext.DrawItem(Background, BackgroundPos.X, BackgroundPos.Y);
+		WorldContext.PrintAt(PrintX, PrintY, Entry.Text);
 	}
-}
 
-void FGameplayDebuggerEntityOverheadTilesCollector::From(const FGameplayDebuggerEntityOverheadTilesCollector& Collector) {
-	for (FGameplayDebuggerEntityOverheadTiles WorldTile : Collector.WorldTiles) {
-		auto& ThisTile = Add(WorldTile.WorldPos);
-		for (FGameplayDebuggerEntityOverheadCategory C : WorldTile.Categories) {
-			auto& ThisCategory = ThisTile.Category(C.Label);
-			for (FGameplayDebuggerEntityOverheadPair Pair : C.Pairs) {
-				ThisCategory << MoveTemp(Pair);
+	// Drop entries for tiles that left the view, checked about once a second
+	constexpr uint64 EvictAfterFrames = 60;
+	if (Frame - Cache.LastEvictFrame >= EvictAfterFrames) {
+		Cache.LastEvictFrame = Frame;
+		for (auto It = Cache.Entries.CreateIterator(); It; ++It) {
+			if (Frame - It.Value().LastUsedFrame > EvictAfterFrames) {
+				It.RemoveCurrent();
 			}
 		}
 	}
 }
+
 void FGameplayDebuggerEntityOverheadTilesCollector::Serialize(FArchive& Ar) {
+	Text.BulkSerialize(Ar);
+
 	int32 NumTiles = WorldTiles.Num();
 	Ar << NumTiles;
 
 	if (Ar.IsLoading()) {
 		WorldTiles.SetNum(NumTiles);
+		TileLookup.Reset();
 	}
 
 	for (int32 Idx = 0; Idx < NumTiles; Idx++) {
 		if (Ar.IsLoading()) {
-			WorldTiles[Idx].Collector     = this;
-			WorldTiles[Idx].CanvasContext = &WorldContext;
-			WorldTiles[Idx].CategoryInst  = Category;
+			WorldTiles[Idx].Collector = this;
 		}
 		WorldTiles[Idx].Serialize(Ar);
+		if (Ar.IsLoading()) {
+			TileLookup.Add(WorldTiles[Idx].Key, Idx);
+		}
 	}
 
-}
-
-void FGameplayDebuggerEntityOverheadCategory::Serialize(FArchive& Ar) {
-	Ar << Label;
-	Ar << ActiveIndentLevel;
-
-	int32 NumPairs = Pairs.Num();
-	Ar << NumPairs;
-
-	if (Ar.IsLoading()) {
-		Pairs.SetNum(NumPairs);
-	}
-
-	for (int32 Idx = 0; Idx < NumPairs; Idx++) {
-		Ar << Pairs[Idx];
-	}
-}
-
-void FGameplayDebuggerEntityOverheadTiles::Serialize(FArchive& Ar) {
-	Ar << WorldPos;
-	Ar << ScreenPos;
-
 	int32 NumCategories = Categories.Num();
 	Ar << NumCategories;
 
@@ -201,8 +261,25 @@ void FGameplayDebuggerEntityOverheadTiles::Serialize(FArchive& Ar) {
 
 	for (int32 Idx = 0; Idx < NumCategories; Idx++) {
 		if (Ar.IsLoading()) {
-			Categories[Idx].Info = this;
+			Categories[Idx].Collector = this;
 		}
 		Categories[Idx].Serialize(Ar);
 	}
+
+	Ar << Pairs;
+}
+
+void FGameplayDebuggerEntityOverheadCategory::Serialize(FArchive& Ar) {
+	Ar << Label;
+	Ar << FirstPair;
+	Ar << LastPair;
+	Ar << NextCategory;
+	Ar << ActiveIndentLevel;
+}
+
+void FGameplayDebuggerEntityOverheadTiles::Serialize(FArchive& Ar) {
+	Ar << WorldPos;
+	Ar << Key;
+	Ar << FirstCategory;
+	Ar << LastCategory;
 }
@@ -5,6 +5,87 @@
 #include "Components/LineBatchComponent.h"
 #include "Engine/World.h"
 
+namespace RogueLineShapes
+{
+	constexpr int32 MinSegments = 4;
+	constexpr int32 MaxSegments = 64;
+
+	/** Segment counts snap to the template buckets 4, 8, 16, 32 and 64 */
+	int32 SnapSegments(const int32 Segments)
+	{
+		const uint32 Clamped = static_cast<uint32>(FMath::Clamp(Segments, MinSegments, MaxSegments));
+		return static_cast<int32>(FMath::RoundUpToPowerOfTwo(Clamped));
+	}
+
+	int32 BucketIndex(const int32 SnappedSegments)
+	{
+		return static_cast<int32>(FMath::FloorLog2(static_cast<uint32>(SnappedSegments))) - 2;
+	}
+
+	/** Cos/sin around the unit circle, Segments + 1 points so the last one closes the ring */
+	TArray<FVector2D> MakeUnitRing(const int32 Segments)
+	{
+		TArray<FVector2D> Ring;
+		Ring.Reserve(Segments + 1);
+		const double AngleStep = 2.0 * UE_DOUBLE_PI / Segments;
+		for (int32 i = 0; i <= Segments; ++i)
+		{
+			double Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, AngleStep * (i % Segments));
+			Ring.Emplace(Cos, Sin);
+		}
+		return Ring;
+	}
+
+	/** Unit sphere as line endpoint pairs, same latitude/longitude layout DrawSphere always used */
+	TArray<FVector> MakeUnitSphere(const int32 Segments)
+	{
+		const TArray<FVector2D> Ring = MakeUnitRing(Segments);
+
+		TArray<FVector> Points;
+		Points.Reserve(Segments * Segments * 4);
+		for (int32 Y = 0; Y < Segments; ++Y)
+		{
+			const FVector2D& Lat1 = Ring[Y];
+			const FVector2D& Lat2 = Ring[Y + 1];
+			FVector Vertex1(Lat1.Y, 0.0, Lat1.X);
+			FVector Vertex3(Lat2.Y, 0.0, Lat2.X);
+			for (int32 X = 1; X <= Segments; ++X)
+			{
+				const FVector2D& Lon = Ring[X];
+				const FVector Vertex2(Lon.X * Lat1.Y, Lon.Y * Lat1.Y, Lat1.X);
+				const FVector Vertex4(Lon.X * Lat2.Y, Lon.Y * Lat2.Y, Lat2.X);
+				Points.Add(Vertex1);
+				Points.Add(Vertex2);
+				Points.Add(Vertex1);
+				Points.Add(Vertex3);
+				Vertex1 = Vertex2;
+				Vertex3 = Vertex4;
+			}
+		}
+		return Points;
+	}
+
+	TConstArrayView<FVector2D> GetUnitRing(const int32 SnappedSegments)
+	{
+		static const TArray<FVector2D> Rings[] = { MakeUnitRing(4), MakeUnitRing(8), MakeUnitRing(16), MakeUnitRing(32), MakeUnitRing(64) };
+		return Rings[BucketIndex(SnappedSegments)];
+	}
+
+	TConstArrayView<FVector> GetUnitSphere(const int32 SnappedSegments)
+	{
+		static const TArray<FVector> Spheres[] = { MakeUnitSphere(4), MakeUnitSphere(8), MakeUnitSphere(16), MakeUnitSphere(32), MakeUnitSphere(64) };
+		return Spheres[BucketIndex(SnappedSegments)];
+	}
+
+	FORCEINLINE FVector StoreVector(const VectorRegister4Double& Vec)
+	{
+		FVector Out;
+		VectorStoreFloat3(Vec, &Out.X);
+		return Out;
+	}
+}
+
 FLineBatchProxy::FLineBatchProxy(float DefaultThickness): CurrentThickness(DefaultThickness) {}
 
 FLineBatchProxy::FLineBatchProxy(const UWorld* World, float DefaultThickness) {
@@ -18,7 +99,56 @@ FLineBatchProxy::FLineBatchProxy(ULineBatchComponent* InLineBatcher, float Defau
 	LineBatcher = InLineBatcher;
 }
 
+FLineBatchProxy::FLineBatchProxy(FLineBatchProxy&& Other)
+	: BatchID(Other.BatchID),
+	  LineBatcher(Other.LineBatcher),
+	  DepthPriority(Other.DepthPriority),
+	  CurrentColor(Other.CurrentColor),
+	  CurrentThickness(Other.CurrentThickness),
+	  LifeTime(Other.LifeTime),
+	  QueuedLines(MoveTemp(Other.QueuedLines)),
+	  ExternalLines(Other.ExternalLines) {
+	// The moved from proxy keeps nothing to flush
+	Other.QueuedLines.Reset();
+	Other.ExternalLines = nullptr;
+}
+
+FLineBatchProxy& FLineBatchProxy::operator=(FLineBatchProxy&& Other) {
+	if (this == &Other)
+		return *this;
+
+	// Lines queued here belong to the old batcher
+	Flush();
+	BatchID = Other.BatchID;
+	LineBatcher = Other.LineBatcher;
+	DepthPriority = Other.DepthPriority;
+	CurrentColor = Other.CurrentColor;
+	CurrentThickness = Other.CurrentThickness;
+	LifeTime = Other.LifeTime;
+	QueuedLines = MoveTemp(Other.QueuedLines);
+	ExternalLines = Other.ExternalLines;
+	Other.QueuedLines.Reset();
+	Other.ExternalLines = nullptr;
+	return *this;
+}
+
+FLineBatchProxy& FLineBatchProxy::WithArena(TArray<FBatchedLine>& InLines) {
+	Flush();
+	ExternalLines = &InLines;
+	return *this;
+}
+
+void FLineBatchProxy::Flush() {
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	if (LineBatcher && Arena.Num() > 0) {
+		LineBatcher->DrawLines(Arena);
+	}
+	Arena.Reset();
+}
+
 FLineBatchProxy& FLineBatchProxy::Persistent(float InLifeTime) {
+	// Queued lines belong to the current batcher
+	Flush();
 	LifeTime = InLifeTime;
 	if (LineBatcher) {
 		LineBatcher = LineBatcher->GetWorld()->GetLineBatcher(UWorld::ELineBatcherType::WorldPersistent);
@@ -27,6 +157,7 @@ FLineBatchProxy& FLineBatchProxy::Persistent(float InLifeTime) {
 }
 
 FLineBatchProxy& FLineBatchProxy::Foreground() {
+	Flush();
 	LifeTime = 0.0f;
 	if (LineBatcher) {
 		LineBatcher = LineBatcher->GetWorld()->GetLineBatcher(UWorld::ELineBatcherType::Foreground);
@@ -194,54 +325,28 @@ FLineBatchProxy& FLineBatchProxy::DrawBoundingBox(const FBox& Box) {
 }
 
 FLineBatchProxy& FLineBatchProxy::DrawSphere(const FVector& Center, float Radius, int32 Segments) {
-	// Need at least 4 segments
-	Segments = FMath::Max(Segments, 4);
-
-	const float AngleInc = 2.f * UE_PI / Segments;
-	int32 NumSegmentsY = Segments;
-	float Latitude = AngleInc;
-	float SinY1 = 0.0f;
-	float CosY1 = 1.0f;
-
-	TArray<FBatchedLine> Lines;
-	Lines.Empty(NumSegmentsY * Segments * 2);
-
-	while (NumSegmentsY--) {
-		const float SinY2 = FMath::Sin(Latitude);
-		const float CosY2 = FMath::Cos(Latitude);
-
-		FVector Vertex1 = FVector(SinY1, 0.0f, CosY1) * Radius + Center;
-		FVector Vertex3 = FVector(SinY2, 0.0f, CosY2) * Radius + Center;
-		float Longitude = AngleInc;
-
-		int32 NumSegmentsX = Segments;
-		while (NumSegmentsX--) {
-			const float SinX = FMath::Sin(Longitude);
-			const float CosX = FMath::Cos(Longitude);
+	if (!LineBatcher) return *this;
 
-			const FVector Vertex2 = FVector((CosX * SinY1), (SinX * SinY1), CosY1) * Radius + Center;
-			const FVector Vertex4 = FVector((CosX * SinY2), (SinX * SinY2), CosY2) * Radius + Center;
+	const TConstArrayView<FVector> UnitSphere = RogueLineShapes::GetUnitSphere(RogueLineShapes::SnapSegments(Segments));
 
-			Lines.Emplace(Vertex1, Vertex2, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-			Lines.Emplace(Vertex1, Vertex3, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+	const VectorRegister4Double VCenter = VectorLoadFloat3(&Center.X);
+	const VectorRegister4Double VRadius = VectorSetFloat1(static_cast<double>(Radius));
 
-			Vertex1 = Vertex2;
-			Vertex3 = Vertex4;
-			Longitude += AngleInc;
-		}
-
-		SinY1 = SinY2;
-		CosY1 = CosY2;
-		Latitude += AngleInc;
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	Arena.Reserve(Arena.Num() + UnitSphere.Num() / 2);
+	for (int32 i = 0; i < UnitSphere.Num(); i += 2) {
+		const FVector Start = RogueLineShapes::StoreVector(VectorMultiplyAdd(VectorLoadFloat3(&UnitSphere[i].X), VRadius, VCenter));
+		const FVector End = RogueLineShapes::StoreVector(VectorMultiplyAdd(VectorLoadFloat3(&UnitSphere[i + 1].X), VRadius, VCenter));
+		Arena.Emplace(Start, End, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 	}
 
-	QueueLineDraw(Lines);
-
 	return *this;
 }
 
 FLineBatchProxy& FLineBatchProxy::DrawCone(const FVector& Origin, const FVector& Direction, float Length, float AngleWidth, float AngleHeight, int32 NumSides) {
-	TArray<FBatchedLine> Lines;
+	if (!LineBatcher) return *this;
+
+	TArray<FBatchedLine>& Arena = GetLineArena();
 
 	NumSides = FMath::Max(NumSides, 4);
 
@@ -254,7 +359,7 @@ FLineBatchProxy& FLineBatchProxy::DrawCone(const FVector& Origin, const FVector&
 	const float SinSqX_2 = SinX_2 * SinX_2;
 	const float SinSqY_2 = SinY_2 * SinY_2;
 
-	TArray<FVector> ConeVerts;
+	TArray<FVector, TInlineAllocator<64>> ConeVerts;
 	ConeVerts.AddUninitialized(NumSides);
 
 	for (int32 i = 0; i < NumSides; i++) {
@@ -284,13 +389,14 @@ FLineBatchProxy& FLineBatchProxy::DrawCone(const FVector& Origin, const FVector&
 	const FMatrix ConeToWorld = FScaleMatrix(FVector(Length)) * FMatrix(DirectionNorm, YAxis, ZAxis, Origin);
 
 	FVector CurrentPoint, PrevPoint, FirstPoint;
+	Arena.Reserve(Arena.Num() + NumSides * 2 + 1);
 	for (int32 i = 0; i < NumSides; i++) {
 		CurrentPoint = ConeToWorld.TransformPosition(ConeVerts[i]);
-		Lines.Emplace(ConeToWorld.GetOrigin(), CurrentPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+		Arena.Emplace(ConeToWorld.GetOrigin(), CurrentPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 
 		// PrevPoint must be defined to draw junctions
 		if (i > 0) {
-			Lines.Emplace(PrevPoint, CurrentPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+			Arena.Emplace(PrevPoint, CurrentPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 		} else {
 			FirstPoint = CurrentPoint;
 		}
@@ -298,17 +404,17 @@ FLineBatchProxy& FLineBatchProxy::DrawCone(const FVector& Origin, const FVector&
 		PrevPoint = CurrentPoint;
 	}
 	// Connect last junction to first
-	Lines.Emplace(CurrentPoint, FirstPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-
-	QueueLineDraw(Lines);
+	Arena.Emplace(CurrentPoint, FirstPoint, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 
 	return *this;
 }
 
 FLineBatchProxy& FLineBatchProxy::DrawCapsule(const FVector& Center, float HalfHeight, float Radius, const FQuat& Rotation) {
-	TArray<FBatchedLine> Lines;
+	if (!LineBatcher) return *this;
 
 	constexpr int32 DrawCollisionSides = 16;
+	const TConstArrayView<FVector2D> Ring = RogueLineShapes::GetUnitRing(DrawCollisionSides);
+
 	const FVector Origin = Center;
 	const FMatrix Axes = FQuatRotationTranslationMatrix(Rotation, FVector::ZeroVector);
 	const FVector XAxis = Axes.GetScaledAxis(EAxis::X);
@@ -320,25 +426,26 @@ FLineBatchProxy& FLineBatchProxy::DrawCapsule(const FVector& Center, float HalfH
 	const FVector TopEnd = Origin + HalfAxis * ZAxis;
 	const FVector BottomEnd = Origin - HalfAxis * ZAxis;
 
-	AddCircle(Lines, TopEnd, XAxis, YAxis, Radius, DrawCollisionSides);
-	AddCircle(Lines, BottomEnd, XAxis, YAxis, Radius, DrawCollisionSides);
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	Arena.Reserve(Arena.Num() + DrawCollisionSides * 4 + 4);
+
+	AppendRing(TopEnd, XAxis, YAxis, Radius, Ring, DrawCollisionSides);
+	AppendRing(BottomEnd, XAxis, YAxis, Radius, Ring, DrawCollisionSides);
 
 	// Draw domed caps
-	AddHalfCircle(Lines, TopEnd, YAxis, ZAxis, Radius, DrawCollisionSides);
-	AddHalfCircle(Lines, TopEnd, XAxis, ZAxis, Radius, DrawCollisionSides);
+	AppendRing(TopEnd, YAxis, ZAxis, Radius, Ring, DrawCollisionSides / 2);
+	AppendRing(TopEnd, XAxis, ZAxis, Radius, Ring, DrawCollisionSides / 2);
 
 	const FVector NegZAxis = -ZAxis;
 
-	AddHalfCircle(Lines, BottomEnd, YAxis, NegZAxis, Radius, DrawCollisionSides);
-	AddHalfCircle(Lines, BottomEnd, XAxis, NegZAxis, Radius, DrawCollisionSides);
+	AppendRing(BottomEnd, YAxis, NegZAxis, Radius, Ring, DrawCollisionSides / 2);
+	AppendRing(BottomEnd, XAxis, NegZAxis, Radius, Ring, DrawCollisionSides / 2);
 
 	// Draw connected lines
-	Lines.Emplace(TopEnd + Radius * XAxis, BottomEnd + Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-	Lines.Emplace(TopEnd - Radius * XAxis, BottomEnd - Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-	Lines.Emplace(TopEnd + Radius * XAxis, BottomEnd + Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-	Lines.Emplace(TopEnd - Radius * XAxis, BottomEnd - Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
-
-	QueueLineDraw(Lines);
+	Arena.Emplace(TopEnd + Radius * XAxis, BottomEnd + Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+	Arena.Emplace(TopEnd - Radius * XAxis, BottomEnd - Radius * XAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+	Arena.Emplace(TopEnd + Radius * YAxis, BottomEnd + Radius * YAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+	Arena.Emplace(TopEnd - Radius * YAxis, BottomEnd - Radius * YAxis, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 
 	return *this;
 }
@@ -356,32 +463,24 @@ FLineBatchProxy& FLineBatchProxy::DrawCircle(FVector Center, float Radius, int32
 }
 
 FLineBatchProxy& FLineBatchProxy::DrawCircle(const FMatrix& TransformMatrix, float Radius, int32 Segments, bool bDrawAxis) {
-	Segments = FMath::Max(Segments, 4);
+	if (!LineBatcher) return *this;
 
-	const float AngleStep = 2.f * UE_PI / static_cast<float>(Segments);
+	Segments = RogueLineShapes::SnapSegments(Segments);
 
 	const FVector Center = TransformMatrix.GetOrigin();
 	const FVector AxisY = TransformMatrix.GetScaledAxis(EAxis::Y);
 	const FVector AxisZ = TransformMatrix.GetScaledAxis(EAxis::Z);
 
-	TArray<FBatchedLine> Lines;
-	Lines.Empty(Segments);
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	Arena.Reserve(Arena.Num() + Segments + 2);
 
-	float Angle = 0.f;
-	while (Segments--) {
-		const FVector Vertex1 = Center + Radius * (AxisY * FMath::Cos(Angle) + AxisZ * FMath::Sin(Angle));
-		Angle += AngleStep;
-		const FVector Vertex2 = Center + Radius * (AxisY * FMath::Cos(Angle) + AxisZ * FMath::Sin(Angle));
-		Lines.Add(FBatchedLine(Vertex1, Vertex2, CurrentColor, LifeTime, CurrentThickness, DepthPriority));
-	}
+	AppendRing(Center, AxisY, AxisZ, Radius, RogueLineShapes::GetUnitRing(Segments), Segments);
 
 	if (bDrawAxis) {
-		Lines.Add(FBatchedLine(Center - Radius * AxisY, Center + Radius * AxisY, CurrentColor, LifeTime, CurrentThickness, DepthPriority));
-		Lines.Add(FBatchedLine(Center - Radius * AxisZ, Center + Radius * AxisZ, CurrentColor, LifeTime, CurrentThickness, DepthPriority));
+		Arena.Emplace(Center - Radius * AxisY, Center + Radius * AxisY, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
+		Arena.Emplace(Center - Radius * AxisZ, Center + Radius * AxisZ, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 	}
 
-	QueueLineDraw(Lines);
-
 	return *this;
 }
 
@@ -727,16 +826,16 @@ FLineBatchProxy& FLineBatchProxy::DrawLines(TArrayView<FBatchedLine> InLines) {
 }
 
 FLineBatchProxy& FLineBatchProxy::DrawLines(TArrayView<FPartialLine> InLines, uint32 InBatchID) {
+	if (!LineBatcher) return *this;
+
 	const uint32 BIDToUse = FMath::Max(InBatchID, BatchID);
 
-	TArray<FBatchedLine> BatchedLines;
-	BatchedLines.Reserve(InLines.Num());
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	Arena.Reserve(Arena.Num() + InLines.Num());
 	for (const FPartialLine& Line : InLines) {
-		BatchedLines.Emplace(Line.Start, Line.End, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BIDToUse);
+		Arena.Emplace(Line.Start, Line.End, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BIDToUse);
 	}
 
-	QueueLineDraw(BatchedLines);
-
 	return *this;
 }
 
@@ -746,40 +845,32 @@ void FLineBatchProxy::QueueLineDraw(const FVector& Start, const FVector& End) {
 
 void FLineBatchProxy::QueueLineDraw(const FBatchedLine& Line) {
 	if (!LineBatcher) return;
-	LineBatcher->DrawLine(Line.Start, Line.End, Line.Color, Line.DepthPriority, Line.Thickness, Line.RemainingLifeTime, Line.BatchID);
+	GetLineArena().Add(Line);
 }
 
 void FLineBatchProxy::QueueLineDraw(TArrayView<FBatchedLine> InLines) {
 	if (!LineBatcher) return;
-	LineBatcher->DrawLines(InLines);
+	GetLineArena().Append(InLines.GetData(), InLines.Num());
 }
 
-FLineBatchProxy& FLineBatchProxy::AddHalfCircle(TArray<FBatchedLine>& LineQueue, const FVector& Base, const FVector& X, const FVector& Y, const float Radius, int32 NumSides) {
-	// Need at least 2 sides
-	NumSides = FMath::Max(NumSides, 2);
-	const float AngleDelta = 2.0f * UE_PI / NumSides;
-	FVector LastVertex = Base + X * Radius;
+void FLineBatchProxy::AppendRing(const FVector& Base, const FVector& X, const FVector& Y, const float Radius, TConstArrayView<FVector2D> Ring, const int32 NumSegments) {
+	check(NumSegments < Ring.Num());
 
-	for (int32 SideIndex = 0; SideIndex < (NumSides / 2); SideIndex++) {
-		FVector Vertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
-		LineQueue.Add(FBatchedLine(LastVertex, Vertex, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID));
-		LastVertex = Vertex;
-	}
-
-	return *this;
-}
+	// Base + (X * Cos + Y * Sin) * Radius with the radius folded into the axes up front
+	const VectorRegister4Double VRadius = VectorSetFloat1(static_cast<double>(Radius));
+	const VectorRegister4Double VBase = VectorLoadFloat3(&Base.X);
+	const VectorRegister4Double VX = VectorMultiply(VectorLoadFloat3(&X.X), VRadius);
+	const VectorRegister4Double VY = VectorMultiply(VectorLoadFloat3(&Y.X), VRadius);
 
-FLineBatchProxy& FLineBatchProxy::AddCircle(TArray<FBatchedLine>& LineQueue, const FVector& Base, const FVector& X, const FVector& Y, const float Radius, int32 NumSides) {
-	// Need at least 2 sides
-	NumSides = FMath::Max(NumSides, 2);
-	const float AngleDelta = 2.0f * UE_PI / NumSides;
-	FVector LastVertex = Base + X * Radius;
+	auto RingPoint = [&](const FVector2D& P) {
+		return RogueLineShapes::StoreVector(VectorMultiplyAdd(VX, VectorSetFloat1(P.X), VectorMultiplyAdd(VY, VectorSetFloat1(P.Y), VBase)));
+	};
 
-	for (int32 SideIndex = 0; SideIndex < NumSides; SideIndex++) {
-		const FVector Vertex = Base + (X * FMath::Cos(AngleDelta * (SideIndex + 1)) + Y * FMath::Sin(AngleDelta * (SideIndex + 1))) * Radius;
-		LineQueue.Add(FBatchedLine(LastVertex, Vertex, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID));
+	TArray<FBatchedLine>& Arena = GetLineArena();
+	FVector LastVertex = RingPoint(Ring[0]);
+	for (int32 SideIndex = 1; SideIndex <= NumSegments; SideIndex++) {
+		const FVector Vertex = RingPoint(Ring[SideIndex]);
+		Arena.Emplace(LastVertex, Vertex, CurrentColor, LifeTime, CurrentThickness, DepthPriority, BatchID);
 		LastVertex = Vertex;
 	}
-
-	return *this;
-}
\ No newline at end of file
+}
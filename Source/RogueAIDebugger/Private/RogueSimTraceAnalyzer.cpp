@@ -0,0 +1,186 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RogueSimTraceAnalyzer.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Simulation/RogueSimTrace.h"
+
+DEFINE_LOG_CATEGORY(LogRogueSimTrace);
+
+namespace RogueSimTraceAnalyzer
+{
+	constexpr int32 NumEventTypes = static_cast<int32>(ERogueSimTraceEvent::PoolReturn) + 1;
+	
+	const TCHAR* GetEventName(const int32 Type)
+	{
+		static const TCHAR* Names[NumEventTypes] = {
+			TEXT("TrainArrive"), TEXT("TrainDepart"), TEXT("Board"), TEXT("Alight"), TEXT("SlotClaim"),
+			TEXT("SlotRelease"), TEXT("Spawn"), TEXT("PoolReuse"), TEXT("PoolReturn")
+		};
+		return (Type >= 0 && Type < NumEventTypes) ? Names[Type] : TEXT("Unknown");
+	}
+}
+
+void FRogueSimTraceAnalyzer::OnAnalysisBegin(const FOnAnalysisContext& Context)
+{
+	Context.InterfaceBuilder.RouteEvent(RouteId_Event, "RogueSim", "Event");
+
+	Trains.Reset();
+	Stations.Reset();
+	EventCounts.Init(0, RogueSimTraceAnalyzer::NumEventTypes);
+	DwellHistogram.Init(0, NumDwellBins);
+	FirstTime = -1.0;
+	LastTime = 0.0;
+}
+
+bool FRogueSimTraceAnalyzer::OnEvent(const uint16 RouteId, EStyle Style, const FOnEventContext& Context)
+{
+	if (RouteId != RouteId_Event) return true;
+
+	const FEventData& EventData = Context.EventData;
+	const uint8 Type = EventData.GetValue<uint8>("Type");
+	const double Time = EventData.GetValue<float>("SimTime");
+	const uint32 Entity = EventData.GetValue<uint32>("Entity");
+	const uint32 Other = EventData.GetValue<uint32>("Other");
+	const int32 Value = EventData.GetValue<int32>("Value");
+
+	if (FirstTime < 0.0) FirstTime = Time;
+	LastTime = FMath::Max(LastTime, Time);
+	if (EventCounts.IsValidIndex(Type)) ++EventCounts[Type];
+
+	switch (static_cast<ERogueSimTraceEvent>(Type))
+	{
+		case ERogueSimTraceEvent::TrainArrive:
+		{
+			FStop& Stop = Trains.FindOrAdd(Entity).Stops.AddDefaulted_GetRef();
+			Stop.Station = Other;
+			Stop.StationIdx = Value;
+			Stop.ArriveTime = Time;
+
+			FStationTimeline& Station = Stations.FindOrAdd(Other);
+			Station.StationIdx = Value;
+			Station.Arrivals.Add(Time);
+		}
+		break;
+		case ERogueSimTraceEvent::TrainDepart:
+		{
+			// Close the open stop at this station, a train first seen departing started docked
+			FTrainTimeline& Train = Trains.FindOrAdd(Entity);
+			if (Train.Stops.Num() > 0 && Train.Stops.Last().Station == Other && Train.Stops.Last().DepartTime < 0.0)
+			{
+				FStop& Stop = Train.Stops.Last();
+				Stop.DepartTime = Time;
+				
+				const int32 Bin = FMath::Clamp(FMath::FloorToInt32((Stop.DepartTime - Stop.ArriveTime) / DwellBinSeconds), 0, NumDwellBins - 1);
+				++DwellHistogram[Bin];
+			}
+		}
+		break;
+		case ERogueSimTraceEvent::SlotClaim: UpdateQueue(Stations.FindOrAdd(Other), Time, 1);
+			break;
+		case ERogueSimTraceEvent::SlotRelease: UpdateQueue(Stations.FindOrAdd(Other), Time, -1);
+			break;
+		default: break;
+	}
+	
+	return true;
+}
+
+void FRogueSimTraceAnalyzer::UpdateQueue(FStationTimeline& Station, const double Time, const int32 Delta)
+{
+	// Time weighted queue length, the first sample only starts the clock
+	if (Station.QueueSamples.Num() > 0)
+	{
+		Station.QueueIntegral += Station.QueueLength * (Time - Station.LastQueueTime);
+	}
+	
+	Station.LastQueueTime = Time;
+	Station.QueueLength = FMath::Max(0, Station.QueueLength + Delta);
+	Station.MaxQueueLength = FMath::Max(Station.MaxQueueLength, Station.QueueLength);
+	Station.QueueSamples.Emplace(Time, Station.QueueLength);
+}
+
+void FRogueSimTraceAnalyzer::OnAnalysisEnd()
+{
+	// Carry queue lengths to the end of the capture
+	for (TPair<uint32, FStationTimeline>& Pair : Stations)
+	{
+		FStationTimeline& Station = Pair.Value;
+		if (Station.QueueSamples.Num() > 0)
+		{
+			Station.QueueIntegral += Station.QueueLength * (LastTime - Station.LastQueueTime);
+			Station.LastQueueTime = LastTime;
+		}
+	}
+}
+
+bool FRogueSimTraceAnalyzer::WriteReport(const FString& OutDir) const
+{
+	const double Duration = FMath::Max(0.0, LastTime - FirstTime);
+
+	FString TrainsCsv = TEXT("Train,Station,StationIdx,Arrive,Depart,Dwell\n");
+	for (const TPair<uint32, FTrainTimeline>& Pair : Trains)
+	{
+		for (const FStop& Stop : Pair.Value.Stops)
+		{
+			const double Dwell = Stop.DepartTime >= 0.0 ? Stop.DepartTime - Stop.ArriveTime : -1.0;
+			TrainsCsv += FString::Printf(TEXT("%u,%u,%d,%.3f,%.3f,%.3f\n"), Pair.Key, Stop.Station, Stop.StationIdx, Stop.ArriveTime, Stop.DepartTime, Dwell);
+		}
+	}
+
+	FString StationsCsv = TEXT("Station,StationIdx,Arrivals,AvgHeadway,MinHeadway,MaxHeadway,AvgQueue,MaxQueue\n");
+	FString QueuesCsv = TEXT("Station,Time,QueueLength\n");
+	for (const TPair<uint32, FStationTimeline>& Pair : Stations)
+	{
+		const FStationTimeline& Station = Pair.Value;
+
+		// Headway from successive arrivals of any train at this station
+		TArray<double> Arrivals = Station.Arrivals;
+		Arrivals.Sort();
+		double MinHeadway = 0.0, MaxHeadway = 0.0, TotalHeadway = 0.0;
+		for (int32 i = 1; i < Arrivals.Num(); ++i)
+		{
+			const double Headway = Arrivals[i] - Arrivals[i - 1];
+			MinHeadway = (i == 1) ? Headway : FMath::Min(MinHeadway, Headway);
+			MaxHeadway = FMath::Max(MaxHeadway, Headway);
+			TotalHeadway += Headway;
+		}
+		
+		const double AvgHeadway = Arrivals.Num() > 1 ? TotalHeadway / (Arrivals.Num() - 1) : 0.0;
+		const double QueueSpan = Station.QueueSamples.Num() > 0 ? Station.LastQueueTime - Station.QueueSamples[0].Key : 0.0;
+		const double AvgQueue = QueueSpan > 0.0 ? Station.QueueIntegral / QueueSpan : Station.QueueLength;
+
+		StationsCsv += FString::Printf(TEXT("%u,%d,%d,%.3f,%.3f,%.3f,%.2f,%d\n"), Pair.Key, Station.StationIdx, Arrivals.Num(),
+			AvgHeadway, MinHeadway, MaxHeadway, AvgQueue, Station.MaxQueueLength);
+		
+		for (const TPair<double, int32>& Sample : Station.QueueSamples)
+		{
+			QueuesCsv += FString::Printf(TEXT("%u,%.3f,%d\n"), Pair.Key, Sample.Key, Sample.Value);
+		}
+
+		UE_LOG(LogRogueSimTrace, Display, TEXT("Station %u (idx %d): arrivals %d, headway avg %.1fs min %.1fs max %.1fs, queue avg %.1f max %d"),
+			Pair.Key, Station.StationIdx, Arrivals.Num(), AvgHeadway, MinHeadway, MaxHeadway, AvgQueue, Station.MaxQueueLength);
+	}
+
+	FString DwellCsv = TEXT("DwellFrom,DwellTo,Stops\n");
+	for (int32 Bin = 0; Bin < DwellHistogram.Num(); ++Bin)
+	{
+		DwellCsv += FString::Printf(TEXT("%.1f,%.1f,%d\n"), Bin * DwellBinSeconds, (Bin + 1) * DwellBinSeconds, DwellHistogram[Bin]);
+		if (DwellHistogram[Bin] > 0)
+		{
+			UE_LOG(LogRogueSimTrace, Display, TEXT("Dwell %4.0f-%4.0fs: %d"), Bin * DwellBinSeconds, (Bin + 1) * DwellBinSeconds, DwellHistogram[Bin]);
+		}
+	}
+
+	for (int32 Type = 0; Type < EventCounts.Num(); ++Type)
+	{
+		UE_LOG(LogRogueSimTrace, Display, TEXT("%-12s %d"), RogueSimTraceAnalyzer::GetEventName(Type), EventCounts[Type]);
+	}
+	UE_LOG(LogRogueSimTrace, Display, TEXT("Trace covers %.1fs of simulation, %d trains, %d stations"), Duration, Trains.Num(), Stations.Num());
+
+	return FFileHelper::SaveStringToFile(TrainsCsv, *(OutDir / TEXT("Trains.csv")))
+		&& FFileHelper::SaveStringToFile(StationsCsv, *(OutDir / TEXT("Stations.csv")))
+		&& FFileHelper::SaveStringToFile(QueuesCsv, *(OutDir / TEXT("StationQueues.csv")))
+		&& FFileHelper::SaveStringToFile(DwellCsv, *(OutDir / TEXT("DwellHistogram.csv")));
+}
@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RogueSimTraceCommandlet.h"
+#include "RogueSimTraceAnalyzer.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Trace/Analysis.h"
+#include "Trace/DataStream.h"
+
+URogueSimTraceCommandlet::URogueSimTraceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 URogueSimTraceCommandlet::Main(const FString& Params)
+{
+	FString TracePath;
+	if (!FParse::Value(*Params, TEXT("Trace="), TracePath))
+	{
+		UE_LOG(LogRogueSimTrace, Error, TEXT("Usage: -run=RogueSimTrace -Trace=<file.utrace> [-Out=<dir>]"));
+		return 1;
+	}
+
+	FString OutDir = FPaths::ProfilingDir() / TEXT("RogueSimTrace");
+	FParse::Value(*Params, TEXT("Out="), OutDir);
+
+	UE::Trace::FFileDataStream DataStream;
+	if (!DataStream.Open(*TracePath))
+	{
+		UE_LOG(LogRogueSimTrace, Error, TEXT("Could not open trace %s"), *TracePath);
+		return 1;
+	}
+
+	FRogueSimTraceAnalyzer Analyzer;
+	UE::Trace::FAnalysisContext AnalysisContext;
+	AnalysisContext.AddAnalyzer(Analyzer);
+	AnalysisContext.Process(DataStream).Wait();
+
+	if (Analyzer.GetTrains().IsEmpty() && Analyzer.GetStations().IsEmpty())
+	{
+		UE_LOG(LogRogueSimTrace, Warning, TEXT("No RogueSim events in %s, was it recorded with -trace=RogueSim?"), *TracePath);
+	}
+
+	IFileManager::Get().MakeDirectory(*OutDir, true);
+	if (!Analyzer.WriteReport(OutDir))
+	{
+		UE_LOG(LogRogueSimTrace, Error, TEXT("Failed to write report to %s"), *OutDir);
+		return 1;
+	}
+
+	UE_LOG(LogRogueSimTrace, Display, TEXT("Report written to %s"), *FPaths::ConvertRelativePathToFull(OutDir));
+	return 0;
+}
@@ -3,12 +3,14 @@
 #pragma once
 #include "AbilitySystemComponent.h"
 #include "AbilitySystemInterface.h"
+#include "RogueAIDebugDataPack.h"
 #include "RogueAIDebuggerEntityOverheadTiles.h"
 #include "Data/RogueEntityDebugData.h"
 
 #if WITH_GAMEPLAY_DEBUGGER
 
 #include "GameplayDebuggerCategory.h"
+#include "Components/LineBatchComponent.h"
 
 class URogueTrainWorldSubsystem;
 
@@ -21,11 +23,16 @@ public:
 
 	// FGameplayDebuggerCategory
 	virtual void CollectData(APlayerController* OwnerPC, AActor* DebugActor) override;
+	virtual void OnDataPackReplicated(int32 DataPackId) override;
+	virtual void OnGameplayDebuggerActivated() override;
+	bool EncodeDataPack();
+	void RebuildOverheads();
 	void CollectPassengerEntityData(); 
 	void CollectTrainEntityData(); 
 	void CollectCarriageEntityData(); 
 	void CollectStationEntityData(); 
 	void CollectTrackData();
+	void CollectPickedEntity(const FVector& ViewLocation, const FVector& ViewDirection);
 	static void GetPassengerEntityOverheadInfo(const FRogueDebugPassenger& DebugPassenger, FGameplayDebuggerEntityOverheadTiles& Info);
 	static void GetTrainEntityOverheadInfo(const FRogueDebugTrain& DebugTrain, FGameplayDebuggerEntityOverheadTiles& Info);
 	static void GetCarriageEntityOverheadInfo(const FRogueDebugCarriage& DebugCarriage, FGameplayDebuggerEntityOverheadTiles& Info);
@@ -38,6 +45,7 @@ public:
 	void OnToggleCarriageOverheads();
 	void OnToggleStationOverheads();
 	void OnToggleTrackOverheads();
+	void OnPickEntity();
 	void SaveAllSettings();
 	void SyncAllSettings();
 	void OnSettingsUpdated(UObject* Obj, struct FPropertyChangedEvent& Event);
@@ -48,17 +56,26 @@ protected:
 	bool bDrawCarriageOverheads = false;
 	bool bDrawStationOverheads = false;
 	bool bDrawTrackOverheads = false;
+	bool bPickRequested = false;
+	bool bPickArmed = false;
+	FMassEntityHandle PickedEntity;
 
 	FDelegateHandle SettingsUpdatedHandle;
 	FGameplayDebuggerEntityOverheadTilesCollector Collector;
+	FGameplayDebuggerEntityOverheadTileCache TileCache;
+	TArray<FBatchedLine> LineArena;
 
 	struct FRepData
 	{
-		FGameplayDebuggerEntityOverheadTilesCollector Collector;
+		// Delta pack written by FRogueDebugPackEncoder
+		TArray<uint8> Payload;
 		void Serialize(FArchive& Ar);
 	};
 
 	FRepData DataPack;
+	FRogueDebugPackEncoder PackEncoder;
+	FRogueDebugPackDecoder PackDecoder;
+	double LastCollectTime = -1.0;
 
 	URogueTrainWorldSubsystem* RogueTrainSubsystem;
 	
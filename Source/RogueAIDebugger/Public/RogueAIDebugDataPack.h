@@ -0,0 +1,108 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/RogueEntityDebugData.h"
+
+/**
+ * Binary encoding of the debug snapshots for the gameplay debugger data pack.
+ * Each row is quantized to a short list of integer fields (positions and distances in whole cm) keyed by entity.
+ * Every KeyframeInterval packs everything is written in full. The packs between carry the fields that differ from
+ * that keyframe as zigzag varint deltas, plus the keyframe keys that stopped being collected. Data pack replication
+ * only delivers the latest pack, so each delta is complete on its own and a viewer that skipped packs decodes the
+ * next one. Only a missed keyframe makes the viewer wait for the following one.
+ */
+namespace RogueDebugPack
+{
+	constexpr uint8 Version = 2;
+	constexpr uint32 KeyframeInterval = 64;
+
+	/** Snapshot kinds in pack order */
+	enum class EKind : uint8
+	{
+		Passenger,
+		Train,
+		Carriage,
+		Station,
+		Num
+	};
+	constexpr int32 NumKinds = static_cast<int32>(EKind::Num);
+}
+
+/** Server side, turns collected snapshot rows into delta packs */
+class ROGUEAIDEBUGGER_API FRogueDebugPackEncoder
+{
+public:
+	void BeginPack();
+	void Add(const FRogueDebugPassenger& Row);
+	void Add(const FRogueDebugTrain& Row);
+	void Add(const FRogueDebugCarriage& Row);
+	void Add(const FRogueDebugStation& Row);
+
+	/** Writes the pack into OutPayload. Returns false and leaves OutPayload untouched when it would decode to the previous pack */
+	bool EndPack(TArray<uint8>& OutPayload);
+
+	/** Write everything in full on the next pack */
+	void ForceKeyframe() { PacksSinceKeyframe = RogueDebugPack::KeyframeInterval; }
+
+private:
+	struct FBaseline
+	{
+		TArray<int32> Fields;
+		uint32 LastPackId = 0;
+	};
+
+	struct FKindState
+	{
+		// Rows as written in the last keyframe
+		TMap<uint64, FBaseline> Baselines;
+
+		// Rows added this pack, fields of row i are Fields[Offsets[i], Offsets[i + 1])
+		TArray<uint64> Keys;
+		TArray<int32> Offsets;
+		TArray<int32> Fields;
+
+		// Reused while writing
+		TArray<int32> ChangedRows;
+		TArray<uint64> RemovedKeys;
+	};
+
+	FKindState& BeginRow(const RogueDebugPack::EKind Kind, const FMassEntityHandle Entity);
+	void EndRow(FKindState& State);
+	void WriteKind(FKindState& State, const uint32 PackId, const bool bKeyframe);
+
+	FKindState Kinds[RogueDebugPack::NumKinds];
+	TArray<uint8> Scratch;
+	TArray<uint8> Body;
+	TArray<uint8> LastBody;
+	uint32 LastPackId = 0;
+	uint32 KeyframePackId = 0;
+	uint32 PacksSinceKeyframe = RogueDebugPack::KeyframeInterval;
+};
+
+/** Client side, applies packs and keeps the decoded rows keyed by entity */
+class ROGUEAIDEBUGGER_API FRogueDebugPackDecoder
+{
+public:
+	/** Returns false when the pack is malformed or deltas against a keyframe this side never applied */
+	bool Apply(TConstArrayView<uint8> Payload);
+	void Reset();
+
+	const TMap<uint64, FRogueDebugPassenger>& GetPassengers() const { return Passengers; }
+	const TMap<uint64, FRogueDebugTrain>& GetTrains() const { return Trains; }
+	const TMap<uint64, FRogueDebugCarriage>& GetCarriages() const { return Carriages; }
+	const TMap<uint64, FRogueDebugStation>& GetStations() const { return Stations; }
+
+private:
+	void StoreRow(const RogueDebugPack::EKind Kind, const uint64 Key, TConstArrayView<int32> Fields);
+	void RebuildRows();
+
+	TMap<uint64, TArray<int32>> Fields[RogueDebugPack::NumKinds];
+	TMap<uint64, TArray<int32>> KeyframeFields[RogueDebugPack::NumKinds];
+	TMap<uint64, FRogueDebugPassenger> Passengers;
+	TMap<uint64, FRogueDebugTrain> Trains;
+	TMap<uint64, FRogueDebugCarriage> Carriages;
+	TMap<uint64, FRogueDebugStation> Stations;
+	uint32 KeyframePackId = 0;
+};
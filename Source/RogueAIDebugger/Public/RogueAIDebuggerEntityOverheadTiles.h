@@ -34,58 +34,57 @@ inline FString GPDGetTempColorStringFromPercentage(int Value) {
 	return FString::Printf(TEXT("{%s}%d{white}%%"), *GPDGetTempColorFromScalar(Value, 100).ToString(), Value);
 }
 
-enum class EGameplayDebuggerEntityOverheadPairType
+enum class EGameplayDebuggerEntityOverheadPairType : uint8
 {
 	RegularKeyValue,
 	Separator
 };
 
-struct FGameplayDebuggerEntityOverheadPair
+/** Range of characters in the collector text arena */
+struct FGameplayDebuggerEntityOverheadText
 {
-	FString Label;
-	FString Value;
-	EGameplayDebuggerEntityOverheadPairType Type = EGameplayDebuggerEntityOverheadPairType::RegularKeyValue;
-	int IndentLevel                        = 0;
+	int32 Offset = 0;
+	int32 Len    = 0;
 
-	FGameplayDebuggerEntityOverheadPair() = default;
+	friend FArchive& operator<<(FArchive& Ar, FGameplayDebuggerEntityOverheadText& Text) {
+		Ar << Text.Offset;
+		Ar << Text.Len;
+		return Ar;
+	}
+};
 
-	FGameplayDebuggerEntityOverheadPair(
-		const FString& InLabel,
-		const FString& InValue,
-		EGameplayDebuggerEntityOverheadPairType InType = EGameplayDebuggerEntityOverheadPairType::RegularKeyValue,
-		int InIndentLevel                        = 0
-	):
-		Label(InLabel),
-		Value(InValue),
-		Type(InType),
-		IndentLevel(InIndentLevel) {}
+struct FGameplayDebuggerEntityOverheadPair
+{
+	FGameplayDebuggerEntityOverheadText Label;
+	FGameplayDebuggerEntityOverheadText Value;
+	EGameplayDebuggerEntityOverheadPairType Type = EGameplayDebuggerEntityOverheadPairType::RegularKeyValue;
+	int IndentLevel = 0;
+	int32 NextPair  = INDEX_NONE;
 
 	friend FArchive& operator<<(FArchive& Ar, FGameplayDebuggerEntityOverheadPair& Pair) {
 		Ar << Pair.Label;
 		Ar << Pair.Value;
 		Ar << Pair.Type;
 		Ar << Pair.IndentLevel;
+		Ar << Pair.NextPair;
 		return Ar;
 	}
 };
 
+/**
+ * Category of one tile. Pairs live in the collector's flat arrays and their text in its arena,
+ * so filling a tile only appends to storage that keeps its capacity between collects.
+ */
 class FGameplayDebuggerEntityOverheadCategory
 {
-public:
-	class FGameplayDebuggerEntityOverheadTiles* Info = nullptr;
-
-	FString Label;
-	TArray<FGameplayDebuggerEntityOverheadPair> Pairs;
-	int ActiveIndentLevel = 0;
+	friend class FGameplayDebuggerEntityOverheadTiles;
+	friend class FGameplayDebuggerEntityOverheadTilesCollector;
 
+public:
 	FGameplayDebuggerEntityOverheadCategory() = default;
 
-	FGameplayDebuggerEntityOverheadCategory(FGameplayDebuggerEntityOverheadTiles* InInfo, const FString& InLabel)
-		: Info(InInfo),
-		  Label(InLabel) {}
-
 	template <typename FmtType, typename... Types>
-	FGameplayDebuggerEntityOverheadCategory& AddF(const FString& InLabel, const FmtType& Fmt, Types... Args) {
+	FGameplayDebuggerEntityOverheadCategory& AddF(const FStringView InLabel, const FmtType& Fmt, Types... Args) {
 		static_assert(TIsArrayOrRefOfTypeByPredicate<FmtType, TIsCharEncodingCompatibleWithTCHAR>::Value, "Formatting string must be a TCHAR array.");
 		static_assert((TIsValidVariadicFunctionArg<Types>::Value && ...), "Invalid argument(s) passed to FGameplayDebuggerCanvasContext::PrintfAt");
 
@@ -94,14 +93,8 @@ public:
 		return *this;
 	}
 
-	FGameplayDebuggerEntityOverheadCategory& Add(const FString& InLabel, const FString& Value = "") {
-		Pairs.Add(FGameplayDebuggerEntityOverheadPair{InLabel, Value, EGameplayDebuggerEntityOverheadPairType::RegularKeyValue, ActiveIndentLevel});
-		return *this;
-	}
-	FGameplayDebuggerEntityOverheadCategory& Separator() {
-		Pairs.Add(FGameplayDebuggerEntityOverheadPair{"", "", EGameplayDebuggerEntityOverheadPairType::Separator, ActiveIndentLevel});
-		return *this;
-	}
+	FGameplayDebuggerEntityOverheadCategory& Add(const FStringView InLabel, const FStringView Value = FStringView());
+	FGameplayDebuggerEntityOverheadCategory& Separator();
 	FGameplayDebuggerEntityOverheadCategory& Indent() {
 		ActiveIndentLevel++;
 		return *this;
@@ -110,15 +103,19 @@ public:
 		ActiveIndentLevel--;
 		return *this;
 	}
-	FGameplayDebuggerEntityOverheadCategory& operator<<(FGameplayDebuggerEntityOverheadPair&& Pair) {
-		Pairs.Add(Pair);
-		return *this;
-	}
 
 	void Serialize(FArchive& Ar);
 
 private:
-	void AddImpl(const FString& Label, const TCHAR* Fmt, ...);
+	void AddImpl(const FStringView InLabel, const TCHAR* Fmt, ...);
+	void AddPair(const FGameplayDebuggerEntityOverheadText& InLabel, const FGameplayDebuggerEntityOverheadText& InValue, const EGameplayDebuggerEntityOverheadPairType Type);
+
+	class FGameplayDebuggerEntityOverheadTilesCollector* Collector = nullptr;
+	FGameplayDebuggerEntityOverheadText Label;
+	int32 FirstPair    = INDEX_NONE;
+	int32 LastPair     = INDEX_NONE;
+	int32 NextCategory = INDEX_NONE;
+	int ActiveIndentLevel = 0;
 };
 
 struct FGameplayDebuggerEntityOverheadCategoryIndentScope
@@ -134,75 +131,87 @@ struct FGameplayDebuggerEntityOverheadCategoryIndentScope
 	}
 };
 
+/** One overhead tile, keyed so the draw side can cache its text. References stay valid until the next Add */
 class FGameplayDebuggerEntityOverheadTiles
 {
 	friend class FGameplayDebuggerEntityOverheadTilesCollector;
 
-	class FGameplayDebuggerEntityOverheadTilesCollector* Collector = nullptr;
-	class FGameplayDebuggerCategory* CategoryInst            = nullptr;
-
-	FVector WorldPos;
-	FVector2D ScreenPos;
-
-	FGameplayDebuggerCanvasContext* CanvasContext;
-
-	TArray<FGameplayDebuggerEntityOverheadCategory> Categories;
-
 public:
 	FGameplayDebuggerEntityOverheadTiles() = default;
 
-	FGameplayDebuggerEntityOverheadTiles(
-		class FGameplayDebuggerCategory* CategoryInst,
-		const FVector& InWorldPos,
-		FGameplayDebuggerCanvasContext* InCanvasContext
-	);
+	/** References stay valid until the next Category call on any tile */
+	FGameplayDebuggerEntityOverheadCategory& Category(const FStringView Label);
 
-	FGameplayDebuggerEntityOverheadTiles(
-		class FGameplayDebuggerEntityOverheadTilesCollector* Collector,
-		const FVector& InWorldPos
-	);
+	void Serialize(FArchive& Ar);
 
-	FGameplayDebuggerEntityOverheadCategory& Category(const FString& Label);
+private:
+	class FGameplayDebuggerEntityOverheadTilesCollector* Collector = nullptr;
+	FVector WorldPos = FVector::ZeroVector;
+	uint64 Key = 0;
+	int32 FirstCategory = INDEX_NONE;
+	int32 LastCategory  = INDEX_NONE;
+};
 
-	void Print();
-	void Print(float ScreenX, float ScreenY);
+/**
+ * Draw side cache of built tile text and its measured size, keyed like the tiles.
+ * An entry is rebuilt only when the hash of its tile content changes and dropped after a few unused frames.
+ */
+class FGameplayDebuggerEntityOverheadTileCache
+{
+	friend class FGameplayDebuggerEntityOverheadTilesCollector;
 
-	void Serialize(FArchive& Ar);
-};
+public:
+	int32 Num() const { return Entries.Num(); }
+	void Reset() { Entries.Reset(); }
 
+private:
+	struct FEntry
+	{
+		uint32 Hash = 0;
+		FString Text;
+		float SizeX = 0.f;
+		float SizeY = 0.f;
+		uint64 LastUsedFrame = 0;
+	};
+
+	TMap<uint64, FEntry> Entries;
+	uint64 LastEvictFrame = 0;
+};
 
 class FGameplayDebuggerEntityOverheadTilesCollector
 {
+	friend class FGameplayDebuggerEntityOverheadTiles;
+	friend class FGameplayDebuggerEntityOverheadCategory;
+
 public:
 	FGameplayDebuggerCategory* Category = nullptr;
-	FGameplayDebuggerCanvasContext* CanvasContext = nullptr;
-	FGameplayDebuggerCanvasContext WorldContext = {};
-
-	TArray<FGameplayDebuggerEntityOverheadTiles> WorldTiles;
 
 	FGameplayDebuggerEntityOverheadTilesCollector() = default;
 	FGameplayDebuggerEntityOverheadTilesCollector(FGameplayDebuggerCategory* CategoryInst): Category(CategoryInst) {}
 
-	FGameplayDebuggerEntityOverheadTilesCollector(
-		FGameplayDebuggerCategory* CategoryInst,
-		FGameplayDebuggerCanvasContext* InCanvasContext
-	):
-		Category(CategoryInst),
-		CanvasContext(InCanvasContext) {
-
-		if (CanvasContext) {
-			WorldContext = FGameplayDebuggerCanvasContext(*CanvasContext);
-			WorldContext.Font = GEngine->GetSmallFont();
-			WorldContext.FontRenderInfo.bEnableShadow = true;
-		}
-	}
-
+	/** Tile for Key, repeated keys append to the same tile. Key is usually the entity handle as a number */
+	FGameplayDebuggerEntityOverheadTiles& Add(const FVector& WorldPos, const uint64 Key);
+	/** Tile keyed by its position, for data without an entity */
 	FGameplayDebuggerEntityOverheadTiles& Add(const FVector& WorldPos);
 
-	void Draw();
+	/** Empty for the next collect, keeps every allocation */
+	void Reset();
+
+	void Draw(FGameplayDebuggerCanvasContext& CanvasContext, FGameplayDebuggerEntityOverheadTileCache& Cache) const;
 
 	void Serialize(FArchive& Ar);
-	void From(const FGameplayDebuggerEntityOverheadTilesCollector& Collector);
+
+private:
+	FGameplayDebuggerEntityOverheadText AppendText(const FStringView InText);
+	FStringView GetText(const FGameplayDebuggerEntityOverheadText& InText) const { return FStringView(Text.GetData() + InText.Offset, InText.Len); }
+	uint32 HashTile(const FGameplayDebuggerEntityOverheadTiles& Tile) const;
+	bool BuildTileText(const FGameplayDebuggerEntityOverheadTiles& Tile, FString& Out) const;
+
+	TArray<TCHAR> Text;
+	TArray<FGameplayDebuggerEntityOverheadTiles> WorldTiles;
+	TArray<FGameplayDebuggerEntityOverheadCategory> Categories;
+	TArray<FGameplayDebuggerEntityOverheadPair> Pairs;
+	TMap<uint64, int32> TileLookup;
 };
 
 #endif
@@ -25,6 +25,14 @@ struct ROGUEAIDEBUGGER_API FRogueAIEditorGameplayDebuggerConfig
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bDrawTrackOverheads = false;
+
+	/** Entities further than this from the view are not collected, 0 disables the distance cull */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"))
+	float OverheadMaxDistance = 10000.f;
+
+	/** Largest distance from the view ray that still picks an entity */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"))
+	float PickRadius = 150.f;
 };
 
 /**
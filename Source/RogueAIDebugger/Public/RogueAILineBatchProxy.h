@@ -18,9 +18,15 @@ struct ROGUEAIDEBUGGER_API FPartialLine
 	                                                             End(InEnd) {}
 };
 
+/**
+ * Fluent wrapper over a line batch component. Lines are not forwarded per draw call, they accumulate in a
+ * frame arena and go to the line batcher in one DrawLines call on Flush or when the proxy goes out of scope.
+ * Spheres, capsules and circles are built from unit templates at fixed segment counts (4 to 64, rounded up
+ * to a power of two) so a draw call only scales and offsets precomputed points.
+ */
 struct ROGUEAIDEBUGGER_API FLineBatchProxy
 {
-	virtual ~FLineBatchProxy() = default;
+	virtual ~FLineBatchProxy() { Flush(); }
 
 
 	static constexpr uint32 INVALID_ID = 0;
@@ -44,16 +50,37 @@ struct ROGUEAIDEBUGGER_API FLineBatchProxy
 	 */
 	float LifeTime = 0.0f;
 
+	/** Lines queued since the last flush, used when no external arena is set */
+	TArray<FBatchedLine> QueuedLines;
+
+	/** Optional caller owned arena so the storage keeps its capacity from frame to frame */
+	TArray<FBatchedLine>* ExternalLines = nullptr;
+
 	FLineBatchProxy() = default;
 
 	explicit FLineBatchProxy(float DefaultThickness);
 	explicit FLineBatchProxy(const UWorld* World, float DefaultThickness = 2.0f);
 	explicit FLineBatchProxy(ULineBatchComponent* InLineBatcher, float DefaultThickness = 2.0f);
 
+	/** Move only, the destructor flushes so a copy would submit the queued lines twice */
+	FLineBatchProxy(const FLineBatchProxy&) = delete;
+	FLineBatchProxy& operator=(const FLineBatchProxy&) = delete;
+	FLineBatchProxy(FLineBatchProxy&& Other);
+	FLineBatchProxy& operator=(FLineBatchProxy&& Other);
+
 	static FLineBatchProxy MakePersistent(const UWorld* World, float InDefaultLifetime = 1.0f) {
-		return FLineBatchProxy(World).Persistent(InDefaultLifetime);
+		FLineBatchProxy Proxy(World);
+		Proxy.Persistent(InDefaultLifetime);
+		return Proxy;
 	}
 
+	/** Queue into InLines instead of the proxy's own arena, InLines must outlive the proxy */
+	FLineBatchProxy& WithArena(TArray<FBatchedLine>& InLines);
+
+	/** Submit every queued line in one call and empty the arena, keeping its allocation */
+	void Flush();
+	int32 NumQueued() const { return ExternalLines ? ExternalLines->Num() : QueuedLines.Num(); }
+
 	FLineBatchProxy& Persistent(float InLifeTime = 0.0f);
 	FLineBatchProxy& Foreground();
 
@@ -175,6 +202,8 @@ struct ROGUEAIDEBUGGER_API FLineBatchProxy
 	virtual void QueueLineDraw(TArrayView<struct FBatchedLine> InLines);
 
 private:
-	FLineBatchProxy& AddHalfCircle(TArray<FBatchedLine>& LineQueue, const FVector& Base, const FVector& X, const FVector& Y, const float Radius, int32 NumSides);
-	FLineBatchProxy& AddCircle(TArray<FBatchedLine>& LineQueue, const FVector& Base, const FVector& X, const FVector& Y, const float Radius, int32 NumSides);
+	TArray<FBatchedLine>& GetLineArena() { return ExternalLines ? *ExternalLines : QueuedLines; }
+
+	/** Queue NumSegments consecutive segments of a unit ring placed at Base on the X/Y plane and scaled by Radius */
+	void AppendRing(const FVector& Base, const FVector& X, const FVector& Y, const float Radius, TConstArrayView<FVector2D> Ring, const int32 NumSegments);
 };
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Analyzer.h"
+
+ROGUEAIDEBUGGER_API DECLARE_LOG_CATEGORY_EXTERN(LogRogueSimTrace, Log, All);
+
+/**
+ * Reads RogueSim.Event records from a trace and rebuilds per train and per station timelines.
+ * Aggregates dwell times, headway between arrivals and waiting queue length at each station.
+ */
+class ROGUEAIDEBUGGER_API FRogueSimTraceAnalyzer : public UE::Trace::IAnalyzer
+{
+public:
+	struct FStop
+	{
+		uint32 Station = 0;
+		int32 StationIdx = INDEX_NONE;
+		double ArriveTime = 0.0;
+		double DepartTime = -1.0; // still docked when the trace ended
+	};
+
+	struct FTrainTimeline
+	{
+		TArray<FStop> Stops;
+	};
+
+	struct FStationTimeline
+	{
+		int32 StationIdx = INDEX_NONE;
+		TArray<double> Arrivals;
+		TArray<TPair<double, int32>> QueueSamples; // time, passengers holding a waiting slot
+		int32 QueueLength = 0;
+		int32 MaxQueueLength = 0;
+		double QueueIntegral = 0.0;
+		double LastQueueTime = 0.0;
+	};
+
+	static constexpr double DwellBinSeconds = 2.0;
+	static constexpr int32 NumDwellBins = 30;
+
+	virtual void OnAnalysisBegin(const FOnAnalysisContext& Context) override;
+	virtual bool OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context) override;
+	virtual void OnAnalysisEnd() override;
+
+	// Write Trains.csv, Stations.csv, StationQueues.csv and DwellHistogram.csv to OutDir and log a summary
+	bool WriteReport(const FString& OutDir) const;
+
+	const TMap<uint32, FTrainTimeline>& GetTrains() const { return Trains; }
+	const TMap<uint32, FStationTimeline>& GetStations() const { return Stations; }
+	
+private:
+	enum : uint16
+	{
+		RouteId_Event
+	};
+
+	TMap<uint32, FTrainTimeline> Trains;
+	TMap<uint32, FStationTimeline> Stations;
+	TArray<int32> EventCounts;
+	TArray<int32> DwellHistogram;
+	double FirstTime = -1.0;
+	double LastTime = 0.0;
+
+	void UpdateQueue(FStationTimeline& Station, const double Time, const int32 Delta);
+};
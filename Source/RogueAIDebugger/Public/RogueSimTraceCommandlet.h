@@ -0,0 +1,22 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RogueSimTraceCommandlet.generated.h"
+
+/**
+ * Runs FRogueSimTraceAnalyzer over a recorded .utrace and writes the CSV report.
+ * Usage: UnrealEditor-Cmd <Project>.uproject -run=RogueSimTrace -Trace=<file.utrace> [-Out=<dir>]
+ */
+UCLASS()
+class ROGUEAIDEBUGGER_API URogueSimTraceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	URogueSimTraceCommandlet();
+	
+	virtual int32 Main(const FString& Params) override;
+};
@@ -27,6 +27,8 @@ public class RogueAIDebugger : ModuleRules
                 "DeveloperSettings", 
                 "GameplayTags",
                 "InputCore", 
+                "TraceLog",
+                "TraceAnalysis",
             }
         );
     }
@@ -4,12 +4,21 @@
 #include "Actors/RogueTrainStation.h"
 #include "Data/RogueDeveloperSettings.h"
 #include "Components/SplineComponent.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
 
 ARogueTrainStation::ARogueTrainStation()
 {
 	PrimaryActorTick.bCanEverTick = false;
 }
 
+void ARogueTrainStation::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Packaged builds never run construction scripts, project against the lines baked at runtime
+	ComputeStationAlpha();
+}
+
 #if WITH_EDITOR
 void ARogueTrainStation::OnConstruction(const FTransform& Transform)
 {
@@ -21,16 +30,45 @@ void ARogueTrainStation::OnConstruction(const FTransform& Transform)
 void ARogueTrainStation::ComputeStationAlpha()
 {
 	if (!GetWorld()) return;
-	const auto* Settings = GetDefault<URogueDeveloperSettings>();
-	if (!Settings || !Settings->TrackSplineActor.IsValid()) return;
-	const AActor* TrackActor = Settings->TrackSplineActor.Get();
-	if (!TrackActor) return;
-	const USplineComponent* Spline = TrackActor->FindComponentByClass<USplineComponent>();
-	if (!Spline) return;
-	
-	// Project to distance & normalize
+
+	// Project onto the nearest line through its segment BVH when the subsystem has baked lines
 	const FVector Platform = GetActorLocation();
-	const float RealDist = Spline->GetDistanceAlongSplineAtLocation(Platform, ESplineCoordinateSpace::World);
-	const float Len = FMath::Max(1.f, Spline->GetSplineLength());
-	StationAlpha = RealDist / Len;
-}
\ No newline at end of file
+	double RealDist = 0.0;
+	int32 LineIndex = INDEX_NONE;
+	const URogueTrainWorldSubsystem* TrainSubsystem = GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
+	if (TrainSubsystem && TrainSubsystem->FindNearestTrackDistance(Platform, RealDist, LineIndex))
+	{
+		if (const USplineComponent* Spline = TrainSubsystem->GetSpline(LineIndex))
+		{
+			StationLineIndex = LineIndex;
+			StationAlpha = static_cast<float>(RealDist) / FMath::Max(1.f, Spline->GetSplineLength());
+			return;
+		}
+	}
+
+	// Editor construction before any line is baked, project onto the nearest configured spline
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (!Settings) return;
+
+	TArray<const AActor*, TInlineAllocator<4>> LineActors;
+	LineActors.Add(Settings->TrackSplineActor.Get());
+	for (const FRogueTrackLineConfig& LineConfig : Settings->AdditionalTrackLines)
+	{
+		LineActors.Add(LineConfig.TrackSplineActor.Get());
+	}
+
+	double BestDistSq = DBL_MAX;
+	for (int32 LineIdx = 0; LineIdx < LineActors.Num(); ++LineIdx)
+	{
+		const USplineComponent* Spline = LineActors[LineIdx] ? LineActors[LineIdx]->FindComponentByClass<USplineComponent>() : nullptr;
+		if (!Spline) continue;
+
+		const float Distance = Spline->GetDistanceAlongSplineAtLocation(Platform, ESplineCoordinateSpace::World);
+		const double DistSq = FVector::DistSquared(Platform, Spline->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World));
+		if (DistSq >= BestDistSq) continue;
+
+		BestDistSq = DistSq;
+		StationLineIndex = LineIdx;
+		StationAlpha = Distance / FMath::Max(1.f, Spline->GetSplineLength());
+	}
+}
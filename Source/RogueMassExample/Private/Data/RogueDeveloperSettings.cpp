@@ -1,3 +1,14 @@
 ﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 #include "RogueMassExample/Public/Data/RogueDeveloperSettings.h"
+
+// The sim clock reads SimulationTimeScale, console and -ExecCmds changes are pushed into it
+static TAutoConsoleVariable<float> CVarRogueSimTimeScale(
+	TEXT("rogue.Sim.TimeScale"),
+	1.f,
+	TEXT("Simulated seconds per real second. Use with -nullrhi for headless fast forward runs."),
+	FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+	{
+		GetMutableDefault<URogueDeveloperSettings>()->SimulationTimeScale = FMath::Max(0.01f, Var->GetFloat());
+	}),
+	ECVF_Default);
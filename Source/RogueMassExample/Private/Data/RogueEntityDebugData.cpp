@@ -2,3 +2,63 @@
 
 
 #include "Data/RogueEntityDebugData.h"
+#include "Algo/BinarySearch.h"
+
+void FRogueDebugSpatialIndex::Build(TConstArrayView<int32> Rows, TConstArrayView<FVector> Positions)
+{
+	Entries.Reset();
+	for (int32 i = 0; i < Rows.Num(); ++i)
+	{
+		Entries.Add({ CellKey(ToCell(Positions[i])), Rows[i], Positions[i] });
+	}
+	
+	Entries.Sort([](const FEntry& A, const FEntry& B) { return A.Cell < B.Cell; });
+}
+
+int32 FRogueDebugSpatialIndex::PickAlongRay(const FVector& Origin, const FVector& Direction, const float MaxDistance, double& InOutBestMissSq) const
+{
+	if (Entries.IsEmpty()) return INDEX_NONE;
+	
+	int32 BestRow = INDEX_NONE;
+	double BestAlong = MaxDistance;
+	
+	auto TestCell = [&](const FIntPoint& Cell)
+	{
+		const uint64 Key = CellKey(Cell);
+		for (int32 i = Algo::LowerBoundBy(Entries, Key, &FEntry::Cell); i < Entries.Num() && Entries[i].Cell == Key; ++i)
+		{
+			const FEntry& Entry = Entries[i];
+			const double Along = FVector::DotProduct(Entry.Position - Origin, Direction);
+			if (Along < 0.0 || Along > MaxDistance) continue;
+
+			// Prefer the smaller miss, the nearer one along the ray on ties
+			const double MissSq = FVector::DistSquared(Entry.Position, Origin + Direction * Along);
+			if (MissSq < InOutBestMissSq || (MissSq == InOutBestMissSq && BestRow != INDEX_NONE && Along < BestAlong))
+			{
+				InOutBestMissSq = MissSq;
+				BestAlong = Along;
+				BestRow = Entry.Row;
+			}
+		}
+	};
+
+	// Step a cell at a time and test the surrounding block, neighbours catch rows just off the stepped cell
+	const int32 NumSteps = FMath::CeilToInt32(MaxDistance / CellSize);
+	FIntPoint LastCell(MAX_int32, MAX_int32);
+	for (int32 Step = 0; Step <= NumSteps; ++Step)
+	{
+		const FIntPoint Cell = ToCell(Origin + Direction * (Step * CellSize));
+		if (Cell == LastCell) continue;
+		LastCell = Cell;
+
+		for (int32 DX = -1; DX <= 1; ++DX)
+		{
+			for (int32 DY = -1; DY <= 1; ++DY)
+			{
+				TestCell(Cell + FIntPoint(DX, DY));
+			}
+		}
+	}
+	
+	return BestRow;
+}
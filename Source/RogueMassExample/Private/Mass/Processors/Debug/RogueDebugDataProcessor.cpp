@@ -2,12 +2,16 @@
 
 
 #include "Mass/Processors/Debug/RogueDebugDataProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonFragments.h"
 #include "MassExecutionContext.h"
 #include "MassNavigationFragments.h"
 #include "Mass/Fragments/RogueFragments.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 
+DECLARE_CYCLE_STAT(TEXT("Debug Data"), STAT_RogueDebugData, STATGROUP_RogueSim);
+
 URogueDebugDataProcessor::URogueDebugDataProcessor():
 	PassengerEntityQuery(*this), TrainEntityQuery(*this), CarriageEntityQuery(*this), StationEntityQuery(*this)
 {
@@ -22,6 +26,8 @@ void URogueDebugDataProcessor::ConfigureQueries(const TSharedRef<FMassEntityMana
 	PassengerEntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::All);
 	PassengerEntityQuery.AddRequirement<FMassMoveTargetFragment>(EMassFragmentAccess::ReadOnly);	
 	PassengerEntityQuery.AddRequirement<FRoguePassengerFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::All);	
+	PassengerEntityQuery.AddRequirement<FRoguePassengerTripFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::All);	
+	PassengerEntityQuery.AddConstSharedRequirement<FRoguePassengerMovementClassFragment>(EMassFragmentPresence::All);
 	PassengerEntityQuery.AddTagRequirement<FRogueTrainPassengerTag>(EMassFragmentPresence::All);
 	PassengerEntityQuery.AddRequirement<FRogueDebugSlotFragment>(EMassFragmentAccess::ReadOnly);
 	PassengerEntityQuery.RegisterWithProcessor(*this);	
@@ -39,6 +45,7 @@ void URogueDebugDataProcessor::ConfigureQueries(const TSharedRef<FMassEntityMana
 	CarriageEntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadOnly);
 	CarriageEntityQuery.AddRequirement<FRogueTrainLinkFragment>(EMassFragmentAccess::ReadOnly);
 	CarriageEntityQuery.AddRequirement<FRogueCarriageFragment>(EMassFragmentAccess::ReadOnly);
+	CarriageEntityQuery.AddConstSharedRequirement<FRogueCarriageClassFragment>(EMassFragmentPresence::All);
 	CarriageEntityQuery.AddTagRequirement<FRogueTrainCarriageTag>(EMassFragmentPresence::All);
 	CarriageEntityQuery.AddRequirement<FRogueDebugSlotFragment>(EMassFragmentAccess::ReadOnly);
 	CarriageEntityQuery.RegisterWithProcessor(*this);
@@ -49,226 +56,229 @@ void URogueDebugDataProcessor::ConfigureQueries(const TSharedRef<FMassEntityMana
 	StationEntityQuery.AddRequirement<FRogueStationFragment>(EMassFragmentAccess::ReadOnly);
 	StationEntityQuery.AddTagRequirement<FRogueTrainStationTag>(EMassFragmentPresence::All);
 	StationEntityQuery.AddRequirement<FRogueDebugSlotFragment>(EMassFragmentAccess::ReadOnly);
+	StationEntityQuery.AddConstSharedRequirement<FRogueStationLayoutFragment>(EMassFragmentPresence::Optional);
 	StationEntityQuery.RegisterWithProcessor(*this);
 }
 
 void URogueDebugDataProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueDebugData);
+	ROGUE_SCOPE_ALLOC_COUNTER("DebugData");
+
+#if WITH_EDITOR
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
-	TWeakObjectPtr<URogueTrainWorldSubsystem> TrainSubsystemWeak = TrainSubsystem;
 	if (!TrainSubsystem) return;
 
-	TArray<FRogueDebugPassenger> LocalPassengerSnap;
-	LocalPassengerSnap.SetNumZeroed(TrainSubsystem->GetPassengerDebugCapacity());
+	// Nothing is collected unless a debugger category asked for it recently. Each kind fills its persistent
+	// back buffer in place and publishes it by flipping, FrameEnd completes before the debugger reads next frame.
+	// Rows outside the requesting view are culled here so the debugger only pays for what is on screen
+	const double Now = Context.GetWorld()->GetRealTimeSeconds();
+	const FRogueDebugView& View = TrainSubsystem->GetDebugView();
 
-	TArray<FRogueDebugTrain> LocalTrainSnap;
-	LocalTrainSnap.SetNumZeroed(TrainSubsystem->GetTrainDebugCapacity());
+	// Passengers
+	if (TrainSubsystem->ShouldCollectDebugSnapshot(ERogueDebugSnapshot::Passengers, Now))
+	{
+		TRogueDebugSnapshotBuffer<FRogueDebugPassenger>& Buffer = TrainSubsystem->GetPassengerDebugBuffer();
+		Buffer.BeginWrite(TrainSubsystem->GetDebugSlotCapacity(ERogueEntityType::Passenger));
+		
+		PassengerEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
+		{
+			const TConstArrayView<FTransformFragment> PassengerTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
+			const TConstArrayView<FMassMoveTargetFragment> MoveTargetFragments = SubContext.GetFragmentView<FMassMoveTargetFragment>();
+			const TConstArrayView<FRoguePassengerFragment> PassengerFragments = SubContext.GetFragmentView<FRoguePassengerFragment>();
+			const TConstArrayView<FRoguePassengerTripFragment> TripFragments = SubContext.GetFragmentView<FRoguePassengerTripFragment>();
+			const TConstArrayView<FRogueDebugSlotFragment> PassengerDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
+			const FRoguePassengerMovementClassFragment& MovementClass = SubContext.GetConstSharedFragment<FRoguePassengerMovementClassFragment>();
+			const int32 NumPassengerEntities = SubContext.GetNumEntities();
 
-	TArray<FRogueDebugCarriage> LocalCarriageSnap;
-	LocalCarriageSnap.SetNumZeroed(TrainSubsystem->GetCarriageDebugCapacity());
+			for (int32 PIndex = 0; PIndex < NumPassengerEntities; PIndex++)
+			{
+				const int32 DebugSlot = PassengerDebugSlots[PIndex].Slot;
+				if (DebugSlot < 0 || DebugSlot >= Buffer.GetBackNum()) continue;
 
-	TArray<FRogueDebugStation> LocalStationSnap;
-	LocalStationSnap.SetNumZeroed(TrainSubsystem->GetStationDebugCapacity());
+				const FTransform& PTransform = PassengerTransformFragments[PIndex].GetTransform();
+				if (!View.IsVisible(PTransform.GetLocation())) continue;
+				
+				const FMassMoveTargetFragment& MoveTarget = MoveTargetFragments[PIndex];
+				const FRoguePassengerFragment& PassengerFragment = PassengerFragments[PIndex];
+				const FRoguePassengerTripFragment& TripFragment = TripFragments[PIndex];
 
-	// Passengers
-	PassengerEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
-	{
-		const TConstArrayView<FTransformFragment> PassengerTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
-		const TConstArrayView<FMassMoveTargetFragment> MoveTargetFragments = SubContext.GetFragmentView<FMassMoveTargetFragment>();
-		const TConstArrayView<FRoguePassengerFragment> PassengerFragments = SubContext.GetFragmentView<FRoguePassengerFragment>();
-		const TConstArrayView<FRogueDebugSlotFragment> PassengerDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
-		const int32 NumPassengerEntities = SubContext.GetNumEntities();
+				// Write to slot index
+				FRogueDebugPassenger& DebugData = Buffer.WriteRow(DebugSlot);
+				DebugData.Entity = SubContext.GetEntity(PIndex);
+				DebugData.WorldPos = PTransform.GetLocation();
+				DebugData.OriginStationIdx = TripFragment.GetOriginStationIdx();
+				DebugData.DestStationIdx = TripFragment.GetDestStationIdx();
+				DebugData.Vehicle = TripFragment.VehicleHandle;
+				DebugData.Phase = PassengerFragment.Phase;
+				DebugData.bWaiting = PassengerFragment.bWaiting;
+				DebugData.WaitingPointIdx = TripFragment.GetWaitingPointIdx();
+				DebugData.WaitingSlotIdx = TripFragment.GetWaitingSlotIdx();
+				DebugData.Move.DesiredSpeed = MoveTarget.DesiredSpeed;
+				DebugData.Move.DistToGoal = MoveTarget.DistanceToGoal;
+				DebugData.Move.Target = MoveTarget.Center;
+				DebugData.Move.AcceptanceRadius = MovementClass.AcceptanceRadius;
+			}
+		});
 
-		for (int32 PIndex = 0; PIndex < NumPassengerEntities; PIndex++)
-		{
-			const int32 DebugSlot = PassengerDebugSlots[PIndex].Slot;
-			if (!LocalPassengerSnap.IsValidIndex(DebugSlot)) continue;
-			
-			const FTransform& PTransform = PassengerTransformFragments[PIndex].GetTransform();
-			const FMassMoveTargetFragment& MoveTarget = MoveTargetFragments[PIndex];
-			const FRoguePassengerFragment& PassengerFragment = PassengerFragments[PIndex];
-			const FMassEntityHandle Entity = SubContext.GetEntity(PIndex);
-
-			FRogueDebugPassenger DebugData;
-			DebugData.Entity = Entity;
-			DebugData.WorldPos = PTransform.GetLocation();
-			DebugData.OriginStation = PassengerFragment.OriginStation;
-			DebugData.DestStation = PassengerFragment.DestinationStation;
-			DebugData.Phase = PassengerFragment.Phase;
-			DebugData.bWaiting = PassengerFragment.bWaiting;
-			DebugData.WaitingPointIdx = PassengerFragment.WaitingPointIdx;
-			DebugData.WaitingSlotIdx = PassengerFragment.WaitingSlotIdx;
-			DebugData.Move.DesiredSpeed = MoveTarget.DesiredSpeed;
-			DebugData.Move.DistToGoal = MoveTarget.DistanceToGoal;
-			DebugData.Move.Target = MoveTarget.Center;
-			DebugData.Move.AcceptanceRadius = PassengerFragment.AcceptanceRadius;
-
-			// Write to slot index
-			LocalPassengerSnap[DebugSlot] = DebugData;
-		}
-	});
-	
-	
-	AsyncTask(ENamedThreads::GameThread, [TrainSubsystemWeak, Snap=MoveTemp(LocalPassengerSnap)]() mutable
-	{
-		if (URogueTrainWorldSubsystem* TSubsystem = TrainSubsystemWeak.Get())
-		{
-			TSubsystem->SetPassengerDebugSnapshot(MoveTemp(Snap));
-		}
-	});
+		Buffer.Publish();
+	}
 
 	// Trains
-	TrainEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
-	{
-		const TConstArrayView<FTransformFragment> TrainTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
-		const TConstArrayView<FRogueTrainTrackFollowFragment> TrainFollowViews = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
-		const TConstArrayView<FRogueTrainStateFragment> StateViews = SubContext.GetFragmentView<FRogueTrainStateFragment>();
-		const TConstArrayView<FRogueDebugSlotFragment> TrainDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
-		const int32 NumTrainEntities = SubContext.GetNumEntities();
-
-		for (int32 TIndex = 0; TIndex < NumTrainEntities; TIndex++)
-		{
-			const int32 DebugSlot = TrainDebugSlots[TIndex].Slot;
-			if (!LocalTrainSnap.IsValidIndex(DebugSlot)) continue;
-
-			const FTransform& TTransform = TrainTransformFragments[TIndex].GetTransform();
-			const FRogueTrainTrackFollowFragment& Follow = TrainFollowViews[TIndex];
-			const FRogueTrainStateFragment& State = StateViews[TIndex];
-			const FMassEntityHandle Entity = SubContext.GetEntity(TIndex);
-
-			FRogueDebugTrain DebugData;
-			DebugData.Entity = Entity;
-			DebugData.Alpha = Follow.Alpha; 
-			DebugData.Speed = Follow.Speed;
-			DebugData.WorldPos = TTransform.GetLocation();
-			DebugData.bIsStopping = State.bIsStopping;
-			DebugData.bAtStation = State.bAtStation;
-			DebugData.TargetStationIdx = State.TargetStationIdx;
-			DebugData.StationTimeRemaining = State.StationTimeRemaining;
-			DebugData.TrainPhase = State.StationTrainPhase;
-			DebugData.HeadwaySpeedScale = State.HeadwaySpeedScale;
-
-			// Write to slot index
-			LocalTrainSnap[DebugSlot] = DebugData;
-		}
-	});	
-	
-	AsyncTask(ENamedThreads::GameThread, [TrainSubsystemWeak, Snap=MoveTemp(LocalTrainSnap)]() mutable
+	if (TrainSubsystem->ShouldCollectDebugSnapshot(ERogueDebugSnapshot::Trains, Now))
 	{
-		if (URogueTrainWorldSubsystem* TSubsystem = TrainSubsystemWeak.Get())
+		TRogueDebugSnapshotBuffer<FRogueDebugTrain>& Buffer = TrainSubsystem->GetTrainDebugBuffer();
+		Buffer.BeginWrite(TrainSubsystem->GetDebugSlotCapacity(ERogueEntityType::TrainEngine));
+		
+		TrainEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
 		{
-			TSubsystem->SetTrainDebugSnapshot(MoveTemp(Snap));
-		}
-	});
+			const TConstArrayView<FTransformFragment> TrainTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
+			const TConstArrayView<FRogueTrainTrackFollowFragment> TrainFollowViews = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
+			const TConstArrayView<FRogueTrainStateFragment> StateViews = SubContext.GetFragmentView<FRogueTrainStateFragment>();
+			const TConstArrayView<FRogueDebugSlotFragment> TrainDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
+			const int32 NumTrainEntities = SubContext.GetNumEntities();
+
+			for (int32 TIndex = 0; TIndex < NumTrainEntities; TIndex++)
+			{
+				const int32 DebugSlot = TrainDebugSlots[TIndex].Slot;
+				if (DebugSlot < 0 || DebugSlot >= Buffer.GetBackNum()) continue;
+
+				const FTransform& TTransform = TrainTransformFragments[TIndex].GetTransform();
+				if (!View.IsVisible(TTransform.GetLocation())) continue;
+
+				const FRogueTrainTrackFollowFragment& Follow = TrainFollowViews[TIndex];
+				const FRogueTrainStateFragment& State = StateViews[TIndex];
+
+				// Write to slot index
+				FRogueDebugTrain& DebugData = Buffer.WriteRow(DebugSlot);
+				DebugData.Entity = SubContext.GetEntity(TIndex);
+				DebugData.Distance = Follow.Distance; 
+				DebugData.Speed = Follow.Speed;
+				DebugData.WorldPos = TTransform.GetLocation();
+				DebugData.bIsStopping = State.bIsStopping;
+				DebugData.bAtStation = State.bAtStation;
+				DebugData.TargetStationIdx = State.TargetStationIdx;
+				DebugData.StationTimeRemaining = State.StationTimeRemaining;
+				DebugData.TrainPhase = State.StationTrainPhase;
+				DebugData.HeadwaySpeedScale = State.HeadwaySpeedScale;
+			}
+		});
+
+		Buffer.Publish();
+	}
 
 	// Carriages
-	CarriageEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
+	if (TrainSubsystem->ShouldCollectDebugSnapshot(ERogueDebugSnapshot::Carriages, Now))
 	{
-		const TConstArrayView<FTransformFragment> CarriageTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
-		const TConstArrayView<FRogueTrainLinkFragment> CarriageLinkFragments = SubContext.GetFragmentView<FRogueTrainLinkFragment>();
-		const TConstArrayView<FRogueTrainTrackFollowFragment> CarriageFollowViews = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
-		const TConstArrayView<FRogueCarriageFragment> CarriageFragments = SubContext.GetFragmentView<FRogueCarriageFragment>();
-		const TConstArrayView<FRogueDebugSlotFragment> CarriageSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
-		const int32 NumCarriageEntities = SubContext.GetNumEntities();
+		TRogueDebugSnapshotBuffer<FRogueDebugCarriage>& Buffer = TrainSubsystem->GetCarriageDebugBuffer();
+		Buffer.BeginWrite(TrainSubsystem->GetDebugSlotCapacity(ERogueEntityType::TrainCarriage));
 		
-		for (int32 CIndex = 0; CIndex < NumCarriageEntities; CIndex++)
+		CarriageEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
 		{
-			const int32 DebugSlot = CarriageSlots[CIndex].Slot;
-			if (!LocalCarriageSnap.IsValidIndex(DebugSlot)) continue;
+			const TConstArrayView<FTransformFragment> CarriageTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
+			const TConstArrayView<FRogueTrainLinkFragment> CarriageLinkFragments = SubContext.GetFragmentView<FRogueTrainLinkFragment>();
+			const TConstArrayView<FRogueTrainTrackFollowFragment> CarriageFollowViews = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
+			const TConstArrayView<FRogueCarriageFragment> CarriageFragments = SubContext.GetFragmentView<FRogueCarriageFragment>();
+			const TConstArrayView<FRogueDebugSlotFragment> CarriageSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
+			const FRogueCarriageClassFragment& CarriageClass = SubContext.GetConstSharedFragment<FRogueCarriageClassFragment>();
+			const int32 NumCarriageEntities = SubContext.GetNumEntities();
 			
-			const FTransform& CTransform = CarriageTransformFragments[CIndex].GetTransform();
-			const FRogueTrainLinkFragment& LinkFragment = CarriageLinkFragments[CIndex];
-			const FRogueTrainTrackFollowFragment& FollowFragment = CarriageFollowViews[CIndex];
-			const FRogueCarriageFragment& CarriageFragment = CarriageFragments[CIndex];
-			const FMassEntityHandle Entity = SubContext.GetEntity(CIndex);
-
-			FRogueDebugCarriage DebugData;
-			DebugData.Entity = Entity;
-			DebugData.Alpha = FollowFragment.Alpha; 
-			DebugData.Speed = FollowFragment.Speed;
-			DebugData.WorldPos = CTransform.GetLocation();
-			DebugData.IndexInTrain = LinkFragment.CarriageIndex;
-			DebugData.Spacing = LinkFragment.Spacing;
-			DebugData.Capacity = CarriageFragment.Capacity;
-			DebugData.Occupants = CarriageFragment.Occupants.Num();
-
-			// Write to slot index
-			LocalCarriageSnap[DebugSlot] = DebugData;
-		}
-	});
-	
-	AsyncTask(ENamedThreads::GameThread, [TrainSubsystemWeak, Snap=MoveTemp(LocalCarriageSnap)]() mutable
-	{
-		if (URogueTrainWorldSubsystem* TSubsystem = TrainSubsystemWeak.Get())
-		{
-			TSubsystem->SetCarriageDebugSnapshot(MoveTemp(Snap));
-		}
-	});
+			for (int32 CIndex = 0; CIndex < NumCarriageEntities; CIndex++)
+			{
+				const int32 DebugSlot = CarriageSlots[CIndex].Slot;
+				if (DebugSlot < 0 || DebugSlot >= Buffer.GetBackNum()) continue;
+
+				const FTransform& CTransform = CarriageTransformFragments[CIndex].GetTransform();
+				if (!View.IsVisible(CTransform.GetLocation())) continue;
+				
+				const FRogueTrainLinkFragment& LinkFragment = CarriageLinkFragments[CIndex];
+				const FRogueTrainTrackFollowFragment& FollowFragment = CarriageFollowViews[CIndex];
+				const FRogueCarriageFragment& CarriageFragment = CarriageFragments[CIndex];
+
+				// Write to slot index
+				FRogueDebugCarriage& DebugData = Buffer.WriteRow(DebugSlot);
+				DebugData.Entity = SubContext.GetEntity(CIndex);
+				DebugData.LeadHandle = TrainSubsystem->GetConsists().GetLead(LinkFragment.ConsistId);
+				DebugData.Distance = FollowFragment.Distance; 
+				DebugData.Speed = FollowFragment.Speed;
+				DebugData.WorldPos = CTransform.GetLocation();
+				DebugData.IndexInTrain = LinkFragment.CarriageIndex;
+				DebugData.Spacing = CarriageClass.Spacing;
+				DebugData.Capacity = CarriageClass.Capacity;
+				DebugData.Occupants = CarriageFragment.NumOccupants;
+			}
+		});
+
+		Buffer.Publish();
+	}
 
 	// Stations
-	StationEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
+	if (TrainSubsystem->ShouldCollectDebugSnapshot(ERogueDebugSnapshot::Stations, Now))
 	{
-		const TConstArrayView<FTransformFragment> StationTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
-		const TConstArrayView<FRogueStationQueueFragment> StationQueueFragments = SubContext.GetFragmentView<FRogueStationQueueFragment>();
-		const TConstArrayView<FRogueStationFragment> StationFragments = SubContext.GetFragmentView<FRogueStationFragment>();
-		const TConstArrayView<FRogueDebugSlotFragment> StationDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
-		const int32 NumStationEntities = SubContext.GetNumEntities();
+		TRogueDebugSnapshotBuffer<FRogueDebugStation>& Buffer = TrainSubsystem->GetStationDebugBuffer();
+		Buffer.BeginWrite(TrainSubsystem->GetDebugSlotCapacity(ERogueEntityType::Station));
 		
-		for (int32 SIndex = 0; SIndex < NumStationEntities; SIndex++)
+		StationEntityQuery.ForEachEntityChunk(Context, [&](const FMassExecutionContext& SubContext)
 		{
-			const int32 DebugSlot = StationDebugSlots[SIndex].Slot;
-			if (!LocalStationSnap.IsValidIndex(DebugSlot)) continue;
+			const TConstArrayView<FTransformFragment> StationTransformFragments = SubContext.GetFragmentView<FTransformFragment>();
+			const TConstArrayView<FRogueStationQueueFragment> StationQueueFragments = SubContext.GetFragmentView<FRogueStationQueueFragment>();
+			const TConstArrayView<FRogueStationFragment> StationFragments = SubContext.GetFragmentView<FRogueStationFragment>();
+			const TConstArrayView<FRogueDebugSlotFragment> StationDebugSlots = SubContext.GetFragmentView<FRogueDebugSlotFragment>();
+			const int32 NumStationEntities = SubContext.GetNumEntities();
+
+			// Each station has its own layout instance so a chunk holds one station, absent until the deferred add lands
+			const FRogueStationLayoutFragment* StationLayout = SubContext.GetConstSharedFragmentPtr<FRogueStationLayoutFragment>();
 			
-			const FTransform& STransform = StationTransformFragments[SIndex].GetTransform();
-			const FRogueStationQueueFragment& QueueFragment = StationQueueFragments[SIndex];
-			const FRogueStationFragment& StationFragment = StationFragments[SIndex];
-			const FMassEntityHandle Entity = SubContext.GetEntity(SIndex);
-
-			FRogueDebugStation DebugData;
-			DebugData.Entity = Entity;
-			DebugData.StationIdx = StationFragment.StationIndex;
-			//DebugData.TrackAlpha = StationFragment.StationAlpha;
-			DebugData.WorldPos = STransform.GetLocation();
-			DebugData.Grids.Init(FRogueDebugWaitingGrid(), QueueFragment.Grids.Num());
-
-			// Queues
-			int32 TotalWaitingCount = 0;
-			int32 i = 0;
-			for (const TPair<int32, FRogueWaitingGrid>& Pair : QueueFragment.Grids)
+			for (int32 SIndex = 0; SIndex < NumStationEntities; SIndex++)
 			{
-				const FRogueWaitingGrid& WaitingGrid = Pair.Value;
-				FRogueDebugWaitingGrid& GridData = DebugData.Grids[i++];
-				GridData.WaitingPointIdx = Pair.Key;
-				GridData.Slots = WaitingGrid.SlotPositions.Num();
+				const int32 DebugSlot = StationDebugSlots[SIndex].Slot;
+				if (DebugSlot < 0 || DebugSlot >= Buffer.GetBackNum()) continue;
+
+				const FTransform& STransform = StationTransformFragments[SIndex].GetTransform();
+				if (!View.IsVisible(STransform.GetLocation())) continue;
+				
+				const FRogueStationQueueFragment& QueueFragment = StationQueueFragments[SIndex];
+				const FRogueStationFragment& StationFragment = StationFragments[SIndex];
+
+				// Write to slot index, the grid array keeps its allocation from the last collect into this buffer
+				FRogueDebugStation& DebugData = Buffer.WriteRow(DebugSlot);
+				DebugData.Entity = SubContext.GetEntity(SIndex);
+				DebugData.StationIdx = StationFragment.StationIndex;
+				//DebugData.TrackAlpha = StationFragment.StationAlpha;
+				DebugData.WorldPos = STransform.GetLocation();
+				DebugData.Grids.SetNum(QueueFragment.Grids.Num(), EAllowShrinking::No);
 
-				int32 WaitingLocalGridCount = 0;
-				for (int j = 0; j < WaitingGrid.OccupiedBy.Num(); ++j)
+				// Queues
+				int32 TotalWaitingCount = 0;
+				int32 i = 0;
+				for (const TPair<int32, FRogueWaitingGrid>& Pair : QueueFragment.Grids)
 				{
-					if (WaitingGrid.OccupiedBy[j].IsValid())
+					const FRogueWaitingGrid& WaitingGrid = Pair.Value;
+					FRogueDebugWaitingGrid& GridData = DebugData.Grids[i++];
+					GridData.WaitingPointIdx = Pair.Key;
+					GridData.Slots = WaitingGrid.OccupiedBy.Num();
+
+					int32 WaitingLocalGridCount = 0;
+					for (int j = 0; j < WaitingGrid.OccupiedBy.Num(); ++j)
 					{
-						WaitingLocalGridCount++;
+						if (WaitingGrid.OccupiedBy[j].IsValid())
+						{
+							WaitingLocalGridCount++;
+						}
 					}
-				}
 
-				GridData.Free = GridData.Slots - WaitingLocalGridCount;
-				GridData.Occupied = WaitingLocalGridCount;
-				TotalWaitingCount += WaitingLocalGridCount;
+					GridData.Free = GridData.Slots - WaitingLocalGridCount;
+					GridData.Occupied = WaitingLocalGridCount;
+					TotalWaitingCount += WaitingLocalGridCount;
+				}
+				
+				DebugData.TotalWaiting = TotalWaitingCount;
+				DebugData.TotalSpawnPoints = StationLayout ? StationLayout->SpawnPoints.Num() : 0;
+				DebugData.TotalWaitingPoints = StationLayout ? StationLayout->WaitingPoints.Num() : 0;
 			}
-			
-			DebugData.TotalWaiting = TotalWaitingCount;
-			DebugData.TotalSpawnPoints = QueueFragment.SpawnPoints.Num();
-			DebugData.TotalWaitingPoints = QueueFragment.WaitingPoints.Num();
-
-			// Write to slot index
-			LocalStationSnap[DebugSlot] = DebugData;
-		}
-	});
-	
-	AsyncTask(ENamedThreads::GameThread, [TrainSubsystemWeak, Snap=MoveTemp(LocalStationSnap)]() mutable
-	{
-		if (URogueTrainWorldSubsystem* TSubsystem = TrainSubsystemWeak.Get())
-		{
-			TSubsystem->SetStationDebugSnapshot(MoveTemp(Snap));
-		}
-	});
+		});
+
+		Buffer.Publish();
+	}
+#endif
 }
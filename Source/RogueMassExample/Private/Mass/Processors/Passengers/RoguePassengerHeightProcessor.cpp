@@ -2,11 +2,15 @@
 
 
 #include "Mass/Processors/Passengers/RoguePassengerHeightProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonFragments.h"
 #include "MassExecutionContext.h"
 #include "Mass/Processors/Passengers/RoguePassengerMovementProcessor.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Utilities/RoguePassengerUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Passenger Height"), STAT_RoguePassengerHeight, STATGROUP_RogueSim);
+
 URoguePassengerHeightProcessor::URoguePassengerHeightProcessor(): EntityQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -17,17 +21,21 @@ URoguePassengerHeightProcessor::URoguePassengerHeightProcessor(): EntityQuery(*t
 void URoguePassengerHeightProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
 {
 	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
-	EntityQuery.AddRequirement<FRoguePassengerFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
 	EntityQuery.AddTagRequirement<FRogueTrainPassengerTag>(EMassFragmentPresence::All);
 }
 
 void URoguePassengerHeightProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RoguePassengerHeight);
+	ROGUE_SCOPE_ALLOC_COUNTER("PassengerHeight");
+
 	UWorld* WorldContext = Context.GetWorld();
 	if (!WorldContext) return;
 
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
 		const TArrayView<FTransformFragment> TransformFragments = SubContext.GetMutableFragmentView<FTransformFragment>();		
 		const int32 NumEntities = SubContext.GetNumEntities();
 		
@@ -2,13 +2,18 @@
 
 
 #include "Mass/Processors/Passengers/RoguePassengerMovementProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonFragments.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Simulation/RogueSimTrace.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RoguePassengerUtility.h"
 #include "Utilities/RogueStationQueueUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Passenger Movement"), STAT_RoguePassengerMovement, STATGROUP_RogueSim);
+
 URoguePassengerMovementProcessor::URoguePassengerMovementProcessor(): EntityQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -21,7 +26,9 @@ void URoguePassengerMovementProcessor::ConfigureQueries(const TSharedRef<FMassEn
 	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
 	EntityQuery.AddRequirement<FMassMoveTargetFragment>(EMassFragmentAccess::ReadWrite);	
 	EntityQuery.AddConstSharedRequirement<FMassMovementParameters>(EMassFragmentPresence::All);
+	EntityQuery.AddConstSharedRequirement<FRoguePassengerMovementClassFragment>(EMassFragmentPresence::All);
 	EntityQuery.AddRequirement<FRoguePassengerFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);	
+	EntityQuery.AddRequirement<FRoguePassengerTripFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);	
 	EntityQuery.AddTagRequirement<FRogueTrainPassengerTag>(EMassFragmentPresence::All);
 	EntityQuery.AddSubsystemRequirement<URogueTrainWorldSubsystem>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.RegisterWithProcessor(*this);	
@@ -31,20 +38,29 @@ void URoguePassengerMovementProcessor::ConfigureQueries(const TSharedRef<FMassEn
 
 void URoguePassengerMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RoguePassengerMovement);
+	ROGUE_SCOPE_ALLOC_COUNTER("PassengerMovement");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 	
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+
+	// Passenger decisions run at the sim rate, Mass steering still moves them every frame
+	if (!TrainSubsystem->GetSimClock().ShouldStep()) return;
 
 	const float Time = Context.GetWorld()->GetTimeSeconds();
 
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
 		const TConstArrayView<FTransformFragment> TransformFragments = SubContext.GetMutableFragmentView<FTransformFragment>();
 		const TArrayView<FMassMoveTargetFragment> NavTargetList = SubContext.GetMutableFragmentView<FMassMoveTargetFragment>();
 		const FMassMovementParameters& MoveParams = SubContext.GetConstSharedFragment<FMassMovementParameters>();
+		const FRoguePassengerMovementClassFragment& MovementClass = SubContext.GetConstSharedFragment<FRoguePassengerMovementClassFragment>();
 		const TArrayView<FRoguePassengerFragment> PassengerFragments = SubContext.GetMutableFragmentView<FRoguePassengerFragment>();
+		const TArrayView<FRoguePassengerTripFragment> TripFragments = SubContext.GetMutableFragmentView<FRoguePassengerTripFragment>();
 		const int32 NumEntities = SubContext.GetNumEntities();
 		
 		for (int32 EntityIndex = 0; EntityIndex < NumEntities; EntityIndex++)
@@ -53,17 +69,19 @@ void URoguePassengerMovementProcessor::Execute(FMassEntityManager& EntityManager
 			FMassMoveTargetFragment& MoveTarget = NavTargetList[EntityIndex];
 			const FMassEntityHandle PassengerHandle = SubContext.GetEntity(EntityIndex);
 			FRoguePassengerFragment& PassengerFragment = PassengerFragments[EntityIndex];
+			FRoguePassengerTripFragment& TripFragment = TripFragments[EntityIndex];
 			const FMassEntityHandle Entity = SubContext.GetEntity(EntityIndex);
 
-			// Check we have a valid station, no wait point has been assigned and we are in the entered world phase
-			if (PassengerFragment.OriginStation.IsValid()
-				&& PassengerFragment.WaitingPointIdx == INDEX_NONE
-				&& PassengerFragment.Phase == ERoguePassengerPhase::EnteredWorld)
+			// Check we are in the entered world phase, have a valid station and no wait point has been assigned
+			// Phase is checked first so the trip fragment is only read by passengers that just spawned
+			if (PassengerFragment.Phase == ERoguePassengerPhase::EnteredWorld
+				&& TripFragment.GetOriginStationIdx() != INDEX_NONE
+				&& TripFragment.GetWaitingPointIdx() == INDEX_NONE)
 			{				
 				// Assign a waiting point 
-				AssignWaitingPoint(EntityManager, PassengerFragment, Entity);
+				AssignWaitingPoint(EntityManager, *TrainSubsystem, PassengerFragment, TripFragment, Entity);
 
-				if (PassengerFragment.WaitingSlotIdx == INDEX_NONE)
+				if (TripFragment.GetWaitingSlotIdx() == INDEX_NONE)
 				{
 					MoveTarget.IntentAtGoal = EMassMovementAction::Stand;
 					MoveTarget.DesiredSpeed = FMassInt16Real(0.f);
@@ -74,7 +92,7 @@ void URoguePassengerMovementProcessor::Execute(FMassEntityManager& EntityManager
 			// If we have a move target, update movement towards it			
 			if (PassengerFragment.Phase != ERoguePassengerPhase::RideOnTrain && !PassengerFragment.bWaiting)
 			{
-				MoveToTarget(PassengerFragment, MoveTarget, MoveParams, PTransform, PassengerFragment.Target);
+				MoveToTarget(MovementClass, PassengerFragment, MoveTarget, MoveParams, PTransform, PassengerFragment.Target);
 			}
 
 			// Subsystem with declared thread-safe access
@@ -83,12 +101,12 @@ void URoguePassengerMovementProcessor::Execute(FMassEntityManager& EntityManager
 			// Handle phase-specific logic, destination arrival, boarding, departing and waiting
 			switch (PassengerFragment.Phase)
 			{
-				case ERoguePassengerPhase::ToStationWaitingPoint: ToStationWaitingPoint(EntityManager, PassengerFragment, PTransform, PassengerHandle, Time); break;
-				case ERoguePassengerPhase::ToAssignedCarriage: ToAssignedCarriage(EntityManager, SubContext, PassengerFragment, PTransform, PassengerHandle); break;
+				case ERoguePassengerPhase::ToStationWaitingPoint: ToStationWaitingPoint(EntityManager, *TrainSubsystem, MovementClass, PassengerFragment, TripFragment, PTransform, PassengerHandle, Time); break;
+				case ERoguePassengerPhase::ToAssignedCarriage: ToAssignedCarriage(EntityManager, SubContext, MovementClass, PassengerFragment, TripFragment, PTransform, PassengerHandle); break;
 				case ERoguePassengerPhase::RideOnTrain: break; // Riding, do nothing
-				case ERoguePassengerPhase::UnloadAtStation: UnloadAtStation(EntityManager, PassengerFragment, PTransform); break;
-				case ERoguePassengerPhase::ToPostUnloadWaitingPoint: ToPostUnloadWaitingPoint(EntityManager, PassengerFragment, PTransform); break;
-				case ERoguePassengerPhase::ToExitSpawn: ToExitSpawn(EntityManager, TrainSubsystemMutable, SubContext, PassengerFragment, PTransform, PassengerHandle); break;
+				case ERoguePassengerPhase::UnloadAtStation: UnloadAtStation(EntityManager, *TrainSubsystem, PassengerFragment, TripFragment, PTransform); break;
+				case ERoguePassengerPhase::ToPostUnloadWaitingPoint: ToPostUnloadWaitingPoint(EntityManager, *TrainSubsystem, MovementClass, PassengerFragment, TripFragment, PTransform); break;
+				case ERoguePassengerPhase::ToExitSpawn: ToExitSpawn(EntityManager, TrainSubsystemMutable, SubContext, MovementClass, PassengerFragment, TripFragment, PTransform, PassengerHandle); break;
 				default:
 					break;
 			}
@@ -96,21 +114,26 @@ void URoguePassengerMovementProcessor::Execute(FMassEntityManager& EntityManager
 	});
 }
 
-void URoguePassengerMovementProcessor::AssignWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment, const FMassEntityHandle& Entity)
+void URoguePassengerMovementProcessor::AssignWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, FRoguePassengerFragment& PassengerFragment,
+	FRoguePassengerTripFragment& TripFragment, const FMassEntityHandle& Entity)
 {
-	if (auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(PassengerFragment.OriginStation))
+	const FMassEntityHandle OriginStation = TrainSubsystem.GetStationEntity(TripFragment.GetOriginStationIdx());
+	const FRogueStationLayoutFragment* StationLayout = TrainSubsystem.GetStationLayout(TripFragment.GetOriginStationIdx());
+	auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(OriginStation);
+	if (StationLayout && StationQueueFragment)
 	{
 		// Choose a random waiting point at that station
-		PassengerFragment.WaitingPointIdx = (StationQueueFragment->WaitingPoints.Num() > 0)
-			? FMath::RandRange(0, StationQueueFragment->WaitingPoints.Num() - 1)
-			: INDEX_NONE;
-		if (PassengerFragment.WaitingPointIdx == INDEX_NONE) return;
+		TripFragment.SetWaitingPointIdx((StationLayout->WaitingPoints.Num() > 0)
+			? FMath::RandRange(0, StationLayout->WaitingPoints.Num() - 1)
+			: INDEX_NONE);
+		if (TripFragment.GetWaitingPointIdx() == INDEX_NONE) return;
 
 		// Assign a waiting slot at that waiting point
 		FVector SlotPosition;
-		const int32 SlotIdx = RogueStationQueueUtility::ClaimWaitingSlot(StationQueueFragment, PassengerFragment.WaitingPointIdx, Entity, SlotPosition);
-		PassengerFragment.WaitingSlotIdx = SlotIdx;
+		const int32 SlotIdx = RogueStationQueueUtility::ClaimWaitingSlot(*StationLayout, StationQueueFragment, TripFragment.GetWaitingPointIdx(), Entity, SlotPosition);
+		TripFragment.SetWaitingSlotIdx(SlotIdx);
 		if (SlotIdx == INDEX_NONE) return;
+		TRACE_ROGUE_SIM_EVENT(SlotClaim, EntityManager.GetWorld()->GetTimeSeconds(), Entity, OriginStation, SlotIdx);
 
 		// Assign move target to waiting point
 		PassengerFragment.Target = SlotPosition;
@@ -118,14 +141,14 @@ void URoguePassengerMovementProcessor::AssignWaitingPoint(const FMassEntityManag
 	}
 }
 
-void URoguePassengerMovementProcessor::MoveToTarget(const FRoguePassengerFragment& PassengerFragment, FMassMoveTargetFragment& MoveTarget, const FMassMovementParameters& MoveParams,
+void URoguePassengerMovementProcessor::MoveToTarget(const FRoguePassengerMovementClassFragment& MovementClass, const FRoguePassengerFragment& PassengerFragment, FMassMoveTargetFragment& MoveTarget, const FMassMovementParameters& MoveParams,
 	const FTransform& PTransform, const FVector& TargetDestination)
 {
 	FVector Delta  = PassengerFragment.Target - PTransform.GetLocation();
 	Delta.Z = 0.f;
 	const float DistToGoal = Delta.Size();
 	
-	if (DistToGoal > PassengerFragment.AcceptanceRadius)
+	if (DistToGoal > MovementClass.AcceptanceRadius)
 	{
 		MoveTarget.Center = TargetDestination;
 		MoveTarget.DistanceToGoal = DistToGoal;
@@ -133,76 +156,76 @@ void URoguePassengerMovementProcessor::MoveToTarget(const FRoguePassengerFragmen
 		
 		constexpr float SlowdownRadius = 120.f; 
 		const float t = FMath::Clamp(DistToGoal / SlowdownRadius, 0.f, 1.f);
-		const float TargetSpeed = t * MoveParams.DefaultDesiredSpeed; 
+		const float TargetSpeed = t * FMath::Min(MoveParams.DefaultDesiredSpeed, MovementClass.MaxSpeed); 
 		MoveTarget.DesiredSpeed = FMassInt16Real(TargetSpeed);
 	}
 }
 
-void URoguePassengerMovementProcessor::ToStationWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment,
-	const FTransform& PTransform, const FMassEntityHandle PassengerHandle, const float Time)
+void URoguePassengerMovementProcessor::ToStationWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment,
+	FRoguePassengerTripFragment& TripFragment, const FTransform& PTransform, const FMassEntityHandle PassengerHandle, const float Time)
 {
 	// Arrived? enqueue into that waiting-point queue if not already queued, idle until boarding - boarding handled by station ops processor
-	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(PassengerFragment.AcceptanceRadius) && !PassengerFragment.bWaiting)
+	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(MovementClass.AcceptanceRadius) && !PassengerFragment.bWaiting)
 	{
-		if (!PassengerFragment.OriginStation.IsValid()) return;
+		const FMassEntityHandle OriginStation = TrainSubsystem.GetStationEntity(TripFragment.GetOriginStationIdx());
+		if (!OriginStation.IsValid()) return;
 		
-		if (auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(PassengerFragment.OriginStation))
+		if (auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(OriginStation))
 		{
-			RoguePassengerQueueUtility::EnqueueAtWaitingPoint(*StationQueueFragment, PassengerFragment.WaitingPointIdx, PassengerHandle, PassengerFragment.DestinationStation, Time, /*prio*/0);
+			RoguePassengerQueueUtility::EnqueueAtWaitingPoint(*StationQueueFragment, TripFragment.GetWaitingPointIdx(), PassengerHandle, TripFragment.GetDestStationIdx(), Time, /*prio*/0);
 			PassengerFragment.bWaiting = true;
 			PassengerFragment.Target = PTransform.GetLocation();
 		}		
 	}
 }
 
-void URoguePassengerMovementProcessor::ToAssignedCarriage(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, FRoguePassengerFragment& PassengerFragment,
+void URoguePassengerMovementProcessor::ToAssignedCarriage(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 	 const FTransform& PTransform, const FMassEntityHandle PassengerHandle)
 {
 	// If we were boarded already, VehicleHandle is set, head to the carriage door (carriage transform)
-	if (PassengerFragment.VehicleHandle.IsSet() && EntityManager.IsEntityValid(PassengerFragment.VehicleHandle))
+	if (TripFragment.VehicleHandle.IsSet() && EntityManager.IsEntityValid(TripFragment.VehicleHandle))
 	{
-		if (const auto* CarriageTransformFragment = EntityManager.GetFragmentDataPtr<FTransformFragment>(PassengerFragment.VehicleHandle))
+		if (const auto* CarriageTransformFragment = EntityManager.GetFragmentDataPtr<FTransformFragment>(TripFragment.VehicleHandle))
 		{
 			PassengerFragment.Target = CarriageTransformFragment->GetTransform().GetLocation();
 
-			if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(PassengerFragment.AcceptanceRadius))
+			if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(MovementClass.AcceptanceRadius))
 			{				
 				RoguePassengerUtility::HidePassenger(EntityManager, PassengerHandle);
 				PassengerFragment.Phase = ERoguePassengerPhase::RideOnTrain;
-				PassengerFragment.WaitingPointIdx = INDEX_NONE;
-				PassengerFragment.WaitingSlotIdx = INDEX_NONE;
+				TripFragment.ClearWaiting();
 			}
 		}
 	}
 }
 
-void URoguePassengerMovementProcessor::UnloadAtStation(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment, const FTransform& PTransform)
+void URoguePassengerMovementProcessor::UnloadAtStation(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, FRoguePassengerFragment& PassengerFragment,
+	FRoguePassengerTripFragment& TripFragment, const FTransform& PTransform)
 {
-	if (!PassengerFragment.DestinationStation.IsValid()) return;
-
-	if (const auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(PassengerFragment.DestinationStation))
+	if (const FRogueStationLayoutFragment* StationLayout = TrainSubsystem.GetStationLayout(TripFragment.GetDestStationIdx()))
 	{
-		const int32 WaitingPoint = RoguePassengerUtility::FindNearestIndex(StationQueueFragment->WaitingPoints, PTransform.GetLocation());				
-		if (StationQueueFragment->WaitingPoints.IsValidIndex(WaitingPoint))
+		const int32 WaitingPoint = RoguePassengerUtility::FindNearestIndex(StationLayout->WaitingPoints, PTransform.GetLocation());				
+		if (StationLayout->WaitingPoints.IsValidIndex(WaitingPoint))
 		{
-			PassengerFragment.WaitingPointIdx = WaitingPoint;
-			PassengerFragment.Target = StationQueueFragment->WaitingPoints[WaitingPoint];
+			TripFragment.SetWaitingPointIdx(WaitingPoint);
+			PassengerFragment.Target = StationLayout->WaitingPoints[WaitingPoint];
 			PassengerFragment.Phase = ERoguePassengerPhase::ToPostUnloadWaitingPoint;
 		}
 	}
 }
 
-void URoguePassengerMovementProcessor::ToPostUnloadWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment, const FTransform& PTransform)
+void URoguePassengerMovementProcessor::ToPostUnloadWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment,
+	FRoguePassengerTripFragment& TripFragment, const FTransform& PTransform)
 {
-	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(PassengerFragment.AcceptanceRadius * 2.f))
+	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(MovementClass.AcceptanceRadius * 2.f))
 	{
 		// Immediately head to nearest exit spawn to leave the world
-		if (const auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(PassengerFragment.DestinationStation))
+		if (const FRogueStationLayoutFragment* StationLayout = TrainSubsystem.GetStationLayout(TripFragment.GetDestStationIdx()))
 		{
-			const int32 ExitIdx = RoguePassengerUtility::FindNearestIndex(StationQueueFragment->SpawnPoints, PTransform.GetLocation());			
-			if (StationQueueFragment->SpawnPoints.IsValidIndex(ExitIdx))
+			const int32 ExitIdx = RoguePassengerUtility::FindNearestIndex(StationLayout->SpawnPoints, PTransform.GetLocation());			
+			if (StationLayout->SpawnPoints.IsValidIndex(ExitIdx))
 			{
-				PassengerFragment.Target = StationQueueFragment->SpawnPoints[ExitIdx];
+				PassengerFragment.Target = StationLayout->SpawnPoints[ExitIdx];
 			}
 		}
 		
@@ -210,16 +233,18 @@ void URoguePassengerMovementProcessor::ToPostUnloadWaitingPoint(const FMassEntit
 	}
 }
 
-void URoguePassengerMovementProcessor::ToExitSpawn(const FMassEntityManager& EntityManager, URogueTrainWorldSubsystem& TrainSubsystem, const FMassExecutionContext& Context, FRoguePassengerFragment& PassengerFragment,
+void URoguePassengerMovementProcessor::ToExitSpawn(const FMassEntityManager& EntityManager, URogueTrainWorldSubsystem& TrainSubsystem, const FMassExecutionContext& Context, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 	 const FTransform& PTransform, const FMassEntityHandle PassengerHandle)
 {
-	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(PassengerFragment.AcceptanceRadius))
+	if (FVector::DistSquared(PTransform.GetLocation(), PassengerFragment.Target) <= FMath::Square(MovementClass.AcceptanceRadius))
 	{
-		if (auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(PassengerFragment.OriginStation))
+		const FMassEntityHandle OriginStation = TrainSubsystem.GetStationEntity(TripFragment.GetOriginStationIdx());
+		if (auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(OriginStation))
 		{
-			if (PassengerFragment.bWaiting && PassengerFragment.WaitingPointIdx != INDEX_NONE && PassengerFragment.WaitingSlotIdx != INDEX_NONE)
+			if (PassengerFragment.bWaiting && TripFragment.GetWaitingPointIdx() != INDEX_NONE && TripFragment.GetWaitingSlotIdx() != INDEX_NONE)
 			{
-				RogueStationQueueUtility::ReleaseSlot(*StationQueueFragment, PassengerFragment);
+				RogueStationQueueUtility::ReleaseSlot(*StationQueueFragment, TripFragment);
+				TRACE_ROGUE_SIM_EVENT(SlotRelease, Context.GetWorld()->GetTimeSeconds(), PassengerHandle, OriginStation, TripFragment.GetWaitingSlotIdx());
 			}
 		}
 		
@@ -2,11 +2,15 @@
 
 
 #include "Mass/Processors/Passengers/RoguePassengerSpawnProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
 #include "Data/RogueDeveloperSettings.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 
+DECLARE_CYCLE_STAT(TEXT("Passenger Spawn"), STAT_RoguePassengerSpawn, STATGROUP_RogueSim);
+
 
 URoguePassengerSpawnProcessor::URoguePassengerSpawnProcessor(): EntityQuery(*this)
 {
@@ -24,55 +28,60 @@ void URoguePassengerSpawnProcessor::ConfigureQueries(const TSharedRef<FMassEntit
 
 void URoguePassengerSpawnProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RoguePassengerSpawn);
+	ROGUE_SCOPE_ALLOC_COUNTER("PassengerSpawn");
+
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
 	
-	const FMassEntityTemplate* PassengerEntityTemplate = TrainSubsystem->GetPassengerTemplate();
-	if (!PassengerEntityTemplate->IsValid()) return;
+	if (!TrainSubsystem->GetPassengerTemplate()) return;
 	
 	SpawnAccumulator += Context.GetDeltaTimeSeconds();
 	if (SpawnAccumulator < Settings->SpawnIntervalSeconds) return;
 	SpawnAccumulator = 0.f;
 
 	// Cap overall passengers
-	if (TrainSubsystem->GetLiveCount(ERogueEntityType::Passenger) >= Settings->MaxPassengersOverall) return;
+	const int32 NumToSpawn = FMath::Min(Settings->PassengersPerSpawn, Settings->MaxPassengersOverall - TrainSubsystem->GetLiveCount(ERogueEntityType::Passenger));
+	for (int32 SpawnIdx = 0; SpawnIdx < NumToSpawn; ++SpawnIdx)
+	{
+		// Pick a random line, passengers travel between stations on the same line
+		const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared(FMath::RandHelper(TrainSubsystem->GetNumTrackLines()));
+		if (!TrackSharedFragment.IsValid()) continue;
 
-	// Pick a random station that has spawn points to spawn at
-	const FMassEntityHandle StationHandle = TrackSharedFragment.GetRandomStationEntity();
-	if (!StationHandle.IsValid()) return;
+		// Pick a random station that has spawn points to spawn at
+		const int32 OriginIdx = TrackSharedFragment.GetRandomStationIndex();
+		const FMassEntityHandle StationHandle = TrackSharedFragment.GetStationEntityByIndex(OriginIdx);
+		if (!StationHandle.IsValid()) continue;
 
-	// Get station queue fragment from chosen station
-	auto* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(StationHandle);
-	if (!StationQueueFragment || StationQueueFragment->SpawnPoints.Num() == 0) return;
+		// Spawn and waiting points come from the chosen station's static layout
+		const FRogueStationLayoutFragment* StationLayout = TrainSubsystem->GetStationLayout(TrackSharedFragment.GetGlobalStationIndex(OriginIdx));
+		if (!StationLayout || StationLayout->SpawnPoints.Num() == 0) continue;
 
-	// Get a random station index for destination that is not current station index
-	const FMassEntityHandle DestinationStation = TrackSharedFragment.GetRandomStationEntity();
-	if (!DestinationStation.IsValid()) return;
+		// Get a random station index for destination that is not current station index
+		const int32 DestinationIdx = TrackSharedFragment.GetRandomStationIndex();
+		if (DestinationIdx == INDEX_NONE) continue;
 	
-	// Choose a random waiting point
-	const int32 WaitingIdx = (StationQueueFragment->WaitingPoints.Num() > 0)
-		? FMath::RandRange(0, StationQueueFragment->WaitingPoints.Num() - 1)
-		: INDEX_NONE;
-
-	// Choose a random spawn point
-	const FVector SpawnLoc = StationQueueFragment->SpawnPoints[FMath::RandHelper(StationQueueFragment->SpawnPoints.Num())];
-
-	FRogueSpawnRequest Request;
-	Request.Type = ERogueEntityType::Passenger;
-	Request.EntityTemplate = PassengerEntityTemplate;
-	Request.RemainingCount = 1;
-	Request.Transform = FTransform(SpawnLoc);
-	Request.OriginStation = StationHandle;
-	Request.DestinationStation = DestinationStation;
-	Request.WaitingPointIdx = WaitingIdx;
-	Request.AcceptanceRadius = Settings->PassengerAcceptanceRadius;
-	Request.MaxSpeed = Settings->PassengerMaxSpeed;
-
-	TrainSubsystem->EnqueueSpawns(Request);
+		// Choose a random waiting point
+		const int32 WaitingIdx = (StationLayout->WaitingPoints.Num() > 0)
+			? FMath::RandRange(0, StationLayout->WaitingPoints.Num() - 1)
+			: INDEX_NONE;
+
+		// Choose a random spawn point
+		const FVector SpawnLoc = StationLayout->SpawnPoints[FMath::RandHelper(StationLayout->SpawnPoints.Num())];
+
+		FRogueSpawnRequest Request;
+		Request.Type = ERogueEntityType::Passenger;
+		Request.RemainingCount = 1;
+		Request.Location = SpawnLoc;
+		Request.OriginStationIdx = TrackSharedFragment.GetGlobalStationIndex(OriginIdx);
+		Request.DestinationStationIdx = TrackSharedFragment.GetGlobalStationIndex(DestinationIdx);
+		Request.WaitingPointIdx = WaitingIdx;
+
+		TrainSubsystem->EnqueueSpawns(Request);
+	}
 }
@@ -2,13 +2,18 @@
 
 
 #include "Mass/Processors/Stations/RogueTrainStationDetectProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
 #include "Data/RogueDeveloperSettings.h"
 #include "Mass/Fragments/RogueFragments.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Simulation/RogueSimTrace.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RogueTrainUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Station Detect"), STAT_RogueStationDetect, STATGROUP_RogueSim);
+
 URogueTrainStationDetectProcessor::URogueTrainStationDetectProcessor(): EntityQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -21,53 +26,75 @@ void URogueTrainStationDetectProcessor::ConfigureQueries(const TSharedRef<FMassE
 	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddRequirement<FRogueTrainStateFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.RegisterWithProcessor(*this);
 }
 
 void URogueTrainStationDetectProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueStationDetect);
+	ROGUE_SCOPE_ALLOC_COUNTER("StationDetect");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 	
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+
+	const FRogueSimClock& SimClock = TrainSubsystem->GetSimClock();
+	if (!SimClock.ShouldStep()) return;
 
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if(!Settings) return;
 	
 	const float StopRadius = Settings ? Settings->StationStopRadius : 600.f;
 	const float ArriveRadius = Settings ? Settings->StationArrivalRadius : 50.f;
+	const double SimTime = Context.GetWorld()->GetTimeSeconds();
 
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Track data for the line this chunk's trains run on
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid()) return;
+
 		const auto TrackFollowFragments = SubContext.GetMutableFragmentView<FRogueTrainTrackFollowFragment>();
 		const auto StateView  = SubContext.GetMutableFragmentView<FRogueTrainStateFragment>();
 
 		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
 		{
-			const auto& TrackFollowFragment = TrackFollowFragments[i];
+			auto& TrackFollowFragment = TrackFollowFragments[i];
 			auto& State = StateView[i];
 
 			if (State.TargetStationIdx == INDEX_NONE)
 			{
-				State.TargetStationIdx = RogueTrainUtility::FindNextStation(*TrackSharedFragment.Spline, TrackSharedFragment.Platforms, TrackFollowFragment.Alpha);
-				State.PrevAlpha = TrackFollowFragment.Alpha;
+				State.TargetStationIdx = RogueTrainUtility::FindNextStation(TrackSharedFragment.Platforms, TrackFollowFragment.Distance, TrackSharedFragment.TrackLength);
+				State.PrevDistance = TrackFollowFragment.Distance;
 				continue; // next tick we’ll evaluate distance
 			}
 
-			const float DockAlpha = TrackSharedFragment.Platforms[State.TargetStationIdx].DockAlpha;
-			const float PrevDistAlpha = RogueTrainUtility::ArcDistanceWrapped(State.PrevAlpha, DockAlpha);
-			const float DistAlpha = RogueTrainUtility::ArcDistanceWrapped(TrackFollowFragment.Alpha, DockAlpha);
-			const float Dist = DistAlpha * TrackSharedFragment.TrackLength;
-			const float DeltaTime = SubContext.GetDeltaTimeSeconds();
+			const double DockDistance = TrackSharedFragment.Platforms[State.TargetStationIdx].DockDistance;
+			const double PrevDist = RogueTrainUtility::ArcDistanceWrapped(State.PrevDistance, DockDistance, TrackSharedFragment.TrackLength);
+			double Dist = RogueTrainUtility::ArcDistanceWrapped(TrackFollowFragment.Distance, DockDistance, TrackSharedFragment.TrackLength);
+			const float DeltaTime = SimClock.GetFrameDeltaTime();
 
-			if (DistAlpha > PrevDistAlpha && !State.bAtStation)
+			// Swept arrival, a dock passed between sim frames still counts, snap back onto it
+			const double Travelled = RogueTrainUtility::ArcDistanceWrapped(State.PrevDistance, TrackFollowFragment.Distance, TrackSharedFragment.TrackLength);
+			const bool bCrossedDock = Travelled > 0.0 && PrevDist <= Travelled;
+			if (bCrossedDock && !State.bAtStation)
+			{
+				TrackFollowFragment.Distance = DockDistance;
+				TrackFollowFragment.InterpFromDistance = DockDistance;
+				TrackFollowFragment.Speed = 0.f;
+				Dist = 0.0;
+			}
+			else if (Dist > PrevDist && !State.bAtStation)
 			{
 				// missed the stop; advance target and reset stopping flags
 				State.bIsStopping = false;
 				State.bAtStation = false;
 				State.PreviousStationIdx = State.TargetStationIdx;
-				State.TargetStationIdx = RogueTrainUtility::FindNextStation(*TrackSharedFragment.Spline, TrackSharedFragment.Platforms, TrackFollowFragment.Alpha);
+				State.TargetStationIdx = RogueTrainUtility::FindNextStation(TrackSharedFragment.Platforms, TrackFollowFragment.Distance, TrackSharedFragment.TrackLength);
 			}
 			
 			if (!State.bAtStation)
@@ -80,6 +107,12 @@ void URogueTrainStationDetectProcessor::Execute(FMassEntityManager& EntityManage
 				{
 					State.bAtStation = true;
 					State.StationTimeRemaining = Settings ? Settings->MaxDwellTimeSeconds : 2.f;
+					++TrainSubsystem->GetMutableRunStats().TrainArrivals;
+
+					if (TrackSharedFragment.StationEntities.IsValidIndex(State.TargetStationIdx))
+					{
+						TRACE_ROGUE_SIM_EVENT(TrainArrive, SimTime, SubContext.GetEntity(i), TrackSharedFragment.StationEntities[State.TargetStationIdx].Value, State.TargetStationIdx);
+					}
 				}
 			}
 			else
@@ -95,10 +128,12 @@ void URogueTrainStationDetectProcessor::Execute(FMassEntityManager& EntityManage
 					State.bIsStopping = false;
 					State.PreviousStationIdx = State.TargetStationIdx;
 					State.TargetStationIdx = (State.TargetStationIdx + 1) % TrackSharedFragment.StationEntities.Num();
+					++TrainSubsystem->GetMutableRunStats().TrainDepartures;
 
 					// Inform station we are departing, free up dock
 					if (!TrackSharedFragment.StationEntities.IsValidIndex(State.TargetStationIdx)) continue;			
 					const FMassEntityHandle PreviousStationEntity = TrackSharedFragment.StationEntities[State.PreviousStationIdx].Value;
+					TRACE_ROGUE_SIM_EVENT(TrainDepart, SimTime, SubContext.GetEntity(i), PreviousStationEntity, State.PreviousStationIdx);
 					if (auto* PreviousStationFragment = EntityManager.GetFragmentDataPtr<FRogueStationFragment>(PreviousStationEntity))
 					{
 						PreviousStationFragment->DockedTrain = FMassEntityHandle();
@@ -106,7 +141,7 @@ void URogueTrainStationDetectProcessor::Execute(FMassEntityManager& EntityManage
 				}
 			}
 			
-			State.PrevAlpha = TrackFollowFragment.Alpha;
+			State.PrevDistance = TrackFollowFragment.Distance;
 		}
 	});	
 }
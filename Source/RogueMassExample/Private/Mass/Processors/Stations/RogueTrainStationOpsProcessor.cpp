@@ -2,17 +2,42 @@
 
 
 #include "Mass/Processors/Stations/RogueTrainStationOpsProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonFragments.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
 #include "Data/RogueDeveloperSettings.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Simulation/RogueSimTrace.h"
 #include "Mass/Processors/Stations/RogueTrainStationDetectProcessor.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RoguePassengerUtility.h"
 #include "Utilities/RogueStationQueueUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Station Ops"), STAT_RogueStationOps, STATGROUP_RogueSim);
+DECLARE_CYCLE_STAT(TEXT("Station Unload"), STAT_RogueStationUnload, STATGROUP_RogueSim);
+DECLARE_CYCLE_STAT(TEXT("Station Load"), STAT_RogueStationLoad, STATGROUP_RogueSim);
 
-URogueTrainStationOpsProcessor::URogueTrainStationOpsProcessor(): EntityQuery(*this)
+namespace
+{
+	// Train loading this step, boarded after the train pass grouped by station
+	struct FRogueLoadingTrain
+	{
+		int32 StationIdx = INDEX_NONE;
+		FMassEntityHandle StationEntity;
+		int32 ConsistId = INDEX_NONE;
+	};
+
+	// Waiting passenger that may board, read from the station's passenger chunks
+	struct FRogueBoardCandidate
+	{
+		int32 WaitingPointIdx = INDEX_NONE;
+		int32 SlotIdx = INDEX_NONE;
+		FMassEntityHandle Passenger;
+	};
+}
+
+URogueTrainStationOpsProcessor::URogueTrainStationOpsProcessor(): EntityQuery(*this), StationPassengerQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
 	ProcessingPhase = EMassProcessingPhase::PrePhysics;
@@ -23,27 +48,52 @@ void URogueTrainStationOpsProcessor::ConfigureQueries(const TSharedRef<FMassEnti
 {
 	EntityQuery.AddRequirement<FRogueTrainStateFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.RegisterWithProcessor(*this);
+
+	StationPassengerQuery.AddRequirement<FRoguePassengerFragment>(EMassFragmentAccess::ReadOnly);
+	StationPassengerQuery.AddRequirement<FRoguePassengerTripFragment>(EMassFragmentAccess::ReadOnly);
+	StationPassengerQuery.AddTagRequirement<FRogueTrainPassengerTag>(EMassFragmentPresence::All);
+	StationPassengerQuery.AddSharedRequirement<FRoguePassengerStationSharedFragment>(EMassFragmentAccess::ReadOnly);
+	StationPassengerQuery.RegisterWithProcessor(*this);
 }
 
 void URogueTrainStationOpsProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueStationOps);
+	ROGUE_SCOPE_ALLOC_COUNTER("StationOps");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+	if (!TrainSubsystem->GetSimClock().ShouldStep()) return;
 
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 
 	const float DepartureTime = Settings->DepartureTimeSeconds;
 	const int32 MaxLoadPerTickPerCar = Settings->MaxLoadPerTickPerCarriage;
+	FRogueOccupantSlab& OccupantSlab = TrainSubsystem->GetOccupantSlab();
 	const float StationStateSwitchTime = (Settings->MaxDwellTimeSeconds * 0.5f) + (DepartureTime * 0.5f);
 	const float CurrentTime = Context.GetWorld()->GetTimeSeconds();
 
+	// Frame scratch for the whole step, nothing below opens a nested scope while these arrays can grow
+	FRogueScratchScope ScratchScope;
+	TRogueScratchArray<FRogueLoadingTrain> LoadingTrains;
+	TRogueScratchArray<FRogueBoardCandidate> Candidates;
+	TRogueScratchArray<int32> CandidateCursors;
+	TRogueScratchArray<int32> CandidateEnds;
+	TRogueScratchArray<int32> WaitingPointIndices;
+
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Track data for the line this chunk's trains run on
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid()) return;
+
 		const TArrayView<FRogueTrainStateFragment> StateView = SubContext.GetMutableFragmentView<FRogueTrainStateFragment>();
 
 		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
@@ -94,26 +144,34 @@ void URogueTrainStationOpsProcessor::Execute(FMassEntityManager& EntityManager,
             // Resolve current station entity
             if (!TrackSharedFragment.StationEntities.IsValidIndex(State.TargetStationIdx)) continue;			
             const FMassEntityHandle CurrentStationEntity = TrackSharedFragment.StationEntities[State.TargetStationIdx].Value;
+			const int32 CurrentStationIdx = TrackSharedFragment.GetGlobalStationIndex(State.TargetStationIdx);
 			if (!EntityManager.IsEntityValid(CurrentStationEntity)) continue;
 
 			// Get station queue fragment
             FRogueStationQueueFragment* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(CurrentStationEntity);
             if (!StationQueueFragment) continue;
+			const FRogueStationLayoutFragment* StationLayout = TrainSubsystem->GetStationLayout(CurrentStationIdx);
+			if (!StationLayout) continue;
 
             // Gather carriages for this engine
-            const TArray<FMassEntityHandle>& CarriageList = State.Carriages;
+            const TConstArrayView<FMassEntityHandle> CarriageList = TrainSubsystem->GetConsists().GetCarriages(State.ConsistId);
             if (CarriageList.Num() <= 0) continue;
 
             // UNLOAD passengers whose Dest == current station (per carriage)
 			if (State.StationTrainPhase == ERogueStationTrainPhase::Unloading)
 			{
+				SCOPE_CYCLE_COUNTER(STAT_RogueStationUnload);
+				
 				int32 EmptyCarriages = 0;
 				for (const FMassEntityHandle CarriageEntity : CarriageList)
 				{					
+					// Slots of carriages still spawning are unset, nothing to unload there
+					if (!RoguePassengerUtility::IsHandleValid(EntityManager, CarriageEntity)) { EmptyCarriages++; continue; }
+					
 					auto* CarriageFragment = EntityManager.GetFragmentDataPtr<FRogueCarriageFragment>(CarriageEntity);
 					if (!CarriageFragment) continue;
 
-					if (CarriageFragment->Occupants.Num() <= 0) EmptyCarriages++;
+					if (CarriageFragment->NumOccupants <= 0) EmptyCarriages++;
 					if (CurrentTime < CarriageFragment->NextAllowedUnloadTime) continue;
 
 					auto* CarriageTransformFragment = EntityManager.GetFragmentDataPtr<FTransformFragment>(CarriageEntity);
@@ -121,29 +179,29 @@ void URogueTrainStationOpsProcessor::Execute(FMassEntityManager& EntityManager,
 
 					const FVector CarriageLocation = CarriageTransformFragment->GetTransform().GetLocation();
 					
-					const int32 NumOccupants = CarriageFragment->Occupants.Num();
-					for (int32 Attempts = 0; Attempts < NumOccupants; ++Attempts)
+					const int32 NumOccupants = CarriageFragment->NumOccupants;
+					for (int32 Attempts = 0; Attempts < NumOccupants && CarriageFragment->NumOccupants > 0; ++Attempts)
 					{
-						const int32 Idx = CarriageFragment->UnloadCursor % CarriageFragment->Occupants.Num();
-						const FMassEntityHandle Passenger = CarriageFragment->Occupants[Idx];
+						const int32 Idx = CarriageFragment->UnloadCursor % CarriageFragment->NumOccupants;
+						const FMassEntityHandle Passenger = OccupantSlab.GetOccupants(*CarriageFragment)[Idx];
 
 						if (!RoguePassengerUtility::IsHandleValid(EntityManager, Passenger))
 						{
-							CarriageFragment->Occupants.RemoveAtSwap(Idx);
+							OccupantSlab.RemoveAtSwap(*CarriageFragment, Idx);
 							continue;
 						}
 
-						const FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger);
-						if (!PassengerFragment)
+						const FRoguePassengerTripFragment* TripFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerTripFragment>(Passenger);
+						if (!TripFragment)
 						{
-							CarriageFragment->Occupants.RemoveAtSwap(Idx);
+							OccupantSlab.RemoveAtSwap(*CarriageFragment, Idx);
 							continue;
 						}
 
 						// Only disembark if this is the destination station
-						if (PassengerFragment->DestinationStation == CurrentStationEntity)
+						if (TripFragment->GetDestStationIdx() == CurrentStationIdx)
 						{
-							RoguePassengerUtility::Disembark(EntityManager, SubContext, *CarriageFragment, Idx, CarriageLocation);
+							RoguePassengerUtility::Disembark(EntityManager, SubContext, CarriageEntity, *CarriageFragment, OccupantSlab, Idx, CarriageLocation);
 							CarriageFragment->NextAllowedUnloadTime = CurrentTime + Settings->UnloadIntervalSeconds;
 							
 							// Keeping UnloadCursor at same Idx; the next passenger shifts into this slot
@@ -163,80 +221,140 @@ void URogueTrainStationOpsProcessor::Execute(FMassEntityManager& EntityManager,
 				}
 			}
 
-            // LOAD passengers whose dest != current station (per carriage)
+            // LOAD passengers whose dest != current station, boarded per station once every train has been stepped
 			if (State.StationTrainPhase == ERogueStationTrainPhase::Loading)
 			{
-				for (const FMassEntityHandle CarriageEntity : CarriageList)
-				{
-					auto* CarriageFragment = EntityManager.GetFragmentDataPtr<FRogueCarriageFragment>(CarriageEntity);
-					const FTransformFragment* CarriageTransformFragment = EntityManager.GetFragmentDataPtr<FTransformFragment>(CarriageEntity);
-					if (!CarriageFragment || !CarriageTransformFragment) continue;
+				LoadingTrains.Add({ CurrentStationIdx, CurrentStationEntity, State.ConsistId });
+			}
+        }
+    });
 
-					const int32 FreeSlots = CarriageFragment->Capacity - CarriageFragment->Occupants.Num();
-					if (FreeSlots <= 0) continue;
+	if (LoadingTrains.Num() == 0) return;
 
-					int32 BoardingBudget = FMath::Min(FreeSlots, MaxLoadPerTickPerCar);
-					if (BoardingBudget <= 0) continue;
+	SCOPE_CYCLE_COUNTER(STAT_RogueStationLoad);
 
-					// Build a list of WP indices from the TMap
-					TArray<int32> WaitingPointIndices;
-					WaitingPointIndices.Reserve(StationQueueFragment->Grids.Num());
-					for (const auto& Pair : StationQueueFragment->Grids)
-					{
-						WaitingPointIndices.Add(Pair.Key);
-					}
+	// Trains at the same station share one read of its passenger chunks
+	LoadingTrains.StableSort([](const FRogueLoadingTrain& A, const FRogueLoadingTrain& B) { return A.StationIdx < B.StationIdx; });
 
-					// Sort by distance to carriage
-					const FVector CarriageLocation = CarriageTransformFragment->GetTransform().GetLocation();
-					WaitingPointIndices.Sort([&](const int32 A, const int32 B)
-					{
-						const FVector& PositionA = StationQueueFragment->WaitingPoints[A];
-						const FVector& PositionB = StationQueueFragment->WaitingPoints[B];
-						return FVector::DistSquared(PositionA, CarriageLocation) < FVector::DistSquared(PositionB, CarriageLocation);
-					});
+	for (int32 First = 0, Last = 0; First < LoadingTrains.Num(); First = Last)
+	{
+		const int32 StationIdx = LoadingTrains[First].StationIdx;
+		for (Last = First + 1; Last < LoadingTrains.Num() && LoadingTrains[Last].StationIdx == StationIdx; ++Last) {}
+
+		FRogueStationQueueFragment* StationQueueFragment = EntityManager.GetFragmentDataPtr<FRogueStationQueueFragment>(LoadingTrains[First].StationEntity);
+		const FRogueStationLayoutFragment* StationLayout = TrainSubsystem->GetStationLayout(StationIdx);
+		if (!StationQueueFragment || !StationLayout) continue;
+
+		// Stream the station's passenger chunks once instead of resolving every grid slot handle, same test as PeekFromGrid
+		Candidates.Reset();
+		RoguePassengerUtility::ForEachStationPassengerChunk(StationPassengerQuery, Context, StationIdx, [&](FMassExecutionContext& PassengerContext)
+		{
+			const TConstArrayView<FRoguePassengerFragment> PassengerView = PassengerContext.GetFragmentView<FRoguePassengerFragment>();
+			const TConstArrayView<FRoguePassengerTripFragment> TripView = PassengerContext.GetFragmentView<FRoguePassengerTripFragment>();
+
+			for (int32 i = 0; i < PassengerContext.GetNumEntities(); ++i)
+			{
+				const FRoguePassengerTripFragment& TripFragment = TripView[i];
+				if (!PassengerView[i].bWaiting || TripFragment.GetOriginStationIdx() != StationIdx) continue;
+				if (!StationLayout->WaitingPoints.IsValidIndex(TripFragment.GetWaitingPointIdx()) || TripFragment.GetWaitingSlotIdx() == INDEX_NONE) continue;
 
-					// Drain queues in waiting point distance order
-					for (int32 j = 0; j < WaitingPointIndices.Num() && BoardingBudget > 0; ++j)
+				Candidates.Add({ TripFragment.GetWaitingPointIdx(), TripFragment.GetWaitingSlotIdx(), PassengerContext.GetEntity(i) });
+			}
+		});
+		if (Candidates.Num() == 0) continue;
+
+		// Each waiting point boards in slot order, the order PeekFromGrid scans its grid in
+		Candidates.Sort([](const FRogueBoardCandidate& A, const FRogueBoardCandidate& B)
+		{
+			return A.WaitingPointIdx != B.WaitingPointIdx ? A.WaitingPointIdx < B.WaitingPointIdx : A.SlotIdx < B.SlotIdx;
+		});
+
+		// Candidate range per waiting point, cursors carry over between the carriages and trains at this station
+		CandidateCursors.Init(0, StationLayout->WaitingPoints.Num());
+		CandidateEnds.Init(0, StationLayout->WaitingPoints.Num());
+		for (int32 c = Candidates.Num() - 1; c >= 0; --c)
+		{
+			CandidateCursors[Candidates[c].WaitingPointIdx] = c;
+			CandidateEnds[Candidates[c].WaitingPointIdx] = FMath::Max(CandidateEnds[Candidates[c].WaitingPointIdx], c + 1);
+		}
+
+		for (int32 TrainIdx = First; TrainIdx < Last; ++TrainIdx)
+		{
+			const FRogueLoadingTrain& LoadingTrain = LoadingTrains[TrainIdx];
+			const TConstArrayView<FMassEntityHandle> CarriageList = TrainSubsystem->GetConsists().GetCarriages(LoadingTrain.ConsistId);
+			if (CarriageList.Num() <= 0) continue;
+
+			// A train is built from one carriage class, read its capacity once per train
+			const FRogueCarriageClassFragment* CarriageClass = RoguePassengerUtility::IsHandleValid(EntityManager, CarriageList[0])
+				? EntityManager.GetConstSharedFragmentDataPtr<FRogueCarriageClassFragment>(CarriageList[0]) : nullptr;
+			const int32 Capacity = CarriageClass ? CarriageClass->Capacity : 0;
+
+			for (const FMassEntityHandle CarriageEntity : CarriageList)
+			{
+				if (!RoguePassengerUtility::IsHandleValid(EntityManager, CarriageEntity)) continue;
+				
+				auto* CarriageFragment = EntityManager.GetFragmentDataPtr<FRogueCarriageFragment>(CarriageEntity);
+				const FTransformFragment* CarriageTransformFragment = EntityManager.GetFragmentDataPtr<FTransformFragment>(CarriageEntity);
+				if (!CarriageFragment || !CarriageTransformFragment) continue;
+
+				const int32 FreeSlots = Capacity - CarriageFragment->NumOccupants;
+				if (FreeSlots <= 0) continue;
+
+				int32 BoardingBudget = FMath::Min(FreeSlots, MaxLoadPerTickPerCar);
+				if (BoardingBudget <= 0) continue;
+
+				// Build a list of WP indices from the TMap
+				WaitingPointIndices.Reset();
+				WaitingPointIndices.Reserve(StationQueueFragment->Grids.Num());
+				for (const auto& Pair : StationQueueFragment->Grids)
+				{
+					if (CandidateCursors.IsValidIndex(Pair.Key)) WaitingPointIndices.Add(Pair.Key);
+				}
+
+				// Sort by distance to carriage
+				const FVector CarriageLocation = CarriageTransformFragment->GetTransform().GetLocation();
+				WaitingPointIndices.Sort([&](const int32 A, const int32 B)
+				{
+					const FVector& PositionA = StationLayout->WaitingPoints[A];
+					const FVector& PositionB = StationLayout->WaitingPoints[B];
+					return FVector::DistSquared(PositionA, CarriageLocation) < FVector::DistSquared(PositionB, CarriageLocation);
+				});
+
+				// Drain queues in waiting point distance order
+				for (int32 j = 0; j < WaitingPointIndices.Num() && BoardingBudget > 0; ++j)
+				{
+					const int32 WaitingPointIdx = WaitingPointIndices[j];
+					const FRogueWaitingGrid& Grid = StationQueueFragment->Grids.FindChecked(WaitingPointIdx);
+					int32& Cursor = CandidateCursors[WaitingPointIdx];
+	
+					for (; Cursor < CandidateEnds[WaitingPointIdx] && BoardingBudget > 0; ++Cursor)
 					{
-						const int32 WaitingPointIdx = WaitingPointIndices[j];
-		
-						while (BoardingBudget > 0)
-						{
-							FMassEntityHandle Passenger;
-							int32 SlotIdx = INDEX_NONE;
-							FVector SlotPos;
+						const FRogueBoardCandidate& Candidate = Candidates[Cursor];
 
-							// Peek at next passenger in queue, if none move to next waiting point
-							if (!RogueStationQueueUtility::PeekFromGrid(EntityManager, *StationQueueFragment, WaitingPointIdx, Passenger, CurrentStationEntity, SlotIdx, SlotPos))
-								break;
-							
-							// Try to board passenger, if successful remove from queue, if unsuccessful break to next waiting point as carriage is likely full
-							if (RoguePassengerUtility::TryBoard(EntityManager, SubContext, Passenger, CarriageEntity, *CarriageFragment))
-							{
-								// Successfully boarded — release the slot
-								if (const FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger))
-								{
-									RogueStationQueueUtility::ReleaseSlot(*StationQueueFragment, *PassengerFragment);
-								}
-					
-								// Clear passenger’s waiting data
-								if (FRoguePassengerFragment* PassengerFragmentMutable = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger))
-								{
-									PassengerFragmentMutable->WaitingPointIdx = INDEX_NONE;
-									PassengerFragmentMutable->WaitingSlotIdx = INDEX_NONE;
-									PassengerFragmentMutable->bWaiting = false;
-								}
-								--BoardingBudget;
-							}
-							else
-							{
-								// Carriage full or other issue, break to next waiting point
-								break;
-							}							
+						// Skip passengers whose slot changed hands since the gather
+						if (!Grid.OccupiedBy.IsValidIndex(Candidate.SlotIdx) || Grid.OccupiedBy[Candidate.SlotIdx] != Candidate.Passenger) continue;
+						
+						// Try to board passenger, if unsuccessful break to next waiting point as carriage is likely full
+						if (!RoguePassengerUtility::TryBoard(EntityManager, Context, Candidate.Passenger, CarriageEntity, *CarriageFragment, OccupantSlab, Capacity))
+							break;
+
+						// Successfully boarded — release the slot
+						if (FRoguePassengerTripFragment* TripFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerTripFragment>(Candidate.Passenger))
+						{
+							RogueStationQueueUtility::ReleaseSlot(*StationQueueFragment, *TripFragment);
+							TRACE_ROGUE_SIM_EVENT(SlotRelease, CurrentTime, Candidate.Passenger, LoadingTrain.StationEntity, TripFragment->GetWaitingSlotIdx());
+			
+							// Clear passenger’s waiting data
+							TripFragment->ClearWaiting();
+						}
+						if (FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Candidate.Passenger))
+						{
+							PassengerFragment->bWaiting = false;
 						}
+						--BoardingBudget;
 					}
 				}
 			}
-        }
-    });
+		}
+	}
 }
@@ -2,16 +2,19 @@
 
 
 #include "Mass/Processors/Trains/RogueTrainCarriageFollowProcessor.h"
+#include "RogueMassExample.h"
 
 #include "MassCommonFragments.h"
 #include "MassCommonTypes.h"
 #include "MassEntityView.h"
 #include "MassExecutionContext.h"
-#include "Data/RogueDeveloperSettings.h"
 #include "Mass/Processors/Trains/RogueTrainEngineMovementProcessor.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RogueTrainUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Carriage Follow"), STAT_RogueCarriageFollow, STATGROUP_RogueSim);
+
 URogueTrainCarriageFollowProcessor::URogueTrainCarriageFollowProcessor() : EntityQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -22,56 +25,83 @@ URogueTrainCarriageFollowProcessor::URogueTrainCarriageFollowProcessor() : Entit
 void URogueTrainCarriageFollowProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
 {
 	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadWrite);
-	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
 	EntityQuery.AddRequirement<FRogueTrainLinkFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.AddTagRequirement<FRogueTrainCarriageTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddConstSharedRequirement<FRogueCarriageClassFragment>(EMassFragmentPresence::All);
 	EntityQuery.RegisterWithProcessor(*this);
 }
 
 void URogueTrainCarriageFollowProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueCarriageFollow);
+	ROGUE_SCOPE_ALLOC_COUNTER("CarriageFollow");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+	if (!TrainSubsystem->GetSimClock().ShouldStep()) return;
 
-	const auto* Settings = GetDefault<URogueDeveloperSettings>();
-	const float RideHeight = Settings ? Settings->CarriageRideHeight : 0.f;
+	const FRogueConsistTable& Consists = TrainSubsystem->GetConsists();
 
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Track data for the line this chunk's trains run on
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid()) return;
+
+		// Spacing and ride height are per carriage class, constant across the chunk
+		const FRogueCarriageClassFragment& CarriageClass = SubContext.GetConstSharedFragment<FRogueCarriageClassFragment>();
+		const float Spacing = CarriageClass.Spacing;
+		const float RideHeight = CarriageClass.RideHeight;
+
 		const auto FollowView = SubContext.GetMutableFragmentView<FRogueTrainTrackFollowFragment>();
 		const auto LinkView = SubContext.GetFragmentView<FRogueTrainLinkFragment>();
-		const auto TransformView = SubContext.GetMutableFragmentView<FTransformFragment>();
 
 		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
 		{
 			const auto& Link = LinkView[i];
-			if (!Link.LeadHandle.IsSet() || !EntityManager.IsEntityValid(Link.LeadHandle))
+			const FMassEntityHandle LeadHandle = Consists.GetLead(Link.ConsistId);
+			if (!LeadHandle.IsSet() || !EntityManager.IsEntityValid(LeadHandle))
 				continue;
 	
-			const FRogueTrainTrackFollowFragment* LeadFollow = EntityManager.GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(Link.LeadHandle);
+			const FRogueTrainTrackFollowFragment* LeadFollow = EntityManager.GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(LeadHandle);
 			if (!LeadFollow) continue;
-			
-			// Center-to-center spacing in **cm** (prefer per-car value; else fall back to settings)
-			const float Spacing = (Link.Spacing > 0.f) ? Link.Spacing : (Settings ? Settings->CarriageLength + Settings->CarriageSpacing : 0.f);
 
-			RogueTrainUtility::FSplineStationSample SplineSample;
 			const float OffsetDist = FMath::Max(1, Link.CarriageIndex) * Spacing;
-			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, LeadFollow->Alpha, -OffsetDist, 0.f, RideHeight, SplineSample))
+			double LeadDistance = LeadFollow->Distance;
+			double LeadInterpFromDistance = LeadFollow->InterpFromDistance;
+
+			// Carriages behind the lead's last junction stay on the from line, the lead is projected back through the junction
+			const FRogueTrainStateFragment* LeadState = EntityManager.GetFragmentDataPtr<FRogueTrainStateFragment>(LeadHandle);
+			if (LeadState && LeadState->TransitFromLine == TrackSharedFragment.LineIndex && LeadState->TransitToLine != TrackSharedFragment.LineIndex)
+			{
+				const double ToTrackLength = TrainSubsystem->GetTrackShared(LeadState->TransitToLine).TrackLength;
+				const double PastJunction = RogueTrainUtility::ArcDistanceWrapped(LeadState->TransitToDistance, LeadFollow->Distance, ToTrackLength);
+				const double InterpPastJunction = RogueTrainUtility::ArcDistanceWrapped(LeadState->TransitToDistance, LeadFollow->InterpFromDistance, ToTrackLength);
+				LeadDistance = RogueTrainUtility::WrapTrackDistance(LeadState->TransitFromDistance + PastJunction, TrackSharedFragment.TrackLength);
+				LeadInterpFromDistance = RogueTrainUtility::WrapTrackDistance(LeadState->TransitFromDistance + InterpPastJunction, TrackSharedFragment.TrackLength);
+
+				// Reached the junction this step, ride the from line until the swap lands and follow the lead's line after
+				if (PastJunction >= OffsetDist)
+				{
+					TrainSubsystem->SetEntityTrackLine(SubContext.Defer(), SubContext.GetEntity(i), LeadState->TransitToLine);
+				}
+			}
+
+			RogueTrainUtility::FSplineStationSample SplineSample;
+			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, LeadDistance, -OffsetDist, 0.f, RideHeight, SplineSample))
 				continue;			
 
 			// Update carriage follow state
 			auto& Follow = FollowView[i];
-			Follow.Alpha = SplineSample.Alpha;
+			Follow.Distance = SplineSample.Distance;
+			Follow.InterpFromDistance = RogueTrainUtility::WrapTrackDistance(LeadInterpFromDistance - OffsetDist, TrackSharedFragment.TrackLength);
 			Follow.WorldPos = SplineSample.Location;
 			Follow.WorldFwd = SplineSample.Forward;
-			
-			FTransform& TrainTransform = TransformView[i].GetMutableTransform();
-			TrainTransform = SplineSample.World;
-			const FQuat Rot = FRotationMatrix::MakeFromXZ(SplineSample.Forward, FVector::UpVector).ToQuat();
-			TrainTransform.SetRotation(Rot);
 		}
 	});
 }
\ No newline at end of file
@@ -2,15 +2,19 @@
 
 
 #include "Mass/Processors/Trains/RogueTrainEngineMovementProcessor.h"
+#include "RogueMassExample.h"
 
 #include "MassCommonFragments.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
 #include "Data/RogueDeveloperSettings.h"
 #include "Mass/Fragments/RogueFragments.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RogueTrainUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Engine Movement"), STAT_RogueEngineMovement, STATGROUP_RogueSim);
+
 URogueTrainEngineMovementProcessor::URogueTrainEngineMovementProcessor() : EntityQuery(*this)
 {	
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -21,36 +25,47 @@ void URogueTrainEngineMovementProcessor::ConfigureQueries(const TSharedRef<FMass
 {
 	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
 	EntityQuery.AddRequirement<FRogueTrainStateFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);	
-	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
 	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.RegisterWithProcessor(*this);	
 }
 
 void URogueTrainEngineMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueEngineMovement);
+	ROGUE_SCOPE_ALLOC_COUNTER("EngineMovement");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+
+	// Runs at the fixed sim rate, transforms are written by the interpolation processor
+	const FRogueSimClock& SimClock = TrainSubsystem->GetSimClock();
+	if (!SimClock.ShouldStep()) return;
 
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 	const float RideHeight = Settings ? Settings->CarriageRideHeight : 0.f;
+	const float StopRadius = Settings->StationStopRadius;
+	const float ArriveRadius = Settings->StationArrivalRadius;
 
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Track data for the line this chunk's trains run on
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid()) return;
+
 		const auto TrackFollowFragments = SubContext.GetMutableFragmentView<FRogueTrainTrackFollowFragment>();
 		const auto StateView  = SubContext.GetMutableFragmentView<FRogueTrainStateFragment>();
-		const auto TransformView = SubContext.GetMutableFragmentView<FTransformFragment>();
 		const int32 NumEntities = SubContext.GetNumEntities();
 
 		for (int32 i = 0; i < NumEntities; ++i)
 		{
-			const FMassEntityHandle Entity = SubContext.GetEntity(i);
 			auto& TrackFollowFragment = TrackFollowFragments[i];
 			const auto& State  = StateView[i];
-			FTransform& TrainTransform = TransformView[i].GetMutableTransform();
 			if (!TrackSharedFragment.StationEntities.IsValidIndex(State.TargetStationIdx)) continue;
 
 			float TargetSpeed = Settings->LeadCruiseSpeed;
@@ -65,21 +80,51 @@ void URogueTrainEngineMovementProcessor::Execute(FMassEntityManager& EntityManag
 				TargetSpeed = FMath::Min(TargetSpeed, Settings->StationApproachSpeed);
 			}
 
-			// Use 'target' for your acceleration model
-			TrackFollowFragment.Speed = FMath::FInterpTo(TrackFollowFragment.Speed, TargetSpeed, SubContext.GetDeltaTimeSeconds(), 2.f);
-			TrackFollowFragment.Alpha = RogueTrainUtility::WrapTrackAlpha(TrackFollowFragment.Alpha + (TrackFollowFragment.Speed * SubContext.GetDeltaTimeSeconds()) / TrackSharedFragment.TrackLength );
+			// Use 'target' for your acceleration model, one fixed step at a time so the result is frame rate independent.
+			// Station detect only sees the frame result, so the approach band and dock are also checked per step
+			const double DockDistance = TrackSharedFragment.Platforms[State.TargetStationIdx].DockDistance;
+			for (int32 Step = 0; Step < SimClock.NumSteps; ++Step)
+			{
+				// Blend origin moves every step, including a hold, so rendering never blends from a stale distance
+				TrackFollowFragment.InterpFromDistance = TrackFollowFragment.Distance;
+
+				const double ToDock = RogueTrainUtility::ArcDistanceWrapped(TrackFollowFragment.Distance, DockDistance, TrackSharedFragment.TrackLength);
+				float StepTargetSpeed = TargetSpeed;
+				if (!State.bAtStation)
+				{
+					// Hold on the dock until station detect marks the arrival
+					if (ToDock <= ArriveRadius)
+					{
+						TrackFollowFragment.Speed = 0.f;
+						break;
+					}
+					
+					if (ToDock <= StopRadius)
+					{
+						StepTargetSpeed = FMath::Min(StepTargetSpeed, Settings->StationApproachSpeed);
+					}
+				}
+				
+				TrackFollowFragment.Speed = FMath::FInterpTo(TrackFollowFragment.Speed, StepTargetSpeed, SimClock.StepDeltaTime, 2.f);
+				const double Travel = TrackFollowFragment.Speed * SimClock.StepDeltaTime;
+
+				// Swept dock check, a long step stops on the dock instead of overshooting it
+				if (!State.bAtStation && Travel >= ToDock)
+				{
+					TrackFollowFragment.Distance = DockDistance;
+					TrackFollowFragment.Speed = 0.f;
+					break;
+				}
+				
+				TrackFollowFragment.Distance = RogueTrainUtility::WrapTrackDistance(TrackFollowFragment.Distance + Travel, TrackSharedFragment.TrackLength);
+			}
 
 			RogueTrainUtility::FSplineStationSample SplineSample;
-			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, TrackFollowFragment.Alpha, 0, 0.f, RideHeight, SplineSample))
+			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, TrackFollowFragment.Distance, 0, 0.f, RideHeight, SplineSample))
 				continue;
 
-			TrackFollowFragment.Alpha = SplineSample.Alpha;
 			TrackFollowFragment.WorldPos = SplineSample.Location;
 			TrackFollowFragment.WorldFwd = SplineSample.Forward;
-			
-			TrainTransform = SplineSample.World;
-			const FQuat Rot = FRotationMatrix::MakeFromXZ(SplineSample.Forward, FVector::UpVector).ToQuat();
-			TrainTransform.SetRotation(Rot);
 		}
 	});
 }
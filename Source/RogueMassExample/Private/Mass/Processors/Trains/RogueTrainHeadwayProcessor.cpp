@@ -2,13 +2,17 @@
 
 
 #include "Mass/Processors/Trains/RogueTrainHeadwayProcessor.h"
+#include "RogueMassExample.h"
 #include "MassCommonTypes.h"
 #include "MassExecutionContext.h"
 #include "Data/RogueDeveloperSettings.h"
 #include "Mass/Fragments/RogueFragments.h"
+#include "Simulation/RogueFrameScratch.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 #include "Utilities/RogueTrainUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Headway"), STAT_RogueHeadway, STATGROUP_RogueSim);
+
 URogueTrainHeadwayProcessor::URogueTrainHeadwayProcessor(): EntityQuery(*this)
 {
 	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
@@ -20,32 +24,53 @@ void URogueTrainHeadwayProcessor::ConfigureQueries(const TSharedRef<FMassEntityM
 	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.AddRequirement<FRogueTrainStateFragment>(EMassFragmentAccess::ReadWrite);
 	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
 	EntityQuery.RegisterWithProcessor(*this);
 }
 
 void URogueTrainHeadwayProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueHeadway);
+	ROGUE_SCOPE_ALLOC_COUNTER("Headway");
+
 	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
 	if (!TrainSubsystem) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystem->GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+	if (!TrainSubsystem->GetSimClock().ShouldStep()) return;
 
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 
-	const float TrackLength = TrackSharedFragment.TrackLength;	
-	const float EngineLength = Settings ? Settings->EngineLength : 1200.f;
-	const float CarriageLength = Settings ? Settings->CarriageLength : 1000.f; 
-	const float Spacing = (Settings ? Settings->CarriageSpacing : 8.f);	
+	// Engines carry no carriage class, the consist length comes from the class their carriages spawn with
+	const FRogueCarriageClassFragment* CarriageClass = TrainSubsystem->GetCarriageClass();
+	if (!CarriageClass) return;
 
-	if(TrackLength <= 0.f) return;
+	const float EngineLength = Settings ? Settings->EngineLength : 1200.f;
+	const float CarriageSpacing = CarriageClass->Spacing;
+	const FRogueConsistTable& Consists = TrainSubsystem->GetConsists();
 
-	struct FEntry { FMassEntityHandle EntityHandle; float LeadAlpha; float TailAlpha; };
-	TArray<FEntry> Engines; Engines.Reserve(64);
+	auto GapToScale = [&](const float Gap, const float TrainLength)
+	{
+		const float MinGap = Settings ? TrainLength : 1500.f;
+		const float FullGap = MinGap * 2.f;
+		const float t = FMath::Clamp((Gap - MinGap) / (FullGap - MinGap), 0.f, 1.f);
+		//return t * t * (3.f - 2.f * t); //(smoothstep)
+		return FMath::Pow(t, 1.5f); //(ease in)
+	};
 
+	// Push this frame's distances into the per line ring index, trains never overtake so no re-sort is needed
 	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Chunks are grouped per line, headway only applies between trains on the same line
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid() || TrackSharedFragment.TrackLength <= 0.0) return;
+
+		FRogueTrainRingIndex* TrainIndex = TrainSubsystem->GetMutableTrainIndex(TrackSharedFragment.LineIndex);
+		if (!TrainIndex) return;
+		
 		const TConstArrayView<FRogueTrainTrackFollowFragment> FollowView = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
 		const TArrayView<FRogueTrainStateFragment> StateView = SubContext.GetMutableFragmentView<FRogueTrainStateFragment>();	
 
@@ -57,72 +82,90 @@ void URogueTrainHeadwayProcessor::Execute(FMassEntityManager& EntityManager, FMa
 			// Clear headway
 			State.HeadwaySpeedScale = 1.f;
 
-			const float LeadAlpha = Follow.Alpha;
-
-			// per-lead carriages if you track it, else default
+			// Carriages configured so far, else the default while the consist is still spawning
 			int32 NumCars = Settings ? Settings->CarriagesPerTrain : 3;
-			if (State.Carriages.Num() > 0)
+			if (const int32 NumConsistCars = Consists.GetNumCarriages(State.ConsistId); NumConsistCars > 0)
 			{
-				NumCars = State.Carriages.Num();
+				NumCars = NumConsistCars;
 			}
 			
-			State.TrainLength = EngineLength + NumCars * CarriageLength;
-			const float DeltaTime = State.TrainLength / TrackLength;
-			const float TailAlpha = RogueTrainUtility::WrapTrackAlpha(LeadAlpha - DeltaTime);
+			State.TrainLength = EngineLength + NumCars * CarriageSpacing;
+
+			const FMassEntityHandle Entity = SubContext.GetEntity(i);
+			if (!TrainIndex->Update(Entity, Follow.Distance, State.TrainLength))
+			{
+				TrainIndex->Add(Entity, Follow.Distance, State.TrainLength);
+			}
 
-			Engines.Add({ SubContext.GetEntity(i), LeadAlpha, TailAlpha });
+			// Past a junction the carriages still ride the from line, keep the tail there as a train parked at
+			// the junction with the length left to cross, so trains behind on the from line keep their gap
+			if (State.bTailOnFromLine)
+			{
+				FRogueTrainRingIndex* FromIndex = TrainSubsystem->GetMutableTrainIndex(State.TransitFromLine);
+				const double PastJunction = RogueTrainUtility::ArcDistanceWrapped(State.TransitToDistance, Follow.Distance, TrackSharedFragment.TrackLength);
+				const float LengthLeft = State.TrainLength - static_cast<float>(PastJunction);
+				if (!FromIndex || LengthLeft <= 0.f)
+				{
+					if (FromIndex) FromIndex->Remove(Entity);
+					State.bTailOnFromLine = false;
+				}
+				else if (!FromIndex->Update(Entity, State.TransitFromDistance, LengthLeft))
+				{
+					FromIndex->Add(Entity, State.TransitFromDistance, LengthLeft);
+				}
+			}
 		}
 	});
 
-	if (Engines.Num() <= 1) return;
-
-	Algo::SortBy(Engines, &FEntry::LeadAlpha);		
-
-	auto GapToScale = [&](const float Gap, const float TrainLength)
+	for (int32 LineIdx = 0; LineIdx < TrainSubsystem->GetNumTrackLines(); ++LineIdx)
 	{
-		const float MinGap = Settings ? TrainLength : 1500.f;
-		const float FullGap = MinGap * 2.f;
-		const float t = FMath::Clamp((Gap - MinGap) / (FullGap - MinGap), 0.f, 1.f);
-		//return t * t * (3.f - 2.f * t); //(smoothstep)
-		return FMath::Pow(t, 1.5f); //(ease in)
-	};
+		TrainSubsystem->GetMutableTrainIndex(LineIdx)->Refresh();
+	}
 
-	// Check gap to next engine's tail
-	for (int32 Idx = 0; Idx < Engines.Num(); ++Idx)
+	// Check gap to the tail of the train ahead on the same line
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
 	{
-		const FEntry& Current = Engines[Idx];
-		const FEntry& Next = Engines[(Idx+1) % Engines.Num()];
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid() || TrackSharedFragment.TrackLength <= 0.0) return;
+		
+		const FRogueTrainRingIndex* TrainIndex = TrainSubsystem->GetTrainIndex(TrackSharedFragment.LineIndex);
+		if (!TrainIndex || TrainIndex->Num() <= 1) return;
 
-		// Distance forward along track from current.lead to next.tail
-		const float ArcDist = RogueTrainUtility::ArcDistanceWrapped(Current.LeadAlpha, Next.TailAlpha);
-		const float Gap = ArcDist * TrackLength;
+		const double TrackLength = TrackSharedFragment.TrackLength;
+		const TConstArrayView<FRogueTrainTrackFollowFragment> FollowView = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
+		const TArrayView<FRogueTrainStateFragment> StateView = SubContext.GetMutableFragmentView<FRogueTrainStateFragment>();
 
-		if (auto* State = EntityManager.GetFragmentDataPtr<FRogueTrainStateFragment>(Current.EntityHandle))
+		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
 		{
-			const float Scale = GapToScale(Gap, State->TrainLength);
+			const auto& Follow = FollowView[i];
+			auto& State = StateView[i];
 			
-			if (const FRogueTrainTrackFollowFragment* Follow = EntityManager.GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(Current.EntityHandle))
+			const FRogueTrainRingIndex::FEntry* Next = TrainIndex->GetAhead(SubContext.GetEntity(i));
+			if (!Next) continue;
+
+			// Distance forward along track from current.lead to next.tail
+			const double NextTailDistance = RogueTrainUtility::WrapTrackDistance(Next->Distance - Next->TrainLength, TrackLength);
+			const float Gap = static_cast<float>(RogueTrainUtility::ArcDistanceWrapped(Follow.Distance, NextTailDistance, TrackLength));
+			const float Scale = GapToScale(Gap, State.TrainLength);
+
+			int32 TargetIdx = State.TargetStationIdx;
+			if (TargetIdx == INDEX_NONE)
 			{
-				int32 TargetIdx = State->TargetStationIdx;
-				if (TargetIdx == INDEX_NONE)
-				{
-					// If you no longer store alphas, call your “next station” helper here
-					TargetIdx = RogueTrainUtility::FindNextStation(*TrackSharedFragment.Spline, TrackSharedFragment.Platforms, Follow->Alpha);
-				}
+				TargetIdx = RogueTrainUtility::FindNextStation(TrackSharedFragment.Platforms, Follow.Distance, TrackLength);
+			}
 
-				if (TargetIdx != INDEX_NONE)
-				{
-					const float StationAlpha = TrackSharedFragment.GetStationAlphaByIndex(TargetIdx);
-					const float DistToStation = RogueTrainUtility::ArcDistanceWrapped(Follow->Alpha, StationAlpha) * TrackLength;
+			if (TargetIdx != INDEX_NONE)
+			{
+				const double StationDistance = TrackSharedFragment.GetStationDistanceByIndex(TargetIdx);
+				const double DistToStation = RogueTrainUtility::ArcDistanceWrapped(Follow.Distance, StationDistance, TrackLength);
 
-					if (DistToStation <= Gap || State->bIsStopping || State->bAtStation)
-					{
-						State->HeadwaySpeedScale = 1.f; // station logic wins
-					}
+				if (DistToStation <= Gap || State.bIsStopping || State.bAtStation)
+				{
+					State.HeadwaySpeedScale = 1.f; // station logic wins
 				}
 			}
 			
-			State->HeadwaySpeedScale = FMath::Min(State->HeadwaySpeedScale, Scale);
+			State.HeadwaySpeedScale = FMath::Min(State.HeadwaySpeedScale, Scale);
 		}
-	}
+	});
 }
@@ -0,0 +1,83 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Mass/Processors/Trains/RogueTrainInterpolationProcessor.h"
+#include "RogueMassExample.h"
+
+#include "MassCommonFragments.h"
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Mass/Fragments/RogueFragments.h"
+#include "Mass/Processors/Trains/RogueTrainJunctionProcessor.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "Utilities/RogueTrainUtility.h"
+
+DECLARE_CYCLE_STAT(TEXT("Train Interpolation"), STAT_RogueTrainInterpolation, STATGROUP_RogueSim);
+
+URogueTrainInterpolationProcessor::URogueTrainInterpolationProcessor() : EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+	ExecutionOrder.ExecuteAfter.Add(URogueTrainJunctionProcessor::StaticClass()->GetFName());
+}
+
+void URogueTrainInterpolationProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::All);
+	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::Any);
+	EntityQuery.AddTagRequirement<FRogueTrainCarriageTag>(EMassFragmentPresence::Any);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddConstSharedRequirement<FRogueCarriageClassFragment>(EMassFragmentPresence::Optional);
+	EntityQuery.RegisterWithProcessor(*this);
+}
+
+void URogueTrainInterpolationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RogueTrainInterpolation);
+	ROGUE_SCOPE_ALLOC_COUNTER("TrainInterpolation");
+
+	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
+	if (!TrainSubsystem) return;
+
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	const float RideHeight = Settings ? Settings->CarriageRideHeight : 0.f;
+	const float Alpha = TrainSubsystem->GetSimClock().Alpha;
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
+	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid()) return;
+
+		// Carriage chunks ride at their class height, engine chunks use the settings value
+		const FRogueCarriageClassFragment* CarriageClass = SubContext.GetConstSharedFragmentPtr<FRogueCarriageClassFragment>();
+		const float ChunkRideHeight = CarriageClass ? CarriageClass->RideHeight : RideHeight;
+
+		const TConstArrayView<FRogueTrainTrackFollowFragment> FollowView = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
+		const TArrayView<FTransformFragment> TransformView = SubContext.GetMutableFragmentView<FTransformFragment>();
+
+		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
+		{
+			const auto& Follow = FollowView[i];
+
+			// Blend in track distance so the render position follows the curve instead of cutting the chord
+			const double Travelled = RogueTrainUtility::ArcDistanceWrapped(Follow.InterpFromDistance, Follow.Distance, TrackSharedFragment.TrackLength);
+			const double RenderDistance = RogueTrainUtility::WrapTrackDistance(Follow.InterpFromDistance + Travelled * Alpha, TrackSharedFragment.TrackLength);
+
+			RogueTrainUtility::FSplineStationSample SplineSample;
+			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, RenderDistance, 0.f, 0.f, ChunkRideHeight, SplineSample))
+				continue;
+
+			FTransform& TrainTransform = TransformView[i].GetMutableTransform();
+			TrainTransform = SplineSample.World;
+			const FQuat Rot = FRotationMatrix::MakeFromXZ(SplineSample.Forward, FVector::UpVector).ToQuat();
+			TrainTransform.SetRotation(Rot);
+		}
+	});
+}
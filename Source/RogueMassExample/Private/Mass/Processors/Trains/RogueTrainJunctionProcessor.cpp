@@ -0,0 +1,111 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Mass/Processors/Trains/RogueTrainJunctionProcessor.h"
+#include "RogueMassExample.h"
+
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Mass/Fragments/RogueFragments.h"
+#include "Mass/Processors/Trains/RogueTrainCarriageFollowProcessor.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "Utilities/RoguePassengerUtility.h"
+#include "Utilities/RogueTrainUtility.h"
+
+DECLARE_CYCLE_STAT(TEXT("Junction"), STAT_RogueJunction, STATGROUP_RogueSim);
+
+// A train only switches once every carriage has followed it onto its current line and nobody is aboard,
+// riders hold destinations on this line and would never reach them on another
+static bool CanSwitchLine(FMassEntityManager& EntityManager, const FRogueConsistTable& Consists, const int32 ConsistId, const int32 LineIndex)
+{
+	for (const FMassEntityHandle Carriage : Consists.GetCarriages(ConsistId))
+	{
+		if (!RoguePassengerUtility::IsHandleValid(EntityManager, Carriage)) continue;
+
+		const FRogueTrackSharedFragment* CarriageTrack = EntityManager.GetSharedFragmentDataPtr<FRogueTrackSharedFragment>(Carriage);
+		if (CarriageTrack && CarriageTrack->LineIndex != LineIndex) return false;
+
+		const FRogueCarriageFragment* CarriageFragment = EntityManager.GetFragmentDataPtr<FRogueCarriageFragment>(Carriage);
+		if (CarriageFragment && CarriageFragment->NumOccupants > 0) return false;
+	}
+	return true;
+}
+
+URogueTrainJunctionProcessor::URogueTrainJunctionProcessor() : EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+	ExecutionOrder.ExecuteAfter.Add(URogueTrainCarriageFollowProcessor::StaticClass()->GetFName());
+}
+
+void URogueTrainJunctionProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FRogueTrainTrackFollowFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FRogueTrainStateFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddTagRequirement<FRogueTrainEngineTag>(EMassFragmentPresence::All);
+	EntityQuery.AddSharedRequirement<FRogueTrackSharedFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.RegisterWithProcessor(*this);
+}
+
+void URogueTrainJunctionProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RogueJunction);
+	ROGUE_SCOPE_ALLOC_COUNTER("Junction");
+
+	auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>();
+	if (!TrainSubsystem) return;
+
+	if (!TrainSubsystem->EnsureTrackShared()) return;
+
+	const FRogueSimClock& SimClock = TrainSubsystem->GetSimClock();
+	if (!SimClock.ShouldStep()) return;
+
+	// Seeded so runs with the same seed take the same branches
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	const int32 Seed = Settings ? Settings->JunctionSeed : 0;
+	if (!bSwitchRandomSeeded || SwitchRandom.GetInitialSeed() != Seed)
+	{
+		SwitchRandom.Initialize(Seed);
+		bSwitchRandomSeeded = true;
+	}
+
+	const FRogueConsistTable& Consists = TrainSubsystem->GetConsists();
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& SubContext)
+	{
+		INC_DWORD_STAT_BY(STAT_RogueEntitiesProcessed, SubContext.GetNumEntities());
+
+		// Junctions are per line, lines without any skip the whole chunk
+		const FRogueTrackSharedFragment& TrackSharedFragment = SubContext.GetSharedFragment<FRogueTrackSharedFragment>();
+		if (!TrackSharedFragment.IsValid() || TrackSharedFragment.Junctions.Num() == 0) return;
+
+		const TConstArrayView<FRogueTrainTrackFollowFragment> FollowView = SubContext.GetFragmentView<FRogueTrainTrackFollowFragment>();
+		const TConstArrayView<FRogueTrainStateFragment> StateView = SubContext.GetFragmentView<FRogueTrainStateFragment>();
+		const float DeltaTime = SimClock.GetFrameDeltaTime();
+
+		for (int32 i = 0; i < SubContext.GetNumEntities(); ++i)
+		{
+			const auto& Follow = FollowView[i];
+			const auto& State = StateView[i];
+			if (State.bAtStation) continue;
+
+			// Distance covered by movement this sim frame, a junction inside it was crossed
+			const double Step = Follow.Speed * DeltaTime;
+			if (Step <= 0.0) continue;
+
+			for (const FRogueTrackJunction& Junction : TrackSharedFragment.Junctions)
+			{
+				const double SinceJunction = RogueTrainUtility::ArcDistanceWrapped(Junction.FromDistance, Follow.Distance, TrackSharedFragment.TrackLength);
+				if (SinceJunction > Step) continue;
+				if (SwitchRandom.FRand() >= Junction.SwitchChance) continue;
+				if (!CanSwitchLine(EntityManager, Consists, State.ConsistId, TrackSharedFragment.LineIndex)) break;
+
+				// Keep the overshoot so the train does not lose distance on the new line
+				TrainSubsystem->SwitchTrainLine(SubContext, SubContext.GetEntity(i), TrackSharedFragment.LineIndex, Junction, SinceJunction);
+				break;
+			}
+		}
+	});
+}
@@ -3,10 +3,25 @@
 
 #include "Mass/Traits/RogueEntityTraitPassenger.h"
 #include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+#include "Data/RogueDeveloperSettings.h"
 #include "Mass/Fragments/RogueFragments.h"
 
 void URogueEntityTraitPassenger::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const
 {
 	BuildContext.AddTag<FRogueTrainPassengerTag>();
 	BuildContext.AddFragment<FRoguePassengerFragment>();
+	BuildContext.AddFragment<FRoguePassengerTripFragment>();
+
+	FRoguePassengerMovementClassFragment Class = MovementClass;
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (bUseDeveloperSettings && Settings)
+	{
+		Class.MaxSpeed = Settings->PassengerMaxSpeed;
+		Class.AcceptanceRadius = Settings->PassengerAcceptanceRadius;
+	}
+
+	// Identical classes hash to one shared instance, so passengers only pay for the chunk reference
+	FMassEntityManager& EntityManager = UE::Mass::Utils::GetEntityManagerChecked(World);
+	BuildContext.AddConstSharedFragment(EntityManager.GetOrCreateConstSharedFragment(Class));
 }
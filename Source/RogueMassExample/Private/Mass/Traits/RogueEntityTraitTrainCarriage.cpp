@@ -3,6 +3,8 @@
 
 #include "Mass/Traits/RogueEntityTraitTrainCarriage.h"
 #include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+#include "Data/RogueDeveloperSettings.h"
 #include "Mass/Fragments/RogueFragments.h"
 
 void URogueEntityTraitTrainCarriage::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext,
@@ -12,4 +14,19 @@ void URogueEntityTraitTrainCarriage::BuildTemplate(FMassEntityTemplateBuildConte
 	BuildContext.AddFragment<FRogueTrainTrackFollowFragment>();
 	BuildContext.AddFragment<FRogueTrainLinkFragment>();
 	BuildContext.AddFragment<FRogueCarriageFragment>();
+
+	FRogueCarriageClassFragment Class = CarriageClass;
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (bUseDeveloperSettings && Settings)
+	{
+		Class.Capacity = Settings->MaxPassengersPerCarriage;
+		Class.Spacing = Settings->CarriageLength + Settings->CarriageSpacing;
+		Class.RideHeight = Settings->CarriageRideHeight;
+	}
+
+	// Carriages count occupants in a uint16, the settings value skips the property clamp
+	Class.Capacity = FMath::Clamp(Class.Capacity, 0, static_cast<int32>(MAX_uint16));
+
+	FMassEntityManager& EntityManager = UE::Mass::Utils::GetEntityManagerChecked(World);
+	BuildContext.AddConstSharedFragment(EntityManager.GetOrCreateConstSharedFragment(Class));
 }
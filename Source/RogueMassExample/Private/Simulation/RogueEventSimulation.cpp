@@ -0,0 +1,386 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/RogueEventSimulation.h"
+#include "RogueMassExample.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Subsystems/RogueScenarioSubsystem.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "Utilities/RogueTrainUtility.h"
+
+FString FRogueEventSimStats::ToString() const
+{
+	const double AvgWait = GetAverageWaitSeconds();
+	const double AvgRide = Alightings > 0 ? TotalRideSeconds / Alightings : 0.0;
+	return FString::Printf(TEXT("Sim %.0fs | Events %lld | Arrivals %lld | Departures %lld | Spawned %lld | Boardings %lld | Alightings %lld | AvgWait %.1fs | AvgRide %.1fs"),
+		SimulatedSeconds, NumEvents, TrainArrivals, TrainDepartures, PassengersSpawned, Boardings, Alightings, AvgWait, AvgRide);
+}
+
+bool FRogueEventSimStats::MatchesWithin(const FRogueEventSimStats& Other, const double Tolerance, FString& OutMismatch) const
+{
+	// Rates per simulated hour so runs of slightly different length still compare
+	const double Hours = FMath::Max(SimulatedSeconds, 1.0) / 3600.0;
+	const double OtherHours = FMath::Max(Other.SimulatedSeconds, 1.0) / 3600.0;
+	
+	const auto Check = [&](const TCHAR* Name, const double Value, const double OtherValue)
+	{
+		const double Error = FMath::Abs(Value - OtherValue) / FMath::Max(FMath::Abs(OtherValue), 1.0);
+		if (Error <= Tolerance) return true;
+		
+		OutMismatch = FString::Printf(TEXT("%s %.2f vs %.2f, off by %.0f%% (tolerance %.0f%%)"), Name, Value, OtherValue, Error * 100.0, Tolerance * 100.0);
+		return false;
+	};
+
+	return Check(TEXT("Arrivals/h"), TrainArrivals / Hours, Other.TrainArrivals / OtherHours)
+		&& Check(TEXT("Boardings/h"), Boardings / Hours, Other.Boardings / OtherHours)
+		&& Check(TEXT("Alightings/h"), Alightings / Hours, Other.Alightings / OtherHours)
+		&& Check(TEXT("AvgWait"), GetAverageWaitSeconds(), Other.GetAverageWaitSeconds());
+}
+
+bool FRogueEventSimulation::Init(URogueTrainWorldSubsystem& TrainSubsystem, const URogueDeveloperSettings& Settings, const int32 Seed)
+{
+	if (!TrainSubsystem.EnsureTrackShared()) return false;
+
+	CruiseSpeed = FMath::Max(1.f, Settings.LeadCruiseSpeed);
+	ApproachSpeed = FMath::Max(1.f, Settings.StationApproachSpeed);
+	StopRadius = Settings.StationStopRadius;
+	DwellSeconds = Settings.MaxDwellTimeSeconds;
+	DepartureSeconds = Settings.DepartureTimeSeconds;
+	UnloadIntervalSeconds = FMath::Max(KINDA_SMALL_NUMBER, Settings.UnloadIntervalSeconds);
+	LoadTickSeconds = Settings.SimulationTickRate > 0.f ? 1.f / Settings.SimulationTickRate : 1.f / 60.f;
+	MaxLoadPerTick = FMath::Max(1, static_cast<int32>(Settings.MaxLoadPerTickPerCarriage));
+	SpawnIntervalSeconds = FMath::Max(KINDA_SMALL_NUMBER, Settings.SpawnIntervalSeconds);
+	PassengersPerSpawn = FMath::Max(0, Settings.PassengersPerSpawn);
+	MaxPassengers = Settings.MaxPassengersOverall;
+	CarriageCapacity = FMath::Clamp(Settings.MaxPassengersPerCarriage, 0, static_cast<int32>(MAX_uint16));
+
+	Lines.Reset();
+	Trains.Reset();
+	Carriages.Reset();
+	OccupantSlab.Reset();
+	Stations.Reset();
+	Passengers.Reset();
+	FreePassengers.Reset();
+	LivePassengers = 0;
+	Queue.Reset();
+	NextSequence = 0;
+	Now = 0.0;
+	Random.Initialize(Seed);
+	Stats = FRogueEventSimStats();
+
+	for (int32 LineIdx = 0; LineIdx < TrainSubsystem.GetNumTrackLines(); ++LineIdx)
+	{
+		// Keep every line so indices match the Mass simulation, invalid lines just have no stations
+		const FRogueTrackSharedFragment& Track = TrainSubsystem.GetTrackShared(LineIdx);
+		FLine& Line = Lines.AddDefaulted_GetRef();
+		Line.FirstStation = Stations.Num();
+		if (!Track.IsValid()) continue;
+		
+		Line.TrackLength = Track.TrackLength;
+		for (const FRoguePlatformData& Platform : Track.Platforms)
+		{
+			Line.DockDistances.Add(Platform.DockDistance);
+			Stations.AddDefaulted();
+		}
+
+		const int32 NumStations = Line.DockDistances.Num();
+		if (NumStations == 0) continue;
+
+		// Same start as CreateTrains, each train sits at a station with a short initial dwell
+		for (int32 i = 0; i < TrainSubsystem.GetNumTrainsOnLine(LineIdx); ++i)
+		{
+			const int32 TrainIdx = Trains.AddDefaulted();
+			FTrain& Train = Trains[TrainIdx];
+			Train.LineIndex = LineIdx;
+			Train.State.bAtStation = true;
+			Train.State.TargetStationIdx = i % NumStations;
+			Train.State.PreviousStationIdx = Train.State.TargetStationIdx;
+			Train.Distance = Line.DockDistances[Train.State.TargetStationIdx];
+
+			for (int32 c = 0; c < Settings.CarriagesPerTrain; ++c)
+			{
+				FRogueCarriageFragment& Carriage = Carriages.AddDefaulted_GetRef();
+				Carriage.OccupantBlock = OccupantSlab.Allocate(CarriageCapacity);
+				Train.CarriageIndices.Add(Carriages.Num() - 1);
+			}
+
+			Push(2.0, EEventType::TrainDepart, TrainIdx);
+		}
+	}
+
+	Push(SpawnIntervalSeconds, EEventType::PassengerSpawn);
+	return Trains.Num() > 0;
+}
+
+void FRogueEventSimulation::RunUntil(const double EndSeconds)
+{
+	while (Queue.Num() > 0 && Queue.HeapTop().Time <= EndSeconds)
+	{
+		FEvent Event;
+		Queue.HeapPop(Event, EAllowShrinking::No);
+		Now = Event.Time;
+		++Stats.NumEvents;
+
+		switch (Event.Type)
+		{
+			case EEventType::PassengerSpawn: HandlePassengerSpawn(); break;
+			case EEventType::TrainArrive: HandleTrainArrive(Event.TrainIdx); break;
+			case EEventType::UnloadTick: HandleUnloadTick(Event.TrainIdx); break;
+			case EEventType::LoadTick: HandleLoadTick(Event.TrainIdx); break;
+			case EEventType::TrainDepart: HandleTrainDepart(Event.TrainIdx); break;
+			default: break;
+		}
+	}
+
+	Now = FMath::Max(Now, EndSeconds);
+	Stats.SimulatedSeconds = Now;
+}
+
+void FRogueEventSimulation::Push(const double Time, const EEventType Type, const int32 TrainIdx)
+{
+	FEvent Event;
+	Event.Time = Time;
+	Event.Sequence = NextSequence++;
+	Event.Type = Type;
+	Event.TrainIdx = TrainIdx;
+	Queue.HeapPush(Event);
+}
+
+double FRogueEventSimulation::TravelTime(const double Arc) const
+{
+	// Cruise until the stop radius, then the approach speed into the dock
+	const double ApproachArc = FMath::Min(Arc, static_cast<double>(StopRadius));
+	return (Arc - ApproachArc) / CruiseSpeed + ApproachArc / ApproachSpeed;
+}
+
+void FRogueEventSimulation::HandlePassengerSpawn()
+{
+	Push(Now + SpawnIntervalSeconds, EEventType::PassengerSpawn);
+	if (Lines.Num() == 0) return;
+
+	// Same rules as the spawn processor, a batch per interval capped by the live total
+	const int32 NumToSpawn = FMath::Min(PassengersPerSpawn, MaxPassengers - LivePassengers);
+	for (int32 SpawnIdx = 0; SpawnIdx < NumToSpawn; ++SpawnIdx)
+	{
+		SpawnPassenger();
+	}
+}
+
+void FRogueEventSimulation::SpawnPassenger()
+{
+	// A random line then an origin and destination on it
+	const FLine& Line = Lines[Random.RandHelper(Lines.Num())];
+	const int32 NumStations = Line.DockDistances.Num();
+	if (NumStations < 2) return;
+
+	const int32 Origin = Random.RandHelper(NumStations);
+	const int32 Dest = (Origin + 1 + Random.RandHelper(NumStations - 1)) % NumStations;
+
+	int32 PassengerIdx = INDEX_NONE;
+	if (FreePassengers.Num() > 0)
+	{
+		PassengerIdx = FreePassengers.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		PassengerIdx = Passengers.AddDefaulted();
+	}
+	
+	FPassenger& Passenger = Passengers[PassengerIdx];
+	Passenger.DestStation = Line.FirstStation + Dest;
+	Passenger.SpawnTime = Now;
+	Passenger.BoardTime = 0.0;
+
+	FRoguePassengerQueueEntry Entry;
+	Entry.Passenger = FMassEntityHandle(PassengerIdx, 1);
+	Entry.DestStationIdx = RogueCompactIndex::Compact<uint16>(Passenger.DestStation);
+	Entry.EnqueuedGameTime = static_cast<float>(Now);
+	Stations[Line.FirstStation + Origin].QueuesByWaitingPoint.FindOrAdd(0).Add(Entry);
+
+	++LivePassengers;
+	++Stats.PassengersSpawned;
+}
+
+void FRogueEventSimulation::HandleTrainArrive(const int32 TrainIdx)
+{
+	FTrain& Train = Trains[TrainIdx];
+	Train.Distance = Lines[Train.LineIndex].DockDistances[Train.State.TargetStationIdx];
+	Train.ArrivalTime = Now;
+	Train.State.bAtStation = true;
+	Train.State.StationTrainPhase = ERogueStationTrainPhase::Unloading;
+	Train.State.StationTimeRemaining = DwellSeconds;
+	++Stats.TrainArrivals;
+
+	Push(Now, EEventType::UnloadTick, TrainIdx);
+	Push(Now + DwellSeconds, EEventType::TrainDepart, TrainIdx);
+}
+
+void FRogueEventSimulation::HandleUnloadTick(const int32 TrainIdx)
+{
+	FTrain& Train = Trains[TrainIdx];
+	if (Train.State.StationTrainPhase != ERogueStationTrainPhase::Unloading) return;
+
+	// Station ops unloads while the remaining dwell is above the switch time
+	const double SwitchTime = DwellSeconds * 0.5 + DepartureSeconds * 0.5;
+	if (Now > Train.ArrivalTime + DwellSeconds - SwitchTime)
+	{
+		Train.State.StationTrainPhase = ERogueStationTrainPhase::Loading;
+		Push(Now, EEventType::LoadTick, TrainIdx);
+		return;
+	}
+
+	// One alighting per carriage per unload interval, like the carriage unload cursor
+	const int32 Station = GlobalStation(Train);
+	int32 EmptyCarriages = 0;
+	for (const int32 CarriageIdx : Train.CarriageIndices)
+	{
+		FRogueCarriageFragment& Carriage = Carriages[CarriageIdx];
+		const TConstArrayView<FMassEntityHandle> Occupants = OccupantSlab.GetOccupants(Carriage);
+		const int32 Idx = Occupants.IndexOfByPredicate([this, Station](const FMassEntityHandle Occupant)
+		{
+			return Passengers[Occupant.Index].DestStation == Station;
+		});
+		
+		if (Idx != INDEX_NONE)
+		{
+			const int32 PassengerIdx = Occupants[Idx].Index;
+			OccupantSlab.RemoveAtSwap(Carriage, Idx);
+			Stats.TotalRideSeconds += Now - Passengers[PassengerIdx].BoardTime;
+			++Stats.Alightings;
+			FreePassengers.Add(PassengerIdx);
+			--LivePassengers;
+		}
+
+		if (Carriage.NumOccupants == 0) ++EmptyCarriages;
+	}
+
+	// All carriages empty skips straight to loading
+	if (EmptyCarriages >= Train.CarriageIndices.Num())
+	{
+		Train.State.StationTrainPhase = ERogueStationTrainPhase::Loading;
+		Push(Now, EEventType::LoadTick, TrainIdx);
+		return;
+	}
+	
+	Push(Now + UnloadIntervalSeconds, EEventType::UnloadTick, TrainIdx);
+}
+
+void FRogueEventSimulation::HandleLoadTick(const int32 TrainIdx)
+{
+	FTrain& Train = Trains[TrainIdx];
+	if (Train.State.StationTrainPhase != ERogueStationTrainPhase::Loading) return;
+
+	// Loading stops once the remaining dwell reaches the departure buffer
+	if (Now >= Train.ArrivalTime + DwellSeconds - DepartureSeconds)
+	{
+		Train.State.StationTrainPhase = ERogueStationTrainPhase::Departing;
+		return;
+	}
+
+	TArray<FRoguePassengerQueueEntry>* Waiting = Stations[GlobalStation(Train)].QueuesByWaitingPoint.Find(0);
+	if (Waiting && Waiting->Num() > 0)
+	{
+		for (const int32 CarriageIdx : Train.CarriageIndices)
+		{
+			FRogueCarriageFragment& Carriage = Carriages[CarriageIdx];
+			const int32 Budget = FMath::Min3(CarriageCapacity - Carriage.NumOccupants, MaxLoadPerTick, Waiting->Num());
+			for (int32 b = 0; b < Budget; ++b)
+			{
+				const FRoguePassengerQueueEntry& Entry = (*Waiting)[b];
+				FPassenger& Passenger = Passengers[Entry.Passenger.Index];
+				Passenger.BoardTime = Now;
+				Stats.TotalWaitSeconds += Now - Passenger.SpawnTime;
+				++Stats.Boardings;
+				OccupantSlab.Add(Carriage, Entry.Passenger);
+			}
+			
+			if (Budget > 0) Waiting->RemoveAt(0, Budget, EAllowShrinking::No);
+			if (Waiting->Num() == 0) break;
+		}
+	}
+
+	// Keep polling at the sim tick, passengers spawned during the window can still board
+	Push(Now + LoadTickSeconds, EEventType::LoadTick, TrainIdx);
+}
+
+void FRogueEventSimulation::HandleTrainDepart(const int32 TrainIdx)
+{
+	FTrain& Train = Trains[TrainIdx];
+	const FLine& Line = Lines[Train.LineIndex];
+	const int32 NumStations = Line.DockDistances.Num();
+	if (NumStations == 0) return;
+
+	Train.State.bAtStation = false;
+	Train.State.StationTrainPhase = ERogueStationTrainPhase::NotStopped;
+	Train.State.PreviousStationIdx = Train.State.TargetStationIdx;
+	Train.State.TargetStationIdx = (Train.State.TargetStationIdx + 1) % NumStations;
+	++Stats.TrainDepartures;
+
+	// A single station line does a full lap
+	double Arc = RogueTrainUtility::ArcDistanceWrapped(Train.Distance, Line.DockDistances[Train.State.TargetStationIdx], Line.TrackLength);
+	if (Arc <= KINDA_SMALL_NUMBER) Arc = Line.TrackLength;
+	
+	Push(Now + TravelTime(Arc), EEventType::TrainArrive, TrainIdx);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GRogueRunEventSimCmd(
+	TEXT("rogue.Sim.RunEventSim"),
+	TEXT("Run the discrete event simulation on the current track. Args: <Hours=24> <Seed=0>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const auto* Settings = GetDefault<URogueDeveloperSettings>();
+		URogueTrainWorldSubsystem* TrainSubsystem = World ? World->GetSubsystem<URogueTrainWorldSubsystem>() : nullptr;
+		if (!Settings || !TrainSubsystem) return;
+
+		const double Hours = Args.Num() > 0 ? FCString::Atod(*Args[0]) : 24.0;
+		const int32 Seed = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 0;
+
+		FRogueEventSimulation Simulation;
+		if (!Simulation.Init(*TrainSubsystem, *Settings, Seed))
+		{
+			UE_LOG(LogRogueSim, Warning, TEXT("Event sim: track not ready, start the simulation first"));
+			return;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		Simulation.RunUntil(Hours * 3600.0);
+		UE_LOG(LogRogueSim, Log, TEXT("Event sim %.1fh in %.2fs real: %s"), Hours, FPlatformTime::Seconds() - StartTime, *Simulation.GetStats().ToString());
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GRogueCrossCheckEventSimCmd(
+	TEXT("rogue.Sim.CrossCheckEventSim"),
+	TEXT("Run the event simulation for as long as the Mass simulation has run and compare the aggregates. Args: <Tolerance=0.25> <Seed=scenario seed or 0>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const auto* Settings = GetDefault<URogueDeveloperSettings>();
+		URogueTrainWorldSubsystem* TrainSubsystem = World ? World->GetSubsystem<URogueTrainWorldSubsystem>() : nullptr;
+		if (!Settings || !TrainSubsystem) return;
+
+		const URogueScenarioSubsystem* ScenarioSubsystem = World->GetSubsystem<URogueScenarioSubsystem>();
+		const double Tolerance = Args.Num() > 0 ? FCString::Atod(*Args[0]) : 0.25;
+		const int32 Seed = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : ScenarioSubsystem ? ScenarioSubsystem->GetParams().Seed : 0;
+
+		const FRogueEventSimStats& MassStats = TrainSubsystem->GetRunStats();
+		FRogueEventSimulation Simulation;
+		if (MassStats.SimulatedSeconds <= 0.0 || !Simulation.Init(*TrainSubsystem, *Settings, Seed))
+		{
+			UE_LOG(LogRogueSim, Warning, TEXT("Event sim cross check: track not ready, start the simulation first"));
+			return;
+		}
+
+		Simulation.RunUntil(MassStats.SimulatedSeconds);
+		UE_LOG(LogRogueSim, Log, TEXT("Cross check event: %s"), *Simulation.GetStats().ToString());
+		UE_LOG(LogRogueSim, Log, TEXT("Cross check mass:  %s"), *MassStats.ToString());
+
+		FString Mismatch;
+		if (Simulation.GetStats().MatchesWithin(MassStats, Tolerance, Mismatch))
+		{
+			UE_LOG(LogRogueSim, Display, TEXT("Event sim cross check passed within %.0f%%"), Tolerance * 100.0);
+		}
+		else
+		{
+			UE_LOG(LogRogueSim, Error, TEXT("Event sim cross check failed: %s"), *Mismatch);
+		}
+	}));
@@ -0,0 +1,160 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/RogueFrameScratch.h"
+
+#if ROGUE_ALLOC_COUNTERS_ENABLED
+
+#include "RogueMassExample.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarRogueCountAllocations(
+	TEXT("rogue.Debug.CountAllocations"),
+	0,
+	TEXT("Count heap allocations per Rogue processor and in the spawn queue. 1 counts for rogue.Report.Allocations, 2 also warns on every frame a scope allocates."),
+	ECVF_Default);
+
+namespace RogueAllocCounters
+{
+	static FCriticalSection CountersLock;
+	static FRogueAllocCounter* FirstCounter = nullptr;
+	static std::atomic<bool> bCapturing{false};
+
+	static uint64 GetMallocCalls()
+	{
+		return static_cast<uint64>(FMalloc::TotalMallocCalls) + static_cast<uint64>(FMalloc::TotalReallocCalls);
+	}
+
+	// Moves this frame's counts into the totals, runs on the game thread after the frame
+	static void EndFrame()
+	{
+		if (!IsCounting()) return;
+
+		const bool bWarn = CVarRogueCountAllocations.GetValueOnGameThread() > 1;
+		FScopeLock Lock(&CountersLock);
+		for (FRogueAllocCounter* Counter = FirstCounter; Counter; Counter = Counter->Next)
+		{
+			const uint32 Allocs = Counter->FrameAllocs.exchange(0, std::memory_order_relaxed);
+			if (Allocs == 0) continue;
+
+			Counter->TotalAllocs += Allocs;
+			++Counter->FramesWithAllocs;
+			if (bWarn)
+			{
+				UE_LOG(LogRogueSim, Warning, TEXT("%s made %u heap allocations on frame %llu"), Counter->Name, Allocs, GFrameCounter);
+			}
+		}
+	}
+
+	static uint64 LogAndResetTotals()
+	{
+		uint64 Sum = 0;
+		FScopeLock Lock(&CountersLock);
+		for (FRogueAllocCounter* Counter = FirstCounter; Counter; Counter = Counter->Next)
+		{
+			Counter->TotalAllocs += Counter->FrameAllocs.exchange(0, std::memory_order_relaxed);
+			if (Counter->TotalAllocs > 0)
+			{
+				UE_LOG(LogRogueSim, Display, TEXT("Allocations %-24s %8llu on %u frames"), Counter->Name, Counter->TotalAllocs, Counter->FramesWithAllocs);
+			}
+
+			Sum += Counter->TotalAllocs;
+			Counter->TotalAllocs = 0;
+			Counter->FramesWithAllocs = 0;
+			Counter->Cycles.store(0, std::memory_order_relaxed);
+			Counter->Calls.store(0, std::memory_order_relaxed);
+		}
+		return Sum;
+	}
+
+	static FDelayedAutoRegisterHelper GRegisterEndFrame(EDelayedRegisterRunPhase::EndOfEngineInit, []
+	{
+		FCoreDelegates::OnEndFrame.AddStatic(&EndFrame);
+	});
+}
+
+FRogueAllocCounter::FRogueAllocCounter(const TCHAR* InName) : Name(InName)
+{
+	FScopeLock Lock(&RogueAllocCounters::CountersLock);
+	Next = RogueAllocCounters::FirstCounter;
+	RogueAllocCounters::FirstCounter = this;
+}
+
+FRogueAllocCounterScope::FRogueAllocCounterScope(FRogueAllocCounter& InCounter)
+{
+	if (!RogueAllocCounters::IsCounting()) return;
+
+	Counter = &InCounter;
+	StartCalls = RogueAllocCounters::GetMallocCalls();
+	StartCycles = FPlatformTime::Cycles64();
+}
+
+FRogueAllocCounterScope::~FRogueAllocCounterScope()
+{
+	if (!Counter) return;
+	Counter->FrameAllocs.fetch_add(static_cast<uint32>(RogueAllocCounters::GetMallocCalls() - StartCalls), std::memory_order_relaxed);
+	Counter->Cycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+	Counter->Calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool RogueAllocCounters::IsCounting()
+{
+	return bCapturing.load(std::memory_order_relaxed) || CVarRogueCountAllocations.GetValueOnAnyThread() > 0;
+}
+
+void RogueAllocCounters::BeginCapture()
+{
+	FScopeLock Lock(&CountersLock);
+	for (FRogueAllocCounter* Counter = FirstCounter; Counter; Counter = Counter->Next)
+	{
+		Counter->FrameAllocs.store(0, std::memory_order_relaxed);
+		Counter->TotalAllocs = 0;
+		Counter->FramesWithAllocs = 0;
+		Counter->Cycles.store(0, std::memory_order_relaxed);
+		Counter->Calls.store(0, std::memory_order_relaxed);
+	}
+	bCapturing.store(true, std::memory_order_relaxed);
+}
+
+uint64 RogueAllocCounters::EndCapture()
+{
+	bCapturing.store(false, std::memory_order_relaxed);
+	return LogAndResetTotals();
+}
+
+void RogueAllocCounters::GetCaptureTotals(TArray<FRogueScopeCaptureTotals>& Out)
+{
+	Out.Reset();
+	FScopeLock Lock(&CountersLock);
+	for (const FRogueAllocCounter* Counter = FirstCounter; Counter; Counter = Counter->Next)
+	{
+		const uint32 Calls = Counter->Calls.load(std::memory_order_relaxed);
+		if (Calls == 0) continue;
+
+		FRogueScopeCaptureTotals& Totals = Out.AddDefaulted_GetRef();
+		Totals.Name = Counter->Name;
+		Totals.Allocs = Counter->TotalAllocs + Counter->FrameAllocs.load(std::memory_order_relaxed);
+		Totals.Cycles = Counter->Cycles.load(std::memory_order_relaxed);
+		Totals.Calls = Calls;
+	}
+}
+
+bool RogueAllocCounters::AreCountsAttributable()
+{
+	return !FApp::ShouldUseThreadingForPerformance();
+}
+
+static FAutoConsoleCommand GRogueReportAllocationsCmd(
+	TEXT("rogue.Report.Allocations"),
+	TEXT("Log the heap allocations counted per scope since the last report and reset them. Needs rogue.Debug.CountAllocations 1."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const uint64 Sum = RogueAllocCounters::LogAndResetTotals();
+		UE_LOG(LogRogueSim, Display, TEXT("Allocations total %llu"), Sum);
+	}));
+
+#endif
@@ -0,0 +1,31 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/RogueSimTrace.h"
+
+#if ROGUE_SIM_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_DEFINE(RogueSimChannel)
+
+// 25 bytes per event, entities are stored by index only
+UE_TRACE_EVENT_BEGIN(RogueSim, Event)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(float, SimTime)
+	UE_TRACE_EVENT_FIELD(uint32, Entity)
+	UE_TRACE_EVENT_FIELD(uint32, Other)
+	UE_TRACE_EVENT_FIELD(int32, Value)
+	UE_TRACE_EVENT_FIELD(uint8, Type)
+UE_TRACE_EVENT_END()
+
+void RogueSimTrace::OutputEvent(const ERogueSimTraceEvent Type, const double SimTime, const FMassEntityHandle Entity, const FMassEntityHandle Other, const int32 Value)
+{
+	UE_TRACE_LOG(RogueSim, Event, RogueSimChannel)
+		<< Event.Cycle(FPlatformTime::Cycles64())
+		<< Event.SimTime(static_cast<float>(SimTime))
+		<< Event.Entity(static_cast<uint32>(Entity.Index))
+		<< Event.Other(static_cast<uint32>(Other.Index))
+		<< Event.Value(Value)
+		<< Event.Type(static_cast<uint8>(Type));
+}
+
+#endif
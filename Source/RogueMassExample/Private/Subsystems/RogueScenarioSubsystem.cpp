@@ -0,0 +1,349 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/RogueScenarioSubsystem.h"
+#include "RogueMassExample.h"
+#include "Actors/RogueTrainTrack.h"
+#include "Components/SplineComponent.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+
+static TOptional<FRogueScenarioParams> GRogueScenarioParamsOverride;
+
+void URogueScenarioSubsystem::SetParamsOverride(const FRogueScenarioParams* InParams)
+{
+	GRogueScenarioParamsOverride = InParams ? TOptional<FRogueScenarioParams>(*InParams) : TOptional<FRogueScenarioParams>();
+}
+
+bool URogueScenarioSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	FString PresetName;
+	return World && World->IsGameWorld() && (GRogueScenarioParamsOverride.IsSet() || FParse::Value(FCommandLine::Get(), TEXT("RogueScenario="), PresetName));
+}
+
+void URogueScenarioSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ParseCommandLine();
+}
+
+void URogueScenarioSubsystem::Deinitialize()
+{
+	if (bApplied)
+	{
+		RestoreSettings(*GetMutableDefault<URogueDeveloperSettings>());
+		bApplied = false;
+	}
+
+	TrackActor = nullptr;
+	FrameTimesMs.Reset();
+	
+	Super::Deinitialize();
+}
+
+TStatId URogueScenarioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URogueScenarioSubsystem, STATGROUP_Tickables);
+}
+
+FRogueScenarioParams URogueScenarioSubsystem::GetPreset(const ERogueScenarioPreset Preset)
+{
+	FRogueScenarioParams Out;
+	switch (Preset)
+	{
+		case ERogueScenarioPreset::Small:
+			Out.NumStations = 4;
+			Out.NumTrains = 2;
+			Out.CarriagesPerTrain = 3;
+			Out.MaxPassengers = 200;
+			Out.SpawnIntervalSeconds = 0.25f;
+			Out.PassengersPerSpawn = 1;
+			break;
+		case ERogueScenarioPreset::Medium:
+			Out.NumStations = 20;
+			Out.NumTrains = 40;
+			Out.CarriagesPerTrain = 3;
+			Out.MaxPassengers = 5000;
+			Out.SpawnIntervalSeconds = 0.05f;
+			Out.PassengersPerSpawn = 2;
+			break;
+		case ERogueScenarioPreset::Large:
+			Out.NumStations = 80;
+			Out.NumTrains = 250;
+			Out.CarriagesPerTrain = 4;
+			Out.MaxPassengers = 25000;
+			Out.SpawnIntervalSeconds = 0.02f;
+			Out.PassengersPerSpawn = 8;
+			break;
+		case ERogueScenarioPreset::Stress:
+			Out.NumStations = 200;
+			Out.NumTrains = 1000;
+			Out.CarriagesPerTrain = 4;
+			Out.MaxPassengers = 100000;
+			Out.SpawnIntervalSeconds = 0.01f;
+			Out.PassengersPerSpawn = 32;
+			break;
+		default: break;
+	}
+	
+	return Out;
+}
+
+void URogueScenarioSubsystem::ParseCommandLine()
+{
+	// The caller drives the frames, no perf run of our own
+	if (GRogueScenarioParamsOverride.IsSet())
+	{
+		Params = GRogueScenarioParamsOverride.GetValue();
+		return;
+	}
+	
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	FString PresetName;
+	FParse::Value(CommandLine, TEXT("RogueScenario="), PresetName);
+	if (const UEnum* PresetEnum = StaticEnum<ERogueScenarioPreset>())
+	{
+		const int64 Value = PresetEnum->GetValueByNameString(PresetName);
+		if (Value != INDEX_NONE)
+		{
+			Preset = static_cast<ERogueScenarioPreset>(Value);
+		}
+		else
+		{
+			UE_LOG(LogRogueSim, Warning, TEXT("Unknown scenario preset '%s', using Small"), *PresetName);
+		}
+	}
+
+	// Preset first, individual values override it
+	Params = GetPreset(Preset);
+	FParse::Value(CommandLine, TEXT("RogueStations="), Params.NumStations);
+	FParse::Value(CommandLine, TEXT("RogueTrains="), Params.NumTrains);
+	FParse::Value(CommandLine, TEXT("RogueCarriages="), Params.CarriagesPerTrain);
+	FParse::Value(CommandLine, TEXT("RoguePassengers="), Params.MaxPassengers);
+	FParse::Value(CommandLine, TEXT("RogueSeed="), Params.Seed);
+	FParse::Value(CommandLine, TEXT("RogueScenarioWarmup="), WarmupFrames);
+	FParse::Value(CommandLine, TEXT("RogueScenarioFrames="), MeasureFrames);
+	FParse::Value(CommandLine, TEXT("RogueScenarioMaxAllocs="), MaxSimAllocs);
+
+	Params.NumStations = FMath::Max(2, Params.NumStations);
+	Params.NumTrains = FMath::Max(1, Params.NumTrains);
+	Params.CarriagesPerTrain = FMath::Max(0, Params.CarriagesPerTrain);
+	Params.MaxPassengers = FMath::Max(0, Params.MaxPassengers);
+}
+
+void URogueScenarioSubsystem::ApplyScenario(UWorld& InWorld)
+{
+	if (bApplied) return;
+	
+	auto* Settings = GetMutableDefault<URogueDeveloperSettings>();
+	if (!Settings) return;
+
+	// Grow the gap between stations so every train placed in it fits with a stop radius of headroom
+	const float TrainLength = Settings->EngineLength + Params.CarriagesPerTrain * (Settings->CarriageLength + Settings->CarriageSpacing);
+	const int32 TrainsPerGap = FMath::DivideAndRoundUp(Params.NumTrains, Params.NumStations);
+	const double StationSpacing = FMath::Max(static_cast<double>(Params.MinStationSpacing), TrainsPerGap * 2.0 * (TrainLength + Settings->StationStopRadius));
+	const double TrackLength = StationSpacing * Params.NumStations;
+
+	TrackActor = SpawnTrack(InWorld, TrackLength);
+	if (!TrackActor) return;
+
+	BackupSettings(*Settings);
+	Settings->TrackSplineActor = TrackActor;
+	Settings->AdditionalTrackLines.Reset();
+	Settings->Junctions.Reset();
+	Settings->JunctionSeed = Params.Seed;
+	BuildStationConfigs(Settings->Stations);
+	Settings->NumTrains = Params.NumTrains;
+	Settings->CarriagesPerTrain = Params.CarriagesPerTrain;
+	Settings->MaxPassengersOverall = Params.MaxPassengers;
+	Settings->SpawnIntervalSeconds = Params.SpawnIntervalSeconds;
+	Settings->PassengersPerSpawn = Params.PassengersPerSpawn;
+	bApplied = true;
+
+	// Passenger spawning draws from the global stream, seed it so runs are repeatable
+	FMath::RandInit(Params.Seed);
+	FMath::SRandInit(Params.Seed);
+
+	UE_LOG(LogRogueSim, Log, TEXT("Scenario %s: %d stations, %d trains x %d carriages, %d passengers, track %.0f m"),
+		*StaticEnum<ERogueScenarioPreset>()->GetNameStringByValue(static_cast<int64>(Preset)), Params.NumStations, Params.NumTrains, Params.CarriagesPerTrain, Params.MaxPassengers, TrackLength * 0.01);
+}
+
+AActor* URogueScenarioSubsystem::SpawnTrack(UWorld& InWorld, const double TrackLength) const
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	
+	ARogueTrainTrack* Track = InWorld.SpawnActor<ARogueTrainTrack>(ARogueTrainTrack::StaticClass(), FTransform::Identity, SpawnParams);
+	if (!Track) return nullptr;
+
+	USplineComponent* Spline = Track->FindComponentByClass<USplineComponent>();
+	if (!Spline)
+	{
+		Track->Destroy();
+		return nullptr;
+	}
+
+	// Closed circle, the train subsystem resamples it to uniform spacing when the line is added
+	const double Radius = TrackLength / UE_DOUBLE_TWO_PI;
+	const int32 NumPoints = FMath::Clamp(Params.NumStations * 4, 16, 1024);
+	
+	Spline->ClearSplinePoints(false);
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		const double Angle = UE_DOUBLE_TWO_PI * i / NumPoints;
+		Spline->AddSplinePoint(FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.0), ESplineCoordinateSpace::Local, false);
+	}
+	
+	Spline->SetClosedLoop(true, false);
+	Spline->UpdateSpline();
+	return Track;
+}
+
+void URogueScenarioSubsystem::BuildStationConfigs(TArray<FRogueStationConfig>& Out) const
+{
+	Out.Reset(Params.NumStations);
+	for (int32 i = 0; i < Params.NumStations; ++i)
+	{
+		FRogueStationConfig& Station = Out.AddDefaulted_GetRef();
+		Station.LineIndex = 0;
+		Station.TrackAlpha = (i + 0.5f) / Params.NumStations;
+	}
+}
+
+void URogueScenarioSubsystem::BackupSettings(const URogueDeveloperSettings& Settings)
+{
+	SettingsBackup.TrackSplineActor = Settings.TrackSplineActor;
+	SettingsBackup.AdditionalTrackLines = Settings.AdditionalTrackLines;
+	SettingsBackup.Junctions = Settings.Junctions;
+	SettingsBackup.JunctionSeed = Settings.JunctionSeed;
+	SettingsBackup.Stations = Settings.Stations;
+	SettingsBackup.NumTrains = Settings.NumTrains;
+	SettingsBackup.CarriagesPerTrain = Settings.CarriagesPerTrain;
+	SettingsBackup.MaxPassengersOverall = Settings.MaxPassengersOverall;
+	SettingsBackup.SpawnIntervalSeconds = Settings.SpawnIntervalSeconds;
+	SettingsBackup.PassengersPerSpawn = Settings.PassengersPerSpawn;
+}
+
+void URogueScenarioSubsystem::RestoreSettings(URogueDeveloperSettings& Settings) const
+{
+	Settings.TrackSplineActor = SettingsBackup.TrackSplineActor;
+	Settings.AdditionalTrackLines = SettingsBackup.AdditionalTrackLines;
+	Settings.Junctions = SettingsBackup.Junctions;
+	Settings.JunctionSeed = SettingsBackup.JunctionSeed;
+	Settings.Stations = SettingsBackup.Stations;
+	Settings.NumTrains = SettingsBackup.NumTrains;
+	Settings.CarriagesPerTrain = SettingsBackup.CarriagesPerTrain;
+	Settings.MaxPassengersOverall = SettingsBackup.MaxPassengersOverall;
+	Settings.SpawnIntervalSeconds = SettingsBackup.SpawnIntervalSeconds;
+	Settings.PassengersPerSpawn = SettingsBackup.PassengersPerSpawn;
+}
+
+void URogueScenarioSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	
+	if (!bApplied || MeasureFrames <= 0 || bReported) return;
+
+	++FramesSeen;
+	if (FramesSeen <= WarmupFrames) return;
+
+	if (FrameTimesMs.Num() == 0)
+	{
+		FrameTimesMs.Reserve(MeasureFrames);
+		MeasureStartTime = FPlatformTime::Seconds();
+
+#if ROGUE_ALLOC_COUNTERS_ENABLED
+		// Steady state target is zero heap allocations in the processors and spawn queue
+		RogueAllocCounters::BeginCapture();
+#endif
+		
+#if STATS
+		// Per processor timings, open the capture in Unreal Insights or the stats viewer
+		GEngine->Exec(GetWorld(), TEXT("stat startfile"));
+#endif
+	}
+
+	// Real frame time, DeltaTime is dilated when the sim is accelerated
+	FrameTimesMs.Add(static_cast<float>(FApp::GetDeltaTime() * 1000.0));
+	if (FrameTimesMs.Num() >= MeasureFrames)
+	{
+#if STATS
+		GEngine->Exec(GetWorld(), TEXT("stat stopfile"));
+#endif
+		ReportPerfRun();
+		bReported = true;
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("RogueScenarioExit")))
+		{
+			FPlatformMisc::RequestExitWithStatus(false, bAllocBudgetExceeded ? 1 : 0, TEXT("URogueScenarioSubsystem"));
+		}
+	}
+}
+
+void URogueScenarioSubsystem::ReportPerfRun()
+{
+	const URogueTrainWorldSubsystem* TrainSubsystem = GetWorld() ? GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>() : nullptr;
+	if (!TrainSubsystem || FrameTimesMs.Num() == 0) return;
+
+	TArray<float> Sorted = FrameTimesMs;
+	Sorted.Sort();
+	
+	double Total = 0.0;
+	for (const float FrameMs : Sorted)
+	{
+		Total += FrameMs;
+	}
+	
+	const float AvgMs = static_cast<float>(Total / Sorted.Num());
+	const float P50Ms = Sorted[Sorted.Num() / 2];
+	const float P95Ms = Sorted[FMath::Min(Sorted.Num() - 1, FMath::FloorToInt32(Sorted.Num() * 0.95f))];
+	const float MaxMs = Sorted.Last();
+	const int32 NumStations = TrainSubsystem->GetLiveCount(ERogueEntityType::Station);
+	const int32 NumEngines = TrainSubsystem->GetLiveCount(ERogueEntityType::TrainEngine);
+	const int32 NumCarriages = TrainSubsystem->GetLiveCount(ERogueEntityType::TrainCarriage);
+	const int32 NumPassengers = TrainSubsystem->GetLiveCount(ERogueEntityType::Passenger);
+	const FString PresetName = StaticEnum<ERogueScenarioPreset>()->GetNameStringByValue(static_cast<int64>(Preset));
+
+	UE_LOG(LogRogueSim, Display, TEXT("Scenario %s perf: %d frames in %.1fs | avg %.2fms p50 %.2fms p95 %.2fms max %.2fms | stations %d engines %d carriages %d passengers %d pooled %d"),
+		*PresetName, Sorted.Num(), FPlatformTime::Seconds() - MeasureStartTime, AvgMs, P50Ms, P95Ms, MaxMs,
+		NumStations, NumEngines, NumCarriages, NumPassengers, TrainSubsystem->GetTotalPoolCount());
+
+#if ROGUE_ALLOC_COUNTERS_ENABLED
+	const uint64 SimAllocs = RogueAllocCounters::EndCapture();
+	UE_LOG(LogRogueSim, Display, TEXT("Scenario %s allocations: %llu heap allocations in counted simulation scopes over %d frames"), *PresetName, SimAllocs, Sorted.Num());
+	if (MaxSimAllocs >= 0 && !RogueAllocCounters::AreCountsAttributable())
+	{
+		// Worker and render thread allocations land in the counts too, a budget would fail on noise
+		UE_LOG(LogRogueSim, Warning, TEXT("Scenario %s allocation budget not enforced, run with -onethread to check it"), *PresetName);
+	}
+	else if (MaxSimAllocs >= 0 && SimAllocs > static_cast<uint64>(MaxSimAllocs))
+	{
+		UE_LOG(LogRogueSim, Error, TEXT("Scenario %s allocation budget exceeded: %llu > %d"), *PresetName, SimAllocs, MaxSimAllocs);
+		bAllocBudgetExceeded = true;
+	}
+#endif
+
+	// One row per run so results can be compared across changes
+	const FString CsvPath = FPaths::ProfilingDir() / TEXT("RogueScenario.csv");
+	if (!FPaths::FileExists(CsvPath))
+	{
+		FFileHelper::SaveStringToFile(TEXT("Date,Preset,Seed,Frames,AvgMs,P50Ms,P95Ms,MaxMs,Stations,Engines,Carriages,Passengers\n"), *CsvPath);
+	}
+	
+	const FString Row = FString::Printf(TEXT("%s,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d\n"),
+		*FDateTime::Now().ToString(), *PresetName, Params.Seed, Sorted.Num(), AvgMs, P50Ms, P95Ms, MaxMs,
+		NumStations, NumEngines, NumCarriages, NumPassengers);
+	FFileHelper::SaveStringToFile(Row, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
@@ -2,46 +2,69 @@
 
 
 #include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "RogueMassExample.h"
 #include "Data/RogueDeveloperSettings.h"
-#include "EngineUtils.h"
+#include "MassCommands.h"
 #include "MassCommonFragments.h"
 #include "MassEntityConfigAsset.h"
 #include "MassEntitySubsystem.h"
+#include "MassSimulationSubsystem.h"
 #include "MassRepresentationFragments.h"
 #include "MassSpawnerSubsystem.h"
-#include "Actors/RogueTrainStation.h"
 #include "Actors/RogueTrainTrack.h"
 #include "Avoidance/MassAvoidanceFragments.h"
 #include "GameFramework/Actor.h"
+#include "GameFramework/WorldSettings.h"
 #include "Components/SplineComponent.h"
+#include "Simulation/RogueFrameScratch.h"
+#include "Simulation/RogueSimTrace.h"
+#include "Subsystems/RogueScenarioSubsystem.h"
 #include "Utilities/RoguePassengerUtility.h"
 #include "Utilities/RogueStationQueueUtility.h"
 #include "Utilities/RogueTrainUtility.h"
 
+DECLARE_CYCLE_STAT(TEXT("Process Pending Spawns"), STAT_RogueProcessPendingSpawns, STATGROUP_RogueSim);
+DECLARE_CYCLE_STAT(TEXT("Spawn Config"), STAT_RogueSpawnConfig, STATGROUP_RogueSim);
+DECLARE_CYCLE_STAT(TEXT("Configure Track To Station"), STAT_RogueConfigureTrackToStation, STATGROUP_RogueSim);
+
 
 void URogueTrainWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
+
+	// Every simulation processor reads the clock, step it before any of them can run in parallel
+	if (UMassSimulationSubsystem* SimulationSubsystem = Collection.InitializeDependency<UMassSimulationSubsystem>())
+	{
+		PhaseStartedHandle = SimulationSubsystem->GetOnProcessingPhaseStarted(EMassProcessingPhase::PrePhysics).AddUObject(this, &URogueTrainWorldSubsystem::AdvanceSimClock);
+	}
 	
 	InitEntityManagement();
 	InitTemplateConfigs();
 	bTrackDirty = true;
-
-#if WITH_EDITOR
-	InitDebugData();
-#endif
-	
 }
 
 void URogueTrainWorldSubsystem::Deinitialize()
 {	
-	PendingSpawns.Reset();
+	for (TRingBuffer<FRogueSpawnRequest>& Ring : PendingSpawns)
+	{
+		Ring.Empty();
+	}
+	SpawnPayloads.Empty();
 	EntityPool.Empty();
 	WorldEntities.Empty();
-	StationActorData.Reset();
-	TrackSpline = nullptr;
+	Lines.Reset();
+	Consists.Reset();
+	OccupantSlab.Reset();
+	RunStats = FRogueEventSimStats();
+	SimClock = FRogueSimClock();
 	EntityManager = nullptr;
 
+	if (UMassSimulationSubsystem* SimulationSubsystem = GetWorld()->GetSubsystem<UMassSimulationSubsystem>())
+	{
+		SimulationSubsystem->GetOnProcessingPhaseStarted(EMassProcessingPhase::PrePhysics).Remove(PhaseStartedHandle);
+	}
+	PhaseStartedHandle.Reset();
+
 	StopSpawnManager();
 
 	Super::Deinitialize();
@@ -111,12 +134,12 @@ void URogueTrainWorldSubsystem::SpawnManager()
 {
 	ProcessPendingSpawns();
 
-	/*UE_LOG(LogTemp, Warning, TEXT("[StationActorData:%d][Engines:%d][Carriages:%d][Passengers:%d] PendingSpawns:%d"),
+	/*UE_LOG(LogTemp, Warning, TEXT("[Stations:%d][Engines:%d][Carriages:%d][Passengers:%d] PendingSpawns:%d"),
 		GetLiveCount(ERogueEntityType::Station),
 		GetLiveCount(ERogueEntityType::TrainEngine),
 		GetLiveCount(ERogueEntityType::TrainCarriage),
 		GetLiveCount(ERogueEntityType::Passenger),
-		PendingSpawns.Num()
+		GetNumPendingSpawns()
 	);*/
 }
 
@@ -152,55 +175,98 @@ void URogueTrainWorldSubsystem::InitEntityManagement()
 void URogueTrainWorldSubsystem::DiscoverSplineFromSettings()
 {
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
-	if (!Settings || !Settings->TrackSplineActor.IsValid()) return;
+	if (!Settings) return;
+
+	Lines.Reset();
+	TrackActors.Reset();
+
+	// Line 0 is the main track, additional lines follow in settings order
+	AddTrackLine(Settings->TrackSplineActor.Get(), Settings->NumTrains, Settings->TrackSplineResampleStep);
+	for (const FRogueTrackLineConfig& LineConfig : Settings->AdditionalTrackLines)
+	{
+		AddTrackLine(LineConfig.TrackSplineActor.Get(), LineConfig.NumTrains, Settings->TrackSplineResampleStep);
+	}
+}
+
+void URogueTrainWorldSubsystem::AddTrackLine(AActor* TrackActor, const int32 NumTrains, const float ResampleStep)
+{
+	if (!EntityManager) return;
+
+	// Always add the line so indices match settings, even if the actor is missing
+	FRogueTrackLine& Line = Lines.AddDefaulted_GetRef();
+	Line.NumTrains = NumTrains;
+
+	FRogueTrackSharedFragment LineFragment;
+	LineFragment.LineIndex = Lines.Num() - 1;
+	Line.SharedFragment = EntityManager->GetOrCreateSharedFragment(LineFragment);
 
-	AActor* TrackActor = Settings->TrackSplineActor.Get();
 	if (!TrackActor) return;
+	Line.TrackActor = TrackActor;
+
+	if (ARogueTrainTrack* TrainTrack = Cast<ARogueTrainTrack>(TrackActor))
+	{
+		TrackActors.Add(TrainTrack);
+	}
 	
-	TrackActors.Add(Cast<ARogueTrainTrack>(TrackActor));
 	if (USplineComponent* Found = TrackActor->FindComponentByClass<USplineComponent>())
 	{
-		TrackSpline = Found;
-
-		if (TrackSpline.Get())
-		{
-			ResampleSplineUniform(*TrackSpline.Get(), Settings->TrackSplineResampleStep);
-		}
+		Line.Spline = Found;
+		ResampleSplineUniform(*Found, ResampleStep);
+		Line.TrainIndex.SetTrackLength(Found->GetSplineLength());
+		RebuildTrackBVH(Lines.Num() - 1);
 	}
 }
 
-void URogueTrainWorldSubsystem::GatherStationActors()
+void URogueTrainWorldSubsystem::RebuildTrackBVH(const int32 LineIndex)
 {
-	StationActorData.Reset();
-	if (!GetWorld()) return;
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (!Settings || !Lines.IsValidIndex(LineIndex)) return;
+
+	FRogueTrackLine& Line = Lines[LineIndex];
+	if (!Line.SharedFragment.IsValid()) return;
 
-	for (TActorIterator<ARogueTrainStation> It(GetWorld()); It; ++It)
+	FRogueTrackSegmentBVH& SegmentBVH = Line.SharedFragment.Get<FRogueTrackSharedFragment>().SegmentBVH;
+	if (const USplineComponent* Spline = Line.Spline.Get())
 	{
-		const ARogueTrainStation* Station = *It;
-		if (!Station) continue;
+		SegmentBVH.Build(*Spline, Settings->TrackQuerySegmentLength);
+	}
+	else
+	{
+		SegmentBVH.Reset();
+	}
+}
 
-		FRogueStationData StationData;
-		StationData.Alpha = Station->GetStationAlpha();
-		StationData.WorldPos = Station->GetActorLocation();
+const FRogueTrackSegmentBVH* URogueTrainWorldSubsystem::GetTrackBVH(const int32 LineIndex) const
+{
+	if (!Lines.IsValidIndex(LineIndex) || !Lines[LineIndex].SharedFragment.IsValid()) return nullptr;
+	
+	const FRogueTrackSegmentBVH& SegmentBVH = Lines[LineIndex].SharedFragment.Get<FRogueTrackSharedFragment>().SegmentBVH;
+	return SegmentBVH.IsValid() ? &SegmentBVH : nullptr;
+}
 
-		StationData.WaitingPoints.Reset();
-		StationData.SpawnPoints.Reset();
+bool URogueTrainWorldSubsystem::FindNearestTrackDistance(const FVector& WorldPos, double& OutDistance, int32& OutLineIndex, const int32 LineIndex) const
+{
+	OutLineIndex = INDEX_NONE;
+	double BestDistSq = DBL_MAX;
 
-		const FTransform ToWorld = Station->GetActorTransform();
-		for (const FTransform& LT : Station->WaitingPointWidgets)
-		{
-			StationData.WaitingPoints.Add(ToWorld.TransformPosition(LT.GetLocation()));
-		}
-		
-		for (const FTransform& LT : Station->SpawnPointWidgets)
+	const int32 FirstLine = LineIndex == INDEX_NONE ? 0 : LineIndex;
+	const int32 LastLine = LineIndex == INDEX_NONE ? Lines.Num() - 1 : LineIndex;
+	for (int32 LineIdx = FirstLine; LineIdx <= LastLine; ++LineIdx)
+	{
+		const FRogueTrackSegmentBVH* SegmentBVH = GetTrackBVH(LineIdx);
+		if (!SegmentBVH) continue;
+
+		double Distance = 0.0;
+		double DistSq = DBL_MAX;
+		if (SegmentBVH->FindClosest(WorldPos, Distance, nullptr, &DistSq) && DistSq < BestDistSq)
 		{
-			StationData.SpawnPoints.Add(ToWorld.TransformPosition(LT.GetLocation()));
+			BestDistSq = DistSq;
+			OutDistance = Distance;
+			OutLineIndex = LineIdx;
 		}
-		
-		StationActorData.Add(StationData);
 	}
-
-	StationActorData.Sort([](const FRogueStationData& L, const FRogueStationData& R){ return L.Alpha < R.Alpha; });
+	
+	return OutLineIndex != INDEX_NONE;
 }
 
 void URogueTrainWorldSubsystem::CreateStations()
@@ -211,47 +277,52 @@ void URogueTrainWorldSubsystem::CreateStations()
 	// Check station data found
 	checkf(Platforms.Num() > 0, TEXT("No stations found! Configure station data in Settings."));
 		
-	const FMassEntityTemplate* StationEntityTemplate = GetStationTemplate();
-	if (!StationEntityTemplate->IsValid()) return;
+	if (!GetStationTemplate()) return;
 
 	// Create station entities at platform locations	
 	for (int i = 0; i < Platforms.Num(); ++i)
 	{
 		FRogueSpawnRequest Request;
 		Request.Type = ERogueEntityType::Station;
-		Request.EntityTemplate = StationEntityTemplate;
 		Request.RemainingCount = 1;
-		Request.PlatformData = Platforms[i];
 		Request.StationIdx = i;
-		Request.Transform = Platforms[i].World;
+		Request.LineIndex = Platforms[i].LineIndex;
+		Request.Location = Platforms[i].World.GetLocation();
+		Request.Rotation = FQuat4f(Platforms[i].World.GetRotation());
 
 		EnqueueSpawns(Request);				
 	}
 }
 
-void URogueTrainWorldSubsystem::ConfigureTrackToStation(const FRogueSpawnRequest& Request, const float ResampleDistance) const
+void URogueTrainWorldSubsystem::ConfigureTrackToStation(const FRogueSpawnRequest& Request, const float ResampleDistance)
 {
-	USplineComponent* Spline = TrackSpline.Get();
-	if (!Spline) return;
+	SCOPE_CYCLE_COUNTER(STAT_RogueConfigureTrackToStation);
+	
+	USplineComponent* Spline = GetSpline(Request.LineIndex);
+	const FRogueTrackSegmentBVH* SegmentBVH = GetTrackBVH(Request.LineIndex);
+	if (!Spline || !SegmentBVH || !Platforms.IsValidIndex(Request.StationIdx)) return;
 
-	const FVector Center = Request.PlatformData.Center;
-	const float PlatformLength = FMath::Max(1.f, Request.PlatformData.PlatformLength);
+	const FRoguePlatformData& PlatformData = Platforms[Request.StationIdx];
+	const FVector Center = PlatformData.Center;
+	const float PlatformLength = FMath::Max(1.f, PlatformData.PlatformLength);
 	const float PlatformHalfLength = PlatformLength * 0.5f;
 	const float SampleDistance = ResampleDistance + PlatformLength;
-	const float TrackOffset = Request.PlatformData.TrackOffset;
+	const float TrackOffset = PlatformData.TrackOffset;
 	const float SplineLength = Spline->GetSplineLength();
-	const FVector Fwd = Request.PlatformData.Fwd;
-	const FVector Up = Request.PlatformData.Up;	
+	const FVector Fwd = PlatformData.Fwd;
+	const FVector Up = PlatformData.Up;	
 	const FVector Right = FVector::CrossProduct(Up, Fwd).GetSafeNormal();
 	const int32 NumPoints = Spline->GetNumberOfSplinePoints();	
-	float DistCenter = Spline->GetDistanceAlongSplineAtLocation(Center, ESplineCoordinateSpace::World);
+	double CenterDistance = 0.0;
+	SegmentBVH->FindClosest(Center, CenterDistance);
+	const float DistCenter = static_cast<float>(CenterDistance);
 	float DistStart = DistCenter - 0.5f * SampleDistance;
 	float DistEnd = DistCenter + 0.5f * SampleDistance;
 	const bool bWrap = (DistEnd < DistStart);
 
 	// Choose offset side
 	float Sign = +1.f;
-	EPlatformSide TrackSide = Request.PlatformData.TrackSide;
+	EPlatformSide TrackSide = PlatformData.TrackSide;
 	if (TrackSide == EPlatformSide::Left)  Sign = -1.f;
 	if (TrackSide == EPlatformSide::Auto)
 	{
@@ -368,6 +439,9 @@ void URogueTrainWorldSubsystem::ConfigureTrackToStation(const FRogueSpawnRequest
 	Spline->SetTangentAtSplinePoint(PlatformStartIndex, StartTangent, ESplineCoordinateSpace::World, false);	
 	
 	Spline->UpdateSpline();	
+
+	// Later stations on this line project against the aligned spline
+	RebuildTrackBVH(Request.LineIndex);
 }
 
 void URogueTrainWorldSubsystem::GetStationSide(const FRoguePlatformData& PlatformData, const FTransform& StationTransform, float& Out)
@@ -392,27 +466,41 @@ void URogueTrainWorldSubsystem::GetStationSide(const FRoguePlatformData& Platfor
 void URogueTrainWorldSubsystem::BuildStationPlatformData()
 {
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
-	if (!Settings || !Settings->TrackSplineActor.IsValid()) return;
+	if (!Settings || !EntityManager) return;
 
-	const TWeakObjectPtr<USplineComponent> Spline = TrackSpline.Get();
-	if (!Spline.IsValid()) return;
-
-	// Copy and sort by alpha so next station is defined correctly
+	// Copy and sort by line then alpha so next station is defined correctly per line
 	TArray<FRogueStationConfig> Stations = Settings->Stations;
-	Algo::SortBy(Stations, &FRogueStationConfig::TrackAlpha);
+	Stations.Sort([](const FRogueStationConfig& A, const FRogueStationConfig& B)
+	{
+		return A.LineIndex != B.LineIndex ? A.LineIndex < B.LineIndex : A.TrackAlpha < B.TrackAlpha;
+	});
 	
 	Platforms.Reset();
+	StationLayouts.Reset();
+	for (FRogueTrackLine& Line : Lines)
+	{
+		Line.StationIndices.Reset();
+	}
 
-	// Create platform data for each station in alpha order
-	TArray<float> StationTrackAlphas;
+	// Create platform data for each station in line and alpha order
 	for (int i = 0; i < Stations.Num(); ++i)
 	{
 		const FRogueStationConfig& StationConfigData = Stations[i];
-		StationTrackAlphas.Add(RogueTrainUtility::WrapTrackAlpha(StationConfigData.TrackAlpha));
+		const USplineComponent* Spline = GetSpline(StationConfigData.LineIndex);
+		const FRogueTrackSegmentBVH* SegmentBVH = GetTrackBVH(StationConfigData.LineIndex);
+		if (!Spline || !SegmentBVH) continue;
 		
 		FRoguePlatformData PlatformSegment;
-		RogueTrainUtility::BuildPlatformSegment(*Spline, StationConfigData, PlatformSegment);
-		Platforms.Add(MoveTemp(PlatformSegment));
+		RogueTrainUtility::BuildPlatformSegment(*Spline, *SegmentBVH, StationConfigData, PlatformSegment);
+		PlatformSegment.LineIndex = StationConfigData.LineIndex;
+
+		const int32 StationIdx = Platforms.Add(MoveTemp(PlatformSegment));
+		Lines[StationConfigData.LineIndex].StationIndices.Add(StationIdx);
+
+		// Static layout is baked once here, station entities reference it as a const shared fragment
+		FRogueStationLayoutFragment Layout;
+		RogueStationQueueUtility::BuildStationLayout(Platforms[StationIdx], StationConfigData, StationIdx, Layout);
+		StationLayouts.Add(EntityManager->GetOrCreateConstSharedFragment(Layout));
 	}
 }
 
@@ -421,134 +509,377 @@ void URogueTrainWorldSubsystem::CreateTrains()
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 
-	const FRogueTrackSharedFragment& TrackSharedFragment = GetTrackShared();
-	if (!TrackSharedFragment.IsValid()) return;
-
 	// Setup train entity configuration templates
-	const FMassEntityTemplate* TrainEngineTemplate = GetTrainTemplate();	
-	const FMassEntityTemplate* TrainCarriageTemplate = GetCarriageTemplate();
-	if (!TrainEngineTemplate->IsValid() || !TrainCarriageTemplate->IsValid()) return;
+	if (!GetTrainTemplate() || !GetCarriageTemplate()) return;
+
+	// Place carriages at the spacing and ride height of the class they spawn with
+	const FRogueCarriageClassFragment* CarriageClass = GetCarriageClass();
+	if (!CarriageClass) return;
 
-	const int32 NumStations = TrackSharedFragment.StationEntities.Num();
-	if (NumStations <= 0) return;
-	
-	const int32 NumberOfTrains = Settings->NumTrains;	
 	const int32 CarriagesPer = Settings->CarriagesPerTrain;
-	const int32 CapacityPerCar = Settings->MaxPassengersPerCarriage;
-	const int32 Passes = FMath::DivideAndRoundUp(NumberOfTrains, NumStations);
+	TArray<FRoguePlacedCar> Placement;
+
+	for (int32 LineIdx = 0; LineIdx < Lines.Num(); ++LineIdx)
+	{
+		const FRogueTrackSharedFragment& TrackSharedFragment = GetTrackShared(LineIdx);
+		if (!TrackSharedFragment.IsValid()) continue;
+
+		const int32 NumStations = TrackSharedFragment.StationEntities.Num();
+		if (NumStations <= 0) continue;
+		
+		const int32 NumberOfTrains = Lines[LineIdx].NumTrains;	
+		const int32 Passes = FMath::DivideAndRoundUp(NumberOfTrains, NumStations);
+		
+		for (int i = 0; i < NumberOfTrains; ++i)
+		{
+			const int32 StationIdx = i % NumStations;
+			const int32 PassIdx = i / NumStations;
+			const int32 NextIdx = (StationIdx + 1) % NumStations;
+			const double D0 = TrackSharedFragment.GetStationDistanceByIndex(StationIdx);
+			const double D1 = TrackSharedFragment.GetStationDistanceByIndex(NextIdx);
+			const double dD = RogueTrainUtility::ArcDistanceWrapped(D0, D1, TrackSharedFragment.TrackLength);
+			const double Frac = (Passes <= 1) ? 0.0 : static_cast<double>(PassIdx) / static_cast<double>(Passes);
+			const double TrainDistance = RogueTrainUtility::WrapTrackDistance(D0 + dD * Frac, TrackSharedFragment.TrackLength);
+
+			// Compute full consist placement from this head distance
+			RogueTrainUtility::ComputeConsistPlacement(TrackSharedFragment, TrainDistance, CarriagesPer, *CarriageClass, Placement);
+			if (Placement.Num() == 0) continue;
+
+			RogueTrainUtility::FSplineStationSample Sample;
+			if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, TrainDistance, Sample))
+			{
+				continue;
+			}		
+				
+			FRogueSpawnRequest Request;
+			Request.Type = ERogueEntityType::TrainEngine;
+			Request.RemainingCount = 1;
+			Request.Location = Placement[0].Transform.GetLocation();  // with ride height
+			Request.Rotation = FQuat4f(Placement[0].Transform.GetRotation());
+			Request.StartDistance = Placement[0].Distance;
+			Request.StationIdx = StationIdx;
+			Request.LineIndex = LineIdx;
+
+			// Carriages need the lead handle, park their placements in the arena until the engine is configured
+			Request.Continuation = ERogueSpawnContinuation::SpawnConsist;
+			Request.PayloadFirst = SpawnPayloads.Num();
+			Request.PayloadNum = Placement.Num() - 1;
+			SpawnPayloads.Append(Placement.GetData() + 1, Placement.Num() - 1);
+
+			EnqueueSpawns(Request);
+		}
+	}
+
+#if WITH_EDITOR
+	// Counts are final here, the scenario is applied and every line has its trains
+	InitDebugData();
+#endif
+}
+
+void URogueTrainWorldSubsystem::BuildTrackSharedData()
+{
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (!Settings) return;
 	
-	for (int i = 0; i < NumberOfTrains; ++i)
-	{
-		const int32 StationIdx = i % NumStations;
-		const int32 PassIdx = i / NumStations;
-		const int32 NextIdx = (StationIdx + 1) % NumStations;
-		const float T0 = TrackSharedFragment.GetStationAlphaByIndex(StationIdx);
-		const float T1 = TrackSharedFragment.GetStationAlphaByIndex(NextIdx);
-		const float dT = RogueTrainUtility::ArcDistanceWrapped(T0, T1);
-		const float Frac = (Passes <= 1) ? 0.f : static_cast<float>(PassIdx) / static_cast<float>(Passes);
-		const float TrainAlpha = RogueTrainUtility::WrapTrackAlpha(T0 + dT * Frac);
-
-		// Compute full consist placement from this head alpha
-		TArray<FRoguePlacedCar> Placement;
-		RogueTrainUtility::ComputeConsistPlacement(TrackSharedFragment, TrainAlpha, CarriagesPer, Placement);
-		if (Placement.Num() == 0) continue;
-
-		RogueTrainUtility::FSplineStationSample Sample;
-		if (!RogueTrainUtility::GetSplineSample(TrackSharedFragment, TrainAlpha, Sample))
+	for (int32 LineIdx = 0; LineIdx < Lines.Num(); ++LineIdx)
+	{
+		FRogueTrackLine& Line = Lines[LineIdx];
+		if (!Line.SharedFragment.IsValid()) continue;
+
+		// Rebuild in place, entities on this line already reference the shared instance
+		FRogueTrackSharedFragment& Track = Line.SharedFragment.Get<FRogueTrackSharedFragment>();
+		Track.Spline = Line.Spline;
+		Track.StationEntities.Reset(Line.StationIndices.Num());
+		Track.StationIndices.Reset(Line.StationIndices.Num());
+		Track.Platforms.Reset(Line.StationIndices.Num());
+		Track.Junctions.Reset();
+		if (!Track.Spline.IsValid()) continue;
+
+		const USplineComponent& Spline = *Track.Spline.Get();
+		Track.TrackLength = Spline.GetSplineLength();
+		Track.SegmentBVH.Build(Spline, Settings->TrackQuerySegmentLength);
+		Line.TrainIndex.SetTrackLength(Track.TrackLength);
+
+		for (int32 LocalIdx = 0; LocalIdx < Line.StationIndices.Num(); ++LocalIdx)
 		{
-			/*Along*/ //0.f,        // e.g. +100.f to place a bit ahead
-			/*Lateral*/ //0.f,      // e.g. +150.f to offset to platform side
-			/*Vertical*/ //0.f,     // e.g. +5.f lift
-			continue;
-		}		
+			// Stations are indexed per line so train state indices stay local to the line
+			const int32 StationIdx = Line.StationIndices[LocalIdx];
+			checkf(StationIdx >= 0 && StationIdx < MAX_uint16, TEXT("Station index %d does not fit the uint16 station indices"), StationIdx);
+			if (const FMassEntityHandle* StationEntity = StationEntities.Find(StationIdx))
+			{
+				Track.StationEntities.Emplace(LocalIdx, *StationEntity);
+				Track.StationIndices.Add(static_cast<uint16>(StationIdx));
+			}
 			
-		FRogueSpawnRequest Request;
-		Request.Type = ERogueEntityType::TrainEngine;
-		Request.EntityTemplate = TrainEngineTemplate;
-		Request.RemainingCount = 1;
-		Request.Transform = Placement[0].Transform;               // with ride height
-		Request.StartAlpha = Placement[0].Alpha;
-		Request.StationIdx = StationIdx;
+			// Bake distances against the final (station aligned) spline
+			FRoguePlatformData& CachedPlatform = Track.Platforms.Add_GetRef(Platforms[StationIdx]);
+			RogueTrainUtility::BakePlatformDistances(Track.SegmentBVH, CachedPlatform);
+		}
 
-		TWeakObjectPtr<URogueTrainWorldSubsystem> TrainSubsystemWeak = this;
-		Request.OnSpawned = [Placement, CapacityPerCar, TrainCarriageTemplate, TrainSubsystemWeak, Settings](const TArray<FMassEntityHandle>& Spawned)
+		// Junction alphas are converted to distances on both lines here
+		for (const FRogueTrackJunctionConfig& JunctionConfig : Settings->Junctions)
 		{
-			auto* TrainSubsystemLocal = TrainSubsystemWeak.Get();
-			if (Spawned.Num() == 0 || !TrainSubsystemLocal) return;
-			const FMassEntityHandle LeadHandle = Spawned[0];
+			if (JunctionConfig.FromLine != LineIdx || JunctionConfig.ToLine == LineIdx) continue;
 
-			const FRogueTrackSharedFragment& TrackSharedFragment = TrainSubsystemLocal->GetTrackShared();
-			if (!TrackSharedFragment.IsValid()) return;
-			
-			const float DerivedSpacing = (Settings->CarriageLength + Settings->CarriageSpacing);
+			const USplineComponent* ToSpline = GetSpline(JunctionConfig.ToLine);
+			if (!ToSpline) continue;
 
-			for (int32 c = 1; c < Placement.Num(); ++c)
-			{				
-				FRogueSpawnRequest CarriageRequest;
-				CarriageRequest.Type = ERogueEntityType::TrainCarriage;
-				CarriageRequest.EntityTemplate = TrainCarriageTemplate;
-				CarriageRequest.RemainingCount = 1;
-				CarriageRequest.LeadHandle = LeadHandle;
-				CarriageRequest.CarriageIndex = c;
-				CarriageRequest.Spacing = DerivedSpacing;
-				CarriageRequest.CarriageCapacity = CapacityPerCar;
-				CarriageRequest.StartAlpha = Placement[c].Alpha;
-				CarriageRequest.Transform = Placement[c].Transform;
+			FRogueTrackJunction& Junction = Track.Junctions.AddDefaulted_GetRef();
+			Junction.FromDistance = RogueTrainUtility::WrapTrackAlpha(JunctionConfig.FromAlpha) * Track.TrackLength;
+			Junction.ToLine = JunctionConfig.ToLine;
+			Junction.ToDistance = RogueTrainUtility::WrapTrackAlpha(JunctionConfig.ToAlpha) * ToSpline->GetSplineLength();
+			Junction.SwitchChance = JunctionConfig.SwitchChance;
+		}
+	}
 
-				TrainSubsystemLocal->EnqueueSpawns(CarriageRequest);
-			}
-		};
+	bTrackDirty = false;
+	++TrackRevision;
+}
+
+bool URogueTrainWorldSubsystem::EnsureTrackShared()
+{
+	if (bTrackDirty) BuildTrackSharedData();
 
-		EnqueueSpawns(Request);
+	// Ready once every line with a spline has all its stations registered
+	bool bAnyValid = false;
+	for (const FRogueTrackLine& Line : Lines)
+	{
+		if (!Line.Spline.IsValid() || !Line.SharedFragment.IsValid()) continue;
+		if (!Line.SharedFragment.Get<FRogueTrackSharedFragment>().IsValid()) return false;
+		bAnyValid = true;
 	}
+	
+	return bAnyValid;
 }
 
-void URogueTrainWorldSubsystem::BuildTrackSharedData()
+const FRogueTrackSharedFragment& URogueTrainWorldSubsystem::GetTrackShared(const int32 LineIndex)
 {
-	const auto* Settings = GetDefault<URogueDeveloperSettings>();
-	if (!Settings) return;
+	static const FRogueTrackSharedFragment InvalidTrack;
 	
-	CachedTrack = FRogueTrackSharedFragment{};
-	CachedTrack.Spline = TrackSpline.Get();
-	if (!CachedTrack.Spline.IsValid()) return;
+	if (bTrackDirty) BuildTrackSharedData();
+	if (!Lines.IsValidIndex(LineIndex) || !Lines[LineIndex].SharedFragment.IsValid()) return InvalidTrack;
+	
+	return Lines[LineIndex].SharedFragment.Get<FRogueTrackSharedFragment>();
+}
 
-	const USplineComponent& Spline = *CachedTrack.Spline.Get();
-	CachedTrack.TrackLength = Spline.GetSplineLength();
+static void ApplyTrackLine(FMassEntityManager& Manager, const FMassEntityHandle Entity, const FSharedStruct& LineFragment, const int32 LineIndex)
+{
+	if (!Manager.IsEntityValid(Entity)) return;
+
+	// Swap the shared value, the entity moves to the chunks of the new line
+	if (const FRogueTrackSharedFragment* Current = Manager.GetSharedFragmentDataPtr<FRogueTrackSharedFragment>(Entity))
+	{
+		if (Current->LineIndex == LineIndex) return;
+		Manager.RemoveSharedFragmentFromEntity(Entity, *FRogueTrackSharedFragment::StaticStruct());
+	}
 
-	if (Platforms.Num() == 0) return;
-	CachedTrack.StationEntities.Reset(Platforms.Num());
-	CachedTrack.Platforms.Reset(Platforms.Num());
+	Manager.AddSharedFragmentToEntity(Entity, LineFragment);
+}
+
+void URogueTrainWorldSubsystem::SetEntityTrackLine(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle Entity, const int32 LineIndex) const
+{
+	if (!Lines.IsValidIndex(LineIndex)) return;
+
+	const FSharedStruct LineFragment = Lines[LineIndex].SharedFragment;
+	CommandBuffer.PushCommand<FMassDeferredSetCommand>([Entity, LineFragment, LineIndex](FMassEntityManager& Manager)
+	{
+		ApplyTrackLine(Manager, Entity, LineFragment, LineIndex);
+	});
+}
+
+static void ApplyStationLayout(FMassEntityManager& Manager, const FMassEntityHandle Entity, const FConstSharedStruct& Layout)
+{
+	if (!Manager.IsEntityValid(Entity)) return;
+
+	// Reused station entities swap layouts like track lines
+	if (const FRogueStationLayoutFragment* Current = Manager.GetConstSharedFragmentDataPtr<FRogueStationLayoutFragment>(Entity))
+	{
+		if (Current->StationIdx == Layout.Get<FRogueStationLayoutFragment>().StationIdx) return;
+		Manager.RemoveConstSharedFragmentFromEntity(Entity, *FRogueStationLayoutFragment::StaticStruct());
+	}
+
+	Manager.AddConstSharedFragmentToEntity(Entity, Layout);
+}
+
+static void ApplyPassengerStation(FMassEntityManager& Manager, const FMassEntityHandle Entity, const FSharedStruct& StationGroup, const int32 StationIdx)
+{
+	if (!Manager.IsEntityValid(Entity)) return;
+
+	// Same swap as track lines, the passenger moves to the chunks of its new station
+	if (const FRoguePassengerStationSharedFragment* Current = Manager.GetSharedFragmentDataPtr<FRoguePassengerStationSharedFragment>(Entity))
+	{
+		if (Current->StationIdx == StationIdx) return;
+		Manager.RemoveSharedFragmentFromEntity(Entity, *FRoguePassengerStationSharedFragment::StaticStruct());
+	}
 	
-	for (int i = 0; i < Platforms.Num(); ++i)
+	Manager.AddSharedFragmentToEntity(Entity, StationGroup);
+}
+
+void URogueTrainWorldSubsystem::SetPassengerStation(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle Entity, const int32 StationIdx) const
+{
+	const FSharedStruct* StationGroup = StationPassengerGroups.Find(StationIdx);
+	if (!StationGroup) return;
+
+	CommandBuffer.PushCommand<FMassDeferredSetCommand>([Entity, StationGroup = *StationGroup, StationIdx](FMassEntityManager& Manager)
 	{
-		// Find the station by alpha to ensure alpha ordering matches entity ordering
-		if (const FMassEntityHandle* StationEntity = StationEntities.Find(i))
+		ApplyPassengerStation(Manager, Entity, StationGroup, StationIdx);
+	});
+}
+
+void URogueTrainWorldSubsystem::AdvanceSimClock(const float DeltaSeconds)
+{
+	check(IsInGameThread());
+	
+	UWorld* World = GetWorld();
+	if (!World) return;
+
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	const float TickRate = Settings ? Settings->SimulationTickRate : 0.f;
+
+	// Time acceleration goes through world time dilation so Mass steering, timers and world time all agree.
+	// Takes effect from the next frame's delta
+	const float TimeScale = Settings ? FMath::Max(0.01f, Settings->SimulationTimeScale) : 1.f;
+	if (TimeScale != SimClock.TimeScale)
+	{
+		if (AWorldSettings* WorldSettings = World->GetWorldSettings())
 		{
-			CachedTrack.StationEntities.Emplace(i, *StationEntity);
+			WorldSettings->MaxGlobalTimeDilation = FMath::Max(WorldSettings->MaxGlobalTimeDilation, TimeScale);
+			WorldSettings->SetTimeDilation(TimeScale);
 		}
-		
-		CachedTrack.Platforms.Add(Platforms[i]);
+		SimClock.TimeScale = TimeScale;
 	}
+	
+	const float FrameDeltaTime = DeltaSeconds;
 
-	bTrackDirty = false;
-	++TrackRevision;
+	// No fixed rate, one step of the frame delta
+	if (TickRate <= 0.f)
+	{
+		SimClock.StepDeltaTime = FrameDeltaTime;
+		SimClock.NumSteps = FrameDeltaTime > 0.f ? 1 : 0;
+		SimClock.Alpha = 1.f;
+		SimClock.Accumulator = 0.0;
+		RunStats.SimulatedSeconds += SimClock.GetFrameDeltaTime();
+		return;
+	}
+
+	SimClock.StepDeltaTime = 1.f / TickRate;
+	SimClock.Accumulator += FrameDeltaTime;
+	SimClock.NumSteps = FMath::FloorToInt32(SimClock.Accumulator / SimClock.StepDeltaTime);
+	SimClock.Accumulator -= SimClock.NumSteps * SimClock.StepDeltaTime;
+
+	// Drop the backlog after a hitch rather than spiralling, accelerated runs need proportionally more steps
+	const int32 MaxSteps = (Settings ? FMath::Max(1, Settings->MaxSimStepsPerFrame) : 1) * FMath::CeilToInt32(FMath::Max(1.f, TimeScale));
+	if (SimClock.NumSteps > MaxSteps)
+	{
+		SimClock.NumSteps = MaxSteps;
+		SimClock.Accumulator = FMath::Fmod(SimClock.Accumulator, static_cast<double>(SimClock.StepDeltaTime));
+	}
+	
+	SimClock.Alpha = FMath::Clamp(static_cast<float>(SimClock.Accumulator / SimClock.StepDeltaTime), 0.f, 1.f);
+	RunStats.SimulatedSeconds += SimClock.GetFrameDeltaTime();
 }
 
-const FRogueTrackSharedFragment& URogueTrainWorldSubsystem::GetTrackShared()
+void URogueTrainWorldSubsystem::IndexTrainOnLine(const FMassEntityHandle Entity, const int32 LineIndex, const double Distance, const float TrainLength)
 {
-	if (bTrackDirty) BuildTrackSharedData();
-	return CachedTrack;
+	if (!Lines.IsValidIndex(LineIndex)) return;
+	
+	RemoveTrainFromIndex(Entity);
+	Lines[LineIndex].TrainIndex.Add(Entity, Distance, TrainLength);
+}
+
+void URogueTrainWorldSubsystem::RemoveTrainFromIndex(const FMassEntityHandle Entity)
+{
+	// A train crossing a junction is indexed on both lines until its tail clears the from line
+	for (FRogueTrackLine& Line : Lines)
+	{
+		Line.TrainIndex.Remove(Entity);
+	}
+}
+
+void URogueTrainWorldSubsystem::SwitchTrainLine(const FMassExecutionContext& Context, const FMassEntityHandle LeadHandle, const int32 FromLine, const FRogueTrackJunction& Junction, const double Overshoot)
+{
+	const int32 ToLine = Junction.ToLine;
+	if (!Lines.IsValidIndex(ToLine)) return;
+
+	const FRogueTrackSharedFragment& ToTrack = GetTrackShared(ToLine);
+	if (!ToTrack.IsValid()) return;
+
+	const FSharedStruct LineFragment = Lines[ToLine].SharedFragment;
+	const double JunctionToDistance = RogueTrainUtility::WrapTrackDistance(Junction.ToDistance, ToTrack.TrackLength);
+	const double Distance = RogueTrainUtility::WrapTrackDistance(Junction.ToDistance + Overshoot, ToTrack.TrackLength);
+	const double JunctionFromDistance = Junction.FromDistance;
+	const int32 TargetStationIdx = RogueTrainUtility::FindNextStation(ToTrack.Platforms, Distance, ToTrack.TrackLength);
+
+	// Position, station target and line land together so no processor sees a half switched train
+	TWeakObjectPtr<URogueTrainWorldSubsystem> WeakThis = this;
+	Context.Defer().PushCommand<FMassDeferredSetCommand>([WeakThis, LeadHandle, LineFragment, FromLine, ToLine, Distance, JunctionFromDistance, JunctionToDistance, TargetStationIdx](FMassEntityManager& Manager)
+	{
+		if (!Manager.IsEntityValid(LeadHandle)) return;
+
+		if (auto* Follow = Manager.GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(LeadHandle))
+		{
+			Follow->Distance = Distance;
+			Follow->InterpFromDistance = Distance; // snap, no blend across lines
+		}
+
+		URogueTrainWorldSubsystem* Subsystem = WeakThis.Get();
+		float TrainLength = 0.f;
+		if (auto* State = Manager.GetFragmentDataPtr<FRogueTrainStateFragment>(LeadHandle))
+		{
+			// A tail still clearing an earlier junction is dropped, this train only spans the two lines of this one
+			if (Subsystem && State->bTailOnFromLine && State->TransitFromLine != FromLine && State->TransitFromLine != ToLine)
+			{
+				if (FRogueTrainRingIndex* PreviousIndex = Subsystem->GetMutableTrainIndex(State->TransitFromLine))
+				{
+					PreviousIndex->Remove(LeadHandle);
+				}
+			}
+			
+			State->TargetStationIdx = TargetStationIdx;
+			State->PreviousStationIdx = INDEX_NONE;
+			State->PrevDistance = Distance;
+			State->bIsStopping = false;
+			State->TransitFromLine = FromLine;
+			State->TransitToLine = ToLine;
+			State->TransitFromDistance = JunctionFromDistance;
+			State->TransitToDistance = JunctionToDistance;
+			State->bTailOnFromLine = true;
+			TrainLength = State->TrainLength;
+		}
+
+		// The lead joins the to line, the from line keeps the train until headway sees its tail clear the junction
+		if (Subsystem && Subsystem->Lines.IsValidIndex(ToLine))
+		{
+			Subsystem->Lines[ToLine].TrainIndex.Add(LeadHandle, Distance, TrainLength);
+		}
+
+		// Only the lead moves now, the carriage follow processor switches each carriage as it reaches the junction
+		ApplyTrackLine(Manager, LeadHandle, LineFragment, ToLine);
+	});
 }
 
 void URogueTrainWorldSubsystem::EnqueueSpawns(const FRogueSpawnRequest& Request)
 {
-	if (!Request.EntityTemplate->IsValid() || Request.RemainingCount <= 0) return;
-	PendingSpawns.Add(Request);
+	if (!GetTemplateByType(Request.Type) || Request.RemainingCount <= 0) return;
+	PendingSpawns[static_cast<int32>(Request.Type)].Add(Request);
+}
+
+int32 URogueTrainWorldSubsystem::GetNumPendingSpawns() const
+{
+	int32 Num = 0;
+	for (const TRingBuffer<FRogueSpawnRequest>& Ring : PendingSpawns)
+	{
+		Num += Ring.Num();
+	}
+	return Num;
 }
 
 void URogueTrainWorldSubsystem::ProcessPendingSpawns()
 {
-	if (!EntityManager || PendingSpawns.Num() == 0) return;
+	SCOPE_CYCLE_COUNTER(STAT_RogueProcessPendingSpawns);
+	ROGUE_SCOPE_ALLOC_COUNTER("ProcessPendingSpawns");
+	
+	if (!EntityManager || GetNumPendingSpawns() == 0) return;
 	
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
@@ -559,47 +890,97 @@ void URogueTrainWorldSubsystem::ProcessPendingSpawns()
 	auto* MassEntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
 	if (!Spawner || !MassEntitySubsystem) return;
 
-	// reverse so we can RemoveAtSwap
-	for (int32 i = PendingSpawns.Num()-1; i >= 0 && Budget > 0; --i)
+	FMassEntityManager& EntityManagerMutable = MassEntitySubsystem->GetMutableEntityManager();
+
+	// Drain in type order, stations before trains and engines before the carriages their continuation queues
+	for (int32 TypeIdx = 0; TypeIdx < NumRogueEntityTypes && Budget > 0; ++TypeIdx)
 	{
-		FRogueSpawnRequest& Request = PendingSpawns[i];
-		const int32 ThisBatch = FMath::Min(Request.RemainingCount, Budget);
+		TRingBuffer<FRogueSpawnRequest>& Ring = PendingSpawns[TypeIdx];
+		while (!Ring.IsEmpty() && Budget > 0)
+		{
+			// Continuations only push into later rings, so this reference stays valid
+			FRogueSpawnRequest& Request = Ring.First();
+			const int32 ThisBatch = FMath::Min(Request.RemainingCount, Budget);
 
-		TArray<FMassEntityHandle> NewEntities;
-		const int32 Reused = RetrievePooledEntities(Request.Type, ThisBatch, NewEntities);
+			SpawnScratch.Reset();
+			const int32 Reused = RetrievePooledEntities(Request.Type, ThisBatch, SpawnScratch);
+			INC_DWORD_STAT_BY(STAT_RoguePoolHits, Reused);
+			INC_DWORD_STAT_BY(STAT_RoguePoolMisses, ThisBatch - Reused);
 
-		if (Reused < ThisBatch)
-		{
-			const int32 Need = ThisBatch - Reused;
-			TArray<FMassEntityHandle> Spawned;
-			Spawner->SpawnEntities(*Request.EntityTemplate, Need, Spawned);
-			NewEntities.Append(Spawned);
-		}
+			if (Reused < ThisBatch)
+			{
+				const int32 Need = ThisBatch - Reused;
+				SpawnedScratch.Reset();
+				Spawner->SpawnEntities(*GetTemplateByType(Request.Type), Need, SpawnedScratch);
+				SpawnScratch.Append(SpawnedScratch);
+			}
 
-		// Configure fragments/tags/position here (per entity)
-		FMassEntityManager& EntityManagerMutable = MassEntitySubsystem->GetMutableEntityManager();
-		for (const FMassEntityHandle NewEntity : NewEntities)
-		{
-			RegisterEntity(Request.Type, NewEntity);
-			ConfigureSpawnedEntity(Request, NewEntity);
+			// Configure fragments/tags/position here (per entity)
+			for (int32 EntityIdx = 0; EntityIdx < SpawnScratch.Num(); ++EntityIdx)
+			{
+				const FMassEntityHandle NewEntity = SpawnScratch[EntityIdx];
+				if (EntityIdx < Reused)
+				{
+					TRACE_ROGUE_SIM_EVENT(PoolReuse, GetWorld()->GetTimeSeconds(), NewEntity, FMassEntityHandle(), static_cast<int32>(Request.Type));
+				}
+				else
+				{
+					TRACE_ROGUE_SIM_EVENT(Spawn, GetWorld()->GetTimeSeconds(), NewEntity, FMassEntityHandle(), static_cast<int32>(Request.Type));
+				}
+				
+				RegisterEntity(Request.Type, NewEntity);
+				ConfigureSpawnedEntity(Request, NewEntity);
+				RunSpawnContinuation(Request, NewEntity);
 
-			// clear pool marker if present
-			EntityManagerMutable.Defer().PushCommand<FMassCommandRemoveTag<FRoguePooledEntityTag>>(NewEntity);
-		}
-		
-		if (Request.OnSpawned)
-		{
-			// Pass back completed handles this interval
-			Request.OnSpawned(NewEntities);   
+				// clear pool marker if present
+				EntityManagerMutable.Defer().PushCommand<FMassCommandRemoveTag<FRoguePooledEntityTag>>(NewEntity);
+			}
+
+			Request.RemainingCount -= ThisBatch;
+			Budget -= ThisBatch;
+
+			if (Request.RemainingCount <= 0)
+			{
+				Ring.PopFront();
+			}
 		}
+	}
 
-		Request.RemainingCount -= ThisBatch;
-		Budget -= ThisBatch;
+	// Every queued consist has handed its placements to carriage requests once no engine is pending
+	if (PendingSpawns[static_cast<int32>(ERogueEntityType::TrainEngine)].IsEmpty())
+	{
+		SpawnPayloads.Reset();
+	}
+}
 
-		if (Request.RemainingCount <= 0)
+void URogueTrainWorldSubsystem::RunSpawnContinuation(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity)
+{
+	switch (Request.Continuation)
+	{
+		case ERogueSpawnContinuation::SpawnConsist:
 		{
-			PendingSpawns.RemoveAtSwap(i);
+			if (!GetTrackShared(Request.LineIndex).IsValid()) return;
+			if (Request.PayloadNum <= 0 || !SpawnPayloads.IsValidIndex(Request.PayloadFirst + Request.PayloadNum - 1)) return;
+
+			for (int32 c = 1; c <= Request.PayloadNum; ++c)
+			{
+				const FRoguePlacedCar& PlacedCar = SpawnPayloads[Request.PayloadFirst + c - 1];
+
+				FRogueSpawnRequest CarriageRequest;
+				CarriageRequest.Type = ERogueEntityType::TrainCarriage;
+				CarriageRequest.RemainingCount = 1;
+				CarriageRequest.LeadHandle = Entity;
+				CarriageRequest.CarriageIndex = c;
+				CarriageRequest.StartDistance = PlacedCar.Distance;
+				CarriageRequest.LineIndex = Request.LineIndex;
+				CarriageRequest.Location = PlacedCar.Transform.GetLocation();
+				CarriageRequest.Rotation = FQuat4f(PlacedCar.Transform.GetRotation());
+
+				EnqueueSpawns(CarriageRequest);
+			}
+			break;
 		}
+		default: break;
 	}
 }
 
@@ -664,10 +1045,20 @@ void URogueTrainWorldSubsystem::EnqueueEntityToPool(const FMassEntityHandle Enti
 		RoguePassengerUtility::HidePassenger(*EntityManager, Entity);
 	}
 	
+#if WITH_EDITOR
+	// Free the debug slot so snapshots only cover live entities
+	if (auto* DebugSlotFragment = EntityManager->GetFragmentDataPtr<FRogueDebugSlotFragment>(Entity))
+	{
+		ReleaseDebugSlot(Type, DebugSlotFragment->Slot);
+		DebugSlotFragment->Slot = INDEX_NONE;
+	}
+#endif
+	
 	// mark pooled
 	Context.Defer().PushCommand<FMassCommandAddTag<FRoguePooledEntityTag>>(Entity);
 
 	EntityPool.FindOrAdd(Type).Add(Entity);
+	TRACE_ROGUE_SIM_EVENT(PoolReturn, Context.GetWorld()->GetTimeSeconds(), Entity, FMassEntityHandle(), static_cast<int32>(Type));
 }
 
 int32 URogueTrainWorldSubsystem::RetrievePooledEntities(const ERogueEntityType Type, const int32 Count, TArray<FMassEntityHandle>& Out)
@@ -700,14 +1091,44 @@ const FMassEntityTemplate* URogueTrainWorldSubsystem::GetCarriageTemplate() cons
 	return CarriageTemplate.IsValid() ? &CarriageTemplate : nullptr;
 }
 
+const FRogueCarriageClassFragment* URogueTrainWorldSubsystem::GetCarriageClass() const
+{
+	if (!CarriageTemplate.IsValid()) return nullptr;
+
+	for (const FConstSharedStruct& Shared : CarriageTemplate.GetSharedFragmentValues().GetConstSharedFragments())
+	{
+		if (const FRogueCarriageClassFragment* CarriageClass = Shared.GetPtr<const FRogueCarriageClassFragment>())
+			return CarriageClass;
+	}
+	return nullptr;
+}
+
 const FMassEntityTemplate* URogueTrainWorldSubsystem::GetPassengerTemplate() const
 {
 	return PassengerTemplate.IsValid() ? &PassengerTemplate : nullptr;
 }
 
+const FMassEntityTemplate* URogueTrainWorldSubsystem::GetTemplateByType(const ERogueEntityType Type) const
+{
+	switch (Type)
+	{
+		case ERogueEntityType::Station: return GetStationTemplate();
+		case ERogueEntityType::TrainEngine: return GetTrainTemplate();
+		case ERogueEntityType::TrainCarriage: return GetCarriageTemplate();
+		case ERogueEntityType::Passenger: return GetPassengerTemplate();
+		default: return nullptr;
+	}
+}
+
 void URogueTrainWorldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 {
 	Super::OnWorldBeginPlay(InWorld);
+
+	// Benchmark scenarios replace the map track and stations, apply before settings are read
+	if (auto* ScenarioSubsystem = InWorld.GetSubsystem<URogueScenarioSubsystem>())
+	{
+		ScenarioSubsystem->ApplyScenario(InWorld);
+	}
 	
 	DiscoverSplineFromSettings();
 	InitConfigTemplates(InWorld);
@@ -717,13 +1138,15 @@ void URogueTrainWorldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 
 void URogueTrainWorldSubsystem::ConfigureSpawnedEntity(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity) 
 {
+	SCOPE_CYCLE_COUNTER(STAT_RogueSpawnConfig);
+	
 	if (!EntityManager) return;
 	
 	// Position
 	if (FTransformFragment* TransformFragment = EntityManager->GetFragmentDataPtr<FTransformFragment>(Entity))
 	{
-		TransformFragment->GetMutableTransform().SetLocation(Request.Transform.GetLocation());
-		TransformFragment->GetMutableTransform().SetRotation(Request.Transform.GetRotation());
+		TransformFragment->GetMutableTransform().SetLocation(Request.Location);
+		TransformFragment->GetMutableTransform().SetRotation(FQuat(Request.Rotation));
 	}
 
 	// Type-specific configuration
@@ -763,6 +1186,14 @@ void URogueTrainWorldSubsystem::ConfigureStation(const FRogueSpawnRequest& Reque
 	// Add station entity with alpha key
 	StationEntities.Add(Request.StationIdx, Entity);
 
+	// Passengers of this station share chunks
+	if (!StationPassengerGroups.Contains(Request.StationIdx))
+	{
+		FRoguePassengerStationSharedFragment StationGroup;
+		StationGroup.StationIdx = Request.StationIdx;
+		StationPassengerGroups.Add(Request.StationIdx, EntityManager->GetOrCreateSharedFragment(StationGroup));
+	}
+
 	// Mark track dirty to rebuild cached data
 	bTrackDirty = true;
 				
@@ -772,33 +1203,36 @@ void URogueTrainWorldSubsystem::ConfigureStation(const FRogueSpawnRequest& Reque
 		StationFragment->DockedTrain = FMassEntityHandle();
 	}
 				
-	if (auto* QueueFragment = EntityManager->GetFragmentDataPtr<FRogueStationQueueFragment>(Entity))
+	if (StationLayouts.IsValidIndex(Request.StationIdx))
 	{
-		QueueFragment->SpawnPoints = Request.PlatformData.SpawnPoints;
-		QueueFragment->WaitingPoints = Request.PlatformData.WaitingPoints;
-		QueueFragment->WaitingGridConfig = Request.PlatformData.WaitingGridConfig;
-
-		QueueFragment->Grids.Reset();
-		for (int WaitIdx = 0; WaitIdx < QueueFragment->WaitingPoints.Num(); ++WaitIdx)
+		// Only occupancy lives on the entity, grids are sized from the shared layout
+		const FConstSharedStruct& Layout = StationLayouts[Request.StationIdx];
+		if (auto* QueueFragment = EntityManager->GetFragmentDataPtr<FRogueStationQueueFragment>(Entity))
 		{
-			const FVector WaitingPoint = QueueFragment->WaitingPoints[WaitIdx];
-			RogueStationQueueUtility::BuildGridForWaitingPoint(Request.PlatformData, *QueueFragment, WaitingPoint, WaitIdx);					
+			RogueStationQueueUtility::InitWaitingGrids(Layout.Get<FRogueStationLayoutFragment>(), *QueueFragment);
 		}
+
+		EntityManager->Defer().PushCommand<FMassDeferredSetCommand>([Entity, Layout](FMassEntityManager& Manager)
+		{
+			ApplyStationLayout(Manager, Entity, Layout);
+		});
 	}
 
 	ConfigureTrackToStation(Request, Settings->TrackSplineResampleStep);
 
-	const int32 Slot = GetStationDebugIndex();
+#if WITH_EDITOR
+	// Pooled entities released their slot, reused ones take a recycled slot here
 	if (auto* DebugSlotFragment = EntityManager->GetFragmentDataPtr<FRogueDebugSlotFragment>(Entity))
 	{
 		if (DebugSlotFragment->Slot == INDEX_NONE)
 		{
-			DebugSlotFragment->Slot = Slot;
+			DebugSlotFragment->Slot = AcquireDebugSlot(ERogueEntityType::Station);
 		}				
-	}			
+	}
+#endif
 				
 	// Once all stations are created, create trains and track meshes
-	if (StationEntities.Num() == Settings->Stations.Num()) // All stations created
+	if (StationEntities.Num() == Platforms.Num()) // All stations created
 	{
 		// Create track meshes
 		for (int i = 0; i < TrackActors.Num(); ++i)
@@ -828,32 +1262,44 @@ void URogueTrainWorldSubsystem::ConfigureTrain(const FRogueSpawnRequest& Request
 		State->TargetStationIdx = Request.StationIdx;
 		State->PreviousStationIdx = Request.StationIdx;
 		State->StationTimeRemaining = 2.f;
-		State->Carriages.Reset(Settings->CarriagesPerTrain);
+		State->ConsistId = Consists.Allocate(Entity, Settings->CarriagesPerTrain, State->ConsistId);
+		State->TransitFromLine = INDEX_NONE;
+		State->TransitToLine = INDEX_NONE;
+		State->bTailOnFromLine = false;
 	}
+
+	SetEntityTrackLine(EntityManager->Defer(), Entity, Request.LineIndex);
+	const FRogueCarriageClassFragment* CarriageClass = GetCarriageClass();
+	const float CarriageSpacing = CarriageClass ? CarriageClass->Spacing : 0.f;
+	IndexTrainOnLine(Entity, Request.LineIndex, Request.StartDistance, Settings->EngineLength + Settings->CarriagesPerTrain * CarriageSpacing);
 				
 	if (auto* Follow = EntityManager->GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(Entity))
 	{
-		Follow->Alpha = Request.StartAlpha;
+		Follow->Distance = Request.StartDistance;
+		Follow->InterpFromDistance = Request.StartDistance;
 		Follow->Speed = 0.f;
 	}
 	else
 	{
 		// Move entity to an archetype that contains this fragment and initialize it
 		FRogueTrainTrackFollowFragment InitFollow;
-		InitFollow.Alpha = Request.StartAlpha;
+		InitFollow.Distance = Request.StartDistance;
+		InitFollow.InterpFromDistance = Request.StartDistance;
 		InitFollow.Speed = 0.f;
 
 		EntityManager->Defer().PushCommand<FMassCommandAddFragmentInstances>(Entity, InitFollow);
 	}
 
-	const int32 Slot = GetTrainDebugIndex();
+#if WITH_EDITOR
+	// Pooled entities released their slot, reused ones take a recycled slot here
 	if (auto* DebugSlotFragment = EntityManager->GetFragmentDataPtr<FRogueDebugSlotFragment>(Entity))
 	{
 		if (DebugSlotFragment->Slot == INDEX_NONE)
 		{
-			DebugSlotFragment->Slot = Slot;
+			DebugSlotFragment->Slot = AcquireDebugSlot(ERogueEntityType::TrainEngine);
 		}				
 	}
+#endif
 }
 
 void URogueTrainWorldSubsystem::ConfigureCarriage(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity)
@@ -863,42 +1309,51 @@ void URogueTrainWorldSubsystem::ConfigureCarriage(const FRogueSpawnRequest& Requ
 
 	if (!EntityManager) return;
 
+	// Lead is configured before its carriage requests are queued, so its consist is already allocated
+	const FRogueTrainStateFragment* LeadState = EntityManager->GetFragmentDataPtr<FRogueTrainStateFragment>(Request.LeadHandle);
+	const int32 ConsistId = LeadState ? LeadState->ConsistId : INDEX_NONE;
+	Consists.SetCarriage(ConsistId, Request.CarriageIndex, Entity);
+
 	if (auto* Link = EntityManager->GetFragmentDataPtr<FRogueTrainLinkFragment>(Entity))
 	{
-		Link->LeadHandle = Request.LeadHandle;
+		Link->ConsistId = ConsistId;
 		Link->CarriageIndex= Request.CarriageIndex;
-		Link->Spacing= Request.Spacing;
 	}
 				
 	if (auto* CarriageFragment = EntityManager->GetFragmentDataPtr<FRogueCarriageFragment>(Entity))
 	{
-		CarriageFragment->Capacity = Request.CarriageCapacity;
-		CarriageFragment->Occupants.Reserve(Request.CarriageCapacity);
+		// Reused carriages keep their run when it still covers the class capacity
+		const auto* CarriageClass = EntityManager->GetConstSharedFragmentDataPtr<FRogueCarriageClassFragment>(Entity);
+		const int32 Capacity = CarriageClass ? CarriageClass->Capacity : 0;
+		if (CarriageFragment->OccupantBlock == INDEX_NONE || OccupantSlab.GetCapacity(CarriageFragment->OccupantBlock) < Capacity)
+		{
+			OccupantSlab.Free(CarriageFragment->OccupantBlock);
+			CarriageFragment->OccupantBlock = OccupantSlab.Allocate(Capacity);
+		}
+		CarriageFragment->NumOccupants = 0;
 		CarriageFragment->NextAllowedUnloadTime = GetWorld()->GetTimeSeconds() + FMath::FRandRange(0.f, Settings->UnloadStartJitter);
 		CarriageFragment->UnloadCursor = 0;
 	}
 				
 	if (auto* Follow = EntityManager->GetFragmentDataPtr<FRogueTrainTrackFollowFragment>(Entity))
 	{
-		Follow->Alpha = Request.StartAlpha;
+		Follow->Distance = Request.StartDistance;
+		Follow->InterpFromDistance = Request.StartDistance;
 		Follow->Speed = 0.f;
 	}
 
-	const int32 Slot = GetCarriageDebugIndex();
+	SetEntityTrackLine(EntityManager->Defer(), Entity, Request.LineIndex);
+
+#if WITH_EDITOR
+	// Pooled entities released their slot, reused ones take a recycled slot here
 	if (auto* DebugSlotFragment = EntityManager->GetFragmentDataPtr<FRogueDebugSlotFragment>(Entity))
 	{
 		if (DebugSlotFragment->Slot == INDEX_NONE)
 		{
-			DebugSlotFragment->Slot = Slot;
+			DebugSlotFragment->Slot = AcquireDebugSlot(ERogueEntityType::TrainCarriage);
 		}				
 	}
-
-	if (auto* TrainStateFragment = EntityManager->GetFragmentDataPtr<FRogueTrainStateFragment>(Request.LeadHandle))
-	{
-		TrainStateFragment->Carriages.Add(Entity);
-	}
-
-	LeadToCarriages.FindOrAdd(Request.LeadHandle).Add(Entity);
+#endif
 }
 
 void URogueTrainWorldSubsystem::ConfigurePassenger(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity)
@@ -910,31 +1365,39 @@ void URogueTrainWorldSubsystem::ConfigurePassenger(const FRogueSpawnRequest& Req
 
 	if (auto* PassengerFragment = EntityManager->GetFragmentDataPtr<FRoguePassengerFragment>(Entity))
 	{
-		PassengerFragment->OriginStation = Request.OriginStation;
-		PassengerFragment->DestinationStation = Request.DestinationStation;
-		PassengerFragment->VehicleHandle = FMassEntityHandle();
-		PassengerFragment->MaxSpeed = Request.MaxSpeed;
-		PassengerFragment->Target = Request.Transform.GetLocation();
-		PassengerFragment->WaitingPointIdx = INDEX_NONE;
-		PassengerFragment->WaitingSlotIdx = INDEX_NONE;
+		PassengerFragment->Target = Request.Location;
 		PassengerFragment->bWaiting = false;
 		PassengerFragment->Phase = ERoguePassengerPhase::EnteredWorld;
+		PassengerFragment->PhaseStartTime = GetWorld()->GetTimeSeconds();
 	}
+	if (auto* TripFragment = EntityManager->GetFragmentDataPtr<FRoguePassengerTripFragment>(Entity))
+	{
+		TripFragment->OriginStationIdx = RogueCompactIndex::Compact<uint16>(Request.OriginStationIdx);
+		TripFragment->DestStationIdx = RogueCompactIndex::Compact<uint16>(Request.DestinationStationIdx);
+		TripFragment->VehicleHandle = FMassEntityHandle();
+		TripFragment->ClearWaiting();
+	}
+	++RunStats.PassengersSpawned;
 	if (auto* RadiusFragment = EntityManager->GetFragmentDataPtr<FAgentRadiusFragment>(Entity))
 	{
 		RadiusFragment->Radius = Settings->PassengerRadius; 
 	}				
 
-	const int32 Slot = GetPassengerDebugSlot();
+#if WITH_EDITOR
+	// Pooled entities released their slot, reused ones take a recycled slot here
 	if (auto* DebugSlotFragment = EntityManager->GetFragmentDataPtr<FRogueDebugSlotFragment>(Entity))
 	{
 		if (DebugSlotFragment->Slot == INDEX_NONE)
 		{
-			DebugSlotFragment->Slot = Slot;
+			DebugSlotFragment->Slot = AcquireDebugSlot(ERogueEntityType::Passenger);
 		}				
 	}
+#endif
+
+	RoguePassengerUtility::ShowPassenger(*EntityManager, Entity, Request.Location);
 
-	RoguePassengerUtility::ShowPassenger(*EntityManager, Entity, Request.Transform.GetLocation());
+	// Waiting passengers live in the chunks of their origin station
+	SetPassengerStation(EntityManager->Defer(), Entity, Request.OriginStationIdx);
 }
 
 void URogueTrainWorldSubsystem::RegisterEntity(const ERogueEntityType Type, const FMassEntityHandle Entity)
@@ -948,6 +1411,18 @@ void URogueTrainWorldSubsystem::UnregisterEntity(const ERogueEntityType Type, co
 	{
 		Arr->RemoveSwap(Entity);
 	}
+
+	if (Type == ERogueEntityType::TrainEngine)
+	{
+		RemoveTrainFromIndex(Entity);
+		if (EntityManager)
+		{
+			if (const auto* State = EntityManager->GetFragmentDataPtr<FRogueTrainStateFragment>(Entity))
+			{
+				Consists.Release(State->ConsistId);
+			}
+		}
+	}
 }
 
 int32 URogueTrainWorldSubsystem::GetTotalLiveCount() const
@@ -982,10 +1457,50 @@ void URogueTrainWorldSubsystem::InitDebugData()
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
 
-	PassengersDebugSnapshot.Init(FRogueDebugPassenger(), Settings->MaxPassengersOverall);
-	TrainsDebugSnapshot.Init(FRogueDebugTrain(), Settings->NumTrains);
-	CarriagesDebugSnapshot.Init(FRogueDebugCarriage(), Settings->NumTrains * Settings->CarriagesPerTrain);
-	StationsDebugSnapshot.Init(FRogueDebugStation(), Settings->Stations.Num());
+	int32 NumTrains = 0;
+	for (const FRogueTrackLine& Line : Lines)
+	{
+		NumTrains += Line.NumTrains;
+	}
+
+	// Reserve from the built scene, every line's trains and the overall passenger cap, so collecting all of it does not grow them
+	PassengersDebugSnapshot.Reserve(Settings->MaxPassengersOverall);
+	TrainsDebugSnapshot.Reserve(NumTrains);
+	CarriagesDebugSnapshot.Reserve(NumTrains * Settings->CarriagesPerTrain);
+	StationsDebugSnapshot.Reserve(Platforms.Num());
+}
+
+void URogueTrainWorldSubsystem::RequestDebugSnapshots(const ERogueDebugSnapshot Types, const FRogueDebugView& View)
+{
+	const UWorld* World = GetWorld();
+	if (!World) return;
+
+	DebugView = View;
+
+	const double Now = World->GetRealTimeSeconds();
+	for (int32 i = 0; i < NumDebugSnapshotTypes; ++i)
+	{
+		if (EnumHasAnyFlags(Types, static_cast<ERogueDebugSnapshot>(1 << i)))
+		{
+			DebugSnapshotRequests[i].LastRequestTime = Now;
+		}
+	}
+}
+
+bool URogueTrainWorldSubsystem::ShouldCollectDebugSnapshot(const ERogueDebugSnapshot Type, const double Now)
+{
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (!Settings) return false;
+	
+	// A request lapses when its consumer stops asking, e.g. the debugger category was closed
+	constexpr double RequestLeaseSeconds = 1.0;
+	
+	FDebugSnapshotRequest& Request = DebugSnapshotRequests[FMath::CountTrailingZeros(static_cast<uint32>(Type))];
+	if (Now - Request.LastRequestTime > RequestLeaseSeconds) return false;
+	if (Now < Request.NextCollectTime) return false;
+
+	Request.NextCollectTime = Now + Settings->DebugSnapshotInterval;
+	return true;
 }
 
 void URogueTrainWorldSubsystem::DrawDebugStations(const UWorld* InWorld)
@@ -995,11 +1510,11 @@ void URogueTrainWorldSubsystem::DrawDebugStations(const UWorld* InWorld)
 
 	for (const auto& It : StationEntities)
 	{
-		if (auto* QueueFragment = EntityManager->GetFragmentDataPtr<FRogueStationQueueFragment>(It.Value))
+		if (const FRogueStationLayoutFragment* Layout = GetStationLayout(It.Key))
 		{
 			if (Settings->bDrawStationSpawnPoints)
 			{
-				for (const FVector& SpawnPosition : QueueFragment->SpawnPoints)
+				for (const FVector& SpawnPosition : Layout->SpawnPoints)
 				{
 					DrawDebugSphere(InWorld, SpawnPosition, 20.f, 8, FColor::Red, true, 30.f);
 				}				
@@ -1007,7 +1522,7 @@ void URogueTrainWorldSubsystem::DrawDebugStations(const UWorld* InWorld)
 					
 			if (Settings->bDrawStationWaitPoints)
 			{				
-				for (const FVector& WaitPosition : QueueFragment->WaitingPoints)
+				for (const FVector& WaitPosition : Layout->WaitingPoints)
 				{
 					DrawDebugSphere(GetWorld(), WaitPosition, 20.f, 8, FColor::Blue, true, 30.f);
 				}				
@@ -1015,14 +1530,10 @@ void URogueTrainWorldSubsystem::DrawDebugStations(const UWorld* InWorld)
 
 			if (Settings->bDrawStationWaitGrid)
 			{
-				for (auto Pair : QueueFragment->Grids)
+				for (FVector GridPoint : Layout->SlotPositions)
 				{
-					const FRogueWaitingGrid& GridData = Pair.Value;
-					for (FVector GridPoint : GridData.SlotPositions)
-					{
-						GridPoint.Z += 20.f;
-						DrawDebugSphere(GetWorld(), GridPoint, 5.f, 8, FColor::Black, true, 30.f);
-					}
+					GridPoint.Z += 20.f;
+					DrawDebugSphere(GetWorld(), GridPoint, 5.f, 8, FColor::Black, true, 30.f);
 				}
 			}
 		}
@@ -0,0 +1,75 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Misc/AutomationTest.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Simulation/RogueEventSimulation.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "Tests/RogueScenarioTestWorld.h"
+
+namespace RogueEventSimCrossCheck
+{
+	// Five simulated minutes, long enough for every train to dwell at each station a few times
+	constexpr int32 Frames = 9000;
+	constexpr float DeltaTime = 1.f / 30.f;
+
+	// The event sim skips headway and platform walking, so agreement is loose by design
+	constexpr double Tolerance = 0.35;
+
+	// Small as shipped, and Small spawning in batches like the heavier presets do
+	static FRogueScenarioParams GetParams(const FString& Name)
+	{
+		FRogueScenarioParams Params = URogueScenarioSubsystem::GetPreset(ERogueScenarioPreset::Small);
+		Params.Seed = 1234;
+		if (Name == TEXT("BatchedSpawns"))
+		{
+			Params.PassengersPerSpawn = 4;
+			Params.SpawnIntervalSeconds = 1.f;
+			Params.MaxPassengers = 400;
+		}
+		return Params;
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FRogueEventSimCrossCheckTest, "RogueMassExample.Simulation.EventSimCrossCheck",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FRogueEventSimCrossCheckTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const TCHAR* Name : { TEXT("Small"), TEXT("BatchedSpawns") })
+	{
+		OutBeautifiedNames.Add(Name);
+		OutTestCommands.Add(Name);
+	}
+}
+
+bool FRogueEventSimCrossCheckTest::RunTest(const FString& Parameters)
+{
+	const FRogueScenarioParams Params = RogueEventSimCrossCheck::GetParams(Parameters);
+
+	FRogueScenarioTestWorld TestWorld(Params);
+	URogueTrainWorldSubsystem* TrainSubsystem = TestWorld.GetTrainSubsystem();
+	if (!TestNotNull(TEXT("Train subsystem"), TrainSubsystem)) return false;
+
+	TestWorld.Tick(RogueEventSimCrossCheck::Frames, RogueEventSimCrossCheck::DeltaTime);
+	const FRogueEventSimStats MassStats = TrainSubsystem->GetRunStats();
+	if (!TestTrue(TEXT("Mass run boarded passengers"), MassStats.Boardings > 0)) return false;
+
+	// Same seed and simulated time on the track the Mass run baked
+	FRogueEventSimulation Simulation;
+	if (!TestTrue(TEXT("Event sim initialised"), Simulation.Init(*TrainSubsystem, *GetDefault<URogueDeveloperSettings>(), Params.Seed))) return false;
+	Simulation.RunUntil(MassStats.SimulatedSeconds);
+
+	AddInfo(FString::Printf(TEXT("Event: %s"), *Simulation.GetStats().ToString()));
+	AddInfo(FString::Printf(TEXT("Mass:  %s"), *MassStats.ToString()));
+
+	FString Mismatch;
+	const bool bMatches = Simulation.GetStats().MatchesWithin(MassStats, RogueEventSimCrossCheck::Tolerance, Mismatch);
+	TestTrue(FString::Printf(TEXT("Event sim and Mass aggregates agree %s"), *Mismatch), bMatches);
+	return true;
+}
+
+#endif
@@ -0,0 +1,174 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Simulation/RogueFrameScratch.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && ROGUE_ALLOC_COUNTERS_ENABLED
+
+#include "Misc/AutomationTest.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+#include "Tests/RogueScenarioTestWorld.h"
+
+namespace RogueScenarioPerfTest
+{
+	constexpr int32 WarmupFrames = 300;
+	constexpr int32 MeasureFrames = 600;
+
+	// Steady state target for the counted simulation scopes over the measured frames
+	constexpr uint64 MaxSimAllocs = 0;
+
+	// Every simulation processor has to run each frame of the measure, the debug data processor is not required
+	const TCHAR* const RequiredScopes[] =
+	{
+		TEXT("PassengerSpawn"), TEXT("PassengerMovement"), TEXT("PassengerHeight"),
+		TEXT("EngineMovement"), TEXT("CarriageFollow"), TEXT("Headway"), TEXT("Junction"), TEXT("TrainInterpolation"),
+		TEXT("StationDetect"), TEXT("StationOps")
+	};
+
+	// Generous so debug and editor builds pass, catches order of magnitude regressions rather than noise
+	static double GetMaxSimMsPerFrame(const ERogueScenarioPreset Preset)
+	{
+		switch (Preset)
+		{
+			case ERogueScenarioPreset::Small:	return 8.0;
+			case ERogueScenarioPreset::Medium:	return 24.0;
+			case ERogueScenarioPreset::Large:	return 80.0;
+			case ERogueScenarioPreset::Stress:	return 250.0;
+			default: return 8.0;
+		}
+	}
+
+	// Small runs with the product tests, the heavier presets only with the stress filter
+	static void GetPresetTests(const bool bHeavy, TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands)
+	{
+		const UEnum* PresetEnum = StaticEnum<ERogueScenarioPreset>();
+		for (const ERogueScenarioPreset Preset : { ERogueScenarioPreset::Small, ERogueScenarioPreset::Medium, ERogueScenarioPreset::Large, ERogueScenarioPreset::Stress })
+		{
+			if ((Preset != ERogueScenarioPreset::Small) != bHeavy) continue;
+			
+			const FString Name = PresetEnum->GetNameStringByValue(static_cast<int64>(Preset));
+			OutBeautifiedNames.Add(Name);
+			OutTestCommands.Add(Name);
+		}
+	}
+
+	static bool ParsePreset(const FString& Parameters, ERogueScenarioPreset& OutPreset)
+	{
+		const int64 Value = StaticEnum<ERogueScenarioPreset>()->GetValueByNameString(Parameters);
+		if (Value == INDEX_NONE) return false;
+		
+		OutPreset = static_cast<ERogueScenarioPreset>(Value);
+		return true;
+	}
+
+	static void AddEntityCounts(FAutomationTestBase& Test, const URogueTrainWorldSubsystem& TrainSubsystem)
+	{
+		Test.AddInfo(FString::Printf(TEXT("Stations %d engines %d carriages %d passengers %d"),
+			TrainSubsystem.GetLiveCount(ERogueEntityType::Station), TrainSubsystem.GetLiveCount(ERogueEntityType::TrainEngine),
+			TrainSubsystem.GetLiveCount(ERogueEntityType::TrainCarriage), TrainSubsystem.GetLiveCount(ERogueEntityType::Passenger)));
+	}
+
+	static bool RunProcessorStats(FAutomationTestBase& Test, const ERogueScenarioPreset Preset)
+	{
+		FRogueScenarioTestWorld TestWorld(URogueScenarioSubsystem::GetPreset(Preset));
+		const URogueTrainWorldSubsystem* TrainSubsystem = TestWorld.GetTrainSubsystem();
+		if (!Test.TestNotNull(TEXT("Train subsystem"), TrainSubsystem)) return false;
+
+		TestWorld.Tick(WarmupFrames);
+
+		TArray<FRogueScopeCaptureTotals> Totals;
+		RogueAllocCounters::BeginCapture();
+		TestWorld.Tick(MeasureFrames);
+		RogueAllocCounters::GetCaptureTotals(Totals);
+		RogueAllocCounters::EndCapture();
+
+		Totals.Sort([](const FRogueScopeCaptureTotals& A, const FRogueScopeCaptureTotals& B) { return A.Cycles > B.Cycles; });
+
+		double TotalMs = 0.0;
+		for (const FRogueScopeCaptureTotals& Scope : Totals)
+		{
+			TotalMs += Scope.GetMilliseconds();
+			Test.AddInfo(FString::Printf(TEXT("%-24s %7.3f ms/frame %6u calls %6llu allocs"), Scope.Name, Scope.GetMilliseconds() / MeasureFrames, Scope.Calls, Scope.Allocs));
+		}
+
+		for (const TCHAR* Required : RequiredScopes)
+		{
+			const FRogueScopeCaptureTotals* Scope = Totals.FindByPredicate([Required](const FRogueScopeCaptureTotals& Entry) { return FCString::Strcmp(Entry.Name, Required) == 0; });
+			Test.TestTrue(FString::Printf(TEXT("%s ran every measured frame"), Required), Scope && Scope->Calls >= static_cast<uint32>(MeasureFrames));
+		}
+
+		AddEntityCounts(Test, *TrainSubsystem);
+		
+		const double MsPerFrame = TotalMs / MeasureFrames;
+		const double MaxSimMsPerFrame = GetMaxSimMsPerFrame(Preset);
+		Test.TestTrue(FString::Printf(TEXT("Simulation %.3f ms/frame within %.1f ms budget"), MsPerFrame, MaxSimMsPerFrame), MsPerFrame <= MaxSimMsPerFrame);
+		return true;
+	}
+
+	static bool RunSteadyStateAllocations(FAutomationTestBase& Test, const ERogueScenarioPreset Preset)
+	{
+		// The malloc counters are process wide, with worker threads running their allocations land in our scopes.
+		// Threading can't be switched off once the task graph is up, so an unattributable run fails instead of passing empty
+		if (!RogueAllocCounters::AreCountsAttributable())
+		{
+			Test.AddError(TEXT("Allocation counts are not attributable with worker threads running, run the test with -onethread"));
+			return false;
+		}
+		
+		FRogueScenarioTestWorld TestWorld(URogueScenarioSubsystem::GetPreset(Preset));
+		const URogueTrainWorldSubsystem* TrainSubsystem = TestWorld.GetTrainSubsystem();
+		if (!Test.TestNotNull(TEXT("Train subsystem"), TrainSubsystem)) return false;
+
+		TestWorld.Tick(WarmupFrames);
+
+		TArray<FRogueScopeCaptureTotals> Totals;
+		RogueAllocCounters::BeginCapture();
+		TestWorld.Tick(MeasureFrames);
+		RogueAllocCounters::GetCaptureTotals(Totals);
+		RogueAllocCounters::EndCapture();
+
+		uint64 SimAllocs = 0;
+		for (const FRogueScopeCaptureTotals& Scope : Totals)
+		{
+			SimAllocs += Scope.Allocs;
+			if (Scope.Allocs > 0)
+			{
+				Test.AddInfo(FString::Printf(TEXT("%-24s %6llu allocs over %d frames"), Scope.Name, Scope.Allocs, MeasureFrames));
+			}
+		}
+
+		AddEntityCounts(Test, *TrainSubsystem);
+		Test.TestTrue(FString::Printf(TEXT("%llu heap allocations in simulation scopes within budget of %llu"), SimAllocs, MaxSimAllocs), SimAllocs <= MaxSimAllocs);
+		return true;
+	}
+}
+
+#define ROGUE_IMPLEMENT_SCENARIO_PERF_TEST(TestClass, PrettyName, Flags, bHeavy, RunFunction) \
+	IMPLEMENT_COMPLEX_AUTOMATION_TEST(TestClass, PrettyName, EAutomationTestFlags_ApplicationContextMask | Flags) \
+	void TestClass::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const \
+	{ \
+		RogueScenarioPerfTest::GetPresetTests(bHeavy, OutBeautifiedNames, OutTestCommands); \
+	} \
+	bool TestClass::RunTest(const FString& Parameters) \
+	{ \
+		ERogueScenarioPreset Preset; \
+		if (!RogueScenarioPerfTest::ParsePreset(Parameters, Preset)) \
+		{ \
+			AddError(FString::Printf(TEXT("Unknown scenario preset '%s'"), *Parameters)); \
+			return false; \
+		} \
+		return RogueScenarioPerfTest::RunFunction(*this, Preset); \
+	}
+
+ROGUE_IMPLEMENT_SCENARIO_PERF_TEST(FRogueScenarioProcessorStatsTest, "RogueMassExample.Performance.ScenarioProcessorStats",
+	EAutomationTestFlags::ProductFilter, false, RunProcessorStats)
+ROGUE_IMPLEMENT_SCENARIO_PERF_TEST(FRogueScenarioProcessorStatsHeavyTest, "RogueMassExample.Performance.ScenarioProcessorStatsHeavy",
+	EAutomationTestFlags::StressFilter, true, RunProcessorStats)
+ROGUE_IMPLEMENT_SCENARIO_PERF_TEST(FRogueScenarioSteadyStateAllocationsTest, "RogueMassExample.Performance.SteadyStateAllocations",
+	EAutomationTestFlags::ProductFilter, false, RunSteadyStateAllocations)
+ROGUE_IMPLEMENT_SCENARIO_PERF_TEST(FRogueScenarioSteadyStateAllocationsHeavyTest, "RogueMassExample.Performance.SteadyStateAllocationsHeavy",
+	EAutomationTestFlags::StressFilter, true, RunSteadyStateAllocations)
+
+#undef ROGUE_IMPLEMENT_SCENARIO_PERF_TEST
+
+#endif
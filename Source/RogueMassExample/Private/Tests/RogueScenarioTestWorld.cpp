@@ -0,0 +1,61 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Tests/RogueScenarioTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+
+FRogueScenarioTestWorld::FRogueScenarioTestWorld(const FRogueScenarioParams& Params)
+{
+	if (!GEngine) return;
+
+	// Subsystems are created with the world, the scenario reads the override in Initialize
+	URogueScenarioSubsystem::SetParamsOverride(&Params);
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("RogueScenarioTest"));
+	URogueScenarioSubsystem::SetParamsOverride(nullptr);
+	if (!World) return;
+	
+	World->AddToRoot();
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	// Begin play applies the scenario, bakes the track and starts the spawn manager
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+}
+
+FRogueScenarioTestWorld::~FRogueScenarioTestWorld()
+{
+	if (!World) return;
+	
+	if (GEngine)
+	{
+		GEngine->DestroyWorldContext(World);
+	}
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	World = nullptr;
+}
+
+void FRogueScenarioTestWorld::Tick(const int32 NumFrames, const float DeltaTime)
+{
+	if (!World) return;
+	
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		// The engine loop is not running, advance the frame counter the sim clock keys on
+		++GFrameCounter;
+		World->Tick(LEVELTICK_All, DeltaTime);
+	}
+}
+
+URogueTrainWorldSubsystem* FRogueScenarioTestWorld::GetTrainSubsystem() const
+{
+	return World ? World->GetSubsystem<URogueTrainWorldSubsystem>() : nullptr;
+}
+
+#endif
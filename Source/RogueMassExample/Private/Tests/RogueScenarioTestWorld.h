@@ -0,0 +1,37 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Subsystems/RogueScenarioSubsystem.h"
+
+class UWorld;
+class URogueTrainWorldSubsystem;
+
+/**
+ * Standalone game world running a generated scenario, for automation tests.
+ * Created without a map or the command line, ticked with a fixed delta so runs repeat for a seed.
+ */
+class FRogueScenarioTestWorld
+{
+public:
+	explicit FRogueScenarioTestWorld(const FRogueScenarioParams& Params);
+	~FRogueScenarioTestWorld();
+
+	FRogueScenarioTestWorld(const FRogueScenarioTestWorld&) = delete;
+	FRogueScenarioTestWorld& operator=(const FRogueScenarioTestWorld&) = delete;
+
+	// Advance the world, the sim clock sees each call as a new engine frame
+	void Tick(const int32 NumFrames, const float DeltaTime = 1.f / 30.f);
+
+	UWorld* GetWorld() const { return World; }
+	URogueTrainWorldSubsystem* GetTrainSubsystem() const;
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif
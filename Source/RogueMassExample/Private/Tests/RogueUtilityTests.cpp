@@ -0,0 +1,400 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "MassEntityManager.h"
+#include "MassExecutionContext.h"
+#include "Components/SplineComponent.h"
+#include "Data/RogueDeveloperSettings.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Utilities/RoguePassengerUtility.h"
+#include "Utilities/RogueStationQueueUtility.h"
+#include "Utilities/RogueTrainUtility.h"
+
+/**
+ * Correctness checks for the helpers timed by rogue.Bench.Utilities, on small fixed seed inputs.
+ * Results are compared with known values or a brute force reference.
+ */
+namespace RogueUtilityTests
+{
+	constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter;
+	constexpr int32 NumInputs = 256;
+
+	// Closed circle like the scenario track, platforms evenly spaced with a station slot each so the fragment is valid
+	static void BuildCircleTrack(const int32 NumPoints, const double Radius, const int32 NumPlatforms, TStrongObjectPtr<USplineComponent>& OutSpline, FRogueTrackSharedFragment& OutTrack)
+	{
+		OutSpline.Reset(NewObject<USplineComponent>(GetTransientPackage()));
+		OutSpline->ClearSplinePoints(false);
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			const double Angle = UE_DOUBLE_TWO_PI * i / NumPoints;
+			OutSpline->AddSplinePoint(FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.0), ESplineCoordinateSpace::Local, false);
+		}
+		OutSpline->SetClosedLoop(true, false);
+		OutSpline->UpdateSpline();
+
+		OutTrack.Spline = OutSpline.Get();
+		OutTrack.TrackLength = OutSpline->GetSplineLength();
+		for (int32 i = 0; i < NumPlatforms; ++i)
+		{
+			FRoguePlatformData& Platform = OutTrack.Platforms.AddDefaulted_GetRef();
+			Platform.TrackDistance = OutTrack.TrackLength * (i + 0.5) / NumPlatforms;
+			Platform.DockDistance = Platform.TrackDistance;
+		}
+		OutTrack.StationEntities.SetNum(NumPlatforms);
+	}
+
+	// One waiting point with a single grid of NumSlots, slots spaced along X
+	static void BuildGrid(const int32 NumSlots, FRogueStationLayoutFragment& OutLayout, FRogueStationQueueFragment& OutQueue)
+	{
+		OutLayout.WaitingPoints.Add(FVector::ZeroVector);
+		OutLayout.SlotsPerGrid = NumSlots;
+		for (int32 i = 0; i < NumSlots; ++i)
+		{
+			OutLayout.SlotPositions.Add(FVector(i * 50.0, 0.0, 0.0));
+		}
+		RogueStationQueueUtility::InitWaitingGrids(OutLayout, OutQueue);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueArcDistanceTest, "RogueMassExample.Utilities.ArcDistanceWrapped", RogueUtilityTests::TestFlags)
+
+bool FRogueArcDistanceTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Forward arc"), RogueTrainUtility::ArcDistanceWrapped(100.0, 300.0, 1000.0), 200.0);
+	TestEqual(TEXT("Arc across the seam"), RogueTrainUtility::ArcDistanceWrapped(900.0, 100.0, 1000.0), 200.0);
+	TestEqual(TEXT("Same point"), RogueTrainUtility::ArcDistanceWrapped(500.0, 500.0, 1000.0), 0.0);
+
+	TestEqual(TEXT("Wrap negative"), RogueTrainUtility::WrapTrackDistance(-100.0, 1000.0), 900.0);
+	TestEqual(TEXT("Wrap past the end"), RogueTrainUtility::WrapTrackDistance(2100.0, 1000.0), 100.0);
+	TestEqual(TEXT("Wrap track length"), RogueTrainUtility::WrapTrackDistance(1000.0, 1000.0), 0.0);
+	TestEqual(TEXT("Wrap on empty track"), RogueTrainUtility::WrapTrackDistance(50.0, 0.0), 0.0);
+
+	// Walking the arc from A always lands on B
+	FRandomStream Random(1234);
+	for (int32 i = 0; i < RogueUtilityTests::NumInputs; ++i)
+	{
+		const double TrackLength = 1000.0;
+		const double From = Random.FRandRange(0.f, 1.f) * TrackLength;
+		const double To = Random.FRandRange(0.f, 1.f) * TrackLength;
+		const double Arc = RogueTrainUtility::ArcDistanceWrapped(From, To, TrackLength);
+		
+		if (!TestTrue(TEXT("Arc inside the track"), Arc >= 0.0 && Arc < TrackLength)) break;
+		if (!TestEqual(TEXT("From plus arc reaches To"), RogueTrainUtility::WrapTrackDistance(From + Arc, TrackLength), To, 1e-6)) break;
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueFindNextStationTest, "RogueMassExample.Utilities.FindNextStation", RogueUtilityTests::TestFlags)
+
+bool FRogueFindNextStationTest::RunTest(const FString& Parameters)
+{
+	TArray<FRoguePlatformData> Platforms;
+	for (const double Distance : { 100.0, 400.0, 700.0 })
+	{
+		Platforms.AddDefaulted_GetRef().TrackDistance = Distance;
+	}
+
+	TestEqual(TEXT("Ahead of the first platform"), RogueTrainUtility::FindNextStation(Platforms, 50.0, 1000.0), 0);
+	TestEqual(TEXT("On a platform moves to the next"), RogueTrainUtility::FindNextStation(Platforms, 100.0, 1000.0), 1);
+	TestEqual(TEXT("Past the last platform wraps"), RogueTrainUtility::FindNextStation(Platforms, 750.0, 1000.0), 0);
+	TestEqual(TEXT("No platforms"), RogueTrainUtility::FindNextStation(TArray<FRoguePlatformData>(), 50.0, 1000.0), static_cast<int32>(INDEX_NONE));
+
+	// Against a sorted scan on the benchmark's evenly spaced platforms
+	FRandomStream Random(1234);
+	constexpr int32 NumPlatforms = 200;
+	constexpr double TrackLength = 100000.0;
+	Platforms.Reset();
+	for (int32 i = 0; i < NumPlatforms; ++i)
+	{
+		Platforms.AddDefaulted_GetRef().TrackDistance = TrackLength * (i + 0.5) / NumPlatforms;
+	}
+	
+	for (int32 i = 0; i < RogueUtilityTests::NumInputs; ++i)
+	{
+		const double Distance = Random.FRandRange(0.f, 1.f) * TrackLength;
+		int32 Expected = 0;
+		while (Expected < NumPlatforms && Platforms[Expected].TrackDistance <= Distance) ++Expected;
+		Expected %= NumPlatforms;
+		
+		if (!TestEqual(FString::Printf(TEXT("Next station from %.1f"), Distance), RogueTrainUtility::FindNextStation(Platforms, Distance, TrackLength), Expected)) break;
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueSplineSampleTest, "RogueMassExample.Utilities.GetSplineSample", RogueUtilityTests::TestFlags)
+
+bool FRogueSplineSampleTest::RunTest(const FString& Parameters)
+{
+	constexpr double Radius = 10000.0;
+	TStrongObjectPtr<USplineComponent> Spline;
+	FRogueTrackSharedFragment Track;
+	RogueUtilityTests::BuildCircleTrack(256, Radius, 4, Spline, Track);
+
+	FRandomStream Random(1234);
+	for (int32 i = 0; i < RogueUtilityTests::NumInputs; ++i)
+	{
+		const double Distance = Random.FRandRange(0.f, 1.f) * Track.TrackLength;
+		RogueTrainUtility::FSplineStationSample Sample;
+		if (!TestTrue(TEXT("Sampled"), RogueTrainUtility::GetSplineSample(Track, Distance, Sample))) break;
+
+		// On the circle, tangent to it, and the same sample one lap later
+		const FVector Radial = Sample.Location.GetSafeNormal2D();
+		TestEqual(TEXT("Sample on the track"), Sample.Location.Size2D(), Radius, Radius * 0.005);
+		TestEqual(TEXT("Sample distance"), Sample.Distance, Distance, 0.01);
+		TestTrue(TEXT("Forward is tangent"), FMath::Abs(FVector::DotProduct(Sample.Forward, Radial)) < 0.05);
+
+		RogueTrainUtility::FSplineStationSample Lapped;
+		RogueTrainUtility::GetSplineSample(Track, Distance + Track.TrackLength, Lapped);
+		if (!TestTrue(TEXT("Distance wraps"), Lapped.Location.Equals(Sample.Location, 1.0))) break;
+	}
+
+	// Offsets move along the local basis
+	RogueTrainUtility::FSplineStationSample Base;
+	RogueTrainUtility::FSplineStationSample Offset;
+	RogueTrainUtility::GetSplineSample(Track, 1000.0, Base);
+	RogueTrainUtility::GetSplineSample(Track, 1000.0, 0.f, 100.f, 50.f, Offset);
+	TestTrue(TEXT("Lateral and vertical offsets"), Offset.Location.Equals(Base.Location + Base.Right * 100.0 + Base.Up * 50.0, 0.1));
+
+	FRogueTrackSharedFragment EmptyTrack;
+	RogueTrainUtility::FSplineStationSample Unused;
+	TestFalse(TEXT("No spline"), RogueTrainUtility::GetSplineSample(EmptyTrack, 0.0, Unused));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueConsistPlacementTest, "RogueMassExample.Utilities.ComputeConsistPlacement", RogueUtilityTests::TestFlags)
+
+bool FRogueConsistPlacementTest::RunTest(const FString& Parameters)
+{
+	const auto* Settings = GetDefault<URogueDeveloperSettings>();
+	if (!TestNotNull(TEXT("Settings"), Settings)) return false;
+	
+	TStrongObjectPtr<USplineComponent> Spline;
+	FRogueTrackSharedFragment Track;
+	RogueUtilityTests::BuildCircleTrack(256, 10000.0, 4, Spline, Track);
+
+	// Head just past the seam so the carriages wrap behind it
+	constexpr int32 NumCarriages = 10;
+	const double HeadDistance = 100.0;
+	FRogueCarriageClassFragment CarriageClass;
+	CarriageClass.Spacing = 1250.f;
+	CarriageClass.RideHeight = 35.f;
+	TArray<FRoguePlacedCar> Placement;
+	RogueTrainUtility::ComputeConsistPlacement(Track, HeadDistance, NumCarriages, CarriageClass, Placement);
+	if (!TestEqual(TEXT("Engine and every carriage placed"), Placement.Num(), NumCarriages + 1)) return false;
+
+	TestEqual(TEXT("Engine centre"), Placement[0].Distance, RogueTrainUtility::WrapTrackDistance(HeadDistance - 0.5 * Settings->EngineLength, Track.TrackLength), 0.01);
+	for (int32 i = 1; i < Placement.Num(); ++i)
+	{
+		TestTrue(TEXT("Placement inside the track"), Placement[i].Distance >= 0.0 && Placement[i].Distance < Track.TrackLength);
+		TestEqual(FString::Printf(TEXT("Gap ahead of carriage %d"), i), RogueTrainUtility::ArcDistanceWrapped(Placement[i].Distance, Placement[i - 1].Distance, Track.TrackLength), static_cast<double>(CarriageClass.Spacing), 0.01);
+	}
+
+	// Invalid track places nothing
+	FRogueTrackSharedFragment EmptyTrack;
+	RogueTrainUtility::ComputeConsistPlacement(EmptyTrack, HeadDistance, NumCarriages, CarriageClass, Placement);
+	TestEqual(TEXT("Nothing placed on an invalid track"), Placement.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueClaimWaitingSlotTest, "RogueMassExample.Utilities.ClaimWaitingSlot", RogueUtilityTests::TestFlags)
+
+bool FRogueClaimWaitingSlotTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumSlots = 10;
+	constexpr int32 FreeSlot = 6;
+	FRogueStationLayoutFragment Layout;
+	FRogueStationQueueFragment Queue;
+	RogueUtilityTests::BuildGrid(NumSlots, Layout, Queue);
+
+	FRogueWaitingGrid& Grid = Queue.Grids[0];
+	for (int32 i = 0; i < NumSlots; ++i)
+	{
+		if (i != FreeSlot) Grid.OccupiedBy[i] = FMassEntityHandle(i + 1, 1);
+	}
+
+	// The only free slot is found and taken
+	const FMassEntityHandle Passenger(NumSlots + 1, 1);
+	FVector SlotPos = FVector::ZeroVector;
+	TestEqual(TEXT("Claims the free slot"), RogueStationQueueUtility::ClaimWaitingSlot(Layout, &Queue, 0, Passenger, SlotPos), FreeSlot);
+	TestTrue(TEXT("Slot now holds the passenger"), Grid.OccupiedBy[FreeSlot] == Passenger);
+	TestEqual(TEXT("Slot position"), SlotPos, Layout.GetSlotPosition(0, FreeSlot));
+
+	// Full grid leaves every slot alone
+	const TArray<FMassEntityHandle> Before = Grid.OccupiedBy;
+	TestEqual(TEXT("Full grid"), RogueStationQueueUtility::ClaimWaitingSlot(Layout, &Queue, 0, FMassEntityHandle(NumSlots + 2, 1), SlotPos), static_cast<int32>(INDEX_NONE));
+	TestTrue(TEXT("Full grid unchanged"), Grid.OccupiedBy == Before);
+	TestEqual(TEXT("Unknown waiting point"), RogueStationQueueUtility::ClaimWaitingSlot(Layout, &Queue, 1, Passenger, SlotPos), static_cast<int32>(INDEX_NONE));
+
+	// Released slot can be claimed again
+	FRoguePassengerTripFragment Trip;
+	Trip.SetWaitingPointIdx(0);
+	Trip.SetWaitingSlotIdx(FreeSlot);
+	RogueStationQueueUtility::ReleaseSlot(Queue, Trip);
+	TestFalse(TEXT("Slot released"), Grid.OccupiedBy[FreeSlot].IsValid());
+	TestEqual(TEXT("Released slot claimed again"), RogueStationQueueUtility::ClaimWaitingSlot(Layout, &Queue, 0, Passenger, SlotPos), FreeSlot);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRoguePeekFromGridTest, "RogueMassExample.Utilities.PeekFromGrid", RogueUtilityTests::TestFlags)
+
+bool FRoguePeekFromGridTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumSlots = 20;
+	constexpr int32 Station = 1;
+	constexpr int32 OtherStation = 2;
+	FRogueStationLayoutFragment Layout;
+	FRogueStationQueueFragment Queue;
+	RogueUtilityTests::BuildGrid(NumSlots, Layout, Queue);
+
+	// Standalone entity manager so the peek resolves real passenger fragments without a world
+	const TSharedRef<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+	{
+		const TArray<const UScriptStruct*> Composition = { FRoguePassengerFragment::StaticStruct(), FRoguePassengerTripFragment::StaticStruct() };
+		const FMassArchetypeHandle Archetype = EntityManager->CreateArchetype(Composition);
+		TArray<FMassEntityHandle> Passengers;
+		EntityManager->BatchCreateEntities(Archetype, NumSlots, Passengers);
+
+		// Slot 3 is for this station but not waiting yet, slot 12 is the first match, everyone else waits elsewhere
+		for (int32 i = 0; i < NumSlots; ++i)
+		{
+			EntityManager->GetFragmentDataChecked<FRoguePassengerFragment>(Passengers[i]).bWaiting = i != 3;
+			EntityManager->GetFragmentDataChecked<FRoguePassengerTripFragment>(Passengers[i]).OriginStationIdx = i == 3 || i >= 12 ? Station : OtherStation;
+			Queue.Grids[0].OccupiedBy[i] = Passengers[i];
+		}
+
+		FMassEntityHandle Passenger;
+		int32 SlotIdx = INDEX_NONE;
+		FVector SlotPos;
+		TestTrue(TEXT("Finds a waiting passenger"), RogueStationQueueUtility::PeekFromGrid(*EntityManager, Layout, Queue, 0, Passenger, Station, SlotIdx, SlotPos));
+		TestEqual(TEXT("First waiting passenger for the station"), SlotIdx, 12);
+		TestTrue(TEXT("Passenger in that slot"), Passenger == Passengers[12]);
+		TestEqual(TEXT("Slot position"), SlotPos, Layout.GetSlotPosition(0, 12));
+		TestTrue(TEXT("Peek leaves the slot occupied"), Queue.Grids[0].OccupiedBy[12] == Passengers[12]);
+
+		TestFalse(TEXT("No passenger for an unknown station"), RogueStationQueueUtility::PeekFromGrid(*EntityManager, Layout, Queue, 0, Passenger, 7, SlotIdx, SlotPos));
+		TestFalse(TEXT("Unknown waiting point"), RogueStationQueueUtility::PeekFromGrid(*EntityManager, Layout, Queue, 1, Passenger, Station, SlotIdx, SlotPos));
+	}
+	EntityManager->Deinitialize();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueStationPassengerChunkTest, "RogueMassExample.Utilities.ForEachStationPassengerChunk", RogueUtilityTests::TestFlags)
+
+bool FRogueStationPassengerChunkTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumStations = 3;
+	constexpr int32 PassengersPerStation = 10;
+
+	const TSharedRef<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+	EntityManager->Initialize();
+	{
+		const TArray<const UScriptStruct*> Composition = { FRoguePassengerFragment::StaticStruct(), FRoguePassengerTripFragment::StaticStruct() };
+		const FMassArchetypeHandle Archetype = EntityManager->CreateArchetype(Composition);
+		TArray<FMassEntityHandle> Passengers;
+		EntityManager->BatchCreateEntities(Archetype, NumStations * PassengersPerStation, Passengers);
+
+		// Stations interleaved in creation order, the shared fragment is what groups them
+		for (int32 i = 0; i < Passengers.Num(); ++i)
+		{
+			FRoguePassengerStationSharedFragment StationGroup;
+			StationGroup.StationIdx = i % NumStations;
+			EntityManager->GetFragmentDataChecked<FRoguePassengerTripFragment>(Passengers[i]).OriginStationIdx = RogueCompactIndex::Compact<uint16>(StationGroup.StationIdx);
+			EntityManager->AddSharedFragmentToEntity(Passengers[i], EntityManager->GetOrCreateSharedFragment(StationGroup));
+		}
+
+		FMassEntityQuery Query(EntityManager);
+		Query.AddRequirement<FRoguePassengerTripFragment>(EMassFragmentAccess::ReadOnly);
+		Query.AddSharedRequirement<FRoguePassengerStationSharedFragment>(EMassFragmentAccess::ReadOnly);
+		FMassExecutionContext Context(*EntityManager);
+
+		for (int32 Station = 0; Station < NumStations; ++Station)
+		{
+			int32 Visited = 0;
+			int32 Misplaced = 0;
+			RoguePassengerUtility::ForEachStationPassengerChunk(Query, Context, Station, [&](FMassExecutionContext& ChunkContext)
+			{
+				for (const FRoguePassengerTripFragment& TripFragment : ChunkContext.GetFragmentView<FRoguePassengerTripFragment>())
+				{
+					Misplaced += TripFragment.GetOriginStationIdx() != Station;
+					++Visited;
+				}
+			});
+			TestEqual(FString::Printf(TEXT("Every passenger of station %d visited"), Station), Visited, PassengersPerStation);
+			TestEqual(FString::Printf(TEXT("Only passengers of station %d visited"), Station), Misplaced, 0);
+		}
+
+		int32 Visited = 0;
+		RoguePassengerUtility::ForEachStationPassengerChunk(Query, Context, NumStations, [&](FMassExecutionContext& ChunkContext) { Visited += ChunkContext.GetNumEntities(); });
+		TestEqual(TEXT("Nothing visited for a station without passengers"), Visited, 0);
+
+		// The filter is cleared again, the plain query sees every station
+		Visited = 0;
+		Query.ForEachEntityChunk(Context, [&](FMassExecutionContext& ChunkContext) { Visited += ChunkContext.GetNumEntities(); });
+		TestEqual(TEXT("Chunk filter cleared"), Visited, NumStations * PassengersPerStation);
+	}
+	EntityManager->Deinitialize();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueFindNearestIndexTest, "RogueMassExample.Utilities.FindNearestIndex", RogueUtilityTests::TestFlags)
+
+bool FRogueFindNearestIndexTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("No points"), RoguePassengerUtility::FindNearestIndex(TArray<FVector>(), FVector::ZeroVector), static_cast<int32>(INDEX_NONE));
+
+	FRandomStream Random(1234);
+	TArray<FVector> Points;
+	for (int32 i = 0; i < 200; ++i)
+	{
+		Points.Add(Random.VRand() * 1000.f);
+	}
+
+	for (int32 i = 0; i < RogueUtilityTests::NumInputs; ++i)
+	{
+		const FVector From = Random.VRand() * Random.FRandRange(0.f, 2000.f);
+		const int32 Nearest = RoguePassengerUtility::FindNearestIndex(Points, From);
+		if (!TestTrue(TEXT("Valid index"), Points.IsValidIndex(Nearest))) break;
+
+		// No other point is strictly closer
+		const double NearestDistSq = FVector::DistSquared(Points[Nearest], From);
+		const bool bCloserExists = Points.ContainsByPredicate([&](const FVector& Point) { return FVector::DistSquared(Point, From) < NearestDistSq - 1e-3; });
+		if (!TestFalse(TEXT("Nearest point"), bCloserExists)) break;
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRogueWaitingPointQueueTest, "RogueMassExample.Utilities.WaitingPointQueue", RogueUtilityTests::TestFlags)
+
+bool FRogueWaitingPointQueueTest::RunTest(const FString& Parameters)
+{
+	FRogueStationQueueFragment Queue;
+	FRoguePassengerQueueEntry Entry;
+	TestFalse(TEXT("Empty queue"), RoguePassengerQueueUtility::DequeueFromWaitingPoint(Queue, 0, Entry));
+
+	// Highest priority first, the longest waiting within a priority
+	RoguePassengerQueueUtility::EnqueueAtWaitingPoint(Queue, 0, FMassEntityHandle(1, 1), 5, 30.f, 0);
+	RoguePassengerQueueUtility::EnqueueAtWaitingPoint(Queue, 0, FMassEntityHandle(2, 1), 6, 10.f, 0);
+	RoguePassengerQueueUtility::EnqueueAtWaitingPoint(Queue, 0, FMassEntityHandle(3, 1), 7, 50.f, 2);
+	RoguePassengerQueueUtility::EnqueueAtWaitingPoint(Queue, 0, FMassEntityHandle(4, 1), 8, 20.f, 2);
+	RoguePassengerQueueUtility::EnqueueAtWaitingPoint(Queue, 1, FMassEntityHandle(5, 1), 9, 0.f, 9);
+	
+	const int32 ExpectedOrder[] = { 4, 3, 2, 1 };
+	for (const int32 Expected : ExpectedOrder)
+	{
+		if (!TestTrue(TEXT("Dequeued"), RoguePassengerQueueUtility::DequeueFromWaitingPoint(Queue, 0, Entry))) return false;
+		TestEqual(TEXT("Dequeue order"), Entry.Passenger.Index, Expected);
+		TestEqual(TEXT("Destination kept"), Entry.GetDestStationIdx(), Expected + 4);
+	}
+	TestFalse(TEXT("Waiting point drained"), RoguePassengerQueueUtility::DequeueFromWaitingPoint(Queue, 0, Entry));
+
+	// Other waiting points are separate queues
+	TestTrue(TEXT("Other waiting point untouched"), RoguePassengerQueueUtility::DequeueFromWaitingPoint(Queue, 1, Entry) && Entry.Passenger.Index == 5);
+	return true;
+}
+
+#endif
@@ -0,0 +1,70 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/RogueConsistTable.h"
+
+int32 FRogueConsistTable::Allocate(const FMassEntityHandle Lead, const int32 MaxCarriages, const int32 ExistingId)
+{
+	const int32 Capacity = FMath::Max(0, MaxCarriages);
+
+	// Reconfigured engine, clear its range in place
+	if (IsValidConsist(ExistingId) && Consists[ExistingId].Lead == Lead && Consists[ExistingId].Capacity >= Capacity)
+	{
+		FRange& Range = Consists[ExistingId];
+		for (int32 i = 0; i < Range.Num; ++i) Carriages[Range.First + i] = FMassEntityHandle();
+		Range.Num = 0;
+		return ExistingId;
+	}
+
+	// Reuse the first released range that fits
+	for (int32 FreeIdx = 0; FreeIdx < FreeIds.Num(); ++FreeIdx)
+	{
+		const int32 ConsistId = FreeIds[FreeIdx];
+		FRange& Range = Consists[ConsistId];
+		if (Range.Capacity < Capacity) continue;
+		
+		FreeIds.RemoveAtSwap(FreeIdx, 1, EAllowShrinking::No);
+		Range.Lead = Lead;
+		Range.Num = 0;
+		return ConsistId;
+	}
+
+	FRange& Range = Consists.AddDefaulted_GetRef();
+	Range.Lead = Lead;
+	Range.First = Carriages.Num();
+	Range.Capacity = Capacity;
+	Carriages.AddDefaulted(Capacity);
+	return Consists.Num() - 1;
+}
+
+void FRogueConsistTable::Release(const int32 ConsistId)
+{
+	if (!IsValidConsist(ConsistId)) return;
+
+	FRange& Range = Consists[ConsistId];
+	for (int32 i = 0; i < Range.Num; ++i) Carriages[Range.First + i] = FMassEntityHandle();
+	Range.Lead = FMassEntityHandle();
+	Range.Num = 0;
+	FreeIds.Add(ConsistId);
+}
+
+void FRogueConsistTable::SetCarriage(const int32 ConsistId, const int32 CarriageIndex, const FMassEntityHandle Carriage)
+{
+	if (!IsValidConsist(ConsistId)) return;
+
+	FRange& Range = Consists[ConsistId];
+	const int32 Slot = CarriageIndex - 1;
+	if (Slot < 0 || Slot >= Range.Capacity) return;
+
+	// Carriages may be configured out of order, gaps stay unset until filled
+	Carriages[Range.First + Slot] = Carriage;
+	Range.Num = FMath::Max(Range.Num, Slot + 1);
+}
+
+TConstArrayView<FMassEntityHandle> FRogueConsistTable::GetCarriages(const int32 ConsistId) const
+{
+	if (!IsValidConsist(ConsistId)) return TConstArrayView<FMassEntityHandle>();
+
+	const FRange& Range = Consists[ConsistId];
+	return TConstArrayView<FMassEntityHandle>(Carriages.GetData() + Range.First, Range.Num);
+}
@@ -0,0 +1,73 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RogueMassExample.h"
+#include "HAL/IConsoleManager.h"
+#include "Mass/Fragments/RogueFragments.h"
+#include "Subsystems/RogueTrainWorldSubsystem.h"
+
+// Passenger data is paid per passenger, keep the trip data and queue entries from growing back
+static_assert(sizeof(FRoguePassengerTripFragment) <= 16, "FRoguePassengerTripFragment is stored per passenger, keep station and waiting indices compact");
+static_assert(sizeof(FRoguePassengerQueueEntry) <= 16, "FRoguePassengerQueueEntry is stored per queued passenger, keep it compact");
+static_assert(sizeof(FRoguePassengerFragment) <= 32, "FRoguePassengerFragment is read every movement step, keep new members in the FVector tail padding");
+
+// Train fragments hold ids into the subsystem consist table and occupant slab, no heap data to copy on archetype moves
+static_assert(std::is_trivially_copyable_v<FRogueTrainStateFragment>, "FRogueTrainStateFragment should stay trivially copyable, keep carriages in the consist table");
+static_assert(std::is_trivially_copyable_v<FRogueCarriageFragment>, "FRogueCarriageFragment should stay trivially copyable, keep occupants in the occupant slab");
+
+// Spawn requests are copied through the per type rings, payloads larger than a transform go in the subsystem arena
+static_assert(std::is_trivially_copyable_v<FRogueSpawnRequest>, "FRogueSpawnRequest should stay trivially copyable, reference payloads by index");
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Static per entity memory of the Rogue fragments, run via rogue.Report.FragmentMemory.
+ * Sizes are the inline struct sizes, heap owned by arrays and maps inside a fragment is not counted.
+ */
+namespace RogueFragmentMemoryReport
+{
+	struct FRow
+	{
+		const TCHAR* Name;
+		int32 Size;
+		int32 Align;
+		bool bPerPassenger;
+	};
+
+	#define ROGUE_FRAGMENT_ROW(Type, bPerPassenger) { TEXT(#Type), static_cast<int32>(sizeof(Type)), static_cast<int32>(alignof(Type)), bPerPassenger }
+
+	static const FRow Rows[] =
+	{
+		ROGUE_FRAGMENT_ROW(FRoguePassengerFragment, true),
+		ROGUE_FRAGMENT_ROW(FRoguePassengerTripFragment, true),
+		ROGUE_FRAGMENT_ROW(FRogueDebugSlotFragment, true),
+		ROGUE_FRAGMENT_ROW(FRoguePassengerQueueEntry, false),
+		ROGUE_FRAGMENT_ROW(FRogueCarriageFragment, false),
+		ROGUE_FRAGMENT_ROW(FRogueTrainLinkFragment, false),
+		ROGUE_FRAGMENT_ROW(FRogueTrainStateFragment, false),
+		ROGUE_FRAGMENT_ROW(FRogueTrainTrackFollowFragment, false),
+		ROGUE_FRAGMENT_ROW(FRogueStationFragment, false),
+		ROGUE_FRAGMENT_ROW(FRogueStationQueueFragment, false),
+	};
+
+	#undef ROGUE_FRAGMENT_ROW
+}
+
+static FAutoConsoleCommand GRogueReportFragmentMemoryCmd(
+	TEXT("rogue.Report.FragmentMemory"),
+	TEXT("Log the per entity size of each Rogue fragment and the passenger total. Args: <Passengers=1000000>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int64 NumPassengers = FMath::Max<int64>(0, Args.Num() > 0 ? FCString::Atoi64(*Args[0]) : 1000000);
+
+		int32 PassengerBytes = 0;
+		for (const RogueFragmentMemoryReport::FRow& Row : RogueFragmentMemoryReport::Rows)
+		{
+			UE_LOG(LogRogueSim, Display, TEXT("Fragment %-32s %4d bytes  align %2d%s"), Row.Name, Row.Size, Row.Align, Row.bPerPassenger ? TEXT("  per passenger") : TEXT(""));
+			if (Row.bPerPassenger) PassengerBytes += Row.Size;
+		}
+
+		UE_LOG(LogRogueSim, Display, TEXT("Rogue passenger fragments %d bytes per passenger, %.1f MB for %lld passengers (engine fragments excluded)"),
+			PassengerBytes, static_cast<double>(PassengerBytes) * NumPassengers / (1024.0 * 1024.0), NumPassengers);
+	}));
+
+#endif
@@ -0,0 +1,64 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/RogueOccupantSlab.h"
+
+int32 FRogueOccupantSlab::Allocate(const int32 Capacity)
+{
+	if (Capacity <= 0) return INDEX_NONE;
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(Capacity, BlockSize);
+	if (TArray<int32>* Free = FreeRuns.Find(NumBlocks); Free && Free->Num() > 0)
+	{
+		return Free->Pop(EAllowShrinking::No);
+	}
+
+	const int32 FirstBlock = RunLengths.Num();
+	RunLengths.AddZeroed(NumBlocks);
+	RunLengths[FirstBlock] = NumBlocks;
+	Handles.AddDefaulted(NumBlocks * BlockSize);
+	return FirstBlock;
+}
+
+void FRogueOccupantSlab::Free(const int32 FirstBlock)
+{
+	if (!RunLengths.IsValidIndex(FirstBlock) || RunLengths[FirstBlock] <= 0) return;
+
+	const int32 NumBlocks = RunLengths[FirstBlock];
+	checkSlow(FirstBlock + NumBlocks <= RunLengths.Num() && (FirstBlock + NumBlocks) * BlockSize <= Handles.Num());
+	checkSlow(!FreeRuns.Contains(NumBlocks) || !FreeRuns[NumBlocks].Contains(FirstBlock));
+	for (int32 i = 0; i < NumBlocks * BlockSize; ++i) Handles[FirstBlock * BlockSize + i] = FMassEntityHandle();
+	FreeRuns.FindOrAdd(NumBlocks).Add(FirstBlock);
+}
+
+TArrayView<FMassEntityHandle> FRogueOccupantSlab::GetOccupants(const FRogueCarriageFragment& Carriage)
+{
+	if (!RunLengths.IsValidIndex(Carriage.OccupantBlock)) return TArrayView<FMassEntityHandle>();
+	return TArrayView<FMassEntityHandle>(Handles.GetData() + Carriage.OccupantBlock * BlockSize, Carriage.NumOccupants);
+}
+
+TConstArrayView<FMassEntityHandle> FRogueOccupantSlab::GetOccupants(const FRogueCarriageFragment& Carriage) const
+{
+	if (!RunLengths.IsValidIndex(Carriage.OccupantBlock)) return TConstArrayView<FMassEntityHandle>();
+	return TConstArrayView<FMassEntityHandle>(Handles.GetData() + Carriage.OccupantBlock * BlockSize, Carriage.NumOccupants);
+}
+
+bool FRogueOccupantSlab::Add(FRogueCarriageFragment& Carriage, const FMassEntityHandle Occupant)
+{
+	if (Carriage.NumOccupants >= GetCapacity(Carriage.OccupantBlock)) return false;
+
+	Handles[Carriage.OccupantBlock * BlockSize + Carriage.NumOccupants] = Occupant;
+	++Carriage.NumOccupants;
+	return true;
+}
+
+void FRogueOccupantSlab::RemoveAtSwap(FRogueCarriageFragment& Carriage, const int32 Index)
+{
+	if (Index < 0 || Index >= Carriage.NumOccupants) return;
+
+	// Same order semantics as TArray::RemoveAtSwap, the unload cursor relies on the last occupant moving into Index
+	FMassEntityHandle* Occupants = Handles.GetData() + Carriage.OccupantBlock * BlockSize;
+	--Carriage.NumOccupants;
+	Occupants[Index] = Occupants[Carriage.NumOccupants];
+	Occupants[Carriage.NumOccupants] = FMassEntityHandle();
+}
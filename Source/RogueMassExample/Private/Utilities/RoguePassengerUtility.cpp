@@ -2,27 +2,28 @@
 
 
 #include "Utilities/RoguePassengerUtility.h"
+#include "RogueMassExample.h"
 #include "MassCommandBuffer.h"
 #include "MassCommands.h"
 #include "MassCommonFragments.h"
 #include "MassMovementFragments.h"
 #include "MassNavigationFragments.h"
 #include "MassRepresentationFragments.h"
+#include "Simulation/RogueSimTrace.h"
 #include "Subsystems/RogueTrainWorldSubsystem.h"
 
 
 void RoguePassengerQueueUtility::EnqueueAtWaitingPoint(FRogueStationQueueFragment& StationQueueFragment, const int32 WaitingPointIdx,
-	const FMassEntityHandle Passenger, const FMassEntityHandle DestStation, const float Time, const int32 Priority)
+	const FMassEntityHandle Passenger, const int32 DestStationIdx, const float Time, const int32 Priority)
 {
 	TArray<FRoguePassengerQueueEntry>* Entries = StationQueueFragment.QueuesByWaitingPoint.Find(WaitingPointIdx);
 	if (!Entries) { Entries = &StationQueueFragment.QueuesByWaitingPoint.Add(WaitingPointIdx); }
 	
 	FRoguePassengerQueueEntry QueueEntry;
 	QueueEntry.Passenger = Passenger;
-	QueueEntry.DestStation = DestStation;
-	QueueEntry.WaitingPointIdx = WaitingPointIdx;
+	QueueEntry.DestStationIdx = RogueCompactIndex::Compact<uint16>(DestStationIdx);
 	QueueEntry.EnqueuedGameTime = Time;
-	QueueEntry.Priority = Priority;
+	QueueEntry.Priority = static_cast<int16>(FMath::Clamp<int32>(Priority, MIN_int16, MAX_int16));
 	
 	Entries->Add(MoveTemp(QueueEntry));
 }
@@ -58,36 +59,66 @@ bool RoguePassengerQueueUtility::DequeueFromWaitingPoint(FRogueStationQueueFragm
 	return false;
 }
 
-void RoguePassengerUtility::Disembark(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, FRogueCarriageFragment& CarriageFragment, const int32 Index, const FVector& Location)
+void RoguePassengerUtility::Disembark(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, const FMassEntityHandle CarriageEntity, FRogueCarriageFragment& CarriageFragment, FRogueOccupantSlab& OccupantSlab, const int32 Index, const FVector& Location)
 {
-	const FMassEntityHandle Passenger = CarriageFragment.Occupants[Index];
+	const TConstArrayView<FMassEntityHandle> Occupants = OccupantSlab.GetOccupants(CarriageFragment);
+	if (!Occupants.IsValidIndex(Index)) return;
+	
+	const FMassEntityHandle Passenger = Occupants[Index];
 	if (IsHandleValid(EntityManager, Passenger))
 	{
-		if (FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger))
+		FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger);
+		FRoguePassengerTripFragment* TripFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerTripFragment>(Passenger);
+		if (PassengerFragment && TripFragment)
 		{
 			RoguePassengerUtility::ShowPassenger(EntityManager, Passenger, Location);
-			PassengerFragment->VehicleHandle = FMassEntityHandle();
-			PassengerFragment->WaitingPointIdx = INDEX_NONE; 
+			TripFragment->VehicleHandle = FMassEntityHandle();
+			TripFragment->SetWaitingPointIdx(INDEX_NONE);
 			PassengerFragment->Phase = ERoguePassengerPhase::UnloadAtStation;
+
+			// Alighted passengers regroup with the chunks of the station they arrived at
+			if (auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>())
+			{
+				TrainSubsystem->SetPassengerStation(Context.Defer(), Passenger, TripFragment->GetDestStationIdx());
+
+				FRogueEventSimStats& RunStats = TrainSubsystem->GetMutableRunStats();
+				RunStats.TotalRideSeconds += Context.GetWorld()->GetTimeSeconds() - PassengerFragment->PhaseStartTime;
+				++RunStats.Alightings;
+			}
 		}
 	}
 	
-	CarriageFragment.Occupants.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	OccupantSlab.RemoveAtSwap(CarriageFragment, Index);
+	INC_DWORD_STAT(STAT_RogueAlightings);
+	TRACE_ROGUE_SIM_EVENT(Alight, Context.GetWorld()->GetTimeSeconds(), Passenger, CarriageEntity, CarriageFragment.NumOccupants);
 }
 
-bool RoguePassengerUtility::TryBoard(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, const FMassEntityHandle Passenger, const FMassEntityHandle CarriageEntity, FRogueCarriageFragment& CarriageFragment)
+bool RoguePassengerUtility::TryBoard(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, const FMassEntityHandle Passenger, const FMassEntityHandle CarriageEntity, FRogueCarriageFragment& CarriageFragment, FRogueOccupantSlab& OccupantSlab, const int32 Capacity)
 {
-	if (CarriageFragment.Occupants.Num() >= CarriageFragment.Capacity) return false;
+	if (CarriageFragment.NumOccupants >= FMath::Min(Capacity, OccupantSlab.GetCapacity(CarriageFragment.OccupantBlock))) return false;
 	if (!IsHandleValid(EntityManager, Passenger)) return false;
 
 	// attach
-	if (FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger))
+	FRoguePassengerFragment* PassengerFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerFragment>(Passenger);
+	FRoguePassengerTripFragment* TripFragment = EntityManager.GetFragmentDataPtr<FRoguePassengerTripFragment>(Passenger);
+	if (PassengerFragment && TripFragment)
 	{
-		PassengerFragment->VehicleHandle = CarriageEntity;
+		TripFragment->VehicleHandle = CarriageEntity;
 		PassengerFragment->Phase = ERoguePassengerPhase::ToAssignedCarriage;
+
+		if (auto* TrainSubsystem = Context.GetWorld()->GetSubsystem<URogueTrainWorldSubsystem>())
+		{
+			const float Now = Context.GetWorld()->GetTimeSeconds();
+			FRogueEventSimStats& RunStats = TrainSubsystem->GetMutableRunStats();
+			RunStats.TotalWaitSeconds += Now - PassengerFragment->PhaseStartTime;
+			++RunStats.Boardings;
+			PassengerFragment->PhaseStartTime = Now;
+		}
 	}
 
-	CarriageFragment.Occupants.Add(Passenger);
+	OccupantSlab.Add(CarriageFragment, Passenger);
+	INC_DWORD_STAT(STAT_RogueBoardings);
+	TRACE_ROGUE_SIM_EVENT(Board, Context.GetWorld()->GetTimeSeconds(), Passenger, CarriageEntity, CarriageFragment.NumOccupants);
 	
 	return true;
 }
@@ -179,3 +210,14 @@ bool RoguePassengerUtility::SnapToPlatform(const UWorld* WorldContext, FVector&
 	
 	return false;
 }
+
+void RoguePassengerUtility::ForEachStationPassengerChunk(FMassEntityQuery& Query, FMassExecutionContext& Context, const int32 StationIdx, const FMassExecuteFunction& Function)
+{
+	// Passengers are chunked per station, the filter skips every other station's chunks without touching their entities
+	Query.SetChunkFilter([StationIdx](const FMassExecutionContext& ChunkContext)
+	{
+		return ChunkContext.GetSharedFragment<FRoguePassengerStationSharedFragment>().StationIdx == StationIdx;
+	});
+	Query.ForEachEntityChunk(Context, Function);
+	Query.ClearChunkFilter();
+}
@@ -2,41 +2,92 @@
 
 
 #include "Utilities/RogueStationQueueUtility.h"
+#include "RogueMassExample.h"
 #include "MassEntityManager.h"
 
+DECLARE_CYCLE_STAT(TEXT("Grid Peek"), STAT_RogueGridPeek, STATGROUP_RogueSim);
 
-void RogueStationQueueUtility::BuildGridForWaitingPoint(const FRoguePlatformData& StationSegment, FRogueStationQueueFragment& QueueFragment,
-                                                        const FVector& WaitingCenter, const int32 WaitingPointIdx)
+
+void RogueStationQueueUtility::BuildStationLayout(const FRoguePlatformData& StationSegment, const FRogueStationConfig& StationConfigData, const int32 StationIdx,
+	FRogueStationLayoutFragment& OutLayout)
 {
-	FRogueWaitingGrid& Grid = QueueFragment.Grids.FindOrAdd(WaitingPointIdx);
-	Grid.SlotPositions.Reset();
-	Grid.OccupiedBy.Reset();
+	OutLayout.StationIdx = StationIdx;
+	OutLayout.WaitingPoints.Reset();
+	OutLayout.SpawnPoints.Reset();
+	OutLayout.SlotPositions.Reset();
+	OutLayout.WaitingGridConfig = StationConfigData.WaitingGridConfig;
+
+	// Set waiting points along platform
+	const float PlatformHalfLength = 0.5f * StationConfigData.PlatformConfig.PlatformLength;
+	const float Inset = FMath::Clamp(80.f, 0.f, PlatformHalfLength);
+	const float Span  = FMath::Max(0.f, StationConfigData.PlatformConfig.PlatformLength - 2.f * Inset);
+	const FVector A = StationSegment.Center - StationSegment.Fwd * (0.5f * Span);
+	const FVector B = StationSegment.Center + StationSegment.Fwd * (0.5f * Span);
+	// Passengers store the waiting point as a uint8 and the slot as a uint16 with the max value meaning unset,
+	// configs that bypassed the editor clamps would leave passengers holding an index they can never use
+	int32 WaitNum = FMath::Max(0, StationConfigData.PlatformConfig.WaitingPoints);
+	if (WaitNum > MAX_uint8 - 1)
+	{
+		UE_LOG(LogRogueSim, Warning, TEXT("Station %d has %d waiting points, clamped to %d"), StationIdx, WaitNum, MAX_uint8 - 1);
+		WaitNum = MAX_uint8 - 1;
+	}
+	
+	for (int32 WaitIdx = 0; WaitIdx < WaitNum; ++WaitIdx)
+	{
+		const float t = (WaitNum <= 1) ? 0.5f : static_cast<float>(WaitIdx) / static_cast<float>(WaitNum-1);
+		OutLayout.WaitingPoints.Add(FMath::Lerp(A, B, t));
+	}
 
-	const int32 Cols = FMath::Max(1, QueueFragment.WaitingGridConfig.GridCols);
-	const int32 Rows = FMath::Max(1, QueueFragment.WaitingGridConfig.GridRows);
+	// Set spawn points
+	const int32 SpawnNum = FMath::Max(0, StationConfigData.PlatformConfig.SpawnPoints);	
+	for (int32 SpawnIdx = 0; SpawnIdx < SpawnNum; ++SpawnIdx)
+	{
+		FVector Forward = SpawnIdx % 2 == 0 ? StationSegment.Fwd : -StationSegment.Fwd;
+		OutLayout.SpawnPoints.Add(StationSegment.Center + Forward  * (StationConfigData.PlatformConfig.SpawnPointDistance));
+	}
+
+	// Grid slots per waiting point, every grid has the same size so a waiting point's slots are one slice
+	const FRogueStationWaitingGridConfig& GridConfig = OutLayout.WaitingGridConfig;
+	const int32 Cols = FMath::Clamp(GridConfig.GridCols, 1, static_cast<int32>(MAX_uint8));
+	const int32 Rows = FMath::Clamp(GridConfig.GridRows, 1, static_cast<int32>(MAX_uint8));
+	if (Cols != FMath::Max(1, GridConfig.GridCols) || Rows != FMath::Max(1, GridConfig.GridRows))
+	{
+		UE_LOG(LogRogueSim, Warning, TEXT("Station %d waiting grid %dx%d clamped to %dx%d"), StationIdx, GridConfig.GridCols, GridConfig.GridRows, Cols, Rows);
+	}
 	const float ColumnHalfWidth = 0.5f * (Cols - 1);
 	const float RowHalfWidth = 0.5f * (Rows - 1);
-	const float MaxHalfWidth = 0.5f * StationSegment.PlatformLength - StationSegment.WaitingGridConfig.GridEdgeInset;
-	const FVector GridCenter = WaitingCenter + StationSegment.Right * StationSegment.WaitingGridConfig.GridOffset;
-	
-	for (int32 Row = 0; Row < Rows; ++Row)
+	const float MaxHalfWidth = 0.5f * StationSegment.PlatformLength - GridConfig.GridEdgeInset;
+	OutLayout.SlotsPerGrid = Cols * Rows;
+	OutLayout.SlotPositions.Reserve(OutLayout.SlotsPerGrid * OutLayout.WaitingPoints.Num());
+
+	for (const FVector& WaitingCenter : OutLayout.WaitingPoints)
 	{
-		for (int32 Col = 0; Col < Cols; ++Col)
+		const FVector GridCenter = WaitingCenter + StationSegment.Right * GridConfig.GridOffset;
+		for (int32 Row = 0; Row < Rows; ++Row)
 		{
-			const float Length = (Col - ColumnHalfWidth) * QueueFragment.WaitingGridConfig.GridColSpacing;
-			const float Width = (Row - RowHalfWidth) * QueueFragment.WaitingGridConfig.GridRowSpacing;
-			
-			const float ClampedLength = FMath::Clamp(Length, -MaxHalfWidth, MaxHalfWidth);
-			const FVector PointAdjusted = GridCenter + StationSegment.Fwd * ClampedLength + StationSegment.Right * (Width + 20.f);
-
-			Grid.SlotPositions.Add(PointAdjusted);
+			for (int32 Col = 0; Col < Cols; ++Col)
+			{
+				const float Length = (Col - ColumnHalfWidth) * GridConfig.GridColSpacing;
+				const float Width = (Row - RowHalfWidth) * GridConfig.GridRowSpacing;
+				
+				const float ClampedLength = FMath::Clamp(Length, -MaxHalfWidth, MaxHalfWidth);
+				OutLayout.SlotPositions.Add(GridCenter + StationSegment.Fwd * ClampedLength + StationSegment.Right * (Width + 20.f));
+			}
 		}
 	}
+}
 
-	Grid.OccupiedBy.Init(FMassEntityHandle(), Grid.SlotPositions.Num());
+void RogueStationQueueUtility::InitWaitingGrids(const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment& QueueFragment)
+{
+	QueueFragment.Grids.Reset();
+	for (int32 WaitIdx = 0; WaitIdx < Layout.WaitingPoints.Num(); ++WaitIdx)
+	{
+		QueueFragment.Grids.Add(WaitIdx).OccupiedBy.Init(FMassEntityHandle(), Layout.SlotsPerGrid);
+	}
 }
 
-int32 RogueStationQueueUtility::ClaimWaitingSlot(FRogueStationQueueFragment* QueueFragment, const int32 WaitingPointIdx, const FMassEntityHandle& Passenger, FVector& OutSlotPos)
+int32 RogueStationQueueUtility::ClaimWaitingSlot(const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment* QueueFragment, const int32 WaitingPointIdx,
+	const FMassEntityHandle& Passenger, FVector& OutSlotPos)
 {
 	FRogueWaitingGrid* Grid = QueueFragment->Grids.Find(WaitingPointIdx);
 	if (!Grid) return INDEX_NONE;
@@ -53,7 +104,7 @@ int32 RogueStationQueueUtility::ClaimWaitingSlot(FRogueStationQueueFragment* Que
 			{
 				SlotIdx = TestIdx;
 				Grid->OccupiedBy[SlotIdx] = Passenger;
-				OutSlotPos = Grid->SlotPositions[SlotIdx];
+				OutSlotPos = Layout.GetSlotPosition(WaitingPointIdx, SlotIdx);
 				return SlotIdx;
 			}
 		}
@@ -68,20 +119,20 @@ int32 RogueStationQueueUtility::ClaimWaitingSlot(FRogueStationQueueFragment* Que
 		if (!Grid->OccupiedBy[i].IsValid())
 		{
 			Grid->OccupiedBy[i] = Passenger;
-			OutSlotPos = Grid->SlotPositions[i];
+			OutSlotPos = Layout.GetSlotPosition(WaitingPointIdx, i);
 			return i;
 		}
 	}
 	return INDEX_NONE;
 }
 
-void RogueStationQueueUtility::ReleaseSlot(FRogueStationQueueFragment& QueueFragment, const FRoguePassengerFragment& PassengerFragment)
+void RogueStationQueueUtility::ReleaseSlot(FRogueStationQueueFragment& QueueFragment, const FRoguePassengerTripFragment& TripFragment)
 {
-	if (FRogueWaitingGrid* Grid = QueueFragment.Grids.Find(PassengerFragment.WaitingPointIdx))
+	if (FRogueWaitingGrid* Grid = QueueFragment.Grids.Find(TripFragment.GetWaitingPointIdx()))
 	{
-		if (Grid->IsValidSlotIndex(PassengerFragment.WaitingSlotIdx))
+		if (Grid->IsValidSlotIndex(TripFragment.GetWaitingSlotIdx()))
 		{
-			Grid->OccupiedBy[PassengerFragment.WaitingSlotIdx] = FMassEntityHandle();
+			Grid->OccupiedBy[TripFragment.GetWaitingSlotIdx()] = FMassEntityHandle();
 		}
 	}
 }
@@ -115,9 +166,11 @@ void RogueStationQueueUtility::ReleaseSlot(FRogueStationQueueFragment& QueueFrag
 	return false;
 }*/
 
-bool RogueStationQueueUtility::PeekFromGrid(const FMassEntityManager& EntityManger, FRogueStationQueueFragment& QueueFragment, const int32 WaitPointIdx,
-	FMassEntityHandle& OutPassenger, const FMassEntityHandle CurrentStationEntity, int32& OutSlotIdx, FVector& OutSlotPos)
+bool RogueStationQueueUtility::PeekFromGrid(const FMassEntityManager& EntityManger, const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment& QueueFragment, const int32 WaitPointIdx,
+	FMassEntityHandle& OutPassenger, const int32 CurrentStationIdx, int32& OutSlotIdx, FVector& OutSlotPos)
 {
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_RogueGridPeek, GRogueVerboseStats);
+	
 	FRogueWaitingGrid* Grid = QueueFragment.Grids.Find(WaitPointIdx);
 	if (!Grid) return false;
 
@@ -126,13 +179,15 @@ bool RogueStationQueueUtility::PeekFromGrid(const FMassEntityManager& EntityMang
 	{
 		if (Grid->OccupiedBy[i].IsValid())
 		{
-			if (const auto PassengerFragment = EntityManger.GetFragmentDataPtr<FRoguePassengerFragment>(Grid->OccupiedBy[i]))
+			const auto PassengerFragment = EntityManger.GetFragmentDataPtr<FRoguePassengerFragment>(Grid->OccupiedBy[i]);
+			const auto TripFragment = EntityManger.GetFragmentDataPtr<FRoguePassengerTripFragment>(Grid->OccupiedBy[i]);
+			if (PassengerFragment && TripFragment)
 			{
-				if (!PassengerFragment->bWaiting || PassengerFragment->OriginStation != CurrentStationEntity) continue;
+				if (!PassengerFragment->bWaiting || TripFragment->GetOriginStationIdx() != CurrentStationIdx) continue;
 				
 				OutPassenger = Grid->OccupiedBy[i];
 				OutSlotIdx = i;
-				OutSlotPos = Grid->SlotPositions.IsValidIndex(i) ? Grid->SlotPositions[i] : FVector::ZeroVector;
+				OutSlotPos = Layout.GetSlotPosition(WaitPointIdx, i);
 				return true;
 			}
 			
@@ -0,0 +1,125 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/RogueTrackBVH.h"
+#include "Components/SplineComponent.h"
+
+void FRogueTrackSegmentBVH::Build(const USplineComponent& Spline, float SegmentLength)
+{
+	Reset();
+	
+	const double TrackLength = Spline.GetSplineLength();
+	if (TrackLength <= 0.0) return;
+	
+	SegmentLength = FMath::Max(1.f, SegmentLength);
+	const int32 NumSegments = FMath::Max(1, FMath::CeilToInt(TrackLength / SegmentLength));
+	const double Step = TrackLength / NumSegments;
+
+	// Uniform arc length samples, the last segment ends on the spline end (start point again for loops)
+	Segments.SetNumUninitialized(NumSegments);
+	FVector Prev = Spline.GetLocationAtDistanceAlongSpline(0.f, ESplineCoordinateSpace::World);
+	for (int32 i = 0; i < NumSegments; ++i)
+	{
+		const double EndDist = (i + 1 == NumSegments) ? TrackLength : (i + 1) * Step;
+		const FVector Next = Spline.GetLocationAtDistanceAlongSpline(static_cast<float>(EndDist), ESplineCoordinateSpace::World);
+
+		FSegment& Segment = Segments[i];
+		Segment.Start = Prev;
+		Segment.End = Next;
+		Segment.StartDistance = i * Step;
+		Segment.Length = EndDist - Segment.StartDistance;
+		Prev = Next;
+	}
+
+	// Leaves hold at least two segments after a split, so the node count stays under the segment count
+	Nodes.Reserve(NumSegments);
+	Nodes.AddDefaulted();
+	BuildNode(0, 0, NumSegments);
+}
+
+void FRogueTrackSegmentBVH::BuildNode(const int32 NodeIdx, const int32 First, const int32 Num)
+{
+	FBox Bounds(ForceInit);
+	FBox Centers(ForceInit);
+	for (int32 i = First; i < First + Num; ++i)
+	{
+		Bounds += Segments[i].Start;
+		Bounds += Segments[i].End;
+		Centers += 0.5 * (Segments[i].Start + Segments[i].End);
+	}
+	
+	Nodes[NodeIdx].Bounds = Bounds;
+	Nodes[NodeIdx].FirstSegment = First;
+	Nodes[NodeIdx].NumSegments = Num;
+	if (Num <= MaxLeafSegments) return;
+
+	// Median split on the widest axis of the segment centers
+	const FVector Extent = Centers.GetExtent();
+	const int32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	MakeArrayView(Segments.GetData() + First, Num).Sort([Axis](const FSegment& A, const FSegment& B)
+	{
+		return (A.Start[Axis] + A.End[Axis]) < (B.Start[Axis] + B.End[Axis]);
+	});
+
+	const int32 Half = Num / 2;
+	const int32 FirstChild = Nodes.Num();
+	Nodes.AddDefaulted(2);
+	Nodes[NodeIdx].FirstChild = FirstChild;
+	
+	BuildNode(FirstChild, First, Half);
+	BuildNode(FirstChild + 1, First + Half, Num - Half);
+}
+
+bool FRogueTrackSegmentBVH::FindClosest(const FVector& WorldPos, double& OutDistance, FVector* OutLocation, double* OutDistSq) const
+{
+	if (!IsValid()) return false;
+
+	double BestDistSq = DBL_MAX;
+	const FSegment* BestSegment = nullptr;
+	FVector BestPoint = FVector::ZeroVector;
+
+	// Tree depth is log2 of the segment count, 64 covers any track we can build
+	int32 Stack[64];
+	int32 StackSize = 0;
+	Stack[StackSize++] = 0;
+	
+	while (StackSize > 0)
+	{
+		const FNode& Node = Nodes[Stack[--StackSize]];
+		if (Node.Bounds.ComputeSquaredDistanceToPoint(WorldPos) >= BestDistSq) continue;
+
+		if (Node.FirstChild == INDEX_NONE)
+		{
+			for (int32 i = Node.FirstSegment; i < Node.FirstSegment + Node.NumSegments; ++i)
+			{
+				const FSegment& Segment = Segments[i];
+				const FVector Point = FMath::ClosestPointOnSegment(WorldPos, Segment.Start, Segment.End);
+				const double DistSq = FVector::DistSquared(Point, WorldPos);
+				if (DistSq < BestDistSq)
+				{
+					BestDistSq = DistSq;
+					BestSegment = &Segment;
+					BestPoint = Point;
+				}
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next and tightens the bound sooner
+		const int32 Left = Node.FirstChild;
+		const int32 Right = Node.FirstChild + 1;
+		const bool bLeftNearer = Nodes[Left].Bounds.ComputeSquaredDistanceToPoint(WorldPos) <= Nodes[Right].Bounds.ComputeSquaredDistanceToPoint(WorldPos);
+		Stack[StackSize++] = bLeftNearer ? Right : Left;
+		Stack[StackSize++] = bLeftNearer ? Left : Right;
+	}
+
+	if (!BestSegment) return false;
+
+	const double ChordLength = FVector::Dist(BestSegment->Start, BestSegment->End);
+	const double T = ChordLength > KINDA_SMALL_NUMBER ? FVector::Dist(BestSegment->Start, BestPoint) / ChordLength : 0.0;
+	OutDistance = BestSegment->StartDistance + T * BestSegment->Length;
+	if (OutLocation) *OutLocation = BestPoint;
+	if (OutDistSq) *OutDistSq = BestDistSq;
+	
+	return true;
+}
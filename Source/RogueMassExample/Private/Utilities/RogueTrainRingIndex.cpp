@@ -0,0 +1,160 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/RogueTrainRingIndex.h"
+#include "Utilities/RogueTrainUtility.h"
+
+void FRogueTrainRingIndex::Add(const FMassEntityHandle Entity, const double Distance, const float TrainLength)
+{
+	if (Slots.Contains(Entity))
+	{
+		Update(Entity, Distance, TrainLength);
+		return;
+	}
+
+	// Insert before the first train at or ahead of the new one so the ring stays ordered
+	// Past the last rank wraps back to the head slot, which is also right after the current furthest train
+	const int32 Rank = LowerBoundRank(Distance);
+	const int32 InsertAt = Entries.Num() == 0 ? 0 : (Head + Rank) % Entries.Num();
+	Entries.Insert({ Entity, Distance, TrainLength }, InsertAt);
+	
+	RebuildSlots();
+	Refresh();
+}
+
+bool FRogueTrainRingIndex::Remove(const FMassEntityHandle Entity)
+{
+	int32 Slot = INDEX_NONE;
+	if (!Slots.RemoveAndCopyValue(Entity, Slot)) return false;
+
+	Entries.RemoveAt(Slot, EAllowShrinking::No);
+	RebuildSlots();
+	Refresh();
+	return true;
+}
+
+bool FRogueTrainRingIndex::Update(const FMassEntityHandle Entity, const double Distance, const float TrainLength)
+{
+	const int32* Slot = Slots.Find(Entity);
+	if (!Slot) return false;
+
+	FEntry& Entry = Entries[*Slot];
+	Entry.Distance = Distance;
+	Entry.TrainLength = TrainLength;
+	return true;
+}
+
+void FRogueTrainRingIndex::Refresh()
+{
+	Head = 0;
+	const int32 Count = Entries.Num();
+	if (Count <= 1) return;
+
+	// A valid ring has at most one descent, the slot after it is the head
+	int32 Descents = 0;
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const int32 Next = (i + 1) % Count;
+		if (Entries[Next].Distance < Entries[i].Distance)
+		{
+			++Descents;
+			Head = Next;
+		}
+	}
+	if (Descents <= 1) return;
+
+	// Order broke (teleport or overtaking), fall back to a full sort
+	Entries.Sort([](const FEntry& A, const FEntry& B) { return A.Distance < B.Distance; });
+	Head = 0;
+	RebuildSlots();
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::Find(const FMassEntityHandle Entity) const
+{
+	const int32* Slot = Slots.Find(Entity);
+	return Slot ? &Entries[*Slot] : nullptr;
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::GetAhead(const FMassEntityHandle Entity) const
+{
+	const int32* Slot = Slots.Find(Entity);
+	if (!Slot || Entries.Num() < 2) return nullptr;
+	
+	return &Entries[(*Slot + 1) % Entries.Num()];
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::GetBehind(const FMassEntityHandle Entity) const
+{
+	const int32* Slot = Slots.Find(Entity);
+	if (!Slot || Entries.Num() < 2) return nullptr;
+	
+	return &Entries[(*Slot + Entries.Num() - 1) % Entries.Num()];
+}
+
+int32 FRogueTrainRingIndex::LowerBoundRank(const double Distance) const
+{
+	// Binary search over ranks, rank 0 is the head so ranks are sorted by distance
+	int32 Low = 0;
+	int32 High = Entries.Num();
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (At(Mid).Distance < Distance) Low = Mid + 1;
+		else High = Mid;
+	}
+	return Low;
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::FindFirstAhead(const double Distance) const
+{
+	if (Entries.Num() == 0) return nullptr;
+
+	const int32 Rank = LowerBoundRank(Distance);
+	return &At(Rank % Entries.Num());
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::FindFirstBehind(const double Distance) const
+{
+	if (Entries.Num() == 0) return nullptr;
+
+	const int32 Rank = LowerBoundRank(Distance);
+	return &At((Rank + Entries.Num() - 1) % Entries.Num());
+}
+
+const FRogueTrainRingIndex::FEntry* FRogueTrainRingIndex::FindNearest(const double Distance) const
+{
+	const FEntry* Ahead = FindFirstAhead(Distance);
+	const FEntry* Behind = FindFirstBehind(Distance);
+	if (!Ahead || !Behind) return nullptr;
+
+	const double ToAhead = RogueTrainUtility::ArcDistanceWrapped(Distance, Ahead->Distance, TrackLength);
+	const double FromBehind = RogueTrainUtility::ArcDistanceWrapped(Behind->Distance, Distance, TrackLength);
+	return ToAhead <= FromBehind ? Ahead : Behind;
+}
+
+void FRogueTrainRingIndex::FindInRange(const double Distance, const double BehindCm, const double AheadCm, TArray<FMassEntityHandle>& Out) const
+{
+	const int32 Count = Entries.Num();
+	if (Count == 0 || TrackLength <= 0.0) return;
+
+	// Walk forward from the first train in range, the window can wrap past the track end
+	const double Span = FMath::Min(BehindCm + AheadCm, TrackLength);
+	const double Start = RogueTrainUtility::WrapTrackDistance(Distance - BehindCm, TrackLength);
+	const int32 FirstRank = LowerBoundRank(Start);
+	for (int32 Step = 0; Step < Count; ++Step)
+	{
+		const FEntry& Entry = At((FirstRank + Step) % Count);
+		if (RogueTrainUtility::ArcDistanceWrapped(Start, Entry.Distance, TrackLength) > Span) break;
+		
+		Out.Add(Entry.Entity);
+	}
+}
+
+void FRogueTrainRingIndex::RebuildSlots()
+{
+	Slots.Reset();
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		Slots.Add(Entries[i].Entity, i);
+	}
+}
@@ -2,22 +2,22 @@
 
 
 #include "Utilities/RogueTrainUtility.h"
+#include "RogueMassExample.h"
 #include "Components/SplineComponent.h"
 #include "Data/RogueDeveloperSettings.h"
 
+DECLARE_CYCLE_STAT(TEXT("Spline Sample"), STAT_RogueSplineSample, STATGROUP_RogueSim);
+
 using namespace RogueTrainUtility;
 
-int32 RogueTrainUtility::FindNextStation(const USplineComponent& Spline,const TArray<FRoguePlatformData>& Platforms, const float CurrentAlpha)
+int32 RogueTrainUtility::FindNextStation(const TArray<FRoguePlatformData>& Platforms, const double CurrentDistance, const double TrackLength)
 {
 	int32 BestIdx = INDEX_NONE;
-	float BestArc = FLT_MAX;
+	double BestArc = DBL_MAX;
 
 	for (int32 i = 0; i < Platforms.Num(); ++i)
 	{
-		const FVector Ref = Platforms[i].Center; 
-		const float StationAlpha = AlphaAtWorld(Spline, Ref);
-
-		const float Arc = ArcDistanceWrapped(CurrentAlpha, StationAlpha);
+		const double Arc = ArcDistanceWrapped(CurrentDistance, Platforms[i].TrackDistance, TrackLength);
 		if (Arc > KINDA_SMALL_NUMBER && Arc < BestArc) 
 		{
 			BestArc = Arc;
@@ -27,37 +27,35 @@ int32 RogueTrainUtility::FindNextStation(const USplineComponent& Spline,const TA
 	return BestIdx; 
 }
 
-float RogueTrainUtility::AlphaAtWorld(const USplineComponent& Spline, const FVector& WorldPos)
+double RogueTrainUtility::DistanceAtWorld(const FRogueTrackSharedFragment& Track, const FVector& WorldPos)
 {
-	const float Len  = FMath::Max(1.f, Spline.GetSplineLength());
-	const float Key  = Spline.FindInputKeyClosestToWorldLocation(WorldPos);
-	const float Dist = Spline.GetDistanceAlongSplineAtSplineInputKey(Key);
-	return FMath::Frac(Dist / Len);
+	double Distance = 0.0;
+	Track.SegmentBVH.FindClosest(WorldPos, Distance);
+	return Distance;
 }
 
-float RogueTrainUtility::ArcDistanceWrapped(const float FromAlpha, const float ToAlpha)
+double RogueTrainUtility::ArcDistanceWrapped(const double FromDistance, const double ToDistance, const double TrackLength)
 {
-	float d = ToAlpha - FromAlpha;
-	if (d < 0.f) d += 1.f;
+	double d = ToDistance - FromDistance;
+	if (d < 0.0) d += TrackLength;
 	return d; 
 }
 
-bool RogueTrainUtility::GetSplineSample(const FRogueTrackSharedFragment& Track, const float StationTrackAlpha,
+bool RogueTrainUtility::GetSplineSample(const FRogueTrackSharedFragment& Track, const double TrackDistance,
 	const float AlongOffsetCm, const float LateralOffsetCm, const float VerticalOffsetCm, FSplineStationSample& Out)
 {
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_RogueSplineSample, GRogueVerboseStats);
+	INC_DWORD_STAT(STAT_RogueSplineSamples);
+	
 	const USplineComponent* Spline = Track.Spline.Get();
 	if (!Spline) return false;
 
-	const float Len = FMath::Max(1.f, Track.TrackLength);
-	const float RawDist = StationTrackAlpha * Len + AlongOffsetCm;
-	float Dist = FMath::Fmod(RawDist, Len); 
-	if (Dist < 0.f) Dist += Len; 
+	const double Dist = WrapTrackDistance(TrackDistance + AlongOffsetCm, Track.TrackLength);
 
-	// Grab full transform at distance (world space)
-	const FTransform SplineTransform = Spline->GetTransformAtDistanceAlongSpline(Dist, ESplineCoordinateSpace::World);
+	// Grab full transform at distance (world space), the spline API is float so convert only here
+	const FTransform SplineTransform = Spline->GetTransformAtDistanceAlongSpline(static_cast<float>(Dist), ESplineCoordinateSpace::World);
 
 	Out.Distance = Dist;
-	Out.Alpha = (Len > 0.f) ? (Dist / Len) : 0.f;
 
 	// Basis
 	const FQuat SplineQuat = SplineTransform.GetRotation();
@@ -93,7 +91,7 @@ FVector RogueTrainUtility::SampleDockPoint(const USplineComponent& Spline, float
 	return Spline.GetLocationAtDistanceAlongSpline(Dist, ESplineCoordinateSpace::World);
 }
 
-void RogueTrainUtility::BuildPlatformSegment(const USplineComponent& Spline, const FRogueStationConfig& StationConfigData, FRoguePlatformData& Out)
+void RogueTrainUtility::BuildPlatformSegment(const USplineComponent& Spline, const FRogueTrackSegmentBVH& SegmentBVH, const FRogueStationConfig& StationConfigData, FRoguePlatformData& Out)
 {
 	const FTransform StationTransform = SampleTrackFrame(Spline, StationConfigData.TrackAlpha); // track frame
 	const FVector Fwd = StationTransform.GetRotation().GetForwardVector();
@@ -115,40 +113,18 @@ void RogueTrainUtility::BuildPlatformSegment(const USplineComponent& Spline, con
 	Out.TrackOffset = StationConfigData.PlatformConfig.TrackOffset;
 	Out.TrackSide = StationConfigData.PlatformConfig.Side;
 	
-	const float TrackLength = Spline.GetSplineLength();
-	const FVector DockPos = Out.End - Out.Fwd * 200.f;
-	const float DockDist = Spline.GetDistanceAlongSplineAtLocation(DockPos, ESplineCoordinateSpace::World);
-	Out.DockAlpha = (TrackLength > 0.f) ? RogueTrainUtility::WrapTrackAlpha(DockDist / TrackLength) : StationConfigData.TrackAlpha;
-
-	// Bake waiting/spawn points aligned to the platform
-	Out.WaitingPoints.Reset();
-	Out.SpawnPoints.Reset();
-
-	// Set waiting points along platform
-	const float Inset = FMath::Clamp(80.f, 0.f, PlatformHalfLength);
-	const float Span  = FMath::Max(0.f, StationConfigData.PlatformConfig.PlatformLength - 2.f * Inset);
-	const FVector A = Out.Center - Out.Fwd * (0.5f * Span);
-	const FVector B = Out.Center + Out.Fwd * (0.5f * Span);
-	const int32 WaitNum = FMath::Max(0, StationConfigData.PlatformConfig.WaitingPoints);
-	
-	for (int32 WaitIdx = 0; WaitIdx < WaitNum; ++WaitIdx)
-	{
-		const float t = (WaitNum <= 1) ? 0.5f : static_cast<float>(WaitIdx) / static_cast<float>(WaitNum-1);
-		Out.WaitingPoints.Add(FMath::Lerp(A, B, t));
-	}
-
-	// Set spawn points
-	const int32 SpawnNum = FMath::Max(0, StationConfigData.PlatformConfig.SpawnPoints);	
-	for (int32 SpawnIdx = 0; SpawnIdx < SpawnNum; ++SpawnIdx)
-	{
-		FVector Forward = SpawnIdx % 2 == 0 ? Out.Fwd : -Out.Fwd;
-		Out.SpawnPoints.Add(Out.Center + Forward  * (StationConfigData.PlatformConfig.SpawnPointDistance));
-	}
+	BakePlatformDistances(SegmentBVH, Out);
+}
 
-	Out.WaitingGridConfig = StationConfigData.WaitingGridConfig;
+void RogueTrainUtility::BakePlatformDistances(const FRogueTrackSegmentBVH& SegmentBVH, FRoguePlatformData& Platform)
+{
+	// Project once against the baked track, runtime code works in distance only
+	const FVector DockPos = Platform.End - Platform.Fwd * 200.f;
+	SegmentBVH.FindClosest(Platform.Center, Platform.TrackDistance);
+	SegmentBVH.FindClosest(DockPos, Platform.DockDistance);
 }
 
-void RogueTrainUtility::ComputeConsistPlacement(const FRogueTrackSharedFragment& Track, const float EngineHeadAlpha, const int32 NumCarriages, TArray<FRoguePlacedCar>& Out)
+void RogueTrainUtility::ComputeConsistPlacement(const FRogueTrackSharedFragment& Track, const double EngineHeadDistance, const int32 NumCarriages, const FRogueCarriageClassFragment& CarriageClass, TArray<FRoguePlacedCar>& Out)
 {
 	const auto* Settings = GetDefault<URogueDeveloperSettings>();
 	if (!Settings) return;
@@ -156,36 +132,26 @@ void RogueTrainUtility::ComputeConsistPlacement(const FRogueTrackSharedFragment&
 	Out.Reset();
 	if (!Track.IsValid()) return;
 
-	auto WrappedAlpha = [&](const float Dist){ return RogueTrainUtility::WrapTrackAlpha(Dist / Track.TrackLength); };
-
-	// Convert to spline distance
-	const float CarDist = EngineHeadAlpha * Track.TrackLength;
-
-	auto SampleAtDist = [&](const float Dist, const float RideHeight)->FRoguePlacedCar
+	auto SampleAtDist = [&](const double Dist, const float RideHeight)->FRoguePlacedCar
 	{
 		RogueTrainUtility::FSplineStationSample Sample;
-		const float Alpha = WrappedAlpha(Dist);
-		if (!RogueTrainUtility::GetSplineSample(Track, Alpha, Sample))
-			return { Alpha, FTransform::Identity };
+		const double Wrapped = WrapTrackDistance(Dist, Track.TrackLength);
+		if (!RogueTrainUtility::GetSplineSample(Track, Wrapped, Sample))
+			return { Wrapped, FTransform::Identity };
 
 		const FVector Up = Sample.Up.IsNearlyZero() ? FVector::UpVector : Sample.Up;
 		const FTransform Transform(FQuat::Identity, Sample.Location + Up * RideHeight, FVector::OneVector);
-		return { Alpha, Transform };
+		return { Wrapped, Transform };
 	};
 
 	// Engine center = head minus half engine length
-	const float EngineCenterDist = CarDist - 0.5f * Settings->EngineLength;
+	const double EngineCenterDist = EngineHeadDistance - 0.5 * Settings->EngineLength;
 	Out.Add(SampleAtDist(EngineCenterDist, Settings->EngineRideHeight));
 
-	// Walk backwards for carriages 
-	float Cursor = EngineCenterDist - 0.5f * Settings->EngineLength - Settings->CarriageSpacing;
-	for (int32 i = 0; i < NumCarriages; ++i)
+	// Walk backwards by the class spacing, the same offsets the carriage follow processor holds them at
+	for (int32 i = 1; i <= NumCarriages; ++i)
 	{
-		const float CarCenterDist = Cursor - 0.5f * Settings->CarriageLength;
-		Out.Add(SampleAtDist(CarCenterDist, Settings->CarriageRideHeight));
-
-		// move next car to rear face and subtract gap
-		Cursor = CarCenterDist - 0.5f * Settings->CarriageLength - Settings->CarriageSpacing;
+		Out.Add(SampleAtDist(EngineCenterDist - i * CarriageClass.Spacing, CarriageClass.RideHeight));
 	}
 }
 
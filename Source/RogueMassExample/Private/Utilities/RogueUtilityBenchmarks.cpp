@@ -0,0 +1,248 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RogueMassExample.h"
+#include "MassEntityManager.h"
+#include "Components/SplineComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Utilities/RoguePassengerUtility.h"
+#include "Utilities/RogueStationQueueUtility.h"
+#include "Utilities/RogueTrainUtility.h"
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Micro benchmarks for the hot utility helpers, run without PIE via rogue.Bench.Utilities.
+ * Inputs are built from a fixed seed at realistic sizes, results are logged and written as json to Saved/Profiling.
+ */
+namespace RogueUtilityBenchmarks
+{
+	constexpr int32 NumSamples = 9;
+	constexpr int32 NumInputs = 1024;
+	constexpr int32 SplinePoints = 10000;
+	constexpr double SplinePointSpacing = 500.0;
+	constexpr int32 NumPlatforms = 200;
+	constexpr int32 GridSlots = 500;
+	constexpr int32 CarriageOccupants = 200;
+
+	struct FResult
+	{
+		FString Name;
+		FString Input;
+		int32 Iterations = 0;
+		double MinNs = 0.0;
+		double MedianNs = 0.0;
+	};
+
+	// Keeps benchmarked results observable so the calls are not optimised away
+	static volatile double GSink = 0.0;
+
+	template<typename FuncType>
+	FResult Run(const TCHAR* Name, const FString& Input, const int32 Iterations, FuncType&& Func)
+	{
+		// Warm caches once before timing
+		for (int32 i = 0; i < FMath::Min(Iterations, NumInputs); ++i)
+		{
+			GSink = GSink + Func(i);
+		}
+
+		TArray<double, TInlineAllocator<NumSamples>> SampleNs;
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			double Accum = 0.0;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < Iterations; ++i)
+			{
+				Accum += Func(i);
+			}
+			
+			SampleNs.Add((FPlatformTime::Seconds() - StartTime) * 1e9 / Iterations);
+			GSink = GSink + Accum;
+		}
+		
+		SampleNs.Sort();
+
+		FResult Result;
+		Result.Name = Name;
+		Result.Input = Input;
+		Result.Iterations = Iterations;
+		Result.MinNs = SampleNs[0];
+		Result.MedianNs = SampleNs[NumSamples / 2];
+		return Result;
+	}
+
+	void RunAll(const int32 Iterations, TArray<FResult>& Out)
+	{
+		FRandomStream Random(1234);
+
+		// Closed circular track with the resampled point density the subsystem produces
+		TStrongObjectPtr<USplineComponent> Spline(NewObject<USplineComponent>(GetTransientPackage()));
+		const double Radius = SplinePoints * SplinePointSpacing / UE_DOUBLE_TWO_PI;
+		Spline->ClearSplinePoints(false);
+		for (int32 i = 0; i < SplinePoints; ++i)
+		{
+			const double Angle = UE_DOUBLE_TWO_PI * i / SplinePoints;
+			Spline->AddSplinePoint(FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.0), ESplineCoordinateSpace::Local, false);
+		}
+		Spline->SetClosedLoop(true, false);
+		Spline->UpdateSpline();
+
+		FRogueTrackSharedFragment Track;
+		Track.Spline = Spline.Get();
+		Track.TrackLength = Spline->GetSplineLength();
+
+		for (int32 i = 0; i < NumPlatforms; ++i)
+		{
+			FRoguePlatformData& Platform = Track.Platforms.AddDefaulted_GetRef();
+			Platform.TrackDistance = Track.TrackLength * (i + 0.5) / NumPlatforms;
+			Platform.DockDistance = Platform.TrackDistance;
+		}
+		Track.StationEntities.SetNum(NumPlatforms); // a station slot per platform or the fragment reads as invalid
+
+		TArray<double> Distances;
+		TArray<FVector> Locations;
+		for (int32 i = 0; i < NumInputs; ++i)
+		{
+			Distances.Add(Random.FRandRange(0.f, 1.f) * Track.TrackLength);
+			Locations.Add(FVector(Random.VRand() * Random.FRandRange(0.f, 2000.f)));
+		}
+
+		const FString SplineInput = FString::Printf(TEXT("%d spline points"), SplinePoints);
+		Out.Add(Run(TEXT("GetSplineSample"), SplineInput, Iterations, [&](const int32 i)
+		{
+			RogueTrainUtility::FSplineStationSample Sample;
+			RogueTrainUtility::GetSplineSample(Track, Distances[i % NumInputs], Sample);
+			return Sample.Location.X;
+		}));
+
+		Out.Add(Run(TEXT("FindNextStation"), FString::Printf(TEXT("%d platforms"), NumPlatforms), Iterations, [&](const int32 i)
+		{
+			return static_cast<double>(RogueTrainUtility::FindNextStation(Track.Platforms, Distances[i % NumInputs], Track.TrackLength));
+		}));
+
+		Out.Add(Run(TEXT("ArcDistanceWrapped"), TEXT("scalar"), Iterations, [&](const int32 i)
+		{
+			return RogueTrainUtility::ArcDistanceWrapped(Distances[i % NumInputs], Distances[(i + 1) % NumInputs], Track.TrackLength);
+		}));
+
+		const FRogueCarriageClassFragment CarriageClass;
+		TArray<FRoguePlacedCar> Placement;
+		Out.Add(Run(TEXT("ComputeConsistPlacement"), FString::Printf(TEXT("%s, 10 carriages"), *SplineInput), Iterations, [&](const int32 i)
+		{
+			RogueTrainUtility::ComputeConsistPlacement(Track, Distances[i % NumInputs], 10, CarriageClass, Placement);
+			return Placement.Num() > 0 ? Placement.Last().Distance : 0.0;
+		}));
+
+		// Waiting grid kept 90% full, each claim is released again so occupancy stays constant
+		FRogueStationLayoutFragment Layout;
+		Layout.WaitingPoints.Add(FVector::ZeroVector);
+		Layout.SlotsPerGrid = GridSlots;
+		FRogueStationQueueFragment QueueFragment;
+		FRogueWaitingGrid& Grid = QueueFragment.Grids.Add(0);
+		for (int32 i = 0; i < GridSlots; ++i)
+		{
+			Layout.SlotPositions.Add(FVector(i * 50.0, 0.0, 0.0));
+			Grid.OccupiedBy.Add(i < GridSlots * 9 / 10 ? FMassEntityHandle(i + 1, 1) : FMassEntityHandle());
+		}
+
+		Out.Add(Run(TEXT("ClaimWaitingSlot"), FString::Printf(TEXT("%d slots, 90%% occupied"), GridSlots), Iterations, [&](const int32 i)
+		{
+			FVector SlotPos;
+			const int32 SlotIdx = RogueStationQueueUtility::ClaimWaitingSlot(Layout, &QueueFragment, 0, FMassEntityHandle(GridSlots + 1, 1), SlotPos);
+			if (Grid.OccupiedBy.IsValidIndex(SlotIdx)) Grid.OccupiedBy[SlotIdx] = FMassEntityHandle();
+			return static_cast<double>(SlotIdx);
+		}));
+
+		// Standalone entity manager so peeks resolve real passenger fragments without touching a world
+		const TSharedRef<FMassEntityManager> EntityManager = MakeShareable(new FMassEntityManager());
+		EntityManager->Initialize();
+		{
+			const TArray<const UScriptStruct*> Composition = { FRoguePassengerFragment::StaticStruct(), FRoguePassengerTripFragment::StaticStruct() };
+			const FMassArchetypeHandle Archetype = EntityManager->CreateArchetype(Composition);
+			TArray<FMassEntityHandle> Passengers;
+			EntityManager->BatchCreateEntities(Archetype, GridSlots, Passengers);
+
+			// Only the back of the grid waits for this station, the scan walks most slots
+			constexpr uint16 Station = 1;
+			constexpr uint16 OtherStation = 2;
+			for (int32 i = 0; i < Passengers.Num(); ++i)
+			{
+				EntityManager->GetFragmentDataChecked<FRoguePassengerFragment>(Passengers[i]).bWaiting = true;
+				EntityManager->GetFragmentDataChecked<FRoguePassengerTripFragment>(Passengers[i]).OriginStationIdx = i >= GridSlots * 9 / 10 ? Station : OtherStation;
+				Grid.OccupiedBy[i] = Passengers[i];
+			}
+
+			Out.Add(Run(TEXT("PeekFromGrid"), FString::Printf(TEXT("%d slots, match at 90%%"), GridSlots), Iterations, [&](const int32 i)
+			{
+				FMassEntityHandle Passenger;
+				int32 SlotIdx = INDEX_NONE;
+				FVector SlotPos;
+				RogueStationQueueUtility::PeekFromGrid(*EntityManager, Layout, QueueFragment, 0, Passenger, Station, SlotIdx, SlotPos);
+				return static_cast<double>(SlotIdx);
+			}));
+		}
+		EntityManager->Deinitialize();
+
+		TArray<FVector> OccupantPositions;
+		for (int32 i = 0; i < CarriageOccupants; ++i)
+		{
+			OccupantPositions.Add(Random.VRand() * 1000.f);
+		}
+
+		Out.Add(Run(TEXT("FindNearestIndex"), FString::Printf(TEXT("%d points"), CarriageOccupants), Iterations, [&](const int32 i)
+		{
+			return static_cast<double>(RoguePassengerUtility::FindNearestIndex(OccupantPositions, Locations[i % NumInputs]));
+		}));
+
+		// Queue held at a constant length, every dequeue is followed by an enqueue
+		for (int32 i = 0; i < CarriageOccupants; ++i)
+		{
+			RoguePassengerQueueUtility::EnqueueAtWaitingPoint(QueueFragment, 0, FMassEntityHandle(i + 1, 1), INDEX_NONE, Random.FRand() * 100.f, Random.RandHelper(3));
+		}
+
+		Out.Add(Run(TEXT("DequeueFromWaitingPoint"), FString::Printf(TEXT("%d queued"), CarriageOccupants), Iterations, [&](const int32 i)
+		{
+			FRoguePassengerQueueEntry Entry;
+			RoguePassengerQueueUtility::DequeueFromWaitingPoint(QueueFragment, 0, Entry);
+			RoguePassengerQueueUtility::EnqueueAtWaitingPoint(QueueFragment, 0, Entry.Passenger, Entry.GetDestStationIdx(), Entry.EnqueuedGameTime + 100.f, Entry.Priority);
+			return static_cast<double>(Entry.EnqueuedGameTime);
+		}));
+	}
+
+	FString ToJson(const TArray<FResult>& Results)
+	{
+		FString Json = TEXT("[\n");
+		for (int32 i = 0; i < Results.Num(); ++i)
+		{
+			const FResult& Result = Results[i];
+			Json += FString::Printf(TEXT("  {\"name\": \"%s\", \"input\": \"%s\", \"iterations\": %d, \"min_ns\": %.2f, \"median_ns\": %.2f}%s\n"),
+				*Result.Name, *Result.Input, Result.Iterations, Result.MinNs, Result.MedianNs, i + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+		}
+		
+		return Json + TEXT("]\n");
+	}
+}
+
+static FAutoConsoleCommand GRogueBenchUtilitiesCmd(
+	TEXT("rogue.Bench.Utilities"),
+	TEXT("Micro benchmark the train, station queue and passenger utilities. Args: <Iterations=10000>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Iterations = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000);
+
+		TArray<RogueUtilityBenchmarks::FResult> Results;
+		RogueUtilityBenchmarks::RunAll(Iterations, Results);
+
+		for (const RogueUtilityBenchmarks::FResult& Result : Results)
+		{
+			UE_LOG(LogRogueSim, Display, TEXT("Bench %-24s %-32s min %8.1f ns  median %8.1f ns"), *Result.Name, *Result.Input, Result.MinNs, Result.MedianNs);
+		}
+
+		const FString JsonPath = FPaths::ProfilingDir() / TEXT("RogueUtilityBench.json");
+		FFileHelper::SaveStringToFile(RogueUtilityBenchmarks::ToJson(Results), *JsonPath);
+		UE_LOG(LogRogueSim, Display, TEXT("Bench results written to %s"), *JsonPath);
+	}));
+
+#endif
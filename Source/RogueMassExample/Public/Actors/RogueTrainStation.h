@@ -23,6 +23,11 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Station")
 	float GetStationAlpha() const { return StationAlpha; }
 
+	UFUNCTION(BlueprintCallable, Category="Station")
+	int32 GetStationLineIndex() const { return StationLineIndex; }
+
+	virtual void BeginPlay() override;
+
 #if WITH_EDITOR
 	virtual void OnConstruction(const FTransform& Transform) override;
 #endif
@@ -30,5 +35,10 @@ public:
 private:
 	UPROPERTY(EditAnywhere, Category="Station")
 	float StationAlpha = 0.f; 
+
+	// Track line the station projects onto, set with the alpha
+	UPROPERTY(VisibleAnywhere, Category="Station")
+	int32 StationLineIndex = 0;
+
 	void ComputeStationAlpha();
 };
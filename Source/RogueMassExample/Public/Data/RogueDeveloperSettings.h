@@ -23,6 +23,18 @@ public:
 	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings")
 	TSoftObjectPtr<AActor> TrackSplineActor;
 
+	/** Extra track lines, indexed from 1 after the main TrackSplineActor line */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings|Lines")
+	TArray<FRogueTrackLineConfig> AdditionalTrackLines;
+
+	/** Junctions trains can use to switch between track lines */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings|Lines")
+	TArray<FRogueTrackJunctionConfig> Junctions;
+
+	/** Seed for junction switch decisions, runs with the same seed take the same branches */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings|Lines")
+	int32 JunctionSeed = 0;
+
 	/** Maximum number of passengers allowed in the simulation at once */
 	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="0"))
 	int32 MaxPassengersOverall = 500;
@@ -31,9 +43,29 @@ public:
 	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="0"))
 	float SpawnIntervalSeconds = 0.25f;
 
+	/** Passengers spawned each spawn interval, raises demand beyond one passenger per frame */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="1"))
+	int32 PassengersPerSpawn = 1;
+
 	/** Interval between spawning new passengers */
 	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="0"))
 	float TrackSplineResampleStep = 500.f;
+
+	/** Segment length used to bake the track for world to track distance queries, smaller is more precise */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="1"))
+	float TrackQuerySegmentLength = 100.f;
+
+	/** Fixed rate in Hz for train and passenger simulation, 0 runs it every frame. Trains are interpolated between steps for rendering */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="0", UIMax="60"))
+	float SimulationTickRate = 20.f;
+
+	/** Maximum fixed simulation steps run in one frame, time beyond this is dropped after a hitch */
+	UPROPERTY(EditDefaultsOnly, Config, Category="Simulation Settings", meta=(ClampMin="1"))
+	int32 MaxSimStepsPerFrame = 4;
+
+	/** Simulated seconds per real second, applied as world time dilation. The step cap scales with it so fixed steps keep up */
+	UPROPERTY(EditAnywhere, Config, Category="Simulation Settings", meta=(ClampMin="0.01", UIMax="1000", ConsoleVariable="rogue.Sim.TimeScale"))
+	float SimulationTimeScale = 1.f;
 	
 	/** Maximum number of entities to spawn per frame to avoid hitches */
 	UPROPERTY(EditDefaultsOnly, Config, Category="Spawning", meta=(ClampMin="1"))
@@ -41,7 +73,7 @@ public:
 
 	/** Train, Carriage and Passenger Settings */
 	
-	/** Number of trains to simulate */
+	/** Number of trains to simulate on the main line */
 	UPROPERTY(EditDefaultsOnly, Config, Category="Trains", meta=(ClampMin="1"))
 	int32 NumTrains = 2;
 	
@@ -90,7 +122,7 @@ public:
 	float UnloadStartJitter = 0.15f;  
 
 	/** Maximum number of passengers per carriage */
-	UPROPERTY(EditDefaultsOnly, Config, Category="Trains|Carriages", meta=(ClampMin="0"))
+	UPROPERTY(EditDefaultsOnly, Config, Category="Trains|Carriages", meta=(ClampMin="0", ClampMax="65535"))
 	int32 MaxPassengersPerCarriage = 100;
 
 	/** Passengers destination acceptance radius */
@@ -141,6 +173,10 @@ public:
 	// Spawn throttle
 
 	// Debugging
+	/** Seconds between debug snapshot collections while the gameplay debugger requests them, 0 collects every frame */
+	UPROPERTY(EditAnywhere, Config, Category="Debug", meta=(ClampMin="0", UIMax="1"))
+	float DebugSnapshotInterval = 0.1f;
+	
 	UPROPERTY(EditDefaultsOnly, Config, Category="Debug|Stations")
 	bool bDrawStationSpawnPoints = false;
 	
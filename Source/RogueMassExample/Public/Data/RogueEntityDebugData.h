@@ -8,6 +8,139 @@
 #include "Mass/Fragments/RogueFragments.h"
 #include "RogueEntityDebugData.generated.h"
 
+/** Snapshot kinds a debug consumer can request, collected independently */
+enum class ERogueDebugSnapshot : uint8
+{
+	None		= 0,
+	Passengers	= 1 << 0,
+	Trains		= 1 << 1,
+	Carriages	= 1 << 2,
+	Stations	= 1 << 3
+};
+ENUM_CLASS_FLAGS(ERogueDebugSnapshot)
+
+/** Recycled debug slot indices, slots return to the free list when their entity goes back to the pool */
+struct FRogueDebugSlotAllocator
+{
+	int32 Acquire() { return FreeSlots.Num() > 0 ? FreeSlots.Pop(EAllowShrinking::No) : Capacity++; }
+	void Release(const int32 Slot) { if (Slot >= 0 && Slot < Capacity) FreeSlots.Push(Slot); }
+	int32 GetCapacity() const { return Capacity; }
+
+private:
+	TArray<int32> FreeSlots;
+	int32 Capacity = 0;
+};
+
+/** View a debug consumer looks through, snapshot rows outside it are not collected */
+struct FRogueDebugView
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Forward = FVector::ForwardVector;
+	float CosHalfFOV = -1.f;	// -1 accepts every direction
+	float MaxDistance = 0.f;	// 0 disables the distance cull
+
+	bool IsVisible(const FVector& Location) const
+	{
+		const FVector ToLocation = Location - Origin;
+		const double DistSq = ToLocation.SizeSquared();
+		if (MaxDistance > 0.f && DistSq > FMath::Square(MaxDistance)) return false;
+		if (DistSq < UE_KINDA_SMALL_NUMBER) return true;
+		
+		return FVector::DotProduct(ToLocation, Forward) >= CosHalfFOV * FMath::Sqrt(DistSq);
+	}
+};
+
+/** Uniform XY grid over snapshot row positions, rebuilt on publish and reused between builds */
+struct ROGUEMASSEXAMPLE_API FRogueDebugSpatialIndex
+{
+	void Build(TConstArrayView<int32> Rows, TConstArrayView<FVector> Positions);
+
+	/**
+	 * Row closest to the ray within the current best miss distance, walking the ray one cell at a time.
+	 * Returns INDEX_NONE and leaves InOutBestMissSq untouched when nothing beats it, so kinds can be chained.
+	 */
+	int32 PickAlongRay(const FVector& Origin, const FVector& Direction, const float MaxDistance, double& InOutBestMissSq) const;
+
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	struct FEntry
+	{
+		uint64 Cell = 0;
+		int32 Row = INDEX_NONE;
+		FVector Position = FVector::ZeroVector;
+	};
+
+	static constexpr double CellSize = 1000.0;
+	
+	static FIntPoint ToCell(const FVector& Location)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	}
+	static uint64 CellKey(const FIntPoint& Cell) { return (static_cast<uint64>(static_cast<uint32>(Cell.X)) << 32) | static_cast<uint32>(Cell.Y); }
+
+	TArray<FEntry> Entries; // sorted by cell
+};
+
+/**
+ * Persistent front/back snapshot arrays. The debug processor fills rows of the back buffer in place and publishes
+ * it by flipping the index, rows keep their capacity between collections so a steady state collect never allocates.
+ * Only rows listed by GetFrontRows were written by the last collect, the rest are free or outside the view.
+ */
+template<typename T>
+struct TRogueDebugSnapshotBuffer
+{
+	const TArray<T>& GetFront() const { return Buffers[FrontIndex]; }
+	TConstArrayView<int32> GetFrontRows() const { return Written[FrontIndex]; }
+	const FRogueDebugSpatialIndex& GetFrontIndex() const { return Index[FrontIndex]; }
+
+	void BeginWrite(const int32 Num)
+	{
+		const int32 Back = FrontIndex ^ 1;
+		Buffers[Back].SetNum(Num, EAllowShrinking::No);
+		Written[Back].Reset();
+	}
+
+	T& WriteRow(const int32 Row)
+	{
+		const int32 Back = FrontIndex ^ 1;
+		Written[Back].Add(Row);
+		return Buffers[Back][Row];
+	}
+
+	int32 GetBackNum() const { return Buffers[FrontIndex ^ 1].Num(); }
+
+	void Publish()
+	{
+		const int32 Back = FrontIndex ^ 1;
+		Positions.Reset();
+		for (const int32 Row : Written[Back])
+		{
+			Positions.Add(Buffers[Back][Row].WorldPos);
+		}
+		
+		Index[Back].Build(Written[Back], Positions);
+		FrontIndex = Back;
+	}
+
+	void Reserve(const int32 Num)
+	{
+		for (int32 i = 0; i < 2; ++i)
+		{
+			Buffers[i].Reserve(Num);
+			Written[i].Reserve(Num);
+		}
+		Positions.Reserve(Num);
+	}
+
+private:
+	TArray<T> Buffers[2];
+	TArray<int32> Written[2];
+	FRogueDebugSpatialIndex Index[2];
+	TArray<FVector> Positions;
+	int32 FrontIndex = 0;
+};
+
 USTRUCT()
 struct FRogueDebugMove
 {
@@ -39,7 +172,7 @@ struct FRogueDebugTrain
 	FMassEntityHandle Entity;
 
 	// Motion / path
-	float Alpha = 0.f;          // [0..1]
+	double Distance = 0.0;      // cm along track
 	float Speed = 0.f;          // cm/s
 	FVector WorldPos = FVector::ZeroVector;
 
@@ -68,7 +201,7 @@ struct FRogueDebugCarriage
 	float Spacing = 0;
 
 	// Path sample (optional)
-	float Alpha = 0.f;
+	double Distance = 0.0;
 	float Speed = 0.f;
 	FVector WorldPos = FVector::ZeroVector;
 };
@@ -81,9 +214,9 @@ struct FRogueDebugPassenger
 	// Identity
 	FMassEntityHandle Entity;
 
-	// Trip
-	FMassEntityHandle OriginStation;
-	FMassEntityHandle DestStation;
+	// Trip, global station indices
+	int32 OriginStationIdx = INDEX_NONE;
+	int32 DestStationIdx = INDEX_NONE;
 
 	// Waiting/grid
 	int32 WaitingPointIdx = INDEX_NONE;
@@ -5,8 +5,10 @@
 #include "CoreMinimal.h"
 #include "MassEntityHandle.h"
 #include "MassEntityTypes.h"
+#include "Utilities/RogueTrackBVH.h"
 #include "RogueFragments.generated.h"
 
+class AActor;
 class USplineComponent;
 
 USTRUCT() struct ROGUEMASSEXAMPLE_API FRogueTrainEngineTag : public FMassTag { GENERATED_BODY() };
@@ -15,6 +17,16 @@ USTRUCT() struct ROGUEMASSEXAMPLE_API FRogueTrainStationTag : public FMassTag {
 USTRUCT() struct ROGUEMASSEXAMPLE_API FRogueTrainPassengerTag : public FMassTag { GENERATED_BODY() };
 USTRUCT() struct ROGUEMASSEXAMPLE_API FRoguePooledEntityTag : public FMassTag { GENERATED_BODY() };
 
+/** Narrow index storage for per entity data, the max value of the type stands in for INDEX_NONE */
+namespace RogueCompactIndex
+{
+	template<typename T>
+	FORCEINLINE int32 Expand(const T Value) { return Value == TNumericLimits<T>::Max() ? INDEX_NONE : static_cast<int32>(Value); }
+
+	template<typename T>
+	FORCEINLINE T Compact(const int32 Value) { return (Value < 0 || Value >= TNumericLimits<T>::Max()) ? TNumericLimits<T>::Max() : static_cast<T>(Value); }
+}
+
 UENUM()
 enum class ERoguePassengerPhase : uint8
 {
@@ -66,8 +78,8 @@ struct FRoguePlatformConfig
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	float SpawnPointDistance = 750.f;
 
-	// Waiting point density for passengers
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	// Waiting point density for passengers, passengers store the waiting point as a uint8
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0", ClampMax="254"))
 	int32 WaitingPoints = 10;
 	
 	// Spawn points for passengers
@@ -83,10 +95,11 @@ struct FRogueStationWaitingGridConfig
 {
 	GENERATED_BODY()
 	
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	// Cols * Rows stays below the uint16 slot index passengers store
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0", ClampMax="255"))
 	int32 GridCols = 4;
 	
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0", ClampMax="255"))
 	int32 GridRows = 2;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
@@ -107,6 +120,10 @@ struct FRogueStationConfig
 {
 	GENERATED_BODY()
 
+	// Track line this station sits on, 0 is the main TrackSplineActor line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	int32 LineIndex = 0;
+
 	// Normalized parameter on the track [0..1]
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0.0", ClampMax="1.0"))
 	float TrackAlpha = 0.f;
@@ -119,31 +136,67 @@ struct FRogueStationConfig
 	FRogueStationWaitingGridConfig WaitingGridConfig;
 };
 
+USTRUCT(BlueprintType)
+struct FRogueTrackLineConfig
+{
+	GENERATED_BODY()
+
+	// Actor containing the spline component for this line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TSoftObjectPtr<AActor> TrackSplineActor;
+
+	// Trains spawned on this line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	int32 NumTrains = 1;
+};
+
+USTRUCT(BlueprintType)
+struct FRogueTrackJunctionConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	int32 FromLine = 0;
+
+	// Normalized junction position on the from line [0..1]
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0.0", ClampMax="1.0"))
+	float FromAlpha = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0"))
+	int32 ToLine = 0;
+
+	// Normalized position trains continue from on the to line [0..1]
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0.0", ClampMax="1.0"))
+	float ToAlpha = 0.f;
+
+	// Chance a train passing the junction takes the diverging line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin="0.0", ClampMax="1.0"))
+	float SwitchChance = 0.5f;
+};
+
 USTRUCT()
 struct FRogueWaitingGrid
 {
 	GENERATED_BODY()
 
-	/** World-space slots centers, created once when stations are built */
-	TArray<FVector> SlotPositions;
-
-	/** Who is in each slot, or invalid if free */
+	/** Who is in each slot, or invalid if free, slot positions live in the station layout */
 	TArray<FMassEntityHandle> OccupiedBy;
 
-	FORCEINLINE bool IsValidSlotIndex(const int32 Idx) const { return SlotPositions.IsValidIndex(Idx); }
+	FORCEINLINE bool IsValidSlotIndex(const int32 Idx) const { return OccupiedBy.IsValidIndex(Idx); }
 };
 
+/** Queued passenger, the waiting point is the queue key so only the destination station index is kept */
 USTRUCT()
 struct ROGUEMASSEXAMPLE_API FRoguePassengerQueueEntry
 {
 	GENERATED_BODY()
 
-	
 	FMassEntityHandle Passenger = FMassEntityHandle();
-	FMassEntityHandle DestStation = FMassEntityHandle();
-	int32 WaitingPointIdx = INDEX_NONE;
 	float EnqueuedGameTime = 0.f;
-	int32 Priority = 0;
+	uint16 DestStationIdx = MAX_uint16; // global station index
+	int16 Priority = 0;
+
+	FORCEINLINE int32 GetDestStationIdx() const { return RogueCompactIndex::Expand(DestStationIdx); }
 };
 
 USTRUCT()
@@ -151,7 +204,7 @@ struct FStationRef
 {
 	GENERATED_BODY()
 	
-	float Alpha = 0.f; 
+	double Distance = 0.0; 
 	FMassEntityHandle Entity;
 };
 
@@ -162,9 +215,43 @@ struct ROGUEMASSEXAMPLE_API FRogueStationQueueFragment : public FMassFragment
 
 	TMap<int32, TArray<FRoguePassengerQueueEntry>> QueuesByWaitingPoint;
 	TMap<int32, FRogueWaitingGrid> Grids;
+};
+
+/** Static station layout, baked once with the platforms and const shared per station so station entities only carry occupancy */
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRogueStationLayoutFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	// Reflected so each station hashes to its own instance
+	UPROPERTY()
+	int32 StationIdx = INDEX_NONE;
+
+	UPROPERTY()
 	TArray<FVector> WaitingPoints;
-	TArray<FVector> SpawnPoints;	
+
+	UPROPERTY()
+	TArray<FVector> SpawnPoints;
+
+	UPROPERTY()
 	FRogueStationWaitingGridConfig WaitingGridConfig;
+
+	// World space slot centers of every waiting point grid back to back, SlotsPerGrid each
+	UPROPERTY()
+	TArray<FVector> SlotPositions;
+
+	UPROPERTY()
+	int32 SlotsPerGrid = 0;
+
+	FORCEINLINE TConstArrayView<FVector> GetGridSlots(const int32 WaitingPointIdx) const
+	{
+		return WaitingPoints.IsValidIndex(WaitingPointIdx) ? TConstArrayView<FVector>(SlotPositions).Slice(WaitingPointIdx * SlotsPerGrid, SlotsPerGrid) : TConstArrayView<FVector>();
+	}
+	FORCEINLINE FVector GetSlotPosition(const int32 WaitingPointIdx, const int32 SlotIdx) const
+	{
+		const TConstArrayView<FVector> Slots = GetGridSlots(WaitingPointIdx);
+		return Slots.IsValidIndex(SlotIdx) ? Slots[SlotIdx] : FVector::ZeroVector;
+	}
 };
 
 USTRUCT()
@@ -181,16 +268,15 @@ struct FRoguePlatformData
 	FVector Fwd = FVector::ForwardVector;
 	FVector Right = FVector::RightVector;
 	FVector Up = FVector::UpVector;
-	float DockAlpha = 0.f;
+	double DockDistance = 0.0; // cm along spline
 	float TrackOffset = 0.f;
 	float PlatformLength = 1000.f;
 	EPlatformSide TrackSide = EPlatformSide::Auto;
+	int32 LineIndex = 0;
 	
 	FTransform World = FTransform::Identity;
-	float Alpha = 0.f;   // normalized [0..1]
-	TArray<FVector> WaitingPoints;
-	TArray<FVector> SpawnPoints;
-	FRogueStationWaitingGridConfig WaitingGridConfig;
+	float Alpha = 0.f;   // normalized [0..1], config only
+	double TrackDistance = 0.0; // cm along spline
 };
 
 USTRUCT()
@@ -198,7 +284,8 @@ struct ROGUEMASSEXAMPLE_API FRogueTrainTrackFollowFragment : public FMassFragmen
 {
 	GENERATED_BODY()
 	
-	float Alpha = 0.f; // [0..1] along spline
+	double Distance = 0.0; // cm along spline [0..TrackLength)
+	double InterpFromDistance = 0.0; // distance before the last sim step, rendering blends from here to Distance
 	float Speed = 0.f;  // cm/s
 	FVector WorldPos = FVector::ZeroVector;
 	FVector WorldFwd = FVector::ForwardVector;
@@ -220,14 +307,21 @@ struct ROGUEMASSEXAMPLE_API FRogueTrainStateFragment : public FMassFragment
 	
 	bool bIsStopping = false;
 	bool bAtStation = false;
+	bool bTailOnFromLine = false; // still indexed on TransitFromLine until the tail clears the junction
 	ERogueStationTrainPhase StationTrainPhase = ERogueStationTrainPhase::NotStopped;
 	float HeadwaySpeedScale = 1.f;
 	float StationTimeRemaining = 0.f;  
-	float PrevAlpha = 0.f;  
+	double PrevDistance = 0.0;  
 	int32 TargetStationIdx = INDEX_NONE;
 	int32 PreviousStationIdx = INDEX_NONE;
 	float TrainLength = 0.f;
-	TArray<FMassEntityHandle> Carriages;
+	int32 ConsistId = INDEX_NONE; // carriages in the subsystem consist table
+
+	// Last junction crossed, carriages behind it keep following the from line up to the junction point
+	int32 TransitFromLine = INDEX_NONE;
+	int32 TransitToLine = INDEX_NONE;
+	double TransitFromDistance = 0.0;
+	double TransitToDistance = 0.0;
 };
 
 USTRUCT()
@@ -235,9 +329,26 @@ struct ROGUEMASSEXAMPLE_API FRogueTrainLinkFragment : public FMassFragment
 {
 	GENERATED_BODY()
 	
-	FMassEntityHandle LeadHandle;
+	int32 ConsistId = INDEX_NONE; // lead resolved through the subsystem consist table
 	int32 CarriageIndex = 0; // 0 reserved for lead
-	float Spacing = 8.f;
+};
+
+/** Carriage class, const shared so every carriage of a class references one instance and chunks group per class */
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRogueCarriageClassFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, meta=(ClampMin="0", ClampMax="65535"))
+	int32 Capacity = 100;
+
+	// Center to center distance between carriages in cm
+	UPROPERTY(EditAnywhere, meta=(ClampMin="0"))
+	float Spacing = 210.f;
+
+	// Rail to mesh pivot
+	UPROPERTY(EditAnywhere)
+	float RideHeight = 10.f;
 };
 
 USTRUCT()
@@ -245,27 +356,68 @@ struct ROGUEMASSEXAMPLE_API FRogueCarriageFragment : public FMassFragment
 {
 	GENERATED_BODY()
 	
-	int32 Capacity = 100;
-	TArray<FMassEntityHandle> Occupants;
+	int32 OccupantBlock = INDEX_NONE; // first block of this carriage's run in the subsystem occupant slab
 	float NextAllowedUnloadTime = 0.f;
-	int32 UnloadCursor = 0; 
+	uint16 NumOccupants = 0;
+	uint16 UnloadCursor = 0; // wraps, only used modulo the occupant count
+};
+
+/** Passenger movement class, const shared so walk values are read once per chunk */
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRoguePassengerMovementClassFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, meta=(ClampMin="0"))
+	float MaxSpeed = 150.f;
+
+	UPROPERTY(EditAnywhere, meta=(ClampMin="0"))
+	float AcceptanceRadius = 50.f;
 };
 
+/** Per tick movement state, read by the passenger movement loop every step */
 USTRUCT()
 struct ROGUEMASSEXAMPLE_API FRoguePassengerFragment : public FMassFragment
 {
 	GENERATED_BODY()
 	
-	FMassEntityHandle OriginStation = FMassEntityHandle();       
-	FMassEntityHandle DestinationStation = FMassEntityHandle();
-	int32 WaitingPointIdx = INDEX_NONE;
-	int32 WaitingSlotIdx = INDEX_NONE;
-	FMassEntityHandle VehicleHandle;
-	ERoguePassengerPhase Phase = ERoguePassengerPhase::ToStationWaitingPoint;
 	FVector Target = FVector::ZeroVector;
-	float AcceptanceRadius = 20.f;
-	float MaxSpeed = 200.f;
+	ERoguePassengerPhase Phase = ERoguePassengerPhase::ToStationWaitingPoint;
 	bool bWaiting = false;
+	float PhaseStartTime = 0.f; // world time of spawn while waiting, of boarding while riding. Sits in the FVector tail padding
+};
+
+/** Trip state, only touched on phase changes, by station ops and by debug queries */
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRoguePassengerTripFragment : public FMassFragment
+{
+	GENERATED_BODY()
+	
+	// Stations are global station indices, resolved to entities through the train subsystem
+	FMassEntityHandle VehicleHandle;
+	uint16 OriginStationIdx = MAX_uint16;
+	uint16 DestStationIdx = MAX_uint16;
+	uint16 WaitingSlotIdx = MAX_uint16;
+	uint8 WaitingPointIdx = MAX_uint8;
+
+	FORCEINLINE int32 GetOriginStationIdx() const { return RogueCompactIndex::Expand(OriginStationIdx); }
+	FORCEINLINE int32 GetDestStationIdx() const { return RogueCompactIndex::Expand(DestStationIdx); }
+	FORCEINLINE int32 GetWaitingPointIdx() const { return RogueCompactIndex::Expand(WaitingPointIdx); }
+	FORCEINLINE int32 GetWaitingSlotIdx() const { return RogueCompactIndex::Expand(WaitingSlotIdx); }
+	FORCEINLINE void SetWaitingPointIdx(const int32 Idx) { WaitingPointIdx = RogueCompactIndex::Compact<uint8>(Idx); }
+	FORCEINLINE void SetWaitingSlotIdx(const int32 Idx) { WaitingSlotIdx = RogueCompactIndex::Compact<uint16>(Idx); }
+	FORCEINLINE void ClearWaiting() { WaitingPointIdx = MAX_uint8; WaitingSlotIdx = MAX_uint16; }
+};
+
+/** Groups passengers into chunks per station, origin while waiting and destination once alighted */
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRoguePassengerStationSharedFragment : public FMassSharedFragment
+{
+	GENERATED_BODY()
+
+	// Only member, reflected so each station hashes to its own instance
+	UPROPERTY()
+	int32 StationIdx = INDEX_NONE;
 };
 
 USTRUCT()
@@ -275,28 +427,45 @@ struct FRogueDebugSlotFragment : public FMassFragment
 	int32 Slot = INDEX_NONE;
 };
 
-/** Shared fragments used in the Mass Train Example */
+struct FRogueTrackJunction
+{
+	double FromDistance = 0.0;
+	int32 ToLine = INDEX_NONE;
+	double ToDistance = 0.0;
+	float SwitchChance = 0.f;
+};
+
+/** Shared fragments used in the Mass Train Example, one instance per track line */
 USTRUCT()
 struct ROGUEMASSEXAMPLE_API FRogueTrackSharedFragment : public FMassSharedFragment
 {
 	GENERATED_BODY()
+
+	// Only reflected member, keeps the shared fragment hash unique per line
+	UPROPERTY()
+	int32 LineIndex = 0;
 	
 	TWeakObjectPtr<USplineComponent> Spline;
 	TArray<TPair<float, FMassEntityHandle>> StationEntities;
+	TArray<uint16> StationIndices; // global station index per local station
 	TArray<FRoguePlatformData> Platforms;
-	float TrackLength = 100000.f;
+	TArray<FRogueTrackJunction> Junctions;
+	FRogueTrackSegmentBVH SegmentBVH; // world to track distance queries
+	double TrackLength = 100000.0;
 
-	FORCEINLINE bool IsValid() const { return Spline.IsValid() && TrackLength > 0.f && StationEntities.Num() == Platforms.Num(); }
+	FORCEINLINE bool IsValid() const { return Spline.IsValid() && TrackLength > 0.0 && StationEntities.Num() == Platforms.Num(); }
 	FORCEINLINE FMassEntityHandle GetStationEntityByIndex(const int32 Index) const
 	{
 		return StationEntities.IsValidIndex(Index) ? StationEntities[Index].Value : FMassEntityHandle();
 	}
-	float GetStationAlphaByIndex(const int32 Index) const;
-	FORCEINLINE FMassEntityHandle GetRandomStationEntity() const
+	double GetStationDistanceByIndex(const int32 Index) const;
+	FORCEINLINE int32 GetGlobalStationIndex(const int32 Index) const
+	{
+		return StationIndices.IsValidIndex(Index) ? static_cast<int32>(StationIndices[Index]) : INDEX_NONE;
+	}
+	FORCEINLINE int32 GetRandomStationIndex() const
 	{
-		if (StationEntities.Num() == 0) return FMassEntityHandle();
-		const int32 Idx = FMath::RandHelper(StationEntities.Num());
-		return StationEntities[Idx].Value;
+		return StationEntities.Num() > 0 ? FMath::RandHelper(StationEntities.Num()) : INDEX_NONE;
 	}
 	FORCEINLINE int32 GetRandomDestinationStation(const FMassEntityHandle ExcludeStation) const
 	{
@@ -313,6 +482,6 @@ struct ROGUEMASSEXAMPLE_API FRogueTrackSharedFragment : public FMassSharedFragme
 
 struct FRoguePlacedCar
 {
-	float Alpha;
+	double Distance;
 	FTransform Transform;
 };
\ No newline at end of file
@@ -29,15 +29,15 @@ protected:
 	FMassEntityQuery EntityQuery;
 
 private:
-	static void AssignWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment, const FMassEntityHandle& Entity);
-	static void MoveToTarget(const FRoguePassengerFragment& PassengerFragment, FMassMoveTargetFragment& MoveTarget, const FMassMovementParameters& MoveParams,const FTransform& PTransform, const FVector& TargetDestination);
-	static void ToStationWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment,
+	static void AssignWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment, const FMassEntityHandle& Entity);
+	static void MoveToTarget(const FRoguePassengerMovementClassFragment& MovementClass, const FRoguePassengerFragment& PassengerFragment, FMassMoveTargetFragment& MoveTarget, const FMassMovementParameters& MoveParams,const FTransform& PTransform, const FVector& TargetDestination);
+	static void ToStationWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 		const FTransform& PTransform, const FMassEntityHandle PassengerHandle, const float Time);
-	static void ToAssignedCarriage(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, FRoguePassengerFragment& PassengerFragment,
+	static void ToAssignedCarriage(const FMassEntityManager& EntityManager, const FMassExecutionContext& Context, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 		const FTransform& PTransform, const FMassEntityHandle PassengerHandle);
-	static void UnloadAtStation(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment, const FTransform& PTransform);
-	static void ToPostUnloadWaitingPoint(const FMassEntityManager& EntityManager, FRoguePassengerFragment& PassengerFragment,
+	static void UnloadAtStation(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment, const FTransform& PTransform);
+	static void ToPostUnloadWaitingPoint(const FMassEntityManager& EntityManager, const URogueTrainWorldSubsystem& TrainSubsystem, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 		const FTransform& PTransform);
-	static void ToExitSpawn(const FMassEntityManager& EntityManager, URogueTrainWorldSubsystem& TrainSubsystem, const FMassExecutionContext& Context, FRoguePassengerFragment& PassengerFragment,
+	static void ToExitSpawn(const FMassEntityManager& EntityManager, URogueTrainWorldSubsystem& TrainSubsystem, const FMassExecutionContext& Context, const FRoguePassengerMovementClassFragment& MovementClass, FRoguePassengerFragment& PassengerFragment, FRoguePassengerTripFragment& TripFragment,
 		const FTransform& PTransform, const FMassEntityHandle PassengerHandle);
 };
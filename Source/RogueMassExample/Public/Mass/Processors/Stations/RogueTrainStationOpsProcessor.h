@@ -22,4 +22,7 @@ protected:
 	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
 
 	FMassEntityQuery EntityQuery;
+
+	// Passengers grouped per station, run over one station's chunks at a time to gather who can board
+	FMassEntityQuery StationPassengerQuery;
 };
@@ -0,0 +1,25 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "RogueTrainInterpolationProcessor.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class ROGUEMASSEXAMPLE_API URogueTrainInterpolationProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+	
+public:
+	URogueTrainInterpolationProcessor();
+	
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+};
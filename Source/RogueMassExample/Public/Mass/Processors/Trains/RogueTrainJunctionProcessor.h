@@ -0,0 +1,28 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "RogueTrainJunctionProcessor.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class ROGUEMASSEXAMPLE_API URogueTrainJunctionProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+	
+public:
+	URogueTrainJunctionProcessor();
+	
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+	FMassEntityQuery EntityQuery;
+
+	FRandomStream SwitchRandom;
+	bool bSwitchRandomSeeded = false;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "MassEntityTraitBase.h"
+#include "Mass/Fragments/RogueFragments.h"
 #include "RogueEntityTraitPassenger.generated.h"
 
 /**
@@ -16,4 +17,11 @@ class ROGUEMASSEXAMPLE_API URogueEntityTraitPassenger : public UMassEntityTraitB
 
 protected:
 	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+
+	/** Take walk values from the developer settings, clear to give this passenger config its own movement class */
+	UPROPERTY(EditAnywhere, Category="Rogue")
+	bool bUseDeveloperSettings = true;
+
+	UPROPERTY(EditAnywhere, Category="Rogue", meta=(EditCondition="!bUseDeveloperSettings"))
+	FRoguePassengerMovementClassFragment MovementClass;
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "MassEntityTraitBase.h"
+#include "Mass/Fragments/RogueFragments.h"
 #include "RogueEntityTraitTrainCarriage.generated.h"
 
 /**
@@ -16,4 +17,11 @@ class ROGUEMASSEXAMPLE_API URogueEntityTraitTrainCarriage : public UMassEntityTr
 
 protected:
 	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+
+	/** Take capacity, spacing and ride height from the developer settings, clear to give this carriage config its own class */
+	UPROPERTY(EditAnywhere, Category="Rogue")
+	bool bUseDeveloperSettings = true;
+
+	UPROPERTY(EditAnywhere, Category="Rogue", meta=(EditCondition="!bUseDeveloperSettings"))
+	FRogueCarriageClassFragment CarriageClass;
 };
@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Mass/Fragments/RogueFragments.h"
+#include "Utilities/RogueOccupantSlab.h"
+
+class URogueTrainWorldSubsystem;
+class URogueDeveloperSettings;
+
+/** Aggregate results, comparable with the counters of a Mass run over the same simulated time */
+struct ROGUEMASSEXAMPLE_API FRogueEventSimStats
+{
+	double SimulatedSeconds = 0.0;
+	int64 NumEvents = 0;
+	int64 TrainArrivals = 0;
+	int64 TrainDepartures = 0;
+	int64 Boardings = 0;
+	int64 Alightings = 0;
+	int64 PassengersSpawned = 0;
+	double TotalWaitSeconds = 0.0;
+	double TotalRideSeconds = 0.0;
+
+	double GetAverageWaitSeconds() const { return Boardings > 0 ? TotalWaitSeconds / Boardings : 0.0; }
+	FString ToString() const;
+
+	/** Per hour arrivals, boardings, alightings and the average wait agree with Other within a relative Tolerance, OutMismatch names the first that does not */
+	bool MatchesWithin(const FRogueEventSimStats& Other, const double Tolerance, FString& OutMismatch) const;
+};
+
+/**
+ * Discrete event backend for capacity studies. Runs the same train, carriage and station rules as the Mass
+ * processors but jumps from event to event instead of stepping frames, so long service periods take seconds.
+ * Trains, carriages and station queues reuse the Mass fragment structs, passengers and stations are referenced
+ * by synthetic handles whose index is their slot in this simulation.
+ * Not modelled: headway between trains and passenger walking time on platforms.
+ */
+class ROGUEMASSEXAMPLE_API FRogueEventSimulation
+{
+public:
+	/** Copy the baked lines and settings, returns false if the track is not ready */
+	bool Init(URogueTrainWorldSubsystem& TrainSubsystem, const URogueDeveloperSettings& Settings, const int32 Seed);
+	
+	/** Process events until simulated time reaches EndSeconds */
+	void RunUntil(const double EndSeconds);
+
+	double GetTime() const { return Now; }
+	const FRogueEventSimStats& GetStats() const { return Stats; }
+
+private:
+	enum class EEventType : uint8
+	{
+		PassengerSpawn,
+		TrainArrive,
+		UnloadTick,
+		LoadTick,
+		TrainDepart
+	};
+
+	struct FEvent
+	{
+		double Time = 0.0;
+		uint64 Sequence = 0; // keeps same time events in push order so runs are deterministic
+		EEventType Type = EEventType::PassengerSpawn;
+		int32 TrainIdx = INDEX_NONE;
+
+		bool operator<(const FEvent& Other) const { return Time != Other.Time ? Time < Other.Time : Sequence < Other.Sequence; }
+	};
+
+	struct FLine
+	{
+		double TrackLength = 0.0;
+		TArray<double> DockDistances;
+		int32 FirstStation = 0; // global station index of local station 0
+	};
+
+	struct FTrain
+	{
+		int32 LineIndex = 0;
+		double Distance = 0.0;
+		double ArrivalTime = 0.0;
+		FRogueTrainStateFragment State;
+		TArray<int32> CarriageIndices;
+	};
+
+	struct FPassenger
+	{
+		int32 DestStation = INDEX_NONE; // global station index
+		double SpawnTime = 0.0;
+		double BoardTime = 0.0;
+	};
+
+	// Settings snapshot
+	float CruiseSpeed = 500.f;
+	float ApproachSpeed = 250.f;
+	float StopRadius = 1000.f;
+	float DwellSeconds = 15.f;
+	float DepartureSeconds = 5.f;
+	float UnloadIntervalSeconds = 0.25f;
+	float LoadTickSeconds = 0.05f;
+	int32 MaxLoadPerTick = 4;
+	int32 CarriageCapacity = 100;
+	float SpawnIntervalSeconds = 0.25f;
+	int32 PassengersPerSpawn = 1;
+	int32 MaxPassengers = 500;
+
+	TArray<FLine> Lines;
+	TArray<FTrain> Trains;
+	TArray<FRogueCarriageFragment> Carriages;
+	FRogueOccupantSlab OccupantSlab;
+	TArray<FRogueStationQueueFragment> Stations;
+	TArray<FPassenger> Passengers;
+	TArray<int32> FreePassengers;
+	int32 LivePassengers = 0;
+
+	TArray<FEvent> Queue;
+	uint64 NextSequence = 0;
+	double Now = 0.0;
+	FRandomStream Random;
+	FRogueEventSimStats Stats;
+
+	void Push(const double Time, const EEventType Type, const int32 TrainIdx = INDEX_NONE);
+	double TravelTime(const double Arc) const;
+	int32 GlobalStation(const FTrain& Train) const { return Lines[Train.LineIndex].FirstStation + Train.State.TargetStationIdx; }
+
+	void HandlePassengerSpawn();
+	void SpawnPassenger();
+	void HandleTrainArrive(const int32 TrainIdx);
+	void HandleUnloadTick(const int32 TrainIdx);
+	void HandleLoadTick(const int32 TrainIdx);
+	void HandleTrainDepart(const int32 TrainIdx);
+};
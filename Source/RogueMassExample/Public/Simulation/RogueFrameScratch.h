@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+#include <atomic>
+
+/**
+ * Frame scratch for processor temporaries. Open a FRogueScratchScope around the work and build TRogueScratchArray
+ * containers inside it, their memory comes from the calling thread's FMemStack and is dropped in one step when the
+ * scope closes. Pages are recycled by the stack, so steady state use never reaches the heap. Nothing built in the
+ * scope may outlive it.
+ */
+struct FRogueScratchScope
+{
+	FRogueScratchScope() : Mark(FMemStack::Get()) {}
+
+private:
+	FMemMark Mark;
+};
+
+template <typename T>
+using TRogueScratchArray = TArray<T, TMemStackAllocator<>>;
+
+#define ROGUE_ALLOC_COUNTERS_ENABLED !UE_BUILD_SHIPPING
+
+#if ROGUE_ALLOC_COUNTERS_ENABLED
+
+/**
+ * Heap allocations made inside one named scope, read from the engine's malloc call counters.
+ * The counters are process wide, so allocations from other threads while the scope is open are included, and
+ * processors running in parallel count each other's allocations. Budgets are only enforced when the process runs
+ * single threaded (-onethread), see RogueAllocCounters::AreCountsAttributable.
+ * While counting, the scope's entries and inclusive cycles are kept too so captures can report time per processor.
+ */
+struct ROGUEMASSEXAMPLE_API FRogueAllocCounter
+{
+	explicit FRogueAllocCounter(const TCHAR* InName);
+
+	const TCHAR* Name;
+	std::atomic<uint32> FrameAllocs{0};
+	uint64 TotalAllocs = 0;
+	uint32 FramesWithAllocs = 0;
+	std::atomic<uint64> Cycles{0};
+	std::atomic<uint32> Calls{0};
+	FRogueAllocCounter* Next = nullptr;
+};
+
+struct ROGUEMASSEXAMPLE_API FRogueAllocCounterScope
+{
+	explicit FRogueAllocCounterScope(FRogueAllocCounter& InCounter);
+	~FRogueAllocCounterScope();
+
+private:
+	FRogueAllocCounter* Counter = nullptr;
+	uint64 StartCalls = 0;
+	uint64 StartCycles = 0;
+};
+
+/** One scope's totals since the capture began */
+struct FRogueScopeCaptureTotals
+{
+	const TCHAR* Name = nullptr;
+	uint64 Allocs = 0;
+	uint64 Cycles = 0;
+	uint32 Calls = 0;
+
+	double GetMilliseconds() const { return FPlatformTime::ToMilliseconds64(Cycles); }
+};
+
+namespace RogueAllocCounters
+{
+	/** Counting is on while rogue.Debug.CountAllocations is set or a capture is open */
+	ROGUEMASSEXAMPLE_API bool IsCounting();
+
+	/** Clears the totals and counts until EndCapture, which logs every scope that allocated and returns the sum */
+	ROGUEMASSEXAMPLE_API void BeginCapture();
+	ROGUEMASSEXAMPLE_API uint64 EndCapture();
+
+	/** Totals of every scope entered since BeginCapture, read before EndCapture resets them */
+	ROGUEMASSEXAMPLE_API void GetCaptureTotals(TArray<FRogueScopeCaptureTotals>& Out);
+
+	/** True when no other thread can allocate inside a scope, so its count is its own. Needs -onethread */
+	ROGUEMASSEXAMPLE_API bool AreCountsAttributable();
+}
+
+// Counts the heap allocations of the enclosing scope under Name, one branch when counting is off
+#define ROGUE_SCOPE_ALLOC_COUNTER(Name) \
+	static FRogueAllocCounter PREPROCESSOR_JOIN(RogueAllocCounter, __LINE__)(TEXT(Name)); \
+	const FRogueAllocCounterScope PREPROCESSOR_JOIN(RogueAllocCounterScope, __LINE__)(PREPROCESSOR_JOIN(RogueAllocCounter, __LINE__))
+
+#else
+
+#define ROGUE_SCOPE_ALLOC_COUNTER(Name)
+
+#endif
@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityHandle.h"
+#include "Trace/Trace.h"
+
+#define ROGUE_SIM_TRACE_ENABLED UE_TRACE_ENABLED
+
+/** Simulation events on the RogueSim trace channel. Entity, Other and Value per type are noted alongside */
+enum class ERogueSimTraceEvent : uint8
+{
+	TrainArrive,	// train, station, local station index
+	TrainDepart,	// train, station, local station index
+	Board,			// passenger, carriage, occupants after boarding
+	Alight,			// passenger, carriage, occupants after alighting
+	SlotClaim,		// passenger, station, slot index
+	SlotRelease,	// passenger, station, slot index
+	Spawn,			// entity, none, ERogueEntityType
+	PoolReuse,		// entity, none, ERogueEntityType
+	PoolReturn		// entity, none, ERogueEntityType
+};
+
+#if ROGUE_SIM_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(RogueSimChannel, ROGUEMASSEXAMPLE_API)
+
+namespace RogueSimTrace
+{
+	ROGUEMASSEXAMPLE_API void OutputEvent(const ERogueSimTraceEvent Type, const double SimTime, const FMassEntityHandle Entity, const FMassEntityHandle Other, const int32 Value);
+}
+
+// Off unless recording with -trace=RogueSim, the channel check is the only cost when disabled
+#define TRACE_ROGUE_SIM_EVENT(Type, SimTime, Entity, Other, Value) \
+	do { if (UE_TRACE_CHANNELEXPR_IS_ENABLED(RogueSimChannel)) { RogueSimTrace::OutputEvent(ERogueSimTraceEvent::Type, SimTime, Entity, Other, Value); } } while (0)
+
+#else
+
+#define TRACE_ROGUE_SIM_EVENT(Type, SimTime, Entity, Other, Value)
+
+#endif
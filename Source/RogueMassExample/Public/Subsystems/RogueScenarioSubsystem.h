@@ -0,0 +1,106 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Mass/Fragments/RogueFragments.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RogueScenarioSubsystem.generated.h"
+
+class URogueDeveloperSettings;
+
+UENUM()
+enum class ERogueScenarioPreset : uint8
+{
+	Small,
+	Medium,
+	Large,
+	Stress
+};
+
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRogueScenarioParams
+{
+	GENERATED_BODY()
+
+	int32 NumStations = 4;
+	int32 NumTrains = 2;
+	int32 CarriagesPerTrain = 3;
+	int32 MaxPassengers = 200;          // passenger demand cap
+	float SpawnIntervalSeconds = 0.25f;
+	int32 PassengersPerSpawn = 1;
+	float MinStationSpacing = 8000.f;   // cm of track between stations, grown to fit the trains
+	int32 Seed = 0;
+};
+
+/** Settings the scenario overrides, restored when the world is torn down */
+USTRUCT()
+struct FRogueScenarioSettingsBackup
+{
+	GENERATED_BODY()
+
+	TSoftObjectPtr<AActor> TrackSplineActor;
+	TArray<FRogueTrackLineConfig> AdditionalTrackLines;
+	TArray<FRogueTrackJunctionConfig> Junctions;
+	int32 JunctionSeed = 0;
+	TArray<FRogueStationConfig> Stations;
+	int32 NumTrains = 0;
+	int32 CarriagesPerTrain = 0;
+	int32 MaxPassengersOverall = 0;
+	float SpawnIntervalSeconds = 0.f;
+	int32 PassengersPerSpawn = 0;
+};
+
+/**
+ * Generates a repeatable benchmark scenario from a preset instead of the hand placed map content.
+ * Only created when the command line has -RogueScenario=<Small|Medium|Large|Stress>, the train subsystem
+ * applies it on begin play before reading the track and stations from settings.
+ * With -RogueScenarioFrames=<N> it samples frame times after a warmup and logs a perf report with entity counts.
+ * -RogueScenarioMaxAllocs=<N> fails the run when the counted simulation scopes allocate more than N times while measuring.
+ */
+UCLASS()
+class ROGUEMASSEXAMPLE_API URogueScenarioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Spawn the generated track and point the developer settings at it
+	void ApplyScenario(UWorld& InWorld);
+	
+	const FRogueScenarioParams& GetParams() const { return Params; }
+	static FRogueScenarioParams GetPreset(const ERogueScenarioPreset Preset);
+
+	// Run a scenario in worlds created while set, without the command line. Automation tests set it before creating their world
+	static void SetParamsOverride(const FRogueScenarioParams* InParams);
+
+private:
+	FRogueScenarioParams Params;
+	ERogueScenarioPreset Preset = ERogueScenarioPreset::Small;
+	FRogueScenarioSettingsBackup SettingsBackup;
+	bool bApplied = false;
+
+	UPROPERTY() AActor* TrackActor = nullptr;
+
+	// Perf run
+	int32 WarmupFrames = 300;
+	int32 MeasureFrames = 0;
+	int32 FramesSeen = 0;
+	int32 MaxSimAllocs = INDEX_NONE;
+	bool bReported = false;
+	bool bAllocBudgetExceeded = false;
+	TArray<float> FrameTimesMs;
+	double MeasureStartTime = 0.0;
+
+	void ParseCommandLine();
+	AActor* SpawnTrack(UWorld& InWorld, const double TrackLength) const;
+	void BuildStationConfigs(TArray<FRogueStationConfig>& Out) const;
+	void BackupSettings(const URogueDeveloperSettings& Settings);
+	void RestoreSettings(URogueDeveloperSettings& Settings) const;
+	void ReportPerfRun();
+};
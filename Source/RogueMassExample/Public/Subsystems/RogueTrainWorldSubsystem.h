@@ -4,8 +4,13 @@
 
 #include "CoreMinimal.h"
 #include "MassEntityTemplate.h"
+#include "Containers/RingBuffer.h"
 #include "Mass/Fragments/RogueFragments.h"
+#include "Simulation/RogueEventSimulation.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "Utilities/RogueConsistTable.h"
+#include "Utilities/RogueOccupantSlab.h"
+#include "Utilities/RogueTrainRingIndex.h"
 
 #if WITH_EDITOR
 #include "Data/RogueEntityDebugData.h"
@@ -15,6 +20,7 @@
 
 class ARogueTrainTrack;
 class UMassEntityConfigAsset;
+struct FMassCommandBuffer;
 class USplineComponent;
 
 UENUM()
@@ -25,51 +31,84 @@ enum class ERogueEntityType : uint8
 	TrainCarriage,
 	Passenger
 };
+constexpr int32 NumRogueEntityTypes = static_cast<int32>(ERogueEntityType::Passenger) + 1;
+
+// Follow up work run per configured entity of a spawn request
+UENUM()
+enum class ERogueSpawnContinuation : uint8
+{
+	None,
+	SpawnConsist // engine, enqueue its carriages from the spawn payload arena
+};
 
 USTRUCT()
-struct ROGUEMASSEXAMPLE_API FRogueStationData
+struct ROGUEMASSEXAMPLE_API FRogueTrackLine
 {
 	GENERATED_BODY()
-	
-	float Alpha = 0.f;
-	FVector WorldPos = FVector::ZeroVector;
-	TArray<FVector> WaitingPoints;
-	TArray<FVector> SpawnPoints;
-	FMassEntityHandle StationHandle = FMassEntityHandle();
+
+	TWeakObjectPtr<AActor> TrackActor;
+	TWeakObjectPtr<USplineComponent> Spline;
+	int32 NumTrains = 0;
+
+	// Global station indices on this line in track order, local index is the position in this array
+	TArray<int32> StationIndices;
+
+	// Mass shared fragment instance, trains and carriages on this line are chunked by it
+	FSharedStruct SharedFragment;
+
+	// Engines on this line in ring order, distances refreshed by the headway processor each frame
+	FRogueTrainRingIndex TrainIndex;
 };
 
+/**
+ * Plain data spawn command, copied through the per type rings without touching the heap.
+ * The template is resolved from Type, consist placements live in the subsystem payload arena and are referenced by range.
+ */
 USTRUCT()
 struct ROGUEMASSEXAMPLE_API FRogueSpawnRequest
 {
 	GENERATED_BODY()
 
 	ERogueEntityType Type = ERogueEntityType::Passenger;
-	const FMassEntityTemplate* EntityTemplate = nullptr;
+	ERogueSpawnContinuation Continuation = ERogueSpawnContinuation::None;
 	int32 RemainingCount = 0;
 
 	// Any
-	FTransform Transform = FTransform::Identity;
-	float StartAlpha = 0.f; 
+	FVector Location = FVector::ZeroVector;
+	FQuat4f Rotation = FQuat4f::Identity;
+	double StartDistance = 0.0; // cm along spline
+	int32 LineIndex = 0;
 
-	// Station
-	FRoguePlatformData PlatformData;
+	// Station, platform and layout are looked up by index
 	int32 StationIdx = INDEX_NONE;
 
 	// Carriage
 	FMassEntityHandle LeadHandle; 
 	int32 CarriageIndex = 1;      
-	float Spacing = 8.f;                  
-	int32 CarriageCapacity = 20;                 
+
+	// Engine, carriage placements in the payload arena [PayloadFirst, PayloadFirst + PayloadNum)
+	int32 PayloadFirst = INDEX_NONE;
+	int32 PayloadNum = 0;
 
 	// Passenger
-	FMassEntityHandle OriginStation = FMassEntityHandle();       
-	FMassEntityHandle DestinationStation = FMassEntityHandle();
+	int32 OriginStationIdx = INDEX_NONE; // global station index
+	int32 DestinationStationIdx = INDEX_NONE;
 	int32 WaitingPointIdx = INDEX_NONE;
-	float AcceptanceRadius = 20.f;
-	float MaxSpeed = 200.f;
+};
+
+USTRUCT()
+struct ROGUEMASSEXAMPLE_API FRogueSimClock
+{
+	GENERATED_BODY()
 
-	// Completion callback
-	TFunction<void(const TArray<FMassEntityHandle>& /*Spawned*/)> OnSpawned = nullptr;
+	double Accumulator = 0.0;
+	float StepDeltaTime = 0.f; // seconds per sim step
+	int32 NumSteps = 0;        // sim steps to run this frame, 0 skips simulation processors
+	float TimeScale = 1.f;     // world time dilation currently applied
+	float Alpha = 1.f;         // render blend between the previous and current sim state
+
+	FORCEINLINE bool ShouldStep() const { return NumSteps > 0; }
+	FORCEINLINE float GetFrameDeltaTime() const { return NumSteps * StepDeltaTime; }
 };
 
 /**
@@ -84,17 +123,56 @@ public:
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
 
-	USplineComponent* GetSpline() const { return TrackSpline.Get(); }
-	const TArray<FRogueStationData>& GetStations() const { return StationActorData; }
+	USplineComponent* GetSpline(const int32 LineIndex = 0) const { return Lines.IsValidIndex(LineIndex) ? Lines[LineIndex].Spline.Get() : nullptr; }
+	FMassEntityHandle GetStationEntity(const int32 StationIdx) const { const FMassEntityHandle* Entity = StationEntities.Find(StationIdx); return Entity ? *Entity : FMassEntityHandle(); }
+	const FRogueStationLayoutFragment* GetStationLayout(const int32 StationIdx) const { return StationLayouts.IsValidIndex(StationIdx) ? StationLayouts[StationIdx].GetPtr<FRogueStationLayoutFragment>() : nullptr; }
+
+	// Move a passenger into the chunks of a station, applied as a deferred shared fragment swap
+	void SetPassengerStation(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle Entity, const int32 StationIdx) const;
 
-	// Build shared track fragment
+	// Build shared track fragments, one per line
 	void BuildTrackSharedData(); 
 	void InvalidateTrackShared() { bTrackDirty = true; }
-	const FRogueTrackSharedFragment& GetTrackShared();
+	bool EnsureTrackShared();
+	const FRogueTrackSharedFragment& GetTrackShared(const int32 LineIndex = 0);
+	int32 GetNumTrackLines() const { return Lines.Num(); }
+	int32 GetNumTrainsOnLine(const int32 LineIndex) const { return Lines.IsValidIndex(LineIndex) ? Lines[LineIndex].NumTrains : 0; }
 	int32 GetTrackRevision() const { return TrackRevision; }
+
+	// Nearest track distance to a world point via the baked segment BVH, INDEX_NONE searches every line
+	bool FindNearestTrackDistance(const FVector& WorldPos, double& OutDistance, int32& OutLineIndex, const int32 LineIndex = INDEX_NONE) const;
+
+	// Fixed rate simulation clock, advanced once per frame on the game thread as the PrePhysics phase starts
+	const FRogueSimClock& GetSimClock() const { return SimClock; }
+
+	// Aggregates of this Mass run in the event simulation's shape, so both backends can be cross checked
+	const FRogueEventSimStats& GetRunStats() const { return RunStats; }
+	FRogueEventSimStats& GetMutableRunStats() { return RunStats; }
+
+	// Ring ordered engines per line for neighbour and range queries
+	const FRogueTrainRingIndex* GetTrainIndex(const int32 LineIndex) const { return Lines.IsValidIndex(LineIndex) ? &Lines[LineIndex].TrainIndex : nullptr; }
+	FRogueTrainRingIndex* GetMutableTrainIndex(const int32 LineIndex) { return Lines.IsValidIndex(LineIndex) ? &Lines[LineIndex].TrainIndex : nullptr; }
+
+	// Carriages of each train in train order, indexed by the consist id on the engine and carriage fragments
+	const FRogueConsistTable& GetConsists() const { return Consists; }
+
+	// Class every carriage is spawned with, read from the carriage template's const shared fragments
+	const FRogueCarriageClassFragment* GetCarriageClass() const;
+
+	// Occupants of every carriage, each carriage fragment keeps its block and count
+	FRogueOccupantSlab& GetOccupantSlab() { return OccupantSlab; }
+	const FRogueOccupantSlab& GetOccupantSlab() const { return OccupantSlab; }
+
+	// Move a train onto another line at a junction, applied as a deferred shared fragment swap.
+	// Carriages follow the from line up to the junction and switch as they cross it
+	void SwitchTrainLine(const FMassExecutionContext& Context, const FMassEntityHandle LeadHandle, const int32 FromLine, const FRogueTrackJunction& Junction, const double Overshoot);
+
+	// Move an engine or carriage into the chunks of a line, pushed into the caller's command buffer
+	void SetEntityTrackLine(FMassCommandBuffer& CommandBuffer, const FMassEntityHandle Entity, const int32 LineIndex) const;
 	
 	// Queue a spawn using the template you created from Dev Settings
 	void EnqueueSpawns(const FRogueSpawnRequest& Request);
+	int32 GetNumPendingSpawns() const;
 
 	// Pooling (generic)
 	void EnqueueEntityToPool(const FMassEntityHandle Entity, const FMassExecutionContext& Context, const ERogueEntityType Type);
@@ -105,9 +183,7 @@ public:
 	const FMassEntityTemplate* GetTrainTemplate() const;
 	const FMassEntityTemplate* GetCarriageTemplate() const;
 	const FMassEntityTemplate* GetPassengerTemplate() const; 
-	
-	TMap<FMassEntityHandle, int32> CarriageCounts;
-	TMap<FMassEntityHandle, TArray<FMassEntityHandle>> LeadToCarriages;
+	const FMassEntityTemplate* GetTemplateByType(const ERogueEntityType Type) const;
 
 protected:
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
@@ -119,14 +195,21 @@ protected:
 
 private:
 	TArray<ARogueTrainTrack*> TrackActors;
-	TWeakObjectPtr<USplineComponent> TrackSpline;
-	TArray<FRogueStationData> StationActorData;
+	TArray<FRogueTrackLine> Lines;
+	FRogueConsistTable Consists;
+	FRogueOccupantSlab OccupantSlab;
 	TMap<int32, FMassEntityHandle> StationEntities;
+	TMap<int32, FSharedStruct> StationPassengerGroups; // FRoguePassengerStationSharedFragment per station
 	TArray<FRoguePlatformData> Platforms;
-	TArray<FRogueSpawnRequest> PendingSpawns;
-	FRogueTrackSharedFragment CachedTrack;
+	TArray<FConstSharedStruct> StationLayouts; // FRogueStationLayoutFragment per station
+	TRingBuffer<FRogueSpawnRequest> PendingSpawns[NumRogueEntityTypes]; // FIFO per type, storage kept between bursts
+	TArray<FRoguePlacedCar> SpawnPayloads; // carriage placements of queued engines, reset once no engine is pending
+	TArray<FMassEntityHandle> SpawnScratch; // reused per batch
+	TArray<FMassEntityHandle> SpawnedScratch;
 	int32 TrackRevision = 0;
 	bool bTrackDirty = true;
+	FRogueSimClock SimClock;
+	FRogueEventSimStats RunStats;
 	TMap<ERogueEntityType, TArray<FMassEntityHandle>> EntityPool;
 	TMap<ERogueEntityType, TArray<FMassEntityHandle>> WorldEntities;
 	UPROPERTY() UMassEntityConfigAsset* StationConfig = nullptr;
@@ -144,10 +227,15 @@ private:
 	void SpawnManager();
 	void StopSpawnManager();
 	void InitEntityManagement();
+	void AdvanceSimClock(const float DeltaSeconds);
 	void DiscoverSplineFromSettings();
-	void GatherStationActors();
+	void AddTrackLine(AActor* TrackActor, const int32 NumTrains, const float ResampleStep);
+	void RebuildTrackBVH(const int32 LineIndex);
+	const FRogueTrackSegmentBVH* GetTrackBVH(const int32 LineIndex) const;
+	void IndexTrainOnLine(const FMassEntityHandle Entity, const int32 LineIndex, const double Distance, const float TrainLength);
+	void RemoveTrainFromIndex(const FMassEntityHandle Entity);
 	void CreateStations();
-	void ConfigureTrackToStation(const FRogueSpawnRequest& Request, const float ResampleDistance) const;
+	void ConfigureTrackToStation(const FRogueSpawnRequest& Request, const float ResampleDistance);
 	static void GetStationSide(const FRoguePlatformData& PlatformData, const FTransform& StationTransform, float& Out);
 	void BuildStationPlatformData();
 	void CreateTrains();
@@ -164,11 +252,13 @@ private:
 	void ConfigureTrain(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity);
 	void ConfigureCarriage(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity);
 	void ConfigurePassenger(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity);
+	void RunSpawnContinuation(const FRogueSpawnRequest& Request, const FMassEntityHandle Entity);
 	
 	TArray<FMassEntityHandle>& GetEntitiesFromPoolByType(const ERogueEntityType Type) {	return EntityPool.FindOrAdd(Type); }
 	TArray<FMassEntityHandle>& GetEntitiesFromWorldByType(const ERogueEntityType Type) { return WorldEntities.FindOrAdd(Type); }
 
 	FTimerHandle SpawnTimerHandle;
+	FDelegateHandle PhaseStartedHandle;
 
 public:
 	// Read-only accessors
@@ -180,26 +270,26 @@ public:
 
 #if WITH_EDITOR
 public:	
-	FORCEINLINE const TArray<FRogueDebugPassenger>& GetPassengerDebugSnapshot() { return PassengersDebugSnapshot; }
-	FORCEINLINE int32 GetPassengerDebugSlot() { return NextPassengerDebugSlot++; }
-	FORCEINLINE int32 GetPassengerDebugCapacity() const { return NextPassengerDebugSlot; }
-	FORCEINLINE void SetPassengerDebugSnapshot(TArray<FRogueDebugPassenger>&& Snapshot) { PassengersDebugSnapshot.Reset(); PassengersDebugSnapshot = MoveTemp(Snapshot); }
-	
-	FORCEINLINE const TArray<FRogueDebugTrain>& GetTrainDebugSnapshot() { return TrainsDebugSnapshot; }
-	FORCEINLINE int32 GetTrainDebugIndex() { return NextTrainDebugSlot++; }
-	FORCEINLINE int32 GetTrainDebugCapacity() const { return NextTrainDebugSlot; }
-	FORCEINLINE void SetTrainDebugSnapshot(TArray<FRogueDebugTrain>&& Snapshot) { TrainsDebugSnapshot.Reset(); TrainsDebugSnapshot = MoveTemp(Snapshot); }
+	FORCEINLINE const TRogueDebugSnapshotBuffer<FRogueDebugPassenger>& GetPassengerDebugSnapshot() const { return PassengersDebugSnapshot; }
+	FORCEINLINE const TRogueDebugSnapshotBuffer<FRogueDebugTrain>& GetTrainDebugSnapshot() const { return TrainsDebugSnapshot; }
+	FORCEINLINE const TRogueDebugSnapshotBuffer<FRogueDebugCarriage>& GetCarriageDebugSnapshot() const { return CarriagesDebugSnapshot; }
+	FORCEINLINE const TRogueDebugSnapshotBuffer<FRogueDebugStation>& GetStationDebugSnapshot() const { return StationsDebugSnapshot; }
+
+	FORCEINLINE TRogueDebugSnapshotBuffer<FRogueDebugPassenger>& GetPassengerDebugBuffer() { return PassengersDebugSnapshot; }
+	FORCEINLINE TRogueDebugSnapshotBuffer<FRogueDebugTrain>& GetTrainDebugBuffer() { return TrainsDebugSnapshot; }
+	FORCEINLINE TRogueDebugSnapshotBuffer<FRogueDebugCarriage>& GetCarriageDebugBuffer() { return CarriagesDebugSnapshot; }
+	FORCEINLINE TRogueDebugSnapshotBuffer<FRogueDebugStation>& GetStationDebugBuffer() { return StationsDebugSnapshot; }
+
+	int32 AcquireDebugSlot(const ERogueEntityType Type) { return DebugSlots.FindOrAdd(Type).Acquire(); }
+	void ReleaseDebugSlot(const ERogueEntityType Type, const int32 Slot) { DebugSlots.FindOrAdd(Type).Release(Slot); }
+	int32 GetDebugSlotCapacity(const ERogueEntityType Type) const { if (const auto* A = DebugSlots.Find(Type)) return A->GetCapacity(); return 0; }
+
+	/** Keep the requested snapshots alive, consumers call this every collect while they display them. Rows outside View are skipped */
+	void RequestDebugSnapshots(const ERogueDebugSnapshot Types, const FRogueDebugView& View = FRogueDebugView());
+	const FRogueDebugView& GetDebugView() const { return DebugView; }
+	/** True when Type has a live request and its collect interval elapsed, advances the next collect time */
+	bool ShouldCollectDebugSnapshot(const ERogueDebugSnapshot Type, const double Now);
 	
-	FORCEINLINE const TArray<FRogueDebugCarriage>& GetCarriageDebugSnapshot() { return CarriagesDebugSnapshot; }
-	FORCEINLINE int32 GetCarriageDebugIndex() { return NextCarriageDebugSlot++; }
-	FORCEINLINE int32 GetCarriageDebugCapacity() const { return NextCarriageDebugSlot; }
-	FORCEINLINE void SetCarriageDebugSnapshot(TArray<FRogueDebugCarriage>&& Snapshot) { CarriagesDebugSnapshot.Reset(); CarriagesDebugSnapshot = MoveTemp(Snapshot); }
-	
-	FORCEINLINE const TArray<FRogueDebugStation>& GetStationDebugSnapshot() { return StationsDebugSnapshot; }
-	FORCEINLINE int32 GetStationDebugIndex() { return NextStationDebugSlot++; }
-	FORCEINLINE int32 GetStationDebugCapacity() const { return NextStationDebugSlot; }
-	FORCEINLINE void SetStationDebugSnapshot(TArray<FRogueDebugStation>&& Snapshot) { StationsDebugSnapshot.Reset(); StationsDebugSnapshot = MoveTemp(Snapshot); }
-
 	FORCEINLINE const TArray<FRogueDebugTrack>& GetTrackDebugSnapshot() { return TracksDebugSnapshot; }
 	//const USplineComponent& GetTrackEntities() const;
 
@@ -218,14 +308,21 @@ private:
 
 	bool bGenerateDebugSnapshot = false;
 
-	TArray<FRogueDebugPassenger> PassengersDebugSnapshot;
-	int32 NextPassengerDebugSlot = 0;
-	TArray<FRogueDebugTrain> TrainsDebugSnapshot;
-	int32 NextTrainDebugSlot = 0;
-	TArray<FRogueDebugCarriage> CarriagesDebugSnapshot;
-	int32 NextCarriageDebugSlot = 0;
-	TArray<FRogueDebugStation> StationsDebugSnapshot;
-	int32 NextStationDebugSlot = 0;
+	struct FDebugSnapshotRequest
+	{
+		double LastRequestTime = -UE_BIG_NUMBER;
+		double NextCollectTime = 0.0;
+	};
+	
+	static constexpr int32 NumDebugSnapshotTypes = 4;
+	FDebugSnapshotRequest DebugSnapshotRequests[NumDebugSnapshotTypes];
+	FRogueDebugView DebugView;
+	TMap<ERogueEntityType, FRogueDebugSlotAllocator> DebugSlots;
+	
+	TRogueDebugSnapshotBuffer<FRogueDebugPassenger> PassengersDebugSnapshot;
+	TRogueDebugSnapshotBuffer<FRogueDebugTrain> TrainsDebugSnapshot;
+	TRogueDebugSnapshotBuffer<FRogueDebugCarriage> CarriagesDebugSnapshot;
+	TRogueDebugSnapshotBuffer<FRogueDebugStation> StationsDebugSnapshot;
 	TArray<FRogueDebugTrack> TracksDebugSnapshot;
 	
 #endif
@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityHandle.h"
+
+/**
+ * Dense train consists, engines keep a consist id and carriages of one train sit contiguously in train order.
+ * Keeps the carriage list out of the engine fragment so engines stay trivially relocatable in their chunks.
+ * Ranges are sized once on allocation, released ids are reused by trains needing no more carriages.
+ */
+struct ROGUEMASSEXAMPLE_API FRogueConsistTable
+{
+	void Reset() { Consists.Reset(); Carriages.Reset(); FreeIds.Reset(); }
+	int32 Num() const { return Consists.Num() - FreeIds.Num(); }
+	bool IsValidConsist(const int32 ConsistId) const { return Consists.IsValidIndex(ConsistId) && Consists[ConsistId].Lead.IsSet(); }
+
+	/** Range for Lead with room for MaxCarriages, keeps ExistingId when it already belongs to Lead and is large enough */
+	int32 Allocate(const FMassEntityHandle Lead, const int32 MaxCarriages, const int32 ExistingId = INDEX_NONE);
+	void Release(const int32 ConsistId);
+
+	/** CarriageIndex is the link index, 1 is the carriage behind the engine */
+	void SetCarriage(const int32 ConsistId, const int32 CarriageIndex, const FMassEntityHandle Carriage);
+
+	FMassEntityHandle GetLead(const int32 ConsistId) const { return IsValidConsist(ConsistId) ? Consists[ConsistId].Lead : FMassEntityHandle(); }
+	int32 GetNumCarriages(const int32 ConsistId) const { return IsValidConsist(ConsistId) ? Consists[ConsistId].Num : 0; }
+	TConstArrayView<FMassEntityHandle> GetCarriages(const int32 ConsistId) const;
+
+private:
+	struct FRange
+	{
+		FMassEntityHandle Lead;
+		int32 First = 0;
+		int32 Num = 0;
+		int32 Capacity = 0;
+	};
+
+	TArray<FRange> Consists;
+	TArray<FMassEntityHandle> Carriages;
+	TArray<int32> FreeIds;
+};
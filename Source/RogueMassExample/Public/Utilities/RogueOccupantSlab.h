@@ -0,0 +1,42 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityHandle.h"
+#include "Mass/Fragments/RogueFragments.h"
+
+/**
+ * Occupants of every carriage in one slab of fixed size blocks.
+ * A carriage owns a run of contiguous blocks covering its class capacity, its fragment keeps only the first block and the count.
+ * Released runs are kept per length and handed to the next carriage of the same size, so the slab only grows with the peak carriage count.
+ * Views are only valid until the next Allocate, the slab may grow and move.
+ */
+struct ROGUEMASSEXAMPLE_API FRogueOccupantSlab
+{
+	static constexpr int32 BlockSize = 16; // handles per block, two cache lines
+
+	void Reset() { Handles.Reset(); RunLengths.Reset(); FreeRuns.Reset(); }
+
+	/** First block of a run holding at least Capacity occupants, INDEX_NONE for an empty capacity */
+	int32 Allocate(const int32 Capacity);
+	void Free(const int32 FirstBlock);
+
+	/** Occupants the run starting at FirstBlock can hold */
+	int32 GetCapacity(const int32 FirstBlock) const { return RunLengths.IsValidIndex(FirstBlock) ? RunLengths[FirstBlock] * BlockSize : 0; }
+
+	TArrayView<FMassEntityHandle> GetOccupants(const FRogueCarriageFragment& Carriage);
+	TConstArrayView<FMassEntityHandle> GetOccupants(const FRogueCarriageFragment& Carriage) const;
+
+	/** Returns false when the carriage run is full */
+	bool Add(FRogueCarriageFragment& Carriage, const FMassEntityHandle Occupant);
+	void RemoveAtSwap(FRogueCarriageFragment& Carriage, const int32 Index);
+
+	int32 GetNumBlocks() const { return RunLengths.Num(); }
+	int64 GetAllocatedSize() const { return Handles.GetAllocatedSize() + RunLengths.GetAllocatedSize(); }
+
+private:
+	TArray<FMassEntityHandle> Handles;   // NumBlocks * BlockSize
+	TArray<int32> RunLengths;            // per block, run length in blocks at the first block of a run, 0 elsewhere
+	TMap<int32, TArray<int32>> FreeRuns; // run length to released first blocks
+};
@@ -8,10 +8,12 @@
 
 namespace RogueStationQueueUtility
 {
-	void BuildGridForWaitingPoint(const FRoguePlatformData& StationSegment, FRogueStationQueueFragment& QueueFragment, const FVector& WaitingCenter, int32 WaitingPointIdx);
-	int32 ClaimWaitingSlot(FRogueStationQueueFragment* QueueFragment, const int32 WaitingPointIdx, const FMassEntityHandle& Passenger, FVector& OutSlotPos);
-	void ReleaseSlot(FRogueStationQueueFragment& QueueFragment, const FRoguePassengerFragment& PassengerFragment);
+	// Bake waiting points, spawn points and grid slots aligned to the platform
+	void BuildStationLayout(const FRoguePlatformData& StationSegment, const FRogueStationConfig& StationConfigData, const int32 StationIdx, FRogueStationLayoutFragment& OutLayout);
+	void InitWaitingGrids(const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment& QueueFragment);
+	int32 ClaimWaitingSlot(const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment* QueueFragment, const int32 WaitingPointIdx, const FMassEntityHandle& Passenger, FVector& OutSlotPos);
+	void ReleaseSlot(FRogueStationQueueFragment& QueueFragment, const FRoguePassengerTripFragment& TripFragment);
 	//bool DequeueFromGrid(const FMassEntityManager& EntityManger, FRogueStationQueueFragment& QueueFragment, const int32 WaitPointIdx, FMassEntityHandle& OutPassenger, int32& OutSlotIdx, FVector& OutSlotPos);
-	bool PeekFromGrid(const FMassEntityManager& EntityManger, FRogueStationQueueFragment& QueueFragment, const int32 WaitPointIdx,
-		FMassEntityHandle& OutPassenger, const FMassEntityHandle CurrentStationEntity, int32& OutSlotIdx, FVector& OutSlotPos);
+	bool PeekFromGrid(const FMassEntityManager& EntityManger, const FRogueStationLayoutFragment& Layout, FRogueStationQueueFragment& QueueFragment, const int32 WaitPointIdx,
+		FMassEntityHandle& OutPassenger, const int32 CurrentStationIdx, int32& OutSlotIdx, FVector& OutSlotPos);
 }
\ No newline at end of file
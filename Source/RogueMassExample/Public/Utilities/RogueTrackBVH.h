@@ -0,0 +1,49 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USplineComponent;
+
+/**
+ * Bounding volume hierarchy over a baked polyline of the track.
+ * Segments are sampled at a fixed arc length so a point on a segment maps straight back to a track distance.
+ */
+struct ROGUEMASSEXAMPLE_API FRogueTrackSegmentBVH
+{
+	struct FSegment
+	{
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		double StartDistance = 0.0; // cm along spline at Start
+		double Length = 0.0;        // arc length covered by the segment
+	};
+
+	struct FNode
+	{
+		FBox Bounds = FBox(ForceInit);
+		int32 FirstChild = INDEX_NONE; // right child is FirstChild + 1, INDEX_NONE for leaves
+		int32 FirstSegment = 0;
+		int32 NumSegments = 0;
+	};
+
+	/** Sample the spline every SegmentLength cm and rebuild the tree */
+	void Build(const USplineComponent& Spline, float SegmentLength);
+	void Reset() { Segments.Reset(); Nodes.Reset(); }
+	bool IsValid() const { return Nodes.Num() > 0; }
+
+	/** Closest track distance to WorldPos, optionally the closest point on the track. Returns false if not built */
+	bool FindClosest(const FVector& WorldPos, double& OutDistance, FVector* OutLocation = nullptr, double* OutDistSq = nullptr) const;
+
+	int32 GetNumSegments() const { return Segments.Num(); }
+	int32 GetNumNodes() const { return Nodes.Num(); }
+
+private:
+	static constexpr int32 MaxLeafSegments = 4;
+	
+	TArray<FSegment> Segments;
+	TArray<FNode> Nodes;
+
+	void BuildNode(const int32 NodeIdx, const int32 First, const int32 Num);
+};
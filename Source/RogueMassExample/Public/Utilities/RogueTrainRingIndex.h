@@ -0,0 +1,58 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityHandle.h"
+
+/**
+ * Trains on one line kept in ring order by track distance.
+ * Trains on a line never overtake, so the order only changes on add/remove and per frame updates are O(1).
+ * Entries are stored from an arbitrary start, Head is the slot with the smallest distance.
+ */
+struct ROGUEMASSEXAMPLE_API FRogueTrainRingIndex
+{
+	struct FEntry
+	{
+		FMassEntityHandle Entity;
+		double Distance = 0.0;   // lead distance in cm
+		float TrainLength = 0.f; // lead to tail in cm
+	};
+
+	void Reset() { Entries.Reset(); Slots.Reset(); Head = 0; }
+	void SetTrackLength(const double InTrackLength) { TrackLength = InTrackLength; }
+	double GetTrackLength() const { return TrackLength; }
+	int32 Num() const { return Entries.Num(); }
+	bool Contains(const FMassEntityHandle Entity) const { return Slots.Contains(Entity); }
+
+	/** Insert in ring order, O(n) but only on spawn, despawn or line switch */
+	void Add(const FMassEntityHandle Entity, const double Distance, const float TrainLength);
+	bool Remove(const FMassEntityHandle Entity);
+
+	/** Move an existing train, call Refresh once all trains of the frame are updated */
+	bool Update(const FMassEntityHandle Entity, const double Distance, const float TrainLength);
+	void Refresh();
+
+	const FEntry* Find(const FMassEntityHandle Entity) const;
+	const FEntry* GetAhead(const FMassEntityHandle Entity) const;
+	const FEntry* GetBehind(const FMassEntityHandle Entity) const;
+
+	/** First train at or ahead of Distance, wrapping, O(log n) */
+	const FEntry* FindFirstAhead(const double Distance) const;
+	/** Last train behind Distance, i.e. the next one to arrive there, O(log n) */
+	const FEntry* FindFirstBehind(const double Distance) const;
+	/** Closest train either way around the ring, O(log n) */
+	const FEntry* FindNearest(const double Distance) const;
+	/** Trains with lead distance in [Distance - BehindCm, Distance + AheadCm], O(log n + k) */
+	void FindInRange(const double Distance, const double BehindCm, const double AheadCm, TArray<FMassEntityHandle>& Out) const;
+
+private:
+	TArray<FEntry> Entries;
+	TMap<FMassEntityHandle, int32> Slots;
+	int32 Head = 0;
+	double TrackLength = 0.0;
+
+	const FEntry& At(const int32 Rank) const { return Entries[(Head + Rank) % Entries.Num()]; }
+	int32 LowerBoundRank(const double Distance) const;
+	void RebuildSlots();
+};
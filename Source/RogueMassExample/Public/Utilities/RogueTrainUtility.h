@@ -9,9 +9,16 @@
 namespace RogueTrainUtility
 {
 	inline float WrapTrackAlpha(const float Alpha) { return Alpha - FMath::FloorToFloat(Alpha); }
-	int32 FindNextStation(const USplineComponent& Spline,const TArray<FRoguePlatformData>& Platforms, const float CurrentAlpha);
-	float AlphaAtWorld(const USplineComponent& Spline, const FVector& WorldPos);
-	float ArcDistanceWrapped(const float FromAlpha, const float ToAlpha);
+	inline double WrapTrackDistance(const double Distance, const double TrackLength)
+	{
+		if (TrackLength <= 0.0) return 0.0;
+		if (Distance >= 0.0 && Distance < TrackLength) return Distance; // common case, no fmod
+		const double Wrapped = FMath::Fmod(Distance, TrackLength);
+		return Wrapped < 0.0 ? Wrapped + TrackLength : Wrapped;
+	}
+	int32 FindNextStation(const TArray<FRoguePlatformData>& Platforms, const double CurrentDistance, const double TrackLength);
+	double DistanceAtWorld(const FRogueTrackSharedFragment& Track, const FVector& WorldPos);
+	double ArcDistanceWrapped(const double FromDistance, const double ToDistance, const double TrackLength);
 	
 	struct FSplineStationSample
 	{
@@ -20,13 +27,12 @@ namespace RogueTrainUtility
 		FVector   Right    = FVector::RightVector;
 		FVector   Up       = FVector::UpVector;
 		FTransform World   = FTransform::Identity;
-		float     Distance = 0.f;   // cm along spline
-		float     Alpha        = 0.f;   // normalized [0..1]
+		double    Distance = 0.0;   // cm along spline
 	};
 
 	/** Returns true if sampled successfully.
 	 *  @param Track			Track fragment with spline reference
-	 *  @param StationTrackAlpha         Normalized station T in [0..1]
+	 *  @param TrackDistance    Distance along the track in cm
 	 *  @param AlongOffsetCm    Extra distance along the spline in cm (positive moves forward)
 	 *  @param LateralOffsetCm  Offset to the right of the track (platform side) in cm
 	 *  @param VerticalOffsetCm Vertical offset in cm
@@ -34,20 +40,21 @@ namespace RogueTrainUtility
 	 */
 	bool GetSplineSample(
 		const FRogueTrackSharedFragment& Track,
-		const float StationTrackAlpha,
+		const double TrackDistance,
 		const float AlongOffsetCm,
 		const float LateralOffsetCm,
 		const float VerticalOffsetCm,
 		FSplineStationSample& Out);
 
 	/** Convenience overload: zero offsets */
-	inline bool GetSplineSample(const FRogueTrackSharedFragment& TrackSharedFragment, const float TrackAlpha, FSplineStationSample& Out)
+	inline bool GetSplineSample(const FRogueTrackSharedFragment& TrackSharedFragment, const double TrackDistance, FSplineStationSample& Out)
 	{
-		return GetSplineSample(TrackSharedFragment, TrackAlpha, /*Along*/0.f, /*Lat*/0.f, /*Z*/0.f, Out);
+		return GetSplineSample(TrackSharedFragment, TrackDistance, /*Along*/0.f, /*Lat*/0.f, /*Z*/0.f, Out);
 	}
 
 	FTransform SampleTrackFrame(const USplineComponent& Spline, float Alpha);
 	FVector SampleDockPoint(const USplineComponent& Spline, float Alpha);
-	void BuildPlatformSegment(const USplineComponent& Spline, const FRogueStationConfig& StationConfigData, FRoguePlatformData& Out);
-	void ComputeConsistPlacement(const FRogueTrackSharedFragment& Track, const float EngineHeadAlpha, const int32 NumCarriages, TArray<FRoguePlacedCar>& Out);
+	void BuildPlatformSegment(const USplineComponent& Spline, const FRogueTrackSegmentBVH& SegmentBVH, const FRogueStationConfig& StationConfigData, FRoguePlatformData& Out);
+	void BakePlatformDistances(const FRogueTrackSegmentBVH& SegmentBVH, FRoguePlatformData& Platform);
+	void ComputeConsistPlacement(const FRogueTrackSharedFragment& Track, const double EngineHeadDistance, const int32 NumCarriages, const FRogueCarriageClassFragment& CarriageClass, TArray<FRoguePlacedCar>& Out);
 }
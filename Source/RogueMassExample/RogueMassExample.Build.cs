@@ -1,4 +1,4 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
+﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 using UnrealBuildTool;
 
@@ -19,6 +19,7 @@ public class RogueMassExample : ModuleRules
 			"MassNavigation",
 			"MassCrowd",
 			"MassLOD",
+			"MassSimulation",
 			"DeveloperSettings",
 			"StructUtils",
 			"UMG"
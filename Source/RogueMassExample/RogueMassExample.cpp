@@ -1,6 +1,23 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
+﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "RogueMassExample.h"
+#include "HAL/IConsoleManager.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogRogueSim);
+
+DEFINE_STAT(STAT_RogueEntitiesProcessed);
+DEFINE_STAT(STAT_RogueSplineSamples);
+DEFINE_STAT(STAT_RogueBoardings);
+DEFINE_STAT(STAT_RogueAlightings);
+DEFINE_STAT(STAT_RoguePoolHits);
+DEFINE_STAT(STAT_RoguePoolMisses);
+
+bool GRogueVerboseStats = false;
+static FAutoConsoleVariableRef CVarRogueVerboseStats(
+	TEXT("rogue.Stats.Verbose"),
+	GRogueVerboseStats,
+	TEXT("Time per call helpers (spline sample, grid peek) in stat RogueSim. Off by default, a scope per call costs about as much as the call."),
+	ECVF_Default);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, RogueMassExample, "RogueMassExample" );
@@ -1,6 +1,20 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
+﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #pragma once
 
 #include "CoreMinimal.h"
 
+ROGUEMASSEXAMPLE_API DECLARE_LOG_CATEGORY_EXTERN(LogRogueSim, Log, All);
+
+// stat RogueSim, cycle counters are declared next to the code they time, per frame counters shared across files here
+DECLARE_STATS_GROUP(TEXT("RogueSim"), STATGROUP_RogueSim, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Entities Processed"), STAT_RogueEntitiesProcessed, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spline Samples"), STAT_RogueSplineSamples, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Boardings"), STAT_RogueBoardings, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Alightings"), STAT_RogueAlightings, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pool Hits"), STAT_RoguePoolHits, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pool Misses"), STAT_RoguePoolMisses, STATGROUP_RogueSim, ROGUEMASSEXAMPLE_API);
+
+// Cycle scopes inside per call helpers (spline sample, grid peek) only open while rogue.Stats.Verbose is set
+extern ROGUEMASSEXAMPLE_API bool GRogueVerboseStats;
+